@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Regression check of the filter bank. A noise signal is split into the channels and reconstructed,
+ * in blocks of varying size, and compared with the input delayed by the latency of the bank.
+ * The output objects are reused across the blocks, the first one starts as a SURFACE.
+ * Build it with -fsanitize=address to catch leaks. Returns 0 if all checks pass.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esweep.h"
+
+#define SAMPLERATE 48000
+#define SIZE 20000
+
+static int failed=0;
+
+static void check(int ok, const char *what) {
+	printf("%-40s%s\n", what, ok ? "ok" : "FAILED");
+	if (!ok) failed++;
+}
+
+/* analysis and synthesis of noise, returns the largest deviation from the delayed input */
+static double reconstruct(int channels, int hop, int taps) {
+	esweep_filterBank *bank;
+	esweep_object *in, *block, *chan, *out;
+	Wave *x, *y;
+	double err=0.0;
+	int i, n, pos, len, produced, latency;
+
+	if ((bank=esweep_filterBankCreate(SAMPLERATE, channels, hop, taps, NULL)) == NULL) return HUGE_VAL;
+	esweep_filterBankInfo(bank, NULL, NULL, &latency);
+
+	in=esweep_create("wave", SAMPLERATE, SIZE);
+	x=(Wave*) in->data;
+	srand(1);
+	for (i=0; i < SIZE; i++) x[i]=2.0*rand()/RAND_MAX-1.0;
+
+	block=esweep_create("wave", SAMPLERATE, 0);
+	chan=esweep_create("surface", SAMPLERATE, 0);
+	esweep_sparseSurface(chan, 4, 4);
+	out=esweep_create("wave", SAMPLERATE, 0);
+
+	for (pos=0, produced=0, n=0; pos < SIZE; pos+=len, n=(n*7+3) % 997) {
+		/* block sizes from 1 to 997 samples, not aligned to the hop */
+		len=n+1 < SIZE-pos ? n+1 : SIZE-pos;
+		esweep_free(block);
+		block=esweep_create("wave", SAMPLERATE, len);
+		memcpy(block->data, x+pos, len*sizeof(Wave));
+		if (esweep_filterBankAnalyze(bank, chan, block, NULL) != ERR_OK) {
+			err=HUGE_VAL;
+			break;
+		}
+		if (chan->size == 0) continue;
+		if (esweep_filterBankSynthesize(bank, out, chan) != ERR_OK) {
+			err=HUGE_VAL;
+			break;
+		}
+		/* output sample j is input sample j-latency */
+		y=(Wave*) out->data;
+		for (i=0; i < out->size; i++) {
+			if (produced+i >= latency && fabs(y[i]-x[produced+i-latency]) > err) err=fabs(y[i]-x[produced+i-latency]);
+		}
+		produced+=out->size;
+	}
+
+	esweep_free(out);
+	esweep_free(chan);
+	esweep_free(block);
+	esweep_free(in);
+	esweep_filterBankFree(bank);
+	return err;
+}
+
+int main() {
+	/*
+	 * float has about 7 digits; with double, the regularization of the synthesis prototype
+	 * limits the error of long prototypes to about -140 dB
+	 */
+	double tol=sizeof(Real) == sizeof(float) ? 1e-4 : 1e-6;
+
+	check(reconstruct(64, 32, 1) < tol, "sqrt-Hann, M=64, D=M/2");
+	check(reconstruct(64, 16, 1) < tol, "sqrt-Hann, M=64, D=M/4");
+	check(reconstruct(64, 32, 4) < tol, "windowed sinc, M=64, D=M/2");
+	check(reconstruct(256, 64, 8) < tol, "windowed sinc, M=256, D=M/4");
+	check(reconstruct(16, 8, 16) < tol, "windowed sinc, M=16, D=M/2");
+
+	return failed > 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * IIR filter benchmark. Compares esweep_filter(), which dispatches to the
+ * specialized biquad cascades, with the generic section loop.
+ * The output of both must be identical and must not be silent.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esweep.h"
+
+/* copy of the generic loop in esweep_filter.c */
+static void generic_iir(esweep_object *in, esweep_object *filter[]) {
+	int i, j;
+	Wave *wave=in->data, tmp;
+	Real *num=(filter[0])->data, *denom=(filter[1])->data;
+	Complex *state=(filter[2])->data;
+
+	for (j=0; j < filter[0]->size; j+=3) {
+		for (i=0; i < in->size; i++) {
+			tmp=wave[i]*num[j]+state[j].real;
+
+			state[j].real=num[j+1]*wave[i]-denom[j+1]*tmp+state[j+1].real;
+			state[j+1].real=num[j+2]*wave[i]-denom[j+2]*tmp;
+
+			wave[i]=tmp;
+		}
+	}
+}
+
+int main() {
+	int samplerate=48000;
+	int size=4096; // block size
+	int sections, sections_max=20; // beyond 16 esweep_filter() uses the generic loop as well
+	int i, N=2000; // filter runs to get valid timing results
+	int equal, silent;
+
+	clock_t ticks, ticks_generic; // timing variables
+
+	esweep_object **filter, **section, **ref;
+	esweep_object *in=esweep_create("wave", samplerate, size);
+	esweep_object *out=esweep_create("wave", samplerate, size);
+	esweep_object *out_ref=esweep_create("wave", samplerate, size);
+	Wave *wave=in->data, *a, *b;
+
+	srand(1);
+	for (i=0; i < size; i++) wave[i]=2.0*rand()/RAND_MAX-1.0;
+
+	printf("sections\tspecialized\tgeneric\t\tspeedup\n");
+	filter=esweep_createFilterFromCoeff("lowpass", 1.0, 0.707, 1000.0, 0.0, 0.0, samplerate);
+	for (sections=1; sections <= sections_max; sections++) {
+		if (sections > 1) {
+			section=esweep_createFilterFromCoeff("lowpass", 1.0, 0.5+0.05*sections, 1000.0+100.0*sections, 0.0, 0.0, samplerate);
+			esweep_appendFilter(filter, section);
+			esweep_freeFilter(section);
+		}
+		esweep_resetFilter(filter);
+		ref=esweep_cloneFilter(filter);
+
+		ticks=clock();
+		for (i=0; i < N; i++) {
+			memcpy(out->data, in->data, size*sizeof(Wave));
+			esweep_filter(out, filter);
+		}
+		ticks=clock()-ticks;
+
+		ticks_generic=clock();
+		for (i=0; i < N; i++) {
+			memcpy(out_ref->data, in->data, size*sizeof(Wave));
+			generic_iir(out_ref, ref);
+		}
+		ticks_generic=clock()-ticks_generic;
+
+		a=out->data;
+		b=out_ref->data;
+		equal=memcmp(a, b, size*sizeof(Wave)) == 0;
+		/* a zero output would make the comparison meaningless */
+		for (silent=1, i=0; i < size && silent; i++) silent=b[i] == 0.0;
+
+		printf("%i:\t\t%li ticks\t%li ticks\t%.2f%s\n", sections, (long) ticks, (long) ticks_generic,
+				ticks > 0 ? (double) ticks_generic/ticks : 0.0, !equal ? "\t(output differs!)" : silent ? "\t(output is zero!)" : "");
+		esweep_freeFilter(ref);
+	}
+
+	esweep_freeFilter(filter);
+	esweep_free(in);
+	esweep_free(out);
+	esweep_free(out_ref);
+
+	return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Regression check of the filter container. Saves and loads a biquad and a FIR, then changes the
+ * type of the loaded (memory mapped) coefficients: element-wise arithmetic with COMPLEX and POLAR
+ * operands and the explicit conversions. Build it with -fsanitize=address to catch a free() of
+ * mapped data. Returns 0 if all checks pass.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esweep.h"
+
+#define FILENAME "filtercheck.flt"
+#define TAPS 100
+
+static int failed=0;
+
+static void check(int ok, const char *what) {
+	printf("%-40s%s\n", what, ok ? "ok" : "FAILED");
+	if (!ok) failed++;
+}
+
+/* save filter, load it again and compare the coefficients */
+static esweep_object **roundtrip(esweep_object **filter) {
+	esweep_object **loaded;
+
+	if (esweep_saveFilter(FILENAME, filter) != ERR_OK) return NULL;
+	if ((loaded=esweep_loadFilter(FILENAME)) == NULL) return NULL;
+	if (loaded[0]->size != filter[0]->size || memcmp(loaded[0]->data, filter[0]->data, filter[0]->size*sizeof(Real)) != 0) return NULL;
+	if (filter[1] != NULL && memcmp(loaded[1]->data, filter[1]->data, filter[1]->size*sizeof(Real)) != 0) return NULL;
+	return loaded;
+}
+
+static void free_filter(esweep_object **filter) {
+	esweep_free(filter[0]);
+	if (filter[1] != NULL) esweep_free(filter[1]);
+	esweep_free(filter[2]);
+	free(filter);
+}
+
+/* loaded WAVE op COMPLEX operand, the result must match the same operation on a copy */
+static int mixed(int (*op)(esweep_object*, const esweep_object*), const char *type) {
+	esweep_object **filter, **loaded, *b, *ref;
+	Real num[TAPS];
+	int i, ok;
+
+	for (i=0; i < TAPS; i++) num[i]=1.0+0.01*i;
+	filter=esweep_createFilterFromArray(num, NULL, TAPS, 48000);
+	if ((loaded=roundtrip(filter)) == NULL) return 0;
+	b=esweep_create(type, 48000, TAPS);
+	for (i=0; i < TAPS; i++) {
+		((Complex*) b->data)[i].real=0.5+0.001*i;
+		((Complex*) b->data)[i].imag=0.25;
+	}
+	ref=esweep_clone(filter[0]);
+	ok=op(ref, b) == ERR_OK && op(loaded[0], b) == ERR_OK && loaded[0]->type == ref->type
+		&& memcmp(loaded[0]->data, ref->data, TAPS*sizeof(Complex)) == 0;
+	esweep_free(ref);
+	esweep_free(b);
+	free_filter(loaded);
+	free_filter(filter);
+	return ok;
+}
+
+int main() {
+	esweep_object **filter, **loaded;
+	Real num[TAPS];
+	int i, ok;
+
+	filter=esweep_createFilterFromCoeff("lowpass", 1.0, 0.707, 1000.0, 0.0, 0.0, 48000);
+	loaded=roundtrip(filter);
+	check(loaded != NULL, "biquad save/load");
+	if (loaded != NULL) free_filter(loaded);
+	free_filter(filter);
+
+	for (i=0; i < TAPS; i++) num[i]=0.01*i;
+	filter=esweep_createFilterFromArray(num, NULL, TAPS, 48000);
+	loaded=roundtrip(filter);
+	check(loaded != NULL, "FIR save/load");
+	if (loaded != NULL) {
+		ok=esweep_toComplex(loaded[0]) == ERR_OK && esweep_toPolar(loaded[0]) == ERR_OK && esweep_toWave(loaded[0]) == ERR_OK;
+		check(ok && fabs(((Wave*) loaded[0]->data)[TAPS-1]-num[TAPS-1]) < 1e-12, "mapped WAVE conversions");
+		free_filter(loaded);
+	}
+	free_filter(filter);
+
+	check(mixed(esweep_add, "complex"), "mapped WAVE + COMPLEX");
+	check(mixed(esweep_sub, "complex"), "mapped WAVE - COMPLEX");
+	check(mixed(esweep_mul, "complex"), "mapped WAVE * COMPLEX");
+	check(mixed(esweep_div, "complex"), "mapped WAVE / COMPLEX");
+	check(mixed(esweep_mul, "polar"), "mapped WAVE * POLAR");
+	check(mixed(esweep_div, "polar"), "mapped WAVE / POLAR");
+
+	remove(FILENAME);
+	return failed > 0;
+}
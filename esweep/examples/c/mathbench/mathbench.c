@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * Element-wise arithmetic benchmark. Runs esweep_add(), esweep_mul() and esweep_div()
+ * on 16M sample objects with each instruction set of vmath.c and reports
+ * the memory throughput. The output of all instruction sets must be identical.
+ * Then esweep_stats() on a 16M sample WAVE, against a naive serial loop, with each instruction set
+ * and several numbers of threads; its output must not depend on either.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esweep.h"
+#include "vmath.h"
+
+/* 16M samples; the Makefile raises ESWEEP_MAX_SIZE above this */
+#define SIZE 0x01000000
+
+typedef struct {
+	const char *name;
+	const char *type_a, *type_b;
+	int size_b;
+	int (*op)(esweep_object*, const esweep_object*);
+	int streams; /* arrays of SIZE Reals moved per call: a read, a written, b read */
+} bench;
+
+static const bench benches[]={
+	{"wave + wave", "wave", "wave", SIZE, esweep_add, 3},
+	{"wave * scalar", "wave", "wave", 1, esweep_mul, 2},
+	{"complex + complex", "complex", "complex", SIZE, esweep_add, 6},
+	{"complex * complex", "complex", "complex", SIZE, esweep_mul, 6},
+	{"complex / complex", "complex", "complex", SIZE, esweep_div, 6},
+	{"complex * scalar", "complex", "complex", 1, esweep_mul, 4},
+	{"complex * wave", "complex", "wave", SIZE, esweep_mul, 5},
+	{"polar * polar", "polar", "polar", SIZE, esweep_mul, 6},
+	{"polar / wave", "polar", "wave", SIZE, esweep_div, 5},
+};
+
+static size_t data_size(const esweep_object *obj) {
+	return obj->type == WAVE ? obj->size*sizeof(Wave) : obj->size*sizeof(Complex);
+}
+
+/* wall clock, clock() would add up the time of all threads */
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec+1e-9*ts.tv_nsec;
+}
+
+/* the reductions before esweep_stats() */
+static void naive_stats(const esweep_object *obj, esweep_statistics *st) {
+	Wave *wave=(Wave*) obj->data;
+	int i;
+
+	st->sum=st->sqsum=0.0;
+	st->min=st->max=wave[0];
+	st->argmin=st->argmax=0;
+	for (i=0; i < obj->size; i++) {
+		st->sum+=wave[i];
+		st->sqsum+=wave[i]*wave[i];
+		if (wave[i] < st->min) {
+			st->min=wave[i];
+			st->argmin=i;
+		}
+		if (wave[i] > st->max) {
+			st->max=wave[i];
+			st->argmax=i;
+		}
+	}
+}
+
+static void bench_stats(int samplerate, int N) {
+	const char *isa[]={"scalar", "sse2", "avx2"};
+	const int threads[]={1, 2, 4, 0};
+	esweep_statistics st, ref;
+	esweep_object *a;
+	long double sum;
+	double sec;
+	char name[16];
+	int i, k, t;
+
+	a=esweep_create("wave", samplerate, SIZE);
+	if (a == NULL) return;
+	/* a large offset, so that the naive sum loses precision */
+	for (i=0; i < SIZE; i++) ((Wave*) a->data)[i]=1e3+(Real) rand()/RAND_MAX;
+	for (sum=0.0, i=0; i < SIZE; i++) sum+=((Wave*) a->data)[i];
+
+	printf("\nreduction\t\tisa\tthreads\ttime/call\tthroughput\tsum error\n");
+	naive_stats(a, &st);
+	sec=-now();
+	for (i=0; i < N; i++) naive_stats(a, &st);
+	sec=(sec+now())/N;
+	printf("%-20s\t%s\t%i\t%.2f ms\t\t%.2f GB/s\t%.3g\n", "naive loop", "-", 1, 1e3*sec,
+			1e-9*SIZE*sizeof(Real)/sec, (double) fabsl(st.sum-sum));
+
+	esweep_stats(a, &ref, 1);
+	for (k=0; k < (int) (sizeof(isa)/sizeof(char*)); k++) {
+		if (!vmath_setIsa(isa[k])) continue;
+		for (t=0; t < (int) (sizeof(threads)/sizeof(int)); t++) {
+			esweep_stats(a, &st, threads[t]);
+			sec=-now();
+			for (i=0; i < N; i++) esweep_stats(a, &st, threads[t]);
+			sec=(sec+now())/N;
+			if (threads[t] > 0) snprintf(name, sizeof(name), "%i", threads[t]);
+			else strcpy(name, "auto");
+			printf("%-20s\t%s\t%s\t%.2f ms\t\t%.2f GB/s\t%.3g%s\n", "esweep_stats", isa[k], name,
+					1e3*sec, 1e-9*SIZE*sizeof(Real)/sec,
+					(double) fabsl(st.sum-sum), memcmp(&st, &ref, sizeof(st)) == 0 ? "" : "\t(output differs!)");
+		}
+	}
+	vmath_setIsa(NULL);
+	esweep_free(a);
+}
+
+static void fill(esweep_object *obj) {
+	Real *data=obj->data;
+	int i, n=obj->type == WAVE ? obj->size : 2*obj->size;
+
+	/* avoid zeros, the polar phase stays small */
+	for (i=0; i < n; i++) data[i]=0.5+(Real) rand()/RAND_MAX;
+}
+
+int main() {
+	const char *isa[]={"scalar", "sse2", "avx2"};
+	int samplerate=48000;
+	int i, j, k, N=10; // runs per instruction set
+	int equal;
+	double sec, bytes;
+	clock_t ticks;
+
+	esweep_object *a, *b, *ref, *in;
+
+	srand(1);
+	printf("size: %i samples, runtime selection: %s\n\n", SIZE, vmath_isa());
+	printf("operation\t\tisa\ttime/call\tthroughput\n");
+	for (j=0; j < (int) (sizeof(benches)/sizeof(bench)); j++) {
+		in=esweep_create(benches[j].type_a, samplerate, SIZE);
+		b=esweep_create(benches[j].type_b, samplerate, benches[j].size_b);
+		a=esweep_create(benches[j].type_a, samplerate, SIZE);
+		ref=NULL;
+		if (in == NULL || a == NULL || b == NULL) return 1;
+		fill(in);
+		fill(b);
+		for (k=0; k < (int) (sizeof(isa)/sizeof(char*)); k++) {
+			if (!vmath_setIsa(isa[k])) continue;
+			/* warm up, page in the memory */
+			memcpy(a->data, in->data, data_size(a));
+			benches[j].op(a, b);
+
+			ticks=0;
+			for (i=0; i < N; i++) {
+				memcpy(a->data, in->data, data_size(a));
+				ticks-=clock();
+				benches[j].op(a, b);
+				ticks+=clock();
+			}
+			sec=(double) ticks/CLOCKS_PER_SEC/N;
+			bytes=(double) benches[j].streams*SIZE*sizeof(Real);
+
+			equal=1;
+			if (ref == NULL) ref=esweep_clone(a);
+			else equal=memcmp(a->data, ref->data, data_size(a)) == 0;
+
+			printf("%-20s\t%s\t%.2f ms\t\t%.2f GB/s%s\n", benches[j].name, isa[k], 1e3*sec,
+					sec > 0.0 ? 1e-9*bytes/sec : 0.0, equal ? "" : "\t(output differs!)");
+		}
+		esweep_free(in);
+		esweep_free(a);
+		esweep_free(b);
+		esweep_free(ref);
+	}
+	vmath_setIsa(NULL);
+
+	bench_stats(samplerate, N);
+
+	return 0;
+}
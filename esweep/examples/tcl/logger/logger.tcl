@@ -10,6 +10,9 @@ array set config {
   General,Interval  1000
   General,Processing  rms
   General,OutputThreshold 5
+  Level,Weighting   A
+  Level,Time        fast
+  Level,Offset      0
 }
 
 
@@ -53,7 +56,7 @@ proc record {signal offset procFunc} {
     # record buffer full, process data
     $procFunc $signal
     # call myself after main interval
-    after $config(General,Interval) [list record $signal 0 $procFunc]
+    after $config(General,Pause) [list record $signal 0 $procFunc]
   }
 }
 
@@ -80,6 +83,21 @@ proc RMS {input} {
   logData $data
 }
 
+# native level logger, one per channel; records continuously and logs one line per completed interval
+# with {time leq lmax lmin l10 l50 l90 lpeak} of each channel
+proc LEVEL {input} {
+  global loggers
+  set data [list]
+  foreach sig $input lv $loggers {
+    foreach rec [esweep::levelLoggerProcess -logger $lv -signal $sig] {
+      lappend data $rec
+    }
+  }
+  if {[llength $data] > 0} {
+    logData $data
+  }
+}
+
 # INIT
 
 # open audio device
@@ -106,10 +124,22 @@ if {[catch {set config(Audio,PlayChannels) [esweep::audioQuery -handle $au -para
 }
 
 # setup processing function
+set config(General,Pause) $config(General,Interval)
 switch $config(General,Processing) {
   rms {
     set procFunc RMS
   }
+  level {
+    set procFunc LEVEL
+    # the logger does the timing, so record without gaps
+    set config(General,Pause) 0
+    set loggers [list]
+    for {set i 0} {$i < $config(Audio,RecChannels)} {incr i} {
+      lappend loggers [esweep::levelLoggerCreate -samplerate $config(Audio,Samplerate) \
+        -interval [expr {$config(General,Interval)/1000.0}] -weighting $config(Level,Weighting) \
+        -time $config(Level,Time) -offset $config(Level,Offset)]
+    }
+  }
   default {
     puts stderr "Unsupported processing type \"$config(General,Processing)\""
     exit 1
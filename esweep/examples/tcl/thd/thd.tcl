@@ -178,18 +178,14 @@ proc measure {} {
 		set out [esweep::create -type wave -samplerate $config(Audio,Samplerate) -size $fftsize]
 		set bin [esweep::generate sine -obj out -frequency $f]
 
+		# esweep generates a sine that it fits with a integer number of periods
+		# in the supplied object. This may give not the desired harmonic here. By fiddling
+		# with the frequency parameter we need to make sure that it is always the correct 
+		# frequecy bin. 
+		set freqs [list]
 		foreach k [concat 1 $config(Measurement,Harmonics)] {
-			# generate sine and cosine for DFT
 			if {$k*$f >= $config(Audio,Samplerate)/2} continue
-			# esweep generates a sine that it fits with a integer number of periods
-			# in the supplied object. This may give not the desired harmonic here. By fiddling
-			# with the frequency parameter we need to make sure that it is always the correct 
-			# frequecy bin. 
-			set fd [expr {1.0*$k*$bin*$samplerate/$fftsize}]
-			set cos($k) [esweep::create -type wave -samplerate $config(Audio,Samplerate) -size $fftsize]
-			esweep::generate sine -obj cos($k) -frequency $fd -phase [expr {acos(0)}]
-			set sin($k) [esweep::create -type wave -samplerate $config(Audio,Samplerate) -size $fftsize]
-			esweep::generate sine -obj sin($k) -frequency $fd
+			lappend freqs [expr {1.0*$k*$bin*$samplerate/$fftsize}]
 		}
 		
 		# reduce output level to -3 dB peak
@@ -208,23 +204,12 @@ proc measure {} {
 		} else {
 			set dut $in2
 		}
-		set fft [esweep::clone -src $dut]
 
-		# do DFT for each harmonic
+		# evaluate all harmonics in a single pass
 		lappend result $f
 		set HD [list]
-		foreach k [concat 1 $config(Measurement,Harmonics)] {
-			if {$k*$f >= $config(Audio,Samplerate)/2} continue
-			set re [esweep::clone -src $dut]
-			set im [esweep::clone -src $dut]
-
-			esweep::expr re * $cos($k)
-			esweep::expr im * $sin($k)
-
-			set re [esweep::sum -obj $re]
-			set im [esweep::sum -obj $im]
-
-			lappend HD [expr {20*log10(2*sqrt($re**2+$im**2)/($config(Audio,Input,Cal)*$config(Audio,Input,Cal,Base)*$fftsize))}]
+		foreach {fd A phi} [esweep::toneAnalyze -obj $dut -frequencies $freqs] {
+			lappend HD [expr {20*log10($A/($config(Audio,Input,Cal)*$config(Audio,Input,Cal,Base)))}]
 		}
 		lappend result $HD
 
@@ -296,6 +296,8 @@ int esweep_toWave(esweep_object *obj);
  * Conversion is only possible for the input types Wave and Polar. Surfaces cannot be converted.
  * Waves will be set to the real part of the new complex data, the imaginary part will be set to zero.
  * Polar samples will be converted according to the euler identity.
+ * The object keeps the polar data as a cache, so converting it back without
+ * changing the data in between is only an exchange of pointers and exact.
  *
  * EXAMPLE:
  * esweep_object *obj=esweep_create("polar", 44100, 1000);
@@ -318,6 +320,7 @@ int esweep_toComplex(esweep_object *obj);
  * Conversion is only possible for the input types Wave and Complex. Surfaces cannot be converted.
  * Waves will be set to the absolute part of the new polar data, the argument (phase) will be set to zero.
  * Complex samples will be converted according to the euler identity.
+ * The complex data is kept as a cache, see esweep_toComplex().
  *
  * EXAMPLE:
  * esweep_object *obj=esweep_create("complex", 44100, 1000);
@@ -597,6 +600,7 @@ int esweep_index(const esweep_object *obj, int index, Real *x, Real *a, Real *b)
  * DESCRIPTION:
  * For complex objects, the magnitude (sqrt(Re**2+Im**2)) is returned.
  * For polar objects, the absolute is returned.
+ * NaN are ignored. See esweep_stats().
  *
  * EXAMPLE:
  */
@@ -615,7 +619,7 @@ int esweep_min(const esweep_object *obj, int from, int to, Real *min);
  * Returns the index requested by flags or an error code (<0)
  *
  * DESCRIPTION:
- * See esweep_max()
+ * See esweep_max(). The position is the index of the first maximum/minimum in obj.
  *
  * EXAMPLE:
  */
@@ -636,6 +640,7 @@ int esweep_minPos(const esweep_object *obj, int from, int to, int *pos);
  * DESCRIPTION:
  * For complex objects, the magnitude (sqrt(Re**2+Im**2)) is used.
  * For polar objects, the absolute is used.
+ * The sums are compensated, see esweep_stats().
  *
  * EXAMPLE:
  */
@@ -643,6 +648,32 @@ int esweep_avg(const esweep_object *obj, Real *avg);
 int esweep_sum(const esweep_object *obj, Real *sum);
 int esweep_sqsum(const esweep_object *obj, Real *sqsum);
 
+/*
+ * esweep_stats()
+ * Calculate sum, sum of squares, mean, RMS, minimum, maximum, their positions and the crest factor in one pass
+ *
+ * PARAMETERS:
+ * const esweep_object *obj: esweep_object
+ * esweep_statistics *stats: holds the results on return
+ * int threads: number of threads, <= 0 to use several threads only for large objects
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * For complex objects, the magnitude (sqrt(Re**2+Im**2)) is used, for polar objects the absolute,
+ * for surfaces z, argmin and argmax are indices into z.
+ * The values are summed in blocks with SIMD, the block sums are added with compensated summation.
+ * The blocks do not depend on the number of threads, so the results are the same for any number of threads.
+ * NaN are ignored by min and max, but not by the sums. The crest factor is max(|min|, |max|)/rms.
+ *
+ * EXAMPLE:
+ * esweep_statistics st;
+ * esweep_stats(a, &st, 0);
+ * printf("%f dB crest factor\n", 20*log10(st.crest));
+ */
+int esweep_stats(const esweep_object *obj, esweep_statistics *stats, int threads);
+
 /*
  * esweep_real()
  * esweep_imag()
@@ -786,6 +817,39 @@ int esweep_pow(esweep_object *obj, Real x);
 
 int esweep_schroeder(esweep_object *obj);
 
+/*
+ * esweep_eval()
+ * Evaluate an expression for every element of an object
+ *
+ * PARAMETERS:
+ * esweep_object *obj: WAVE (samples), POLAR (magnitudes) or SURFACE (z); modified in place
+ * const char *expr: the expression, e. g. "20*lg(abs(x))+k"
+ * int n: number of variables (at most 16)
+ * const char *names[]: names of the variables, may be NULL if n is 0
+ * const Real values[]: values of the variables, may be NULL if n is 0
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * The expression may use the operators + - * / ^ (power), parentheses, numbers, the element x, its
+ * index i, pi, the variables and the functions abs, sqrt, lg, ln, exp, sin, cos, tan, atan, floor, ceil,
+ * pow(a, b), min(a, b), max(a, b) and clip(a, lo, hi). Variables hide the predefined names.
+ * The expression is compiled once and cached by its source and the variable names, so only the values
+ * of the variables should change between calls. Then the object is processed in a single pass, not in
+ * one pass per operation like with esweep_lg(), esweep_mul() etc. Infinite results are clamped to
+ * the largest representable value like in the other math functions. Unlike esweep_lg(), lg(x) of a
+ * negative x is an invalid operation, use lg(abs(x)).
+ * The nesting of the expression is not limited, but it may have at most 256 operands and operations
+ * and 64 different constants, including the variables.
+ *
+ * EXAMPLE:
+ * const char *names[]={"k"};
+ * Real values[]={94.0};
+ * esweep_eval(spectrum, "20*lg(x)+k", 1, names, values);
+ */
+int esweep_eval(esweep_object *obj, const char *expr, int n, const char *names[], const Real values[]);
+
 /* dsp */
 
 int esweep_fft(esweep_object *out, esweep_object *in, esweep_object *table);
@@ -800,6 +864,29 @@ int esweep_delay(esweep_object *signal, esweep_object *line, int *offset);
 int esweep_hilbert(esweep_object *obj, esweep_object *table);
 int esweep_analytic(esweep_object *obj, esweep_object *table);
 
+/*
+ * esweep_envelope()
+ * Envelope, energy time curve, instantaneous phase or frequency from the analytic signal
+ *
+ * PARAMETERS:
+ * esweep_object *obj: WAVE, replaced in place
+ * const char *mode: "magnitude", "etc" (10*lg of the squared magnitude, floored at -300 dB),
+ *                   "phase" (wrapped, rad) or "frequency" (Hz)
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * The Hilbert transform is computed with real FFTs of the next power of 2 not smaller than the size of obj
+ * and combined with the signal in a single pass. The FFT buffers are cached per size, so repeated calls
+ * with the same size do not allocate memory. The instantaneous frequency is the phase difference of
+ * successive samples and needs no unwrapping.
+ *
+ * EXAMPLE:
+ * esweep_envelope(ir, "etc");
+ */
+int esweep_envelope(esweep_object *obj, const char *mode);
+
 int esweep_integrate(esweep_object *obj);
 int esweep_differentiate(esweep_object *obj);
 
@@ -811,10 +898,149 @@ int esweep_gDelayToPhase(esweep_object *obj);
 
 int esweep_smooth(esweep_object *obj, Real factor);
 
+/*
+ * esweep_smoothExt()
+ * Fractional octave smoothing
+ *
+ * PARAMETERS:
+ * esweep_object *obj: POLAR or COMPLEX object, smoothed in place
+ * Real factor: smoothing width is 1/factor octave (>= 1)
+ * const char *mode: "magnitude" (default if NULL), "power" or "complex"
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * Each bin i is replaced by the average of the bins i-i/(4*factor)..i+i/(2*factor).
+ * "magnitude" averages the magnitude and the unwrapped phase, "power" the squared magnitude
+ * and the unwrapped phase, "complex" the real and imaginary part. DC is left alone.
+ * The averages are calculated from prefix sums, so the run time is linear in the size of obj and
+ * independent of the factor. esweep_smooth() is the same with mode "magnitude".
+ *
+ * EXAMPLE:
+ * esweep_smoothExt(fr, 6, "power");
+ */
+int esweep_smoothExt(esweep_object *obj, Real factor, const char *mode);
+
+/*
+ * esweep_smoothLog()
+ * Fractional octave smoothing with logarithmically spaced output
+ *
+ * PARAMETERS:
+ * esweep_object *obj: POLAR or COMPLEX object, not modified
+ * Real factor: smoothing width is 1/factor octave (>= 1)
+ * const char *mode: see esweep_smoothExt()
+ * Real f1, f2: first and last output frequency, 0 < f1 < f2 <= samplerate/2
+ * int points: number of output points (>= 2)
+ * Real *freq: receives the frequencies of the output points
+ * Polar *out: receives the smoothed values
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * The same averages as esweep_smoothExt(), but only evaluated at the output frequencies.
+ * The cost is O(size+points), which is much cheaper than smoothing and resampling afterwards
+ * when a spectrum with many bins is to be displayed.
+ */
+int esweep_smoothLog(esweep_object *obj, Real factor, const char *mode, Real f1, Real f2, int points, Real *freq, Polar *out);
+
+/*
+ * esweep_logResample()
+ * Collapse a spectrum to a logarithmic frequency grid
+ *
+ * PARAMETERS:
+ * esweep_object *out: a SURFACE with one row, x is the frequency and z the level of each grid point
+ * const esweep_object *in: POLAR or COMPLEX object, not modified
+ * Real fmin, fmax: frequency range, 0 < fmin < fmax <= samplerate/2
+ * int ppo: grid points per octave (>= 1)
+ * const char *mode: "power" (default if NULL) or "max"
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * The grid frequencies are fmin*2^(i/ppo) up to fmax. Each grid point covers the bins within +-1/(2*ppo) octave.
+ * "power" is the RMS of their magnitudes, so the energy of the spectrum is preserved, "max" holds the
+ * highest magnitude. Grid points without a bin are interpolated from the nearest bins.
+ * All bins are visited once. out is only reallocated when its size does not match; like other surfaces,
+ * it can be passed to esweep_lg(), esweep_mul() etc., the frequencies stay in x.
+ *
+ * EXAMPLE:
+ * esweep_object *fr=esweep_create("surface", 48000, 0);
+ * esweep_logResample(fr, spectrum, 20, 20000, 48, "power");
+ */
+int esweep_logResample(esweep_object *out, const esweep_object *in, Real fmin, Real fmax, int ppo, const char *mode);
+
 int esweep_window(esweep_object *obj, const char *left_win, Real left_width, const char *right_win, Real right_width);
+
+/*
+ * esweep_windowInfo()
+ * Coherent gain and equivalent noise bandwidth of a window
+ *
+ * PARAMETERS:
+ * const char *window: "rect", "bartlett", "hann", "hamming", "blackman", "blackmanharris", "flattop",
+ *                     "kaiser", "tukey" or "gauss"; the last three may carry a parameter, e. g. "kaiser:6.5"
+ *                     (beta, default 8.6), "tukey:0.25" (tapered fraction, default 0.5) or "gauss:0.3"
+ *                     (sigma relative to the half width, default 0.4)
+ * int size: window length in samples
+ * Real *coherent_gain: receives the mean of the window
+ * Real *enbw: receives the equivalent noise bandwidth in bins
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * The window is the symmetric one the spectrum, STFT, transfer function and CQT engines apply,
+ * the left half over size/2 samples and the right half over the rest. Divide a magnitude spectrum
+ * by coherent_gain*size to read sine amplitudes, divide a power spectrum by enbw to read power densities.
+ * The same window names are accepted by esweep_window() and the engines.
+ *
+ * EXAMPLE:
+ * Real cg, enbw;
+ * esweep_windowInfo("flattop", 4096, &cg, &enbw);
+ */
+int esweep_windowInfo(const char *window, int size, Real *coherent_gain, Real *enbw);
 int esweep_restoreHermitian(esweep_object *obj);
 
+/*
+ * esweep_peakDetect()
+ * Indices of the peaks of a WAVE or of the magnitude of a POLAR object
+ *
+ * Same as esweep_peakFind() without distance, prominence and interpolation.
+ * *n is the size of peaks on input and the number of peaks on output.
+ */
 int esweep_peakDetect(esweep_object *obj, Real threshold, int *peaks, int *n);
+
+/*
+ * esweep_peakFind()
+ * Find peaks with hysteresis, minimum distance and prominence
+ *
+ * PARAMETERS:
+ * const esweep_object *obj: WAVE, or POLAR and COMPLEX objects (magnitude)
+ * Real threshold: hysteresis; the signal must drop by more than threshold after a peak, and rise
+ *                 by more than threshold before the next one. 0 finds all local maxima, negative values find minima
+ * Real distance: minimum distance of peaks in samples, of closer peaks only the highest is kept; 0 disables
+ * Real prominence: minimum height of a peak above the higher of the minima to the next higher sample on both sides; 0 disables
+ * const char *interpolation: "none", "parabolic" or "gaussian" (parabola through the logarithms); NULL is "none"
+ * esweep_peak *peaks: receives the peaks in ascending order
+ * int *n: size of peaks on input, number of peaks on output
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * The position and level of each peak are interpolated from the peak sample and its neighbours.
+ * The x of the peak is the interpolated time of a WAVE, or the frequency of a spectrum with the
+ * bin spacing of esweep_fft(). The cost is O(size), plus O(p*log(p)) for p peaks with distance > 0.
+ * If there are more peaks than fit into peaks, the first *n ones are returned.
+ *
+ * EXAMPLE:
+ * esweep_peak peaks[10];
+ * int n=10;
+ * esweep_peakFind(spectrum, 0, 5, 0.01, "gaussian", peaks, &n);
+ */
+int esweep_peakFind(const esweep_object *obj, Real threshold, Real distance, Real prominence, const char *interpolation, esweep_peak *peaks, int *n);
 /* filter */
 int esweep_filter(esweep_object *obj, esweep_object *filter[]);
 int esweep_resample(esweep_object *out, esweep_object *in, esweep_object *filter[], Complex *carry);
@@ -830,74 +1056,1024 @@ int esweep_freeFilter(esweep_object *filter[]);
 int esweep_saveFilter(const char *filename, esweep_object *filter[]);
 esweep_object **esweep_loadFilter(const char *filename);
 
+/*
+ * esweep_saveFilterExt()
+ * Save a filter together with precomputed spectra and meta data
+ *
+ * PARAMETERS:
+ * const char *filename: name of the output file
+ * esweep_object *filter[]: the filter
+ * esweep_object *spectra[]: COMPLEX objects of identical size, e. g. the transformed partitions of a FIR kernel; may be NULL
+ * int n_spectra: number of objects in spectra
+ * const char *meta: meta data, may be NULL
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * The file is written in the native layout of the machine, all data sections are aligned to 64 bytes.
+ * esweep_saveFilter() is the same without spectra and meta data. The filter state is not saved.
+ */
+int esweep_saveFilterExt(const char *filename, esweep_object *filter[], esweep_object *spectra[], int n_spectra, const char *meta);
 
-/* generate */
+/*
+ * esweep_loadFilterExt()
+ * Load a filter together with precomputed spectra and meta data
+ *
+ * PARAMETERS:
+ * const char *filename: name of the input file
+ * esweep_object **spectra[]: receives a newly allocated array of the spectra, or NULL if there are none; may be NULL
+ * int *n_spectra: receives the number of spectra; may be NULL
+ * char **meta: receives the newly allocated meta data, or NULL if there is none; may be NULL
+ *
+ * RETURN:
+ * Returns the filter or NULL on error
+ *
+ * DESCRIPTION:
+ * When the byte order and the size of Real in the file match the library, the file is mapped
+ * into memory (copy-on-write) and the numerator, denominator and spectra point directly into the
+ * mapping, so loading takes constant time regardless of the size of the filter.
+ * The mapping is released when the last of these objects is freed with esweep_free() or esweep_freeFilter().
+ * Mapped objects may change their size or type like any other object (e. g. by esweep_toComplex());
+ * they get their own memory then and release their reference to the mapping.
+ * Otherwise, the data is converted while reading.
+ * The filter state is always reset. Files written by older versions of esweep_saveFilter() are loaded as well.
+ * esweep_loadFilter() is the same without spectra and meta data.
+ *
+ * EXAMPLE:
+ * esweep_object **filter, **spectra;
+ * int n;
+ * char *meta;
+ * filter=esweep_loadFilterExt("correction.flt", &spectra, &n, &meta);
+ */
+esweep_object **esweep_loadFilterExt(const char *filename, esweep_object **spectra[], int *n_spectra, char **meta);
 
-int esweep_concat(esweep_object *dst, esweep_object *src, int dst_pos, int src_pos);
-esweep_object *esweep_cut(esweep_object *obj, int start, int stop);
-int esweep_pad(esweep_object *obj, int size);
+/* delay line */
 
 /*
- * TODO: merge these functions in a single function with variable arguments
- * jfab, 09.01.2011: maybe with varargs; otherwise all functions must accept the same number of arguments
- * 		     and drop unused
- * jfab, 16.03.2011: no, this can be done in the Tcl interface. In plain C, we use one function for each generator
+ * esweep_delayLineCreate()
+ * Create a multichannel delay line with fractional delays
+ *
+ * PARAMETERS:
+ * int samplerate: samplerate of the signals
+ * int channels: number of channels (1..ESWEEP_MAX_CHANNELS)
+ * Real max_delay: maximum delay in samples
+ *
+ * RETURN:
+ * Returns the delay line or NULL on error
+ *
+ * DESCRIPTION:
+ * All channels start with a delay of 0 and an empty buffer. The delay of each channel can be set
+ * independently with esweep_delayLineSet(). The integer part of the delay is taken from a ring buffer of
+ * power-of-two size, the fractional part is interpolated with a 3rd order Lagrange interpolator
+ * (Farrow structure). Delays below 1 sample are interpolated linearly.
+ *
+ * EXAMPLE:
+ * esweep_delayLine *line=esweep_delayLineCreate(48000, 2, 480.0);
  */
+esweep_delayLine *esweep_delayLineCreate(int samplerate, int channels, Real max_delay);
 
 /*
- * esweep_genSine()
- * Generate a sine wave
+ * esweep_delayLineSet()
+ * Set the delay of a channel
  *
  * PARAMETERS:
- * esweep_object *obj: esweep_object
- * Real freq: frequency
- * Real phase: phase
+ * esweep_delayLine *line: the delay line
+ * int channel: the channel, or -1 for all channels
+ * Real delay: the new delay in samples (0..max_delay)
+ * int ramp: length of the transition in samples, 0 changes the delay immediately
  *
  * RETURN:
- * Returns the number of generated periods or an error code.
+ * Returns an error code
  *
  * DESCRIPTION:
- * The frequency is automatically adjusted so that always an integer multiple of one period
- * matches in obj. If obj is Complex the analytical wave is created (Real part: sine, Imaginary part: cosine).
+ * With a ramp, the delay glides linearly from its current value to the new one while the line is
+ * processed, avoiding clicks when changing the delay of a running signal.
+ * A running ramp is continued from its current position.
+ *
+ * EXAMPLE:
+ * esweep_delayLineSet(line, 1, 12.37, 2048);
  */
+int esweep_delayLineSet(esweep_delayLine *line, int channel, Real delay, int ramp);
 
-int esweep_genSine(esweep_object *obj, Real freq, Real phase, int *periods);
-int esweep_genLogsweep(esweep_object *obj, Real locut, Real hicut, const char *spec, Real *sweep_rate);
-int esweep_genDirac(esweep_object *obj, Real delay);
-int esweep_genLinsweep(esweep_object *obj, Real locut, Real hicut, const char *spec, Real *sweep_rate);
-int esweep_genNoise(esweep_object *output, Real locut, Real hicut, const char *spec);
+/*
+ * esweep_delayLineGet()
+ * Get the current delay of a channel
+ *
+ * PARAMETERS:
+ * const esweep_delayLine *line: the delay line
+ * int channel: the channel
+ * Real *delay: receives the current delay in samples, which is in between when a ramp is running
+ *
+ * RETURN:
+ * Returns an error code
+ */
+int esweep_delayLineGet(const esweep_delayLine *line, int channel, Real *delay);
 
-/* file handling */
+/*
+ * esweep_delayLineProcess()
+ * Delay signals
+ *
+ * PARAMETERS:
+ * esweep_delayLine *line: the delay line
+ * esweep_object *signal[]: one WAVE per channel, all of the same size and samplerate as the line
+ * int channels: number of objects in signal, must match the line
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * The signals are delayed in place. The line keeps its state, so consecutive
+ * blocks of a stream can be processed one after another.
+ */
+int esweep_delayLineProcess(esweep_delayLine *line, esweep_object *signal[], int channels);
 
 /*
- * esweep_toAscii()
- * Write the object's data in an ASCII file
+ * esweep_delayLineReset()
+ * Clear the buffers of a delay line. The delays are not changed.
+ */
+int esweep_delayLineReset(esweep_delayLine *line);
+
+/*
+ * esweep_delayLineFree()
+ * Free a delay line
+ */
+int esweep_delayLineFree(esweep_delayLine *line);
+
+/* filter bank */
+
+/*
+ * esweep_filterBankCreate()
+ * Create a uniform polyphase DFT filter bank
  *
  * PARAMETERS:
- * const char *filename: name of output file
- * const esweep_object *obj: esweep object
- * const char *comment: comment placed in the file before the data, may be NULL
+ * int samplerate: samplerate of the signals
+ * int channels: number of channels M, a power of 2
+ * int hop: decimation factor D (1..M); D=M is critically sampled, D<M oversampled
+ * int taps: length of the default prototype filter in multiples of M; ignored if prototype is given
+ * esweep_object *prototype: a WAVE with the prototype lowpass, the size must be a multiple of M; may be NULL
+ *
+ * RETURN:
+ * Returns the filter bank or NULL on error
+ *
+ * DESCRIPTION:
+ * Each channel k is centered at k*samplerate/M and has a bandwidth of samplerate/M. The analysis bank
+ * splits a signal into the complex baseband signals of the channels, decimated by D, with one FFT
+ * of size M per hop. The synthesis bank reconstructs the signal from the channels.
+ * The default prototype with taps=1 is a sqrt-Hann window, which has a high leakage into the neighbouring channels.
+ * With taps>1, the default prototype is a Blackman windowed sinc lowpass with a cutoff of samplerate/(2*M),
+ * the longer the prototype, the better the selectivity of the channels. The prototype is normalized to unity gain.
+ * The prototype of the synthesis bank is calculated from the analysis prototype. The reconstruction is perfect
+ * for D <= M/2 with any reasonable prototype. With D=M it is only perfect for prototypes of length M without zeros.
+ *
+ * EXAMPLE:
+ * esweep_filterBank *bank=esweep_filterBankCreate(48000, 256, 64, 4, NULL);
  */
-int esweep_toAscii(const char *filename, const esweep_object *obj, const char *comment);
-int esweep_save(const char *filename, const esweep_object *input, const char *meta);
-int esweep_load(esweep_object *output, const char *filename, char **meta);
+esweep_filterBank *esweep_filterBankCreate(int samplerate, int channels, int hop, int taps, esweep_object *prototype);
 
-/* audio */
+/*
+ * esweep_filterBankInfo()
+ * Get the layout of a filter bank
+ *
+ * PARAMETERS:
+ * const esweep_filterBank *bank: the filter bank
+ * int *bins: receives the number of channels per frame (M/2+1); may be NULL
+ * int *hop: receives the decimation factor; may be NULL
+ * int *latency: receives the delay of analysis and synthesis in samples (L-D); may be NULL
+ *
+ * RETURN:
+ * Returns an error code
+ */
+int esweep_filterBankInfo(const esweep_filterBank *bank, int *bins, int *hop, int *latency);
 
-esweep_audio* esweep_audioOpen(const char *device);
-int esweep_audioQuery(const esweep_audio *handle, const char *query, int *result);
-int esweep_audioConfigure(esweep_audio *handle, const char *param, int value);
-int esweep_audioSync(esweep_audio *handle);
-int esweep_audioPause(esweep_audio *handle);
-int esweep_audioOut(esweep_audio *handle, esweep_object *out[], int channels, int *offset);
-int esweep_audioIn(esweep_audio *handle, esweep_object *in[], int channels, int *offset);
-int esweep_audioClose(esweep_audio *handle);
+/*
+ * esweep_filterBankAnalyze()
+ * Split a signal into the channels of the filter bank
+ *
+ * PARAMETERS:
+ * esweep_filterBank *bank: the filter bank
+ * esweep_object *out: receives the channel samples as COMPLEX object
+ * esweep_object *in: the input WAVE
+ * int *frames: receives the number of frames in out; may be NULL
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * The input is a block of a stream, it may have any size. A frame is produced every D input samples,
+ * remaining samples are kept for the next call. A frame consists of the channels 0..M/2,
+ * the other channels are the complex conjugates of these because the input is real.
+ * The frames are stored consecutively in out, which is resized as needed.
+ * It is empty if the block did not complete a frame.
+ */
+int esweep_filterBankAnalyze(esweep_filterBank *bank, esweep_object *out, esweep_object *in, int *frames);
 
-/* surface */
+/*
+ * esweep_filterBankSynthesize()
+ * Reconstruct a signal from the channels of the filter bank
+ *
+ * PARAMETERS:
+ * esweep_filterBank *bank: the filter bank
+ * esweep_object *out: receives the output WAVE of D samples per frame
+ * esweep_object *in: COMPLEX object with frames as produced by esweep_filterBankAnalyze()
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * The output is delayed by L-D samples relative to the input of the analysis.
+ * The channel samples may be modified between analysis and synthesis, e. g. to equalize a signal.
+ */
+int esweep_filterBankSynthesize(esweep_filterBank *bank, esweep_object *out, esweep_object *in);
 
-int esweep_csd(esweep_object *out, esweep_object *in, Real time_step, int steps, Real rise_time, Real smooth_factor);
-int esweep_cbsd(esweep_object *out, esweep_object *in, Real f1, Real f2, int resolution, int periods, int steps, char time_shift);
+/*
+ * esweep_filterBankReset()
+ * Clear the state of analysis and synthesis
+ */
+int esweep_filterBankReset(esweep_filterBank *bank);
 
-int esweep_addToSurface(esweep_object *obj, esweep_object *b, char axis, int index, Real dep);
+/*
+ * esweep_filterBankFree()
+ * Free a filter bank
+ */
+int esweep_filterBankFree(esweep_filterBank *bank);
+
+/* averaged spectrum */
+
+/*
+ * esweep_spectrumCreate()
+ * Create a streaming spectrum analyzer with averaging (Welch's method)
+ *
+ * PARAMETERS:
+ * int samplerate: samplerate of the signal
+ * int size: FFT size N, a power of 2
+ * Real overlap: overlap of successive frames in percent, typically 50 or 75
+ * const char *window: a window name as in esweep_windowInfo(), e. g. "hann" or "kaiser:6.5"; NULL is "hann"
+ * const char *average: "linear", "exponential" or "peak"; NULL is "linear"
+ * Real tau: time constant of the exponential average in seconds, ignored otherwise
+ *
+ * RETURN:
+ * Returns the analyzer or NULL on error
+ *
+ * DESCRIPTION:
+ * The signal is fed block by block with esweep_spectrumProcess(), independent of the FFT size.
+ * Every N*(1-overlap/100) samples, the last N samples are windowed and transformed. The power spectra of
+ * the frames are averaged in place: "linear" is the mean of all frames since the last reset,
+ * "exponential" weights the frames with exp(-t/tau), "peak" holds the maximum of each bin.
+ * The average can be read at any time with esweep_spectrumRead().
+ *
+ * EXAMPLE:
+ * esweep_spectrum *spec=esweep_spectrumCreate(48000, 4096, 75, "hann", "exponential", 0.5);
+ */
+esweep_spectrum *esweep_spectrumCreate(int samplerate, int size, Real overlap, const char *window, const char *average, Real tau);
+
+/*
+ * esweep_spectrumInfo()
+ * Get the FFT size, the hop between the frames and the number of frames averaged so far; each pointer may be NULL
+ */
+int esweep_spectrumInfo(const esweep_spectrum *spec, int *size, int *hop, int *frames);
+
+/*
+ * esweep_spectrumProcess()
+ * Feed the analyzer with the samples of a WAVE, or the real part of a COMPLEX object
+ */
+int esweep_spectrumProcess(esweep_spectrum *spec, const esweep_object *in);
+
+/*
+ * esweep_spectrumRead()
+ * Read the averaged spectrum
+ *
+ * PARAMETERS:
+ * const esweep_spectrum *spec: the analyzer
+ * esweep_object *out: the output, a POLAR object of size N
+ * const char *mode: "magnitude", "power" or "psd"
+ * int *frames: number of averaged frames, may be NULL
+ *
+ * RETURN:
+ * ERR_OK on success, an error code otherwise
+ *
+ * DESCRIPTION:
+ * The spectrum is single sided. "magnitude" is scaled to the peak amplitude and "power" to the mean square
+ * of a sine in the center of a bin, "psd" is the power spectral density in units^2/Hz.
+ * The phase is 0, the bins above N/2 mirror the lower half, so the frequency of bin k is k*samplerate/N
+ * like with esweep_fft(). out is only reallocated if it is not already a POLAR object of size N,
+ * hence polling the analyzer with the same object does not allocate memory.
+ */
+int esweep_spectrumRead(const esweep_spectrum *spec, esweep_object *out, const char *mode, int *frames);
+
+/*
+ * esweep_spectrumReset()
+ * Clear the input buffer and the averages
+ */
+int esweep_spectrumReset(esweep_spectrum *spec);
+
+/*
+ * esweep_spectrumFree()
+ * Free an analyzer
+ */
+int esweep_spectrumFree(esweep_spectrum *spec);
+
+/* transfer function */
+
+/*
+ * esweep_transferCreate()
+ * Create a streaming dual channel transfer function and coherence estimator
+ *
+ * PARAMETERS:
+ * int samplerate: samplerate of the signals
+ * int size: FFT size N, a power of 2
+ * Real overlap: overlap of successive frames in percent
+ * const char *window: a window name as in esweep_windowInfo(), e. g. "hann" or "kaiser:6.5"; NULL is "hann"
+ * int channels: number of measurement channels sharing one reference
+ * const char *average: "linear" or "exponential"; NULL is "linear"
+ * Real tau: time constant of the exponential average in seconds, ignored otherwise
+ *
+ * RETURN:
+ * Returns the estimator or NULL on error
+ *
+ * DESCRIPTION:
+ * The reference and the measurement channels are framed like with esweep_spectrumCreate(). Each frame of the
+ * reference is transformed once, then the auto spectra Gxx, Gyy and the cross spectrum Gxy of every channel
+ * are averaged in place. The memory does not grow with the duration of the measurement.
+ * The estimates are read at any time with esweep_transferRead().
+ *
+ * EXAMPLE:
+ * esweep_transfer *tf=esweep_transferCreate(48000, 8192, 50, "hann", 2, "exponential", 2.0);
+ */
+esweep_transfer *esweep_transferCreate(int samplerate, int size, Real overlap, const char *window, int channels, const char *average, Real tau);
+
+/*
+ * esweep_transferInfo()
+ * Get the FFT size, the hop, the number of channels and the number of frames averaged so far; each pointer may be NULL
+ */
+int esweep_transferInfo(const esweep_transfer *tf, int *size, int *hop, int *channels, int *frames);
+
+/*
+ * esweep_transferProcess()
+ * Feed the estimator with a block of the reference and the same number of samples of every channel
+ *
+ * PARAMETERS:
+ * esweep_transfer *tf: the estimator
+ * const esweep_object *ref: the reference, a WAVE or the real part of a COMPLEX object
+ * const esweep_object *meas[]: one WAVE or COMPLEX object per channel, all with the size of ref
+ *
+ * RETURN:
+ * ERR_OK on success, an error code otherwise
+ */
+int esweep_transferProcess(esweep_transfer *tf, const esweep_object *ref, const esweep_object *meas[]);
+
+/*
+ * esweep_transferRead()
+ * Read the estimate of one channel
+ *
+ * PARAMETERS:
+ * const esweep_transfer *tf: the estimator
+ * int channel: the channel, starting from 0
+ * esweep_object *out: the output, a COMPLEX object of size N for "h1" and "h2", a POLAR object of size N for "coherence"
+ * const char *mode: "h1", "h2" or "coherence"
+ * int *frames: number of averaged frames, may be NULL
+ *
+ * RETURN:
+ * ERR_OK on success, an error code otherwise
+ *
+ * DESCRIPTION:
+ * "h1" is Gxy/Gxx, the estimate for noise at the output of the system, "h2" is Gyy/conj(Gxy),
+ * the estimate for noise at the input. "coherence" is |Gxy|^2/(Gxx*Gyy) in the magnitude, the phase is 0.
+ * Bins where the estimate is undefined are 0. The bins above N/2 are the hermitian mirror image, so
+ * esweep_ifft() of "h1" or "h2" gives the impulse response. out is only reallocated if it
+ * does not have the right type and size.
+ */
+int esweep_transferRead(const esweep_transfer *tf, int channel, esweep_object *out, const char *mode, int *frames);
+
+/*
+ * esweep_transferReset()
+ * Clear the input buffers and the averages
+ */
+int esweep_transferReset(esweep_transfer *tf);
+
+/*
+ * esweep_transferFree()
+ * Free an estimator
+ */
+int esweep_transferFree(esweep_transfer *tf);
+
+/* multi resolution frequency response */
+
+/*
+ * esweep_multiResolution()
+ * Frequency response of an impulse response with a frequency dependent gate
+ *
+ * PARAMETERS:
+ * esweep_object *out: the output, a POLAR object with one element per output frequency
+ * const esweep_object *ir: the impulse response, a WAVE starting at t=0
+ * Real cycles: length of the gate in periods of the frequency (>= 1)
+ * Real f1, f2: first and last output frequency, 0 < f1 < f2 <= samplerate/2
+ * int points: number of logarithmically spaced output frequencies (>= 2)
+ * Real *freq: receives the output frequencies, may be NULL
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * The response at the frequency f is calculated from the first cycles/f seconds of ir, so it contains
+ * more of the room at low frequencies and less at high frequencies. The gate is flat for the first half
+ * and falls off with a half Hann window. The gate length halves with every octave up, interpolated in between;
+ * above samplerate/6 it stays at its minimum, below f1 or when the response fits into the gate at its maximum.
+ * The output frequency i is f1*(f2/f1)^(i/(points-1)). out is only reallocated if it is not already
+ * a POLAR object of the right size.
+ *
+ * EXAMPLE:
+ * esweep_multiResolution(fr, ir, 8, 20, 20000, 400, NULL);
+ */
+int esweep_multiResolution(esweep_object *out, const esweep_object *ir, Real cycles, Real f1, Real f2, int points, Real *freq);
+
+/* short time fourier transform */
+
+/*
+ * esweep_stftCreate()
+ * Create a short time fourier transform (spectrogram) engine
+ *
+ * PARAMETERS:
+ * int samplerate: samplerate of the signal
+ * int size: FFT size N, a power of 2
+ * int hop: distance of successive frames in samples, 1 <= hop <= N
+ * const char *window: a window name as in esweep_windowInfo(), e. g. "hann" or "kaiser:6.5"; NULL is "hann"
+ * const char *axis: "linear" or "log"; NULL is "linear"
+ * Real f1, f2: frequency range of the log axis, ignored with "linear"
+ * int bins: number of frequency bins of the log axis, ignored with "linear"
+ *
+ * RETURN:
+ * Returns the engine or NULL on error
+ *
+ * DESCRIPTION:
+ * The linear axis has the N/2+1 bins of a real FFT from 0 to samplerate/2. The log axis
+ * has bins logarithmically spaced frequencies from f1 to f2; each bin is the RMS of the FFT bins
+ * in its band, or interpolated if the band is narrower than the FFT resolution.
+ * The magnitudes are scaled to the peak amplitude of a sine.
+ *
+ * EXAMPLE:
+ * esweep_stftEngine *stft=esweep_stftCreate(48000, 2048, 256, "hann", "log", 20, 20000, 200);
+ */
+esweep_stftEngine *esweep_stftCreate(int samplerate, int size, int hop, const char *window, const char *axis, Real f1, Real f2, int bins);
+
+/*
+ * esweep_stftInfo()
+ * Get the number of frequency bins and the number of frames since the last reset; each pointer may be NULL
+ */
+int esweep_stftInfo(const esweep_stftEngine *stft, int *bins, long *frames);
+
+/*
+ * esweep_stftProcess()
+ * Append the spectrogram of a signal to a surface
+ *
+ * PARAMETERS:
+ * esweep_stftEngine *stft: the engine
+ * esweep_object *out: a SURFACE, xsize must be the number of bins
+ * const esweep_object *in: a WAVE, or the real part of a COMPLEX object
+ * int threads: number of threads computing the frames
+ * int *frames: number of rows written, may be NULL
+ *
+ * RETURN:
+ * ERR_OK on success, an error code otherwise
+ *
+ * DESCRIPTION:
+ * The input is appended to the samples of the previous calls, every complete frame becomes one
+ * row of the surface. x is the frequency, y the time of the centre of the frame, and z[bin+row*xsize] the magnitude.
+ * The rows are filled from the first to the last; when the surface is full, it scrolls and the oldest rows are dropped.
+ * The surface is not reallocated, so ysize is the length of the history. Use esweep_sparseSurface() to set it up.
+ */
+int esweep_stftProcess(esweep_stftEngine *stft, esweep_object *out, const esweep_object *in, int threads, int *frames);
+
+/*
+ * esweep_stftReset()
+ * Clear the input buffer and start again with the first row of the surface
+ */
+int esweep_stftReset(esweep_stftEngine *stft);
+
+/*
+ * esweep_stftFree()
+ * Free an engine
+ */
+int esweep_stftFree(esweep_stftEngine *stft);
+
+/*
+ * esweep_stft()
+ * Spectrogram of a signal
+ *
+ * PARAMETERS:
+ * esweep_object *out: a SURFACE object, it is resized to hold all frames
+ * const esweep_object *in: a WAVE, or the real part of a COMPLEX object
+ * const char *window: see esweep_stftCreate()
+ * int fft_size: FFT size, a power of 2, not larger than the input
+ * int hop: distance of successive frames in samples
+ * int threads: number of threads
+ *
+ * RETURN:
+ * ERR_OK on success, an error code otherwise
+ *
+ * DESCRIPTION:
+ * A one-shot version of esweep_stftProcess() with a linear frequency axis.
+ */
+int esweep_stft(esweep_object *out, const esweep_object *in, const char *window, int fft_size, int hop, int threads);
+
+/* constant Q transform */
+
+/*
+ * esweep_cqtCreate()
+ * Create a constant Q transform
+ *
+ * PARAMETERS:
+ * int samplerate: samplerate of the signal
+ * Real f1, f2: frequency of the first bin and upper limit of the last one, 0 < f1 <= f2 < samplerate/2
+ * int bpo: bins per octave
+ * const char *window: a window name as in esweep_windowInfo(), e. g. "hann" or "kaiser:6.5"; NULL is "hann"
+ * Real threshold: spectral kernel values below threshold times the maximum of the kernel are dropped,
+ *                 e. g. 0.0054; 0 keeps all values of the positive frequencies
+ *
+ * RETURN:
+ * Returns the transform or NULL on error
+ *
+ * DESCRIPTION:
+ * The transform of Brown and Puckette. Bin k has the frequency f1*2^(k/bpo) and the bandwidth
+ * f/Q with Q=1/(2^(1/bpo)-1). The frames are as long as the longest kernel, rounded up to a power of 2.
+ * Each frame is transformed with one FFT, then multiplied with the sparse spectral kernels of all bins.
+ * The kernels are computed once and shared by all transforms with the same parameters.
+ * They are cached, the kernels of the last 4 configurations without transform are kept as well.
+ *
+ * EXAMPLE:
+ * esweep_cqt *cqt=esweep_cqtCreate(48000, 27.5, 14080, 48, "hann", 0.0054);
+ */
+esweep_cqt *esweep_cqtCreate(int samplerate, Real f1, Real f2, int bpo, const char *window, Real threshold);
+
+/*
+ * esweep_cqtInfo()
+ * Get the number of bins, the frame size and the frequencies of the bins; each pointer may be NULL
+ */
+int esweep_cqtInfo(const esweep_cqt *cqt, int *bins, int *size, Real *freq);
+
+/*
+ * esweep_cqtAnalyze()
+ * Transform one frame into a POLAR object
+ *
+ * PARAMETERS:
+ * esweep_cqt *cqt: the transform
+ * const esweep_object *in: WAVE, or the real part of a COMPLEX object, with the samplerate of the transform
+ * int start: first sample of the frame, the frame is zero padded after the end of the input
+ * esweep_object *out: receives the amplitudes and phases of the bins
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * The kernels are centered in the frame. The magnitude is the amplitude of a sine at the bin frequency.
+ * out has one element per bin, the frequencies are returned by esweep_cqtInfo().
+ * It is only reallocated if it is not already a POLAR object of this size.
+ */
+int esweep_cqtAnalyze(esweep_cqt *cqt, const esweep_object *in, int start, esweep_object *out);
+
+/*
+ * esweep_cqtSurface()
+ * Transform one frame into a row of a SURFACE
+ *
+ * PARAMETERS:
+ * esweep_cqt *cqt, const esweep_object *in, int start: see esweep_cqtAnalyze()
+ * esweep_object *out: SURFACE, xsize must be the number of bins
+ * int row: the row
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * Writes the magnitudes into z of the row, the bin frequencies into x and the time of the
+ * center of the frame into y of the row.
+ */
+int esweep_cqtSurface(esweep_cqt *cqt, const esweep_object *in, int start, esweep_object *out, int row);
+
+/*
+ * esweep_cqtFree()
+ * Free a transform
+ */
+int esweep_cqtFree(esweep_cqt *cqt);
+
+/* sound level logger */
+
+/*
+ * esweep_levelLoggerCreate()
+ * Create a streaming sound level logger
+ *
+ * PARAMETERS:
+ * int samplerate: samplerate of the signal
+ * const char *weighting: frequency weighting "A", "C" or "Z" (none); NULL is "A"
+ * const char *time: time weighting "fast" (125 ms), "slow" (1 s) or "impulse" (35 ms rise, 1.5 s decay); NULL is "fast"
+ * Real interval: length of a logging interval in seconds
+ * Real offset: added to all levels in dB, e. g. the sound pressure level of a full scale signal
+ *
+ * RETURN:
+ * Returns the logger or NULL on error
+ *
+ * DESCRIPTION:
+ * The A and C weightings are biquad cascades with the pole frequencies of IEC 61672, normalized to 0 dB at 1 kHz.
+ * The 12.2 kHz poles are left out when they are above samplerate/2. The percentile levels come from
+ * a histogram of the time weighted level with a resolution of 0.1 dB, so the memory of the logger is fixed.
+ * The time weighting starts at the mean square of the first samples after a reset.
+ *
+ * EXAMPLE:
+ * esweep_levelLogger *lv=esweep_levelLoggerCreate(48000, "A", "fast", 1.0, 94.0);
+ */
+esweep_levelLogger *esweep_levelLoggerCreate(int samplerate, const char *weighting, const char *time, Real interval, Real offset);
+
+/*
+ * esweep_levelLoggerProcess()
+ * Feed the logger with a block of samples
+ *
+ * PARAMETERS:
+ * esweep_levelLogger *lv: the logger
+ * const esweep_object *in: WAVE or the real part of a COMPLEX object with the samplerate of the logger
+ * esweep_levelRecord *records: receives one record per interval completed by this block
+ * int *n: size of records on input, number of completed intervals on output
+ *
+ * RETURN:
+ * ERR_OK on success, an error code otherwise
+ *
+ * DESCRIPTION:
+ * Blocks may have any size and do not need to be aligned to the intervals. records must have room
+ * for all intervals completed by the block, at most in->size/interval+1. in is not modified.
+ */
+int esweep_levelLoggerProcess(esweep_levelLogger *lv, const esweep_object *in, esweep_levelRecord *records, int *n);
+
+/*
+ * esweep_levelLoggerTotal()
+ * The levels over everything since the last reset, including the current incomplete interval
+ */
+int esweep_levelLoggerTotal(const esweep_levelLogger *lv, esweep_levelRecord *total);
+
+/*
+ * esweep_levelLoggerReset()
+ * Clear the filters, the time weighting and all levels
+ */
+int esweep_levelLoggerReset(esweep_levelLogger *lv);
+
+/*
+ * esweep_levelLoggerFree()
+ * Free a logger
+ */
+int esweep_levelLoggerFree(esweep_levelLogger *lv);
+
+/* tone analysis */
+
+/*
+ * esweep_toneAnalyze()
+ * Amplitudes and phases of a signal at arbitrary frequencies
+ *
+ * PARAMETERS:
+ * const esweep_object *in: WAVE
+ * const Real *freqs: the frequencies, 0..samplerate/2
+ * int n: number of frequencies
+ * Polar *out: array of n elements, the peak amplitude and the phase (re cosine, at the first sample) of each tone
+ *
+ * RETURN:
+ * ERR_OK on success, an error code otherwise
+ *
+ * DESCRIPTION:
+ * All frequencies are evaluated in a single pass through the signal with a bank of Goertzel filters.
+ * The frequencies need not be on the grid of an FFT, but the signal should contain an integer number
+ * of periods of each strong tone, otherwise the leakage limits the dynamic range.
+ *
+ * EXAMPLE:
+ * Real f[]={1000, 2000, 3000};
+ * Polar p[3];
+ * esweep_toneAnalyze(in, f, 3, p);
+ */
+int esweep_toneAnalyze(const esweep_object *in, const Real *freqs, int n, Polar *out);
+
+/*
+ * esweep_thd()
+ * Total harmonic distortion
+ *
+ * PARAMETERS:
+ * const esweep_object *in: WAVE with a sine of frequency f0 plus its distortion
+ * Real f0: frequency of the fundamental
+ * int harmonics: number of harmonics, including the fundamental
+ * Real *thd: THD as ratio, may be NULL
+ * Real *thdn: THD+N as ratio, may be NULL
+ * Polar *out: array of harmonics elements with the amplitudes and phases of the fundamental and the harmonics, may be NULL
+ *
+ * RETURN:
+ * ERR_OK on success, an error code otherwise
+ *
+ * DESCRIPTION:
+ * THD is the RMS of the harmonics 2..harmonics relative to the fundamental; harmonics above Nyquist are 0.
+ * THD+N is the RMS of everything except DC and the fundamental, relative to the RMS of the signal without DC.
+ * Like esweep_toneAnalyze(), this needs a single pass through the signal.
+ */
+int esweep_thd(const esweep_object *in, Real f0, int harmonics, Real *thd, Real *thdn, Polar *out);
+
+/*
+ * esweep_imd()
+ * Intermodulation distortion of a two-tone signal
+ *
+ * PARAMETERS:
+ * const esweep_object *in: WAVE with the sines f1 and f2
+ * Real f1, f2: the frequencies of the tones
+ * int order: highest order of the products, at least 2
+ * Real *imd: the IMD as ratio
+ *
+ * RETURN:
+ * ERR_OK on success, an error code otherwise
+ *
+ * DESCRIPTION:
+ * The IMD is the RMS of all products |m*f2+k*f1| with m, k != 0 and |m|+|k| <= order
+ * below Nyquist, relative to the amplitude of f2. With f1 as low frequency of high level and f2 as high
+ * frequency (SMPTE, DIN), this is the usual definition. Products which fall on f1 or f2 are omitted.
+ */
+int esweep_imd(const esweep_object *in, Real f1, Real f2, int order, Real *imd);
+
+/* room acoustics */
+
+/*
+ * esweep_roomAcoustics()
+ * Calculate room acoustic parameters after ISO 3382 from an impulse response
+ *
+ * PARAMETERS:
+ * esweep_object *ir: WAVE with the impulse response, including the noise floor behind the decay
+ * const Real *fc: center frequencies of the octave bands, 0 for the broadband response
+ * int n_bands: number of bands
+ * int threads: number of threads for the calculation of the bands, <= 0 for one thread per band
+ * esweep_roomParams *params: array of n_bands elements, holds the parameters of each band on return
+ *
+ * RETURN:
+ * ERR_OK on success, an error code otherwise
+ *
+ * DESCRIPTION:
+ * The onset is the first sample of the broadband response which is not more than 20 dB below the peak.
+ * Each band is filtered with a 6th order Butterworth octave bandpass, applied to the time reversed response.
+ * The truncation point (crosspoint) of the squared response is found with the iterative method of Lundeby,
+ * the energy behind the crosspoint is estimated from the fitted decay and added to the Schroeder integral.
+ * EDT, T20 and T30 are extrapolated to 60 dB from the regression of the decay curve between
+ * 0 and -10 dB, -5 and -25 dB, -5 and -35 dB. C50, C80, D50 and the centre time Ts are calculated from
+ * the same energy. Parameters which cannot be evaluated, e. g. T30 with less than 35 dB of decay above
+ * the noise, are set to NAN; test them with isnan(), every finite value is a valid result.
+ *
+ * EXAMPLE:
+ * Real fc[]={0, 125, 250, 500, 1000, 2000, 4000};
+ * esweep_roomParams par[7];
+ * esweep_roomAcoustics(ir, fc, 7, 0, par);
+ */
+int esweep_roomAcoustics(esweep_object *ir, const Real *fc, int n_bands, int threads, esweep_roomParams *params);
+
+
+/* generate */
+
+int esweep_concat(esweep_object *dst, esweep_object *src, int dst_pos, int src_pos);
+esweep_object *esweep_cut(esweep_object *obj, int start, int stop);
+int esweep_pad(esweep_object *obj, int size);
+
+/*
+ * TODO: merge these functions in a single function with variable arguments
+ * jfab, 09.01.2011: maybe with varargs; otherwise all functions must accept the same number of arguments
+ * 		     and drop unused
+ * jfab, 16.03.2011: no, this can be done in the Tcl interface. In plain C, we use one function for each generator
+ */
+
+/*
+ * esweep_genSine()
+ * Generate a sine wave
+ *
+ * PARAMETERS:
+ * esweep_object *obj: esweep_object
+ * Real freq: frequency
+ * Real phase: phase
+ *
+ * RETURN:
+ * Returns the number of generated periods or an error code.
+ *
+ * DESCRIPTION:
+ * The frequency is automatically adjusted so that always an integer multiple of one period
+ * matches in obj. If obj is Complex the analytical wave is created (Real part: sine, Imaginary part: cosine).
+ */
+
+int esweep_genSine(esweep_object *obj, Real freq, Real phase, int *periods);
+int esweep_genLogsweep(esweep_object *obj, Real locut, Real hicut, const char *spec, Real *sweep_rate);
+int esweep_genDirac(esweep_object *obj, Real delay);
+int esweep_genLinsweep(esweep_object *obj, Real locut, Real hicut, const char *spec, Real *sweep_rate);
+int esweep_genNoise(esweep_object *output, Real locut, Real hicut, const char *spec);
+
+/* file handling */
+
+/*
+ * esweep_toAscii()
+ * Write the object's data in an ASCII file
+ *
+ * PARAMETERS:
+ * const char *filename: name of output file
+ * const esweep_object *obj: esweep object
+ * const char *comment: comment placed in the file before the data, may be NULL
+ */
+int esweep_toAscii(const char *filename, const esweep_object *obj, const char *comment);
+int esweep_save(const char *filename, const esweep_object *input, const char *meta);
+int esweep_load(esweep_object *output, const char *filename, char **meta);
+
+/* audio */
+
+esweep_audio* esweep_audioOpen(const char *device);
+int esweep_audioQuery(const esweep_audio *handle, const char *query, int *result);
+int esweep_audioConfigure(esweep_audio *handle, const char *param, int value);
+int esweep_audioSync(esweep_audio *handle);
+int esweep_audioPause(esweep_audio *handle);
+int esweep_audioOut(esweep_audio *handle, esweep_object *out[], int channels, int *offset);
+int esweep_audioIn(esweep_audio *handle, esweep_object *in[], int channels, int *offset);
+int esweep_audioClose(esweep_audio *handle);
+
+/* surface */
+
+/*
+ * esweep_csd()
+ * Cumulative spectral decay of an impulse response
+ *
+ * PARAMETERS:
+ * esweep_object *out: SURFACE object, receives the waterfall
+ * esweep_object *in: WAVE object, the impulse response
+ * Real time_step: time between the spectra in ms
+ * int steps: number of spectra
+ * Real rise_time: length of the Blackman rise window in ms
+ * Real smooth_factor: smoothing width is 1/smooth_factor octave (>= 1), 0 disables smoothing
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * Same as esweep_csdExt() on the full frequency grid with a single thread.
+ */
+int esweep_csd(esweep_object *out, esweep_object *in, Real time_step, int steps, Real rise_time, Real smooth_factor);
+
+/*
+ * esweep_csdExt()
+ * Cumulative spectral decay, multithreaded and optionally on a logarithmic frequency axis
+ *
+ * PARAMETERS:
+ * esweep_object *out, *in, Real time_step, int steps, Real rise_time, Real smooth_factor: see esweep_csd()
+ * Real f1, f2: frequency range of the logarithmic axis, 0 < f1 < f2 <= samplerate/2
+ * int points: number of frequencies of the logarithmic axis, 0 for the full FFT grid
+ * int threads: number of threads computing the spectra
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * Spectrum i is the magnitude of the FFT of the impulse response starting at i*time_step,
+ * zero padded to the next power of 2 of the input size. x of the surface is the frequency,
+ * y the start time in s, and z[x+y*xsize] the magnitude.
+ * The full grid has size/2+1 bins. With points > 0 and without smoothing only the requested
+ * frequencies are evaluated on the tail of the response, so the cost of a spectrum is proportional
+ * to points times the length of the tail. This pays off for some dozen frequencies.
+ * With smoothing, the smoothed spectrum is evaluated at the requested frequencies only.
+ *
+ * EXAMPLE:
+ * esweep_csdExt(csd, ir, 0.1, 200, 0.5, 0, 20, 20000, 400, 4);
+ */
+int esweep_csdExt(esweep_object *out, const esweep_object *in, Real time_step, int steps, Real rise_time, Real smooth_factor,
+		Real f1, Real f2, int points, int threads);
+
+/*
+ * esweep_cbsd()
+ * Burst decay of an impulse response, the convolution with Morlet wavelets
+ *
+ * PARAMETERS:
+ * esweep_object *out: SURFACE object, receives the burst decay
+ * esweep_object *in: WAVE object, the impulse response
+ * Real f1, f2: frequency range, samplerate/size <= f1 <= f2 < samplerate/2
+ * int resolution: number of periods of the wavelets (>= 2)
+ * int periods: length of the output in periods of each frequency
+ * int steps: output samples per period
+ * char time_shift: 'y' shifts the wavelets by "resolution" periods towards positive times
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * Same as esweep_cbsdExt() with a single thread.
+ */
+int esweep_cbsd(esweep_object *out, esweep_object *in, Real f1, Real f2, int resolution, int periods, int steps, char time_shift);
+
+/*
+ * esweep_cbsdExt()
+ * Multithreaded burst decay
+ *
+ * PARAMETERS:
+ * see esweep_cbsd()
+ * int threads: number of threads computing the frequencies
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * The frequencies are spaced so that the spectra of the wavelets cross at -3 dB.
+ * x of the surface is the frequency, y the time in periods, z[x+y*xsize] the magnitude.
+ * Only the band of each wavelet and only the output samples are computed, so the cost
+ * does not grow with the length of the impulse response as much as with a full inverse FFT per frequency.
+ */
+int esweep_cbsdExt(esweep_object *out, const esweep_object *in, Real f1, Real f2, int resolution, int periods, int steps, char time_shift, int threads);
+
+int esweep_addToSurface(esweep_object *obj, esweep_object *b, char axis, int index, Real dep);
+
+/* floating point environment */
+
+/*
+ * esweep_setDenormals()
+ * Set the denormal policy of the library
+ *
+ * PARAMETERS:
+ * const char *mode: one of
+ * 	"off": do nothing
+ * 	"ftz": flush denormals to zero inside filters, convolution and audio I/O (default)
+ * 	"dc": inject a tiny DC offset (ESWEEP_DENORMAL_DC_OFFSET) into the state of IIR filters
+ * 	"all": "ftz" and "dc"
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * Decaying IIR filter tails and the tails of long convolutions produce subnormal numbers when the
+ * input goes silent, which may slow down the processing dramatically.
+ * The policy is global and used by all threads. Each affected function sets the FTZ/DAZ
+ * flags of the calling thread on entry and restores them on exit, the FP environment of the
+ * application is not changed.
+ * Flushing to zero requires SSE (-msse -mfpmath=sse), otherwise "ftz" has no effect.
+ *
+ * EXAMPLE:
+ * esweep_setDenormals("all");
+ */
+int esweep_setDenormals(const char *mode);
+
+/*
+ * esweep_getDenormals()
+ * Get the denormal policy of the library
+ *
+ * PARAMETERS:
+ * const char *mode[]: the name of the current policy (see esweep_setDenormals())
+ *
+ * RETURN:
+ * Returns an error code
+ */
+int esweep_getDenormals(const char *mode[]);
+
+/*
+ * esweep_setNonFinite()
+ * Set the policy for non-finite results of the math functions
+ *
+ * PARAMETERS:
+ * const char *mode: one of
+ * 	"clamp": replace +-inf by the largest finite number, NaN is an error (default)
+ * 	"propagate": leave inf and NaN in the result
+ * 	"error": leave inf and NaN in the result, but return ERR_FP
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * Affects the arithmetic functions, esweep_ln(), esweep_lg(), esweep_exp(), esweep_pow(),
+ * esweep_schroeder(), esweep_abs(), esweep_arg(), esweep_real(), esweep_imag() and esweep_eval().
+ * The results are checked while they are computed, the FP exception flags are neither read nor cleared.
+ * The policy is global; each call uses the policy that was set when it started.
+ *
+ * EXAMPLE:
+ * esweep_setNonFinite("propagate");
+ */
+int esweep_setNonFinite(const char *mode);
+
+/*
+ * esweep_getNonFinite()
+ * Get the policy for non-finite results
+ *
+ * PARAMETERS:
+ * const char *mode[]: the name of the current policy (see esweep_setNonFinite())
+ *
+ * RETURN:
+ * Returns an error code
+ */
+int esweep_getNonFinite(const char *mode[]);
+
+/*
+ * esweep_getNonFiniteCount()
+ * Get the number of non-finite results since the last reset
+ *
+ * PARAMETERS:
+ * long *inf: number of infinite results, may be NULL
+ * long *nan: number of NaN results, may be NULL
+ * long *clamped: number of results replaced by the largest finite number, may be NULL
+ * int reset: if not 0, reset the counters after reading them
+ *
+ * RETURN:
+ * Returns an error code
+ *
+ * DESCRIPTION:
+ * The counters are summed over all threads.
+ *
+ * EXAMPLE:
+ * long inf, nan, clamped;
+ * esweep_lg(a);
+ * esweep_getNonFiniteCount(&inf, &nan, &clamped, 1);
+ */
+int esweep_getNonFiniteCount(long *inf, long *nan, long *clamped, int reset);
 
 #endif /* ESWEEP_H */
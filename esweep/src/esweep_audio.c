@@ -89,6 +89,7 @@ int esweep_audioPause(esweep_audio *handle) {
 
 int esweep_audioOut(esweep_audio *handle, esweep_object *out[], int channels, int *offset) {
 	u_int i; 
+	unsigned int csr;
 	ESWEEP_ASSERT(handle != NULL, ERR_BAD_ARGUMENT);
         ESWEEP_ASSERT(handle->au_hdl >= 0, ERR_BAD_ARGUMENT);
 	ESWEEP_ASSERT(out != NULL, ERR_OBJ_IS_NULL); 
@@ -100,12 +101,17 @@ int esweep_audioOut(esweep_audio *handle, esweep_object *out[], int channels, in
 		ESWEEP_ASSERT(out[i]->type == WAVE || out[i]->type == COMPLEX, ERR_NOT_ON_THIS_TYPE);
 	}
 
-	ESWEEP_ASSERT((*offset=handle->audio_out((void*) handle, out, channels, *offset)) >= 0, ERR_UNKNOWN);
+	/* the conversion from and to the sample format must not run into denormals */
+	ESWEEP_DENORMAL_ENTER(csr);
+	*offset=handle->audio_out((void*) handle, out, channels, *offset);
+	ESWEEP_DENORMAL_LEAVE(csr);
+	ESWEEP_ASSERT(*offset >= 0, ERR_UNKNOWN);
 	return ERR_OK;
 }
 
 int esweep_audioIn(esweep_audio *handle, esweep_object *in[], int channels, int *offset) {
 	u_int i; 
+	unsigned int csr;
 
 	ESWEEP_ASSERT(handle != NULL, ERR_BAD_ARGUMENT);
         ESWEEP_ASSERT(handle->au_hdl >= 0, ERR_BAD_ARGUMENT);
@@ -117,7 +123,11 @@ int esweep_audioIn(esweep_audio *handle, esweep_object *in[], int channels, int
 		ESWEEP_ASSERT(in[i]->type == WAVE || in[i]->type ==COMPLEX, ERR_NOT_ON_THIS_TYPE);
 	}
 
-	ESWEEP_ASSERT((*offset=handle->audio_in((void*) handle, in, channels, *offset)) >= 0, ERR_UNKNOWN);
+	/* the conversion from and to the sample format must not run into denormals */
+	ESWEEP_DENORMAL_ENTER(csr);
+	*offset=handle->audio_in((void*) handle, in, channels, *offset);
+	ESWEEP_DENORMAL_LEAVE(csr);
+	ESWEEP_ASSERT(*offset >= 0, ERR_UNKNOWN);
 	return ERR_OK;
 }
 
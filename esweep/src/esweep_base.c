@@ -100,7 +100,7 @@ int esweep_setSize(esweep_object *obj, int size) { /* TEST: OK */
 	ESWEEP_ASSERT(obj->type != SURFACE, ERR_NOT_ON_THIS_TYPE);
 
 	if (size == 0) {
-		free(obj->data);
+		__esweep_freeData(obj->data);
 		obj->data=NULL;
 		obj->size=0;
 		return ERR_OK;
@@ -125,7 +125,7 @@ int esweep_setSize(esweep_object *obj, int size) { /* TEST: OK */
 			} else {
 				memcpy(new_data, obj->data, size*samplesize);
 			}
-			free(obj->data);
+			__esweep_freeData(obj->data);
 		}
 		obj->data=new_data;
 		obj->size=size;
@@ -171,7 +171,7 @@ int esweep_buildWave(esweep_object *obj, const Real wave[], int size) { /* TEST:
 	ESWEEP_MALLOC(a, size, sizeof(Wave), ERR_MALLOC);
 
 	memcpy(a, wave, size*sizeof(Wave));
-	free(obj->data);
+	__esweep_freeData(obj->data);
 	obj->data=a;
 	obj->size=size; 
 
@@ -230,7 +230,7 @@ int esweep_buildComplex(esweep_object *obj, const Real real[], const Real imag[]
 		}
 	}
 
-	free(obj->data);
+	__esweep_freeData(obj->data);
 	obj->data=a;
 	obj->size=size; 
 
@@ -290,7 +290,7 @@ int esweep_buildPolar(esweep_object *obj, const Real abs[], const Real arg[], in
 		}
 	}
 
-	free(obj->data);
+	__esweep_freeData(obj->data);
 	obj->data=a;
 	obj->size=size; 
 
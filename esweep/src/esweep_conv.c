@@ -55,13 +55,13 @@ int esweep_toWave(esweep_object *obj) { /* TEST: OK */
 		case COMPLEX:
 			cpx=(Complex*) obj->data;
 			c2r(wave, cpx, obj->size);
-			free(cpx);
+			__esweep_freeData(cpx);
 			obj->data=wave;
 			break;
 		case POLAR:
 			polar=(Polar*) obj->data;
 			abs2r(wave, polar, obj->size);
-			free(polar);
+			__esweep_freeData(polar);
 			obj->data=wave;
 			break;
 		default:
@@ -70,6 +70,7 @@ int esweep_toWave(esweep_object *obj) { /* TEST: OK */
 	}
 
 	obj->type=WAVE;
+	__esweep_reprFree(obj);
 
 	return ERR_OK;
 }
@@ -100,12 +101,16 @@ int esweep_toComplex(esweep_object *obj) { /* TEST: OK */
 		case WAVE:
 			ESWEEP_MALLOC(cpx, obj->size, sizeof(Complex), ERR_MALLOC);
 			wave=(Wave*) obj->data;
-			cpx=(Complex*) calloc(obj->size, sizeof(Complex));
 			r2c(cpx, wave, obj->size);
-			free(wave);
+			__esweep_freeData(wave);
 			obj->data=cpx;
 			break;
 		case POLAR:
+			/*
+			 * Convert into the cache and swap, so the polar data stays available
+			 * for the way back; a valid cache makes this a simple swap
+			 */
+			if (__esweep_reprComplex(obj) != NULL && __esweep_reprSwap(obj)) return ERR_OK;
 			/* Polar and Complex data types have the same internal shape,
 			 * we can convert in-place */
 			polar=(Polar*) obj->data;
@@ -144,6 +149,8 @@ int esweep_toPolar(esweep_object *obj) { /* TEST: OK */
 
 	switch (obj->type) {
 		case COMPLEX:
+			/* see esweep_toComplex() */
+			if (__esweep_reprPolar(obj) != NULL && __esweep_reprSwap(obj)) return ERR_OK;
 			/* Polar and Complex data types have the same internal shape,
 			 * we can convert in-place */
 			cpx=(Complex*) obj->data;
@@ -154,7 +161,7 @@ int esweep_toPolar(esweep_object *obj) { /* TEST: OK */
 			ESWEEP_MALLOC(polar, obj->size, sizeof(Complex), ERR_MALLOC);
 			wave=(Wave*) obj->data;
 			r2p(polar, wave, obj->size);
-			free(wave);
+			__esweep_freeData(wave);
 			obj->data=polar;
 			break;
 		default:
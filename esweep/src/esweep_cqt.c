@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * src/esweep_cqt.c:
+ * Constant Q transform with sparse spectral kernels
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esweep_priv.h"
+#include "fft.h"
+
+/*
+ * The constant Q transform after J. C. Brown and M. S. Puckette, "An efficient algorithm for the
+ * calculation of a constant Q transform", JASA 92(5), 1992.
+ *
+ * Bin k has the frequency f[k]=f1*2^(k/bpo) and a windowed complex exponential of length Q*samplerate/f[k]
+ * as temporal kernel, Q=1/(2^(1/bpo)-1). All kernels are centered in a frame of the FFT size N,
+ * the next power of 2 of the longest kernel. By Parseval, the transform of bin k is
+ *
+ * 	cq[k] = sum x[n]*conj(t[k][n]) = 1/N * sum X[j]*conj(T[k][j])
+ *
+ * The spectral kernels T[k] are concentrated around f[k], only the band where |T[k]| exceeds threshold
+ * times its maximum is kept. Hence a frame costs one real FFT plus a sparse matrix-vector product.
+ *
+ * The kernels depend only on the configuration. They are kept in a cache and shared by all
+ * transforms with the same configuration, reference counted. When the last transform using them
+ * is freed, they stay in the cache, up to CQT_CACHE_UNUSED configurations.
+ */
+
+#define CQT_CACHE_UNUSED 4
+
+typedef struct __cqt_kernel {
+	/* configuration */
+	int samplerate;
+	Real f1, f2;
+	int bpo;
+	int win_type;
+	Real win_param;
+	Real threshold;
+	/* kernels */
+	int bins;
+	int size; /* FFT size N */
+	Real *freq;
+	int *first; /* first FFT bin of the band */
+	int *count; /* number of FFT bins of the band */
+	long *offset; /* offset of the band in values */
+	Complex *values; /* 2/N*conj(T[k][j]), scaled to the amplitude of a sine */
+	Complex *table;
+	Complex *twiddle;
+	int refs;
+	struct __cqt_kernel *next;
+} cqt_kernel;
+
+struct __esweep_cqt {
+	cqt_kernel *kernel;
+	Complex *z;
+	Complex *X;
+	Polar *cq;
+};
+
+static cqt_kernel *cqt_cache=NULL;
+static pthread_mutex_t cqt_lock=PTHREAD_MUTEX_INITIALIZER;
+
+static void __esweep_cqtKernelFree(cqt_kernel *kernel) {
+	free(kernel->freq);
+	free(kernel->first);
+	free(kernel->count);
+	free(kernel->offset);
+	free(kernel->values);
+	free(kernel->table);
+	free(kernel->twiddle);
+	free(kernel);
+}
+
+static cqt_kernel *__esweep_cqtKernel(int samplerate, Real f1, Real f2, int bpo, int win_type, Real win_param, Real threshold) {
+	cqt_kernel *kernel;
+	Complex *t, *table, *values;
+	Real Q, *w, sum, max, re, im;
+	long total;
+	int k, n, j, len, start, half;
+
+	ESWEEP_MALLOC(kernel, 1, sizeof(cqt_kernel), NULL);
+	kernel->samplerate=samplerate;
+	kernel->f1=f1;
+	kernel->f2=f2;
+	kernel->bpo=bpo;
+	kernel->win_type=win_type;
+	kernel->win_param=win_param;
+	kernel->threshold=threshold;
+
+	Q=1.0/(pow(2.0, 1.0/bpo)-1.0);
+	kernel->bins=(int) floor(bpo*log2(f2/f1)+1e-9)+1;
+	len=(int) ceil(Q*samplerate/f1);
+	for (kernel->size=4; kernel->size < len; kernel->size*=2);
+	half=kernel->size/2;
+	if (kernel->size > ESWEEP_MAX_SIZE) {
+		free(kernel);
+		ESWEEP_ASSERT(0, NULL);
+	}
+
+	ESWEEP_MALLOC(kernel->freq, kernel->bins, sizeof(Real), NULL);
+	ESWEEP_MALLOC(kernel->first, kernel->bins, sizeof(int), NULL);
+	ESWEEP_MALLOC(kernel->count, kernel->bins, sizeof(int), NULL);
+	ESWEEP_MALLOC(kernel->offset, kernel->bins+1, sizeof(long), NULL);
+	ESWEEP_MALLOC(t, kernel->size, sizeof(Complex), NULL);
+	ESWEEP_MALLOC(w, kernel->size, sizeof(Real), NULL);
+	table=fft_create_table(kernel->size);
+	values=NULL;
+
+	for (k=0, total=0; k < kernel->bins; k++) {
+		kernel->freq[k]=f1*pow(2.0, (Real) k/bpo);
+		len=(int) ceil(Q*samplerate/kernel->freq[k]);
+		if (len > kernel->size) len=kernel->size;
+		start=(kernel->size-len)/2;
+
+		/* temporal kernel, centered in the frame */
+		for (n=0; n < len; n++) w[n]=1.0;
+		window_ext(w, 0, len/2, WIN_LEFT, win_type, win_param);
+		window_ext(w, len/2, len, WIN_RIGHT, win_type, win_param);
+		for (n=0, sum=0.0; n < len; n++) sum+=w[n];
+		memset(t, 0, kernel->size*sizeof(Complex));
+		for (n=0; n < len; n++) {
+			t[start+n].real=w[n]/sum*cos(2*M_PI*kernel->freq[k]*n/samplerate);
+			t[start+n].imag=w[n]/sum*sin(2*M_PI*kernel->freq[k]*n/samplerate);
+		}
+		fft(t, table, kernel->size, FFT_FORWARD);
+
+		/* the band above the threshold, positive frequencies only */
+		for (j=0, max=0.0; j <= half; j++) {
+			if (t[j].real*t[j].real+t[j].imag*t[j].imag > max) max=t[j].real*t[j].real+t[j].imag*t[j].imag;
+		}
+		max*=threshold*threshold;
+		for (j=0; j < half && t[j].real*t[j].real+t[j].imag*t[j].imag < max; j++);
+		kernel->first[k]=j;
+		for (j=half; j > kernel->first[k] && t[j].real*t[j].real+t[j].imag*t[j].imag < max; j--);
+		kernel->count[k]=j-kernel->first[k]+1;
+		kernel->offset[k]=total;
+		total+=kernel->count[k];
+
+		values=(Complex*) realloc(values, total*sizeof(Complex));
+		if (values == NULL) break;
+		/* cq = 1/N*sum X*conj(T), times 2 for the amplitude of a real sine */
+		for (j=0; j < kernel->count[k]; j++) {
+			re=t[kernel->first[k]+j].real;
+			im=t[kernel->first[k]+j].imag;
+			values[kernel->offset[k]+j].real=2*re/kernel->size;
+			values[kernel->offset[k]+j].imag=-2*im/kernel->size;
+		}
+	}
+	kernel->offset[kernel->bins]=total;
+	kernel->values=values;
+	free(t);
+	free(w);
+	free(table);
+	if (values == NULL) {
+		__esweep_cqtKernelFree(kernel);
+		ESWEEP_ASSERT(0, NULL);
+	}
+
+	kernel->table=fft_create_table(half);
+	kernel->twiddle=fft_create_real_table(kernel->size);
+	kernel->refs=0;
+	kernel->next=NULL;
+	return kernel;
+}
+
+esweep_cqt *esweep_cqtCreate(int samplerate, Real f1, Real f2, int bpo, const char *win_name, Real threshold) {
+	esweep_cqt *cqt;
+	cqt_kernel *kernel;
+	int win_type=WIN_HANN;
+	Real win_param=0.0;
+
+	ESWEEP_ASSERT(samplerate > 0, NULL);
+	ESWEEP_ASSERT(f1 > 0 && f2 >= f1 && 2*f2 < samplerate, NULL);
+	ESWEEP_ASSERT(bpo >= 1, NULL);
+	ESWEEP_ASSERT(threshold >= 0 && threshold < 1, NULL);
+	if (win_name != NULL) {
+		win_type=window_parse(win_name, &win_param);
+		ESWEEP_ASSERT(win_type != WIN_NOWIN, NULL);
+	}
+
+	/* look for the kernels in the cache */
+	pthread_mutex_lock(&cqt_lock);
+	for (kernel=cqt_cache; kernel != NULL; kernel=kernel->next) {
+		if (kernel->samplerate == samplerate && kernel->f1 == f1 && kernel->f2 == f2 && kernel->bpo == bpo
+				&& kernel->win_type == win_type && kernel->win_param == win_param && kernel->threshold == threshold) break;
+	}
+	if (kernel == NULL && (kernel=__esweep_cqtKernel(samplerate, f1, f2, bpo, win_type, win_param, threshold)) != NULL) {
+		kernel->next=cqt_cache;
+		cqt_cache=kernel;
+	}
+	if (kernel != NULL) kernel->refs++;
+	pthread_mutex_unlock(&cqt_lock);
+	ESWEEP_ASSERT(kernel != NULL, NULL);
+
+	ESWEEP_MALLOC(cqt, 1, sizeof(esweep_cqt), NULL);
+	cqt->kernel=kernel;
+	ESWEEP_MALLOC(cqt->z, kernel->size/2, sizeof(Complex), NULL);
+	ESWEEP_MALLOC(cqt->X, kernel->size/2+1, sizeof(Complex), NULL);
+	ESWEEP_MALLOC(cqt->cq, kernel->bins, sizeof(Polar), NULL);
+	return cqt;
+}
+
+int esweep_cqtInfo(const esweep_cqt *cqt, int *bins, int *size, Real *freq) {
+	ESWEEP_ASSERT(cqt != NULL, ERR_BAD_ARGUMENT);
+	if (bins != NULL) *bins=cqt->kernel->bins;
+	if (size != NULL) *size=cqt->kernel->size;
+	if (freq != NULL) memcpy(freq, cqt->kernel->freq, cqt->kernel->bins*sizeof(Real));
+	return ERR_OK;
+}
+
+/* transform of the frame starting at sample start, into cqt->cq */
+static int __esweep_cqtFrame(esweep_cqt *cqt, const esweep_object *in, int start) {
+	const cqt_kernel *kernel=cqt->kernel;
+	const Complex *K, *X=cqt->X;
+	const Complex *cpx;
+	const Real *wave;
+	double re, im;
+	Real x;
+	int i, j, k, n, half=kernel->size/2;
+
+	ESWEEP_OBJ_NOTEMPTY(in, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(in->type == WAVE || in->type == COMPLEX, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_ASSERT(in->samplerate == kernel->samplerate, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(start >= 0, ERR_BAD_ARGUMENT);
+
+	/* the frame, zero padded after the end of the input */
+	wave=(const Real*) in->data;
+	cpx=(const Complex*) in->data;
+	memset(cqt->z, 0, half*sizeof(Complex));
+	n=in->size-start < kernel->size ? in->size-start : kernel->size;
+	for (i=0; i < n; i++) {
+		x=in->type == WAVE ? wave[start+i] : cpx[start+i].real;
+		if (i & 1) cqt->z[i/2].imag=x;
+		else cqt->z[i/2].real=x;
+	}
+	fft_real(cqt->X, cqt->z, kernel->table, kernel->twiddle, kernel->size);
+
+	/* sparse matrix-vector product */
+	for (k=0; k < kernel->bins; k++) {
+		K=kernel->values+kernel->offset[k];
+		X=cqt->X+kernel->first[k];
+		for (j=0, re=0.0, im=0.0; j < kernel->count[k]; j++) {
+			re+=X[j].real*K[j].real-X[j].imag*K[j].imag;
+			im+=X[j].real*K[j].imag+X[j].imag*K[j].real;
+		}
+		cqt->cq[k].abs=sqrt(re*re+im*im);
+		cqt->cq[k].arg=atan2(im, re);
+	}
+	return ERR_OK;
+}
+
+int esweep_cqtAnalyze(esweep_cqt *cqt, const esweep_object *in, int start, esweep_object *out) {
+	Polar *polar;
+
+	ESWEEP_ASSERT(cqt != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(out != NULL, ERR_EMPTY_OBJECT);
+	if (__esweep_cqtFrame(cqt, in, start) != ERR_OK) return ERR_BAD_ARGUMENT;
+
+	/* reallocate the output only if necessary */
+	if (out->type != POLAR || out->size != cqt->kernel->bins) {
+		ESWEEP_MALLOC(polar, cqt->kernel->bins, sizeof(Polar), ERR_MALLOC);
+		__esweep_freeData(out->data);
+		out->data=polar;
+		out->type=POLAR;
+		out->size=cqt->kernel->bins;
+	}
+	out->samplerate=cqt->kernel->samplerate;
+	memcpy(out->data, cqt->cq, cqt->kernel->bins*sizeof(Polar));
+	return ERR_OK;
+}
+
+int esweep_cqtSurface(esweep_cqt *cqt, const esweep_object *in, int start, esweep_object *out, int row) {
+	Surface *surf;
+	int k;
+
+	ESWEEP_ASSERT(cqt != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_OBJ_NOTEMPTY(out, ERR_EMPTY_OBJECT);
+	surf=(Surface*) out->data;
+	ESWEEP_OBJ_ISVALID_SURFACE(out, surf, ERR_NOT_ON_THIS_TYPE, ERR_OBJ_NOT_VALID);
+	ESWEEP_ASSERT(surf->xsize == cqt->kernel->bins, ERR_SIZE_MISMATCH);
+	ESWEEP_ASSERT(row >= 0 && row < surf->ysize, ERR_BAD_ARGUMENT);
+	if (__esweep_cqtFrame(cqt, in, start) != ERR_OK) return ERR_BAD_ARGUMENT;
+
+	/* x is the frequency, y the time of the center of the frame */
+	memcpy(surf->x, cqt->kernel->freq, surf->xsize*sizeof(Real));
+	surf->y[row]=(start+0.5*cqt->kernel->size)/cqt->kernel->samplerate;
+	for (k=0; k < surf->xsize; k++) surf->z[k+row*surf->xsize]=cqt->cq[k].abs;
+	out->samplerate=cqt->kernel->samplerate;
+	return ERR_OK;
+}
+
+int esweep_cqtFree(esweep_cqt *cqt) {
+	cqt_kernel **p, *kernel;
+	int unused;
+
+	ESWEEP_ASSERT(cqt != NULL, ERR_BAD_ARGUMENT);
+	pthread_mutex_lock(&cqt_lock);
+	if (--cqt->kernel->refs == 0) {
+		/* move the kernels to the front of the cache */
+		for (p=&cqt_cache; *p != cqt->kernel; p=&(*p)->next);
+		*p=cqt->kernel->next;
+		cqt->kernel->next=cqt_cache;
+		cqt_cache=cqt->kernel;
+		/* free the least recently used unused kernels */
+		for (p=&cqt_cache, unused=0; *p != NULL; ) {
+			kernel=*p;
+			if (kernel->refs == 0 && ++unused > CQT_CACHE_UNUSED) {
+				*p=kernel->next;
+				__esweep_cqtKernelFree(kernel);
+			} else {
+				p=&kernel->next;
+			}
+		}
+	}
+	pthread_mutex_unlock(&cqt_lock);
+	free(cqt->z);
+	free(cqt->X);
+	free(cqt->cq);
+	free(cqt);
+	return ERR_OK;
+}
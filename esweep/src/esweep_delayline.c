@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * src/esweep_delayline.c:
+ * Multichannel delay line with fractional delays
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esweep_priv.h"
+
+#if defined(__SSE2__) && !defined(REAL32)
+#include <emmintrin.h>
+#elif defined(__SSE__) && defined(REAL32)
+#include <xmmintrin.h>
+#endif
+
+/*
+ * The signal is processed in blocks of at most DELAY_BLOCK samples. Each block is
+ * first written into the ring buffer of the channel and then read back with the delay.
+ * The ring buffer has a size of a power of two, so the index is wrapped with a mask. Each sample is written
+ * twice, at pos and at pos+size. Hence, all samples needed for a block are contiguous in memory,
+ * and the interpolation of a block with constant delay is a 4-tap FIR filter.
+ *
+ * The fractional part is interpolated with a 3rd order Lagrange interpolator in Farrow structure.
+ * The taps are y0=x[n-i+1], y1=x[n-i], y2=x[n-i-1], y3=x[n-i-2] for the delay D=i+f.
+ * Because x[n+1] is not available for delays below 1 sample, these are interpolated linearly.
+ */
+#define DELAY_BLOCK 256
+
+struct __esweep_delayLine {
+	int samplerate;
+	int channels;
+	Real max_delay;
+	/* size of the ring buffers, power of two */
+	int size;
+	int mask;
+	/* write position */
+	int pos;
+	/* ring buffers, 2*size samples per channel */
+	Real *buf;
+	/* current and target delay, increment per sample and remaining samples of a delay ramp */
+	Real *delay;
+	Real *target;
+	Real *step;
+	int *ramp;
+};
+
+/* interpolation coefficients for the taps y0..y3 */
+static inline void coefficients(Real delay, Real h[4]) {
+	int i=(int) delay;
+	Real f=delay-i;
+
+	if (i < 1) {
+		h[0]=0.0;
+		h[1]=1.0-f;
+		h[2]=f;
+		h[3]=0.0;
+	} else {
+		/* Farrow structure: every tap is a polynomial in f */
+		h[0]=f*(-1.0/3.0+f*(0.5-f/6.0));
+		h[1]=1.0+f*(-0.5+f*(-1.0+f*0.5));
+		h[2]=f*(1.0+f*(0.5-f*0.5));
+		h[3]=f*(-1.0/6.0+f*f/6.0);
+	}
+}
+
+/* out[k]=h[3]*in[k]+h[2]*in[k+1]+h[1]*in[k+2]+h[0]*in[k+3] */
+static inline void fir4(Real *out, const Real *in, const Real h[4], int n) {
+	int k=0;
+#if defined(__SSE2__) && !defined(REAL32)
+	__m128d h0=_mm_set1_pd(h[0]), h1=_mm_set1_pd(h[1]), h2=_mm_set1_pd(h[2]), h3=_mm_set1_pd(h[3]);
+	__m128d acc;
+	for (; k+2 <= n; k+=2) {
+		acc=_mm_mul_pd(h3, _mm_loadu_pd(in+k));
+		acc=_mm_add_pd(acc, _mm_mul_pd(h2, _mm_loadu_pd(in+k+1)));
+		acc=_mm_add_pd(acc, _mm_mul_pd(h1, _mm_loadu_pd(in+k+2)));
+		acc=_mm_add_pd(acc, _mm_mul_pd(h0, _mm_loadu_pd(in+k+3)));
+		_mm_storeu_pd(out+k, acc);
+	}
+#elif defined(__SSE__) && defined(REAL32)
+	__m128 h0=_mm_set1_ps(h[0]), h1=_mm_set1_ps(h[1]), h2=_mm_set1_ps(h[2]), h3=_mm_set1_ps(h[3]);
+	__m128 acc;
+	for (; k+4 <= n; k+=4) {
+		acc=_mm_mul_ps(h3, _mm_loadu_ps(in+k));
+		acc=_mm_add_ps(acc, _mm_mul_ps(h2, _mm_loadu_ps(in+k+1)));
+		acc=_mm_add_ps(acc, _mm_mul_ps(h1, _mm_loadu_ps(in+k+2)));
+		acc=_mm_add_ps(acc, _mm_mul_ps(h0, _mm_loadu_ps(in+k+3)));
+		_mm_storeu_ps(out+k, acc);
+	}
+#endif
+	for (; k < n; k++) {
+		out[k]=h[3]*in[k]+h[2]*in[k+1]+h[1]*in[k+2]+h[0]*in[k+3];
+	}
+}
+
+esweep_delayLine *esweep_delayLineCreate(int samplerate, int channels, Real max_delay) {
+	esweep_delayLine *line;
+	int size;
+
+	ESWEEP_ASSERT(samplerate > 0, NULL);
+	ESWEEP_ASSERT(channels > 0 && channels <= ESWEEP_MAX_CHANNELS, NULL);
+	ESWEEP_ASSERT(max_delay >= 0.0 && max_delay < ESWEEP_MAX_SIZE, NULL);
+
+	/* the taps reach 2 samples beyond the delay, and a whole block is written before reading */
+	for (size=1; size < (int) ceil(max_delay)+3+DELAY_BLOCK; size<<=1);
+
+	ESWEEP_MALLOC(line, 1, sizeof(esweep_delayLine), NULL);
+	line->samplerate=samplerate;
+	line->channels=channels;
+	line->max_delay=max_delay;
+	line->size=size;
+	line->mask=size-1;
+	line->pos=0;
+	ESWEEP_MALLOC(line->buf, 2*size*channels, sizeof(Real), NULL);
+	ESWEEP_MALLOC(line->delay, channels, sizeof(Real), NULL);
+	ESWEEP_MALLOC(line->target, channels, sizeof(Real), NULL);
+	ESWEEP_MALLOC(line->step, channels, sizeof(Real), NULL);
+	ESWEEP_MALLOC(line->ramp, channels, sizeof(int), NULL);
+
+	return line;
+}
+
+int esweep_delayLineSet(esweep_delayLine *line, int channel, Real delay, int ramp) {
+	int c, first, last;
+
+	ESWEEP_ASSERT(line != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(channel >= -1 && channel < line->channels, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(delay >= 0.0 && delay <= line->max_delay, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(ramp >= 0, ERR_BAD_ARGUMENT);
+
+	if (channel < 0) {
+		first=0;
+		last=line->channels-1;
+	} else {
+		first=last=channel;
+	}
+
+	for (c=first; c <= last; c++) {
+		line->target[c]=delay;
+		if (ramp == 0) {
+			line->delay[c]=delay;
+			line->ramp[c]=0;
+		} else {
+			/* glide from the current delay; a running ramp is continued from where it is */
+			line->step[c]=(delay-line->delay[c])/ramp;
+			line->ramp[c]=ramp;
+		}
+	}
+
+	return ERR_OK;
+}
+
+int esweep_delayLineGet(const esweep_delayLine *line, int channel, Real *delay) {
+	ESWEEP_ASSERT(line != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(channel >= 0 && channel < line->channels, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(delay != NULL, ERR_BAD_ARGUMENT);
+
+	*delay=line->delay[channel];
+	return ERR_OK;
+}
+
+int esweep_delayLineProcess(esweep_delayLine *line, esweep_object *signal[], int channels) {
+	int c, k, j, i, n, offset, size;
+	Real *x, *b, h[4];
+	Real delay;
+
+	ESWEEP_ASSERT(line != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(signal != NULL, ERR_OBJ_IS_NULL);
+	ESWEEP_ASSERT(channels == line->channels, ERR_BAD_ARGUMENT);
+	for (c=0; c < channels; c++) {
+		ESWEEP_OBJ_NOTEMPTY(signal[c], ERR_EMPTY_OBJECT);
+		ESWEEP_ASSERT(signal[c]->type == WAVE, ERR_NOT_ON_THIS_TYPE);
+		ESWEEP_ASSERT(signal[c]->samplerate == line->samplerate, ERR_DIFF_MAPPING);
+		ESWEEP_ASSERT(signal[c]->size == signal[0]->size, ERR_SIZE_MISMATCH);
+	}
+
+	size=signal[0]->size;
+	for (offset=0; offset < size; offset+=n) {
+		n=size-offset < DELAY_BLOCK ? size-offset : DELAY_BLOCK;
+		for (c=0; c < channels; c++) {
+			x=(Real*) signal[c]->data+offset;
+			b=line->buf+2*c*line->size;
+
+			/* write the block */
+			for (k=0; k < n; k++) {
+				j=(line->pos+k) & line->mask;
+				b[j]=b[j+line->size]=x[k];
+			}
+
+			if (line->ramp[c] == 0) {
+				/* constant delay */
+				delay=line->delay[c];
+				i=(int) delay;
+				coefficients(delay, h);
+				fir4(x, b+((line->pos-i-2) & line->mask), h, n);
+			} else {
+				/* delay ramp, calculate the coefficients for each sample */
+				for (k=0; k < n; k++) {
+					if (line->ramp[c] > 0) {
+						line->ramp[c]--;
+						line->delay[c]=line->ramp[c] == 0 ? line->target[c] : line->delay[c]+line->step[c];
+					}
+					delay=line->delay[c];
+					i=(int) delay;
+					coefficients(delay, h);
+					j=(line->pos+k-i-2) & line->mask;
+					x[k]=h[3]*b[j]+h[2]*b[j+1]+h[1]*b[j+2]+h[0]*b[j+3];
+				}
+			}
+		}
+		line->pos=(line->pos+n) & line->mask;
+	}
+
+	return ERR_OK;
+}
+
+int esweep_delayLineReset(esweep_delayLine *line) {
+	ESWEEP_ASSERT(line != NULL, ERR_BAD_ARGUMENT);
+	memset(line->buf, 0, 2*line->size*line->channels*sizeof(Real));
+	line->pos=0;
+	return ERR_OK;
+}
+
+int esweep_delayLineFree(esweep_delayLine *line) {
+	ESWEEP_ASSERT(line != NULL, ERR_BAD_ARGUMENT);
+	free(line->buf);
+	free(line->delay);
+	free(line->target);
+	free(line->step);
+	free(line->ramp);
+	free(line);
+	return ERR_OK;
+}
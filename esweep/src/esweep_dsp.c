@@ -15,6 +15,7 @@
  */
 
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -24,6 +25,10 @@
 #include "dsp.h"
 #include "fft.h"
 
+#if defined(__SSE2__) && !defined(REAL32)
+#include <emmintrin.h>
+#endif
+
 /*
  * src/esweep_dsp.c:
  * Various DSP functions
@@ -69,7 +74,7 @@ int esweep_fft(esweep_object *out, esweep_object *in, esweep_object *table) {
 				default: /* any other case should have been handled by the switch-statement above */
 					break;
 			}
-			free(in->data);
+			__esweep_freeData(in->data);
 			in->size=fft_size; 
 			in->data=cpx;
 			in->type=COMPLEX;
@@ -78,7 +83,7 @@ int esweep_fft(esweep_object *out, esweep_object *in, esweep_object *table) {
 		switch (out->type) {
 			case SURFACE: /* Fallthrough */
 			case WAVE:
-				free(out->data);
+				__esweep_freeData(out->data);
 				out->size=fft_size;
 				out->type=COMPLEX;
 				ESWEEP_MALLOC(out->data, fft_size, sizeof(Complex), ERR_MALLOC);
@@ -93,7 +98,7 @@ int esweep_fft(esweep_object *out, esweep_object *in, esweep_object *table) {
 				 * possibilities, e. g. during linear convolution.
 				 */
 				if (out->size < fft_size) {
-					free(out->data);
+					__esweep_freeData(out->data);
 					out->size=fft_size;
 					ESWEEP_MALLOC(out->data, fft_size, sizeof(Complex), ERR_MALLOC);
 				} else {
@@ -177,7 +182,7 @@ int esweep_ifft(esweep_object *out, esweep_object *in, esweep_object *table) {
 				default: /* any other case should be handled by the switch-statement above */
 					break;
 			}
-			free(in->data);
+			__esweep_freeData(in->data);
 			in->size=fft_size; 
 			in->data=cpx;
 			in->type=COMPLEX;
@@ -186,7 +191,7 @@ int esweep_ifft(esweep_object *out, esweep_object *in, esweep_object *table) {
 		switch (out->type) {
 			case SURFACE: /* Fallthrough */
 			case WAVE:
-				free(out->data);
+				__esweep_freeData(out->data);
 				out->size=fft_size;
 				out->type=COMPLEX;
 				ESWEEP_MALLOC(out->data, fft_size, sizeof(Complex), ERR_MALLOC);
@@ -201,7 +206,7 @@ int esweep_ifft(esweep_object *out, esweep_object *in, esweep_object *table) {
 				 * possibilities, e. g. during linear convolution.
 				 */
 				if (out->size < fft_size) {
-					free(out->data);
+					__esweep_freeData(out->data);
 					out->size=fft_size;
 					ESWEEP_MALLOC(out->data, fft_size, sizeof(Complex), ERR_MALLOC);
 				} else {
@@ -256,7 +261,7 @@ int esweep_createFFTTable(esweep_object *table, int fft_size) {
 	int size;
 
 	ESWEEP_OBJ_ISVALID(table, ERR_OBJ_NOT_VALID);
-	if (table->data!=NULL) free(table->data);
+	if (table->data!=NULL) __esweep_freeData(table->data);
 
 	if (fft_size <= 0) size = table->size;
 	else size=fft_size; 
@@ -279,7 +284,7 @@ if "filter" is COMPLEX it is assumed as pre-transformed
 this saves 1 FFT hence gives a speed-up
 */
 
-int esweep_convolve(esweep_object *in, esweep_object *filter, esweep_object *table) {
+static int __esweep_convolve(esweep_object *in, esweep_object *filter, esweep_object *table) {
 	Complex *cpx, *complex_filter=NULL, *fft_table;
 	int fft_size;
 	int i;
@@ -323,7 +328,7 @@ int esweep_convolve(esweep_object *in, esweep_object *filter, esweep_object *tab
 			/* The input must be transformed */
 			ESWEEP_MALLOC(cpx, fft_size, sizeof(Complex), ERR_MALLOC);
 			fft_rc(cpx, (Wave*) (in->data), fft_table, in->size, fft_size, FFT_FORWARD);
-			free(in->data);
+			__esweep_freeData(in->data);
 			in->data=cpx;
 			in->type=COMPLEX;
 			in->size=fft_size;
@@ -333,7 +338,7 @@ int esweep_convolve(esweep_object *in, esweep_object *filter, esweep_object *tab
 			if (fft_size != in->size) {
 				ESWEEP_MALLOC(cpx, fft_size, sizeof(Complex), ERR_MALLOC);
 				fft_cc(cpx, (Complex*) (in->data), fft_table, in->size, fft_size, FFT_FORWARD);
-				free(in->data);
+				__esweep_freeData(in->data);
 				in->data=cpx;
 				in->size=fft_size;
 			} else {
@@ -374,7 +379,7 @@ int esweep_convolve(esweep_object *in, esweep_object *filter, esweep_object *tab
 fast _linear_ deconvolution
 see esweep_convolve
 */
-int esweep_deconvolve(esweep_object *in, esweep_object *filter, esweep_object *table) {
+static int __esweep_deconvolve(esweep_object *in, esweep_object *filter, esweep_object *table) {
 	Complex *cpx, *complex_filter=NULL, *fft_table;
 	int fft_size;
 	int i;
@@ -418,7 +423,7 @@ int esweep_deconvolve(esweep_object *in, esweep_object *filter, esweep_object *t
 			/* The input must be transformed */
 			ESWEEP_MALLOC(cpx, fft_size, sizeof(Complex), ERR_MALLOC);
 			fft_rc(cpx, (Wave*) (in->data), fft_table, in->size, fft_size, FFT_FORWARD);
-			free(in->data);
+			__esweep_freeData(in->data);
 			in->data=cpx;
 			in->type=COMPLEX;
 			in->size=fft_size;
@@ -428,7 +433,7 @@ int esweep_deconvolve(esweep_object *in, esweep_object *filter, esweep_object *t
 			if (fft_size != in->size) {
 				ESWEEP_MALLOC(cpx, fft_size, sizeof(Complex), ERR_MALLOC);
 				fft_cc(cpx, (Complex*) (in->data), fft_table, in->size, fft_size, FFT_FORWARD);
-				free(in->data);
+				__esweep_freeData(in->data);
 				in->data=cpx;
 				in->size=fft_size;
 			} else {
@@ -465,6 +470,30 @@ int esweep_deconvolve(esweep_object *in, esweep_object *filter, esweep_object *t
 	return ERR_OK;
 }
 
+/*
+ * The decaying tails of long convolutions produce denormals,
+ * so both run with the denormal policy of the library
+ */
+int esweep_convolve(esweep_object *in, esweep_object *filter, esweep_object *table) {
+	int ret;
+	unsigned int csr;
+
+	ESWEEP_DENORMAL_ENTER(csr);
+	ret=__esweep_convolve(in, filter, table);
+	ESWEEP_DENORMAL_LEAVE(csr);
+	return ret;
+}
+
+int esweep_deconvolve(esweep_object *in, esweep_object *filter, esweep_object *table) {
+	int ret;
+	unsigned int csr;
+
+	ESWEEP_DENORMAL_ENTER(csr);
+	ret=__esweep_deconvolve(in, filter, table);
+	ESWEEP_DENORMAL_LEAVE(csr);
+	return ret;
+}
+
 /* delay line with a ringbuffer scheme */
 int esweep_delay(esweep_object *signal, esweep_object *line, int *offset) {
 	Complex *cpx_sig, *cpx_line; 
@@ -538,7 +567,7 @@ int esweep_hilbert(esweep_object *obj, esweep_object *table) {
 		case WAVE:
 			ESWEEP_MALLOC(complex, fft_size, sizeof(Complex), ERR_MALLOC);
 			r2c(complex, (Wave*) obj->data, obj->size);
-			free(obj->data);
+			__esweep_freeData(obj->data);
 			obj->size=fft_size;
 			obj->type=COMPLEX;
 			obj->data=complex;
@@ -574,7 +603,7 @@ int esweep_analytic(esweep_object *obj, esweep_object *table) {
 			fft_size=(int) (pow(2, ceil(log(obj->size)/log(2)))+0.5);
 			ESWEEP_MALLOC(analytic, fft_size, sizeof(Complex), ERR_MALLOC);
 			r2c(analytic, (Wave*) obj->data, obj->size);
-			free(obj->data);
+			__esweep_freeData(obj->data);
 			obj->size=fft_size;
 			obj->type=COMPLEX;
 			obj->data=analytic;
@@ -606,6 +635,158 @@ int esweep_analytic(esweep_object *obj, esweep_object *table) {
 }
 #endif
 
+/*
+ * FFT plans for esweep_envelope(). A plan is taken out of the pool while it is in use, so concurrent calls
+ * never share the buffers, and put back afterwards. Only the ENVELOPE_PLANS most recently used plans are kept.
+ */
+
+#define ENVELOPE_PLANS 4
+#define ENVELOPE_FLOOR 1e-30 /* -300 dB */
+
+typedef struct __envelope_plan {
+	int size; /* N, power of 2 */
+	Complex *z; /* N/2 */
+	Complex *X; /* N/2+1 */
+	Complex *table;
+	Complex *twiddle;
+	struct __envelope_plan *next;
+} envelope_plan;
+
+static envelope_plan *envelope_pool=NULL;
+static pthread_mutex_t envelope_lock=PTHREAD_MUTEX_INITIALIZER;
+
+static void __esweep_envelopeFreePlan(envelope_plan *plan) {
+	free(plan->z);
+	free(plan->X);
+	free(plan->table);
+	free(plan->twiddle);
+	free(plan);
+}
+
+static envelope_plan *__esweep_envelopeGetPlan(int size) {
+	envelope_plan *plan, **p;
+
+	pthread_mutex_lock(&envelope_lock);
+	for (p=&envelope_pool; *p != NULL && (*p)->size != size; p=&(*p)->next);
+	plan=*p;
+	if (plan != NULL) *p=plan->next;
+	pthread_mutex_unlock(&envelope_lock);
+	if (plan != NULL) return plan;
+
+	if ((plan=(envelope_plan*) calloc(1, sizeof(envelope_plan))) == NULL) return NULL;
+	plan->size=size;
+	plan->z=(Complex*) calloc(size/2, sizeof(Complex));
+	plan->X=(Complex*) calloc(size/2+1, sizeof(Complex));
+	plan->table=fft_create_table(size/2);
+	plan->twiddle=fft_create_real_table(size);
+	if (plan->z == NULL || plan->X == NULL || plan->table == NULL || plan->twiddle == NULL) {
+		__esweep_envelopeFreePlan(plan);
+		return NULL;
+	}
+	return plan;
+}
+
+static void __esweep_envelopePutPlan(envelope_plan *plan) {
+	envelope_plan *p;
+	int n;
+
+	pthread_mutex_lock(&envelope_lock);
+	plan->next=envelope_pool;
+	envelope_pool=plan;
+	for (p=envelope_pool, n=1; p->next != NULL && n < ENVELOPE_PLANS; p=p->next, n++);
+	plan=p->next;
+	p->next=NULL;
+	pthread_mutex_unlock(&envelope_lock);
+
+	for (; plan != NULL; plan=p) {
+		p=plan->next;
+		__esweep_envelopeFreePlan(plan);
+	}
+}
+
+/*
+ * The Hilbert transform h of the signal x is the inverse FFT of -i*sign(k)*X[k]. Because h is real, this is done
+ * with the real inverse FFT, so the analytic signal x+i*h costs two FFTs of size N/2.
+ */
+int esweep_envelope(esweep_object *obj, const char *mode) {
+	envelope_plan *plan;
+	Wave *wave;
+	Complex *z, *X;
+	Real re, im, p_re=0.0, p_im=0.0, scale, f_scale;
+	int i, k, N, half, type;
+
+	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(obj->type == WAVE, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_ASSERT(mode != NULL, ERR_BAD_ARGUMENT);
+
+	if (strcmp(mode, "magnitude") == 0) type=0;
+	else if (strcmp(mode, "etc") == 0) type=1;
+	else if (strcmp(mode, "phase") == 0) type=2;
+	else if (strcmp(mode, "frequency") == 0) type=3;
+	else ESWEEP_ASSERT(0, ERR_BAD_ARGUMENT);
+
+	for (N=4; N < obj->size; N*=2);
+	half=N/2;
+	ESWEEP_ASSERT((plan=__esweep_envelopeGetPlan(N)) != NULL, ERR_MALLOC);
+	z=plan->z;
+	X=plan->X;
+	wave=(Wave*) obj->data;
+
+	/* zero padded */
+	for (k=0; 2*k+1 < obj->size; k++) {
+		z[k].real=wave[2*k];
+		z[k].imag=wave[2*k+1];
+	}
+	if (2*k < obj->size) {
+		z[k].real=wave[2*k];
+		z[k++].imag=0.0;
+	}
+	for (; k < half; k++) z[k].real=z[k].imag=0.0;
+	fft_real(X, z, plan->table, plan->twiddle, N);
+
+	/* -i*X[k] for the positive frequencies, DC and Nyquist vanish */
+	X[0].real=X[0].imag=X[half].real=X[half].imag=0.0;
+	for (k=1; k < half; k++) {
+		re=X[k].real;
+		X[k].real=X[k].imag;
+		X[k].imag=-re;
+	}
+	fft_real_inverse(z, X, plan->table, plan->twiddle, N);
+
+	/* z[k]=N*(h[2k]+i*h[2k+1]) */
+	scale=1.0/N;
+	f_scale=obj->samplerate/(2*M_PI);
+	for (i=0; i < obj->size; i++) {
+		re=wave[i];
+		im=scale*(i & 1 ? z[i/2].imag : z[i/2].real);
+		switch (type) {
+			case 0:
+				wave[i]=sqrt(re*re+im*im);
+				break;
+			case 1:
+				wave[i]=10.0*log10(re*re+im*im > ENVELOPE_FLOOR ? re*re+im*im : ENVELOPE_FLOOR);
+				break;
+			case 2:
+				wave[i]=atan2(im, re);
+				break;
+			case 3:
+				/* the phase difference to the previous sample, without unwrapping */
+				if (i > 0) wave[i]=f_scale*atan2(im*p_re-re*p_im, re*p_re+im*p_im);
+				p_re=re;
+				p_im=im;
+				break;
+		}
+	}
+	/* the first sample has no predecessor, use the difference to the next one */
+	if (type == 3) {
+		if (obj->size > 1) wave[0]=wave[1];
+		else wave[0]=0.0;
+	}
+
+	__esweep_envelopePutPlan(plan);
+	return ERR_OK;
+}
+
 /* time integration implemented as an IIR-Filter
 
 WAVE: simple accumulation
@@ -912,50 +1093,255 @@ int esweep_gDelayToPhase(esweep_object *obj) {
 #endif
 /*
 smooth magnitude and argument of "a" in the range Octave/factor
-only POLAR
+POLAR and COMPLEX
+
+Bin i is the average of the bins round(i-i/(4*factor))..round(i+i/(2*factor)).
+The averages are differences of prefix sums, hence each bin costs O(1) regardless of the factor.
 */
 
+#define SMOOTH_MAGNITUDE 0 /* average magnitude and unwrapped phase */
+#define SMOOTH_POWER 1 /* average squared magnitude and unwrapped phase */
+#define SMOOTH_COMPLEX 2 /* average real and imaginary part */
+
+static int __esweep_smoothMode(const char *mode) {
+	if (mode == NULL || strcmp(mode, "magnitude") == 0) return SMOOTH_MAGNITUDE;
+	if (strcmp(mode, "power") == 0) return SMOOTH_POWER;
+	if (strcmp(mode, "complex") == 0) return SMOOTH_COMPLEX;
+	return -1;
+}
+
+/*
+ * Prefix sums over the bins 0..size/2 of obj: sum[i] is the sum of the bins 0..i-1.
+ * Always double precision, the unwrapped phase may grow large.
+ */
+static int __esweep_smoothSums(esweep_object *obj, int mode, double **sum1, double **sum2) {
+	Polar *polar=(Polar*) obj->data;
+	Complex *cpx=(Complex*) obj->data;
+	int herm_size=obj->size/2+1;
+	int i, k;
+	Real abs, arg, last=0.0;
+	double *s1, *s2;
+
+	ESWEEP_MALLOC(s1, herm_size+1, sizeof(double), ERR_MALLOC);
+	ESWEEP_MALLOC(s2, herm_size+1, sizeof(double), ERR_MALLOC);
+
+	for (i=0, k=0; i < herm_size; i++) {
+		if (obj->type == POLAR) {
+			abs=polar[i].abs;
+			arg=polar[i].arg;
+		} else {
+			abs=sqrt(cpx[i].real*cpx[i].real+cpx[i].imag*cpx[i].imag);
+			arg=atan2(cpx[i].imag, cpx[i].real);
+		}
+		switch (mode) {
+			case SMOOTH_COMPLEX:
+				s1[i+1]=s1[i]+abs*cos(arg);
+				s2[i+1]=s2[i]+abs*sin(arg);
+				break;
+			default:
+				/* unwrap phase, see dsp_unwrapPhase() */
+				if (i > 0) {
+					if (arg-last > M_PI) k--;
+					if (arg-last < -M_PI) k++;
+				}
+				last=arg;
+				s1[i+1]=s1[i]+(mode == SMOOTH_POWER ? abs*abs : abs);
+				s2[i+1]=s2[i]+arg+k*2*M_PI;
+				break;
+		}
+	}
+
+	*sum1=s1;
+	*sum2=s2;
+	return ERR_OK;
+}
+
+/* average around the (fractional) bin i */
+static __inline void __esweep_smoothBin(const double *sum1, const double *sum2, int herm_size, int mode, Real i, Real factor, Polar *out) {
+	int j, range;
+	double m1, m2;
+
+	j=(int) (i-i/(4*factor)+0.5);
+	j=j < 0 ? 0 : j;
+	range=(int) (i+i/(2*factor)+0.5);
+	range=range >= herm_size ? herm_size-1 : range;
+
+	m1=(sum1[range+1]-sum1[j])/(range-j+1);
+	m2=(sum2[range+1]-sum2[j])/(range-j+1);
+	switch (mode) {
+		case SMOOTH_COMPLEX:
+			out->abs=sqrt(m1*m1+m2*m2);
+			out->arg=atan2(m2, m1);
+			break;
+		case SMOOTH_POWER:
+			out->abs=sqrt(m1);
+			out->arg=m2;
+			break;
+		default:
+			out->abs=m1;
+			out->arg=m2;
+			break;
+	}
+}
+
 int esweep_smooth(esweep_object *obj, Real factor) {
-	Polar *polar, *tmp;
-	int herm_size; 
-	int range; 
-	int i, j, k; 
+	return esweep_smoothExt(obj, factor, NULL);
+}
+
+int esweep_smoothExt(esweep_object *obj, Real factor, const char *mode) {
+	Polar *tmp;
+	Complex *cpx;
+	double *sum1, *sum2;
+	Real abs, arg;
+	int herm_size;
+	int i, m;
 
 	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
 	ESWEEP_ASSERT(factor >= 1, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT((m=__esweep_smoothMode(mode)) >= 0, ERR_BAD_ARGUMENT);
 
 	switch (obj->type) {
 		case POLAR:
-			polar=(Polar*) obj->data;
-			herm_size=obj->size/2+1; 
-			/* unwrap phase */
-			dsp_unwrapPhase(polar, obj->size);
-			tmp=(Polar*) calloc(obj->size, sizeof(Polar));
-			/* do not touch the nyquist frequency */
+		case COMPLEX:
+			herm_size=obj->size/2+1;
+			if (__esweep_smoothSums(obj, m, &sum1, &sum2) != ERR_OK) return ERR_MALLOC;
+			ESWEEP_MALLOC(tmp, obj->size, sizeof(Polar), ERR_MALLOC);
+			/* DC is not smoothed */
+			if (obj->type == POLAR) {
+				tmp[0]=((Polar*) obj->data)[0];
+			} else {
+				cpx=(Complex*) obj->data;
+				tmp[0].abs=sqrt(cpx[0].real*cpx[0].real+cpx[0].imag*cpx[0].imag);
+				tmp[0].arg=atan2(cpx[0].imag, cpx[0].real);
+			}
 			for (i=1;i<herm_size;i++) {
-				j=(int) (i-i/(4*factor)+0.5);
-				j=j < 0 ? 0 : j; 
-				range=(int) (i+i/(2*factor)+0.5); 
-				range=range >= herm_size ? herm_size-1 : range; 
-				tmp[i].abs=tmp[i].arg=0.0;
-				for (k=0;j <= range;j++, k++) {
-					tmp[i].abs+=polar[j].abs;
-					tmp[i].arg+=polar[j].arg;
-				}
-				tmp[obj->size-i].abs=tmp[i].abs/=k;
-				tmp[obj->size-i].arg=-(tmp[i].arg/=k);
+				__esweep_smoothBin(sum1, sum2, herm_size, m, i, factor, &tmp[i]);
+				tmp[obj->size-i].abs=tmp[i].abs;
+				tmp[obj->size-i].arg=-tmp[i].arg;
 			}
+			free(sum1);
+			free(sum2);
 			/* wrap phase */
 			dsp_wrapPhase(tmp, obj->size);
-			
-			free(obj->data);
-			obj->data=(void*) tmp; 
+
+			if (obj->type == COMPLEX) {
+				cpx=(Complex*) tmp;
+				for (i=0;i<obj->size;i++) {
+					abs=tmp[i].abs;
+					arg=tmp[i].arg;
+					cpx[i].real=abs*cos(arg);
+					cpx[i].imag=abs*sin(arg);
+				}
+			}
+			__esweep_freeData(obj->data);
+			obj->data=(void*) tmp;
 			break;
-		case COMPLEX:
 		case WAVE:
 		case SURFACE:
 		default:
-			ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE); 
+			ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE);
+	}
+
+	return ERR_OK;
+}
+
+int esweep_smoothLog(esweep_object *obj, Real factor, const char *mode, Real f1, Real f2, int points, Real *freq, Polar *out) {
+	double *sum1, *sum2;
+	Real df, ratio;
+	int herm_size;
+	int i, m;
+
+	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(obj->type == POLAR || obj->type == COMPLEX, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_ASSERT(factor >= 1, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT((m=__esweep_smoothMode(mode)) >= 0, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(f1 > 0.0 && f1 < f2 && f2 <= obj->samplerate/2.0, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(points >= 2, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(freq != NULL && out != NULL, ERR_BAD_ARGUMENT);
+
+	herm_size=obj->size/2+1;
+	df=(Real) obj->samplerate/obj->size;
+	ratio=pow(f2/f1, 1.0/(points-1));
+	if (__esweep_smoothSums(obj, m, &sum1, &sum2) != ERR_OK) return ERR_MALLOC;
+
+	for (i=0; i < points; i++) {
+		freq[i]=f1*pow(ratio, i);
+		__esweep_smoothBin(sum1, sum2, herm_size, m, freq[i]/df, factor, &out[i]);
+		/* wrap phase */
+		out[i].arg=atan2(sin(out[i].arg), cos(out[i].arg));
+	}
+
+	free(sum1);
+	free(sum2);
+	return ERR_OK;
+}
+
+/* magnitude or squared magnitude of bin k of a POLAR or COMPLEX object */
+static Real __esweep_binValue(const esweep_object *obj, int k, int squared) {
+	Polar *polar;
+	Complex *cpx;
+	Real p;
+
+	if (obj->type == POLAR) {
+		polar=(Polar*) obj->data;
+		return squared ? polar[k].abs*polar[k].abs : polar[k].abs;
+	}
+	cpx=(Complex*) obj->data;
+	p=cpx[k].real*cpx[k].real+cpx[k].imag*cpx[k].imag;
+	return squared ? p : sqrt(p);
+}
+
+/*
+ * The bins of the cell i are those between the geometric means of the neighbouring grid frequencies. Cells
+ * without any bin, i. e. at low frequencies, are interpolated linearly between the two nearest bins.
+ */
+int esweep_logResample(esweep_object *out, const esweep_object *in, Real fmin, Real fmax, int ppo, const char *mode) {
+	Surface *surf;
+	Real df, edge, q, frac, v, v0, v1, acc;
+	int i, k, k0, n, half, count, max_hold=0;
+
+	ESWEEP_OBJ_NOTEMPTY(in, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(in->type == POLAR || in->type == COMPLEX, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_ASSERT(out != NULL && out->data != NULL, ERR_OBJ_IS_NULL);
+	surf=(Surface*) out->data;
+	ESWEEP_OBJ_ISVALID_SURFACE(out, surf, ERR_NOT_ON_THIS_TYPE, ERR_OBJ_NOT_VALID);
+	ESWEEP_ASSERT(fmin > 0.0 && fmin < fmax && fmax <= in->samplerate/2.0, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(ppo >= 1, ERR_BAD_ARGUMENT);
+	if (mode != NULL) {
+		ESWEEP_ASSERT(strcmp(mode, "power") == 0 || strcmp(mode, "max") == 0, ERR_BAD_ARGUMENT);
+		max_hold=strcmp(mode, "max") == 0;
+	}
+
+	n=(int) (ppo*log2(fmax/fmin)+1e-9)+1;
+	/* the output is only reallocated when its size does not match */
+	if (surf->xsize != n || surf->ysize != 1) {
+		if (esweep_sparseSurface(out, n, 1) != ERR_OK) return ERR_MALLOC;
+	}
+	out->samplerate=in->samplerate;
+	surf->y[0]=0.0;
+
+	half=in->size/2;
+	df=(Real) in->samplerate/in->size;
+	k=(int) ceil(fmin*pow(2.0, -0.5/ppo)/df);
+	for (i=0; i < n; i++) {
+		surf->x[i]=fmin*pow(2.0, (Real) i/ppo);
+		edge=surf->x[i]*pow(2.0, 0.5/ppo)/df;
+		for (acc=0.0, count=0; k < edge && k <= half; k++, count++) {
+			v=__esweep_binValue(in, k, !max_hold);
+			if (max_hold) acc=v > acc ? v : acc;
+			else acc+=v;
+		}
+		if (count == 0) {
+			q=surf->x[i]/df;
+			k0=(int) q;
+			if (k0 >= half) k0=half-1;
+			frac=q-k0;
+			v0=__esweep_binValue(in, k0, !max_hold);
+			v1=__esweep_binValue(in, k0+1, !max_hold);
+			acc=v0+frac*(v1-v0);
+			count=1;
+		}
+		surf->z[i]=max_hold ? acc : sqrt(acc/count);
 	}
 
 	return ERR_OK;
@@ -970,6 +1356,8 @@ possible window types are:
 - Hamming
 - Bartlett (triangle)
 - Blackman
+- Blackman-Harris, flat top
+- Kaiser, Tukey and Gauss, with an optional parameter like "kaiser:6.5"
 
 both left and right may be different, width in percent
 */
@@ -977,6 +1365,7 @@ both left and right may be different, width in percent
 
 int esweep_window(esweep_object *obj, const char *left_win, Real left_width, const char *right_win, Real right_width) {
 	int win_type;
+	Real param=0.0;
 
 	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
 
@@ -991,21 +1380,16 @@ int esweep_window(esweep_object *obj, const char *left_win, Real left_width, con
 	if (strlen(left_win)>0) {
 		/* set window type */
 
-		win_type=WIN_NOWIN;
-		if (strcmp("rect", left_win)==0) { win_type=WIN_RECT; }
-		if (strcmp("bartlett", left_win)==0) { win_type=WIN_BART; }
-		if (strcmp("hann", left_win)==0) { win_type=WIN_HANN; }
-		if (strcmp("hamming", left_win)==0) { win_type=WIN_HAMM; }
-		if (strcmp("blackman", left_win)==0) { win_type=WIN_BLACK; }
+		win_type=window_parse(left_win, &param);
 
 		/* apply window */
 
 		switch (obj->type) {
 			case WAVE: 
-				window((Wave*) obj->data, 0, (int) (obj->size*left_width/100+0.5), WIN_LEFT, win_type);
+				window_ext((Wave*) obj->data, 0, (int) (obj->size*left_width/100+0.5), WIN_LEFT, win_type, param);
 				break; 
 			case COMPLEX: 
-				window_complex((Complex*) obj->data, 0, (int) (obj->size*left_width/100+0.5), WIN_LEFT, win_type);
+				window_complex_ext((Complex*) obj->data, 0, (int) (obj->size*left_width/100+0.5), WIN_LEFT, win_type, param);
 				break; 
 			default: 
 				ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE); 
@@ -1017,21 +1401,16 @@ int esweep_window(esweep_object *obj, const char *left_win, Real left_width, con
 	if (strlen(right_win)>0) {
 		/* set window type */
 
-		win_type=WIN_NOWIN;
-		if (strcmp("rect", right_win)==0) { win_type=WIN_RECT; }
-		if (strcmp("bartlett", right_win)==0) { win_type=WIN_BART; }
-		if (strcmp("hann", right_win)==0) { win_type=WIN_HANN; }
-		if (strcmp("hamming", right_win)==0) { win_type=WIN_HAMM; }
-		if (strcmp("blackman", right_win)==0) { win_type=WIN_BLACK; }
+		win_type=window_parse(right_win, &param);
 
 		/* apply window */
 
 		switch (obj->type) {
 			case WAVE: 
-				window((Wave*) obj->data, (int) (obj->size-obj->size*right_width/100+0.5), obj->size, WIN_RIGHT, win_type);
+				window_ext((Wave*) obj->data, (int) (obj->size-obj->size*right_width/100+0.5), obj->size, WIN_RIGHT, win_type, param);
 				break; 
 			case COMPLEX: 
-				window_complex((Complex*) obj->data, (int) (obj->size-obj->size*right_width/100+0.5), obj->size, WIN_RIGHT, win_type);
+				window_complex_ext((Complex*) obj->data, (int) (obj->size-obj->size*right_width/100+0.5), obj->size, WIN_RIGHT, win_type, param);
 				break; 
 			default: 
 				ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE); 
@@ -1041,6 +1420,25 @@ int esweep_window(esweep_object *obj, const char *left_win, Real left_width, con
 	return ERR_OK;
 }
 
+/*
+coherent gain and equivalent noise bandwidth of a window, as the analyzers apply it
+*/
+
+int esweep_windowInfo(const char *window, int size, Real *coherent_gain, Real *enbw) {
+	int win_type;
+	Real param=0.0;
+
+	ESWEEP_ASSERT(window != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(size > 1, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(coherent_gain != NULL && enbw != NULL, ERR_BAD_ARGUMENT);
+
+	win_type=window_parse(window, &param);
+	ESWEEP_ASSERT(win_type != WIN_NOWIN, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(window_gains(win_type, param, size, coherent_gain, enbw) == 0, ERR_MALLOC);
+
+	return ERR_OK;
+}
+
 int esweep_restoreHermitian(esweep_object *obj) {
 	Polar *polar; 
 	Complex *cpx; 
@@ -1063,7 +1461,7 @@ int esweep_restoreHermitian(esweep_object *obj) {
 				polar[new_size-i].arg=-polar[i].arg;
 			}
 			obj->size=new_size; 
-			free(obj->data); 
+			__esweep_freeData(obj->data); 
 			obj->data=polar; 
 			break; 
 		case COMPLEX:  
@@ -1079,7 +1477,7 @@ int esweep_restoreHermitian(esweep_object *obj) {
 				cpx[new_size-i].imag=-cpx[i].imag;
 			}
 			obj->size=new_size; 
-			free(obj->data); 
+			__esweep_freeData(obj->data); 
 			obj->data=cpx; 
 			break; 
 		default: 
@@ -1089,107 +1487,232 @@ int esweep_restoreHermitian(esweep_object *obj) {
 	return ERR_OK; 
 }
 
-int esweep_peakDetect(esweep_object *obj, Real threshold, int *peaks, int *n) {
-	Real *real; 
-	Polar *polar; 
-	int i, k, m; 
+/*
+ * Peak detection
+ *
+ * The signal is scanned once for local extrema (with SSE2 two samples at a time), all further steps only visit the extrema:
+ * - hysteresis: a maximum is a peak if the signal drops more than threshold below it, and it must rise
+ *   more than threshold above the following minimum before the next peak is searched
+ * - prominence: the height above the higher of the two bases, where a base is the minimum between
+ *   the peak and the next higher sample on that side (or the border); computed with a monotonic stack
+ * - distance: of peaks closer than distance samples, only the highest is kept
+ * Minima are found as the peaks of the negated signal.
+ */
 
-	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
-	ESWEEP_ASSERT(n != NULL, ERR_BAD_ARGUMENT); 
-	ESWEEP_ASSERT(*n > 1, ERR_BAD_ARGUMENT); 
-	ESWEEP_ASSERT(peaks != NULL, ERR_BAD_ARGUMENT); 
-	ESWEEP_ASSERT(threshold != 0, ERR_BAD_ARGUMENT); 
+typedef struct {
+	Real level;
+	int k;
+} peak_rank;
+
+static int __esweep_peakCompare(const void *a, const void *b) {
+	Real la=((const peak_rank*) a)->level, lb=((const peak_rank*) b)->level;
+	return la > lb ? -1 : la < lb ? 1 : 0;
+}
+
+/* indices of the local extrema of v, plus the first and the last sample */
+static int __esweep_peakExtrema(const Real *v, int size, int *ext) {
+	int i=1, m=0;
+
+	ext[m++]=0;
+#if defined(__SSE2__) && !defined(REAL32)
+	for (; i+2 < size; i+=2) {
+		__m128d a=_mm_loadu_pd(v+i-1), b=_mm_loadu_pd(v+i), c=_mm_loadu_pd(v+i+1);
+		int mask=_mm_movemask_pd(_mm_or_pd(_mm_and_pd(_mm_cmpgt_pd(b, a), _mm_cmpge_pd(b, c)),
+					_mm_and_pd(_mm_cmplt_pd(b, a), _mm_cmple_pd(b, c))));
+		if (mask & 1) ext[m++]=i;
+		if (mask & 2) ext[m++]=i+1;
+	}
+#endif
+	for (; i < size-1; i++) {
+		if ((v[i] > v[i-1] && v[i] >= v[i+1]) || (v[i] < v[i-1] && v[i] <= v[i+1])) ext[m++]=i;
+	}
+	if (size > 1) ext[m++]=size-1;
+	return m;
+}
+
+/* bases of the extrema from one side, dir is 1 (left) or -1 (right) */
+static void __esweep_peakBases(const Real *v, const int *ext, int m, int dir, int *stack, Real *seg_min, Real *base) {
+	Real b;
+	int k, j, top=0;
+
+	for (j=0; j < m; j++) {
+		k=dir > 0 ? j : m-1-j;
+		b=v[ext[k]];
+		while (top > 0 && v[ext[stack[top-1]]] <= v[ext[k]]) {
+			top--;
+			if (seg_min[top] < b) b=seg_min[top];
+		}
+		base[k]=b;
+		stack[top]=k;
+		seg_min[top]=b;
+		top++;
+	}
+}
+
+int esweep_peakFind(const esweep_object *obj, Real threshold, Real distance, Real prominence, const char *interpolation, esweep_peak *peaks, int *n) {
+	const Complex *cpx;
+	const Polar *polar;
+	peak_rank *rank;
+	Real *v, *left, *right, *seg_min;
+	Real sign, thr, mx, mn, a, b, c, d, level;
+	int *ext, *stack, *cand;
+	char *removed;
+	int i, j, k, m, p, q, kmax, look_max, interp, gauss;
 
-	m=0; 
+	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(peaks != NULL && n != NULL && *n > 0, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(distance >= 0 && prominence >= 0, ERR_BAD_ARGUMENT);
+	interp=-1;
+	if (interpolation == NULL || strcmp(interpolation, "none") == 0) interp=0;
+	else if (strcmp(interpolation, "parabolic") == 0) interp=1;
+	else if (strcmp(interpolation, "gaussian") == 0) interp=2;
+	ESWEEP_ASSERT(interp >= 0, ERR_BAD_ARGUMENT);
+
+	/* the signal, negated when searching minima */
+	sign=threshold < 0 ? -1.0 : 1.0;
+	thr=sign*threshold;
+	ESWEEP_MALLOC(v, obj->size, sizeof(Real), ERR_MALLOC);
 	switch (obj->type) {
-		case WAVE: 
-			real=(Real*) obj->data; 
-			if (threshold > 0) {
-				for (i=1; i < obj->size; i++) {
-					/* as long as the function is rising, follow it */
-					if (real[i] > real[i-1]) continue; 
-					/* if not, check if it drops below the threshold */
-					for (k=i; k < obj->size; k++) {
-						if (real[k] > real[i-1]) break; // obviously not
-						if (real[i-1] - real[k] > threshold) {
-							peaks[m]=i-1; 
-							m++;
-							if (m == *n) return ERR_OK; //array is full
-							/* now find the bottom of the hole */
-							for (i=k+1; i < obj->size; i++) {
-								if (real[i] > real[i-1]) break; 
-							}
-							break; 
-						}
-					}
-				}
-			} else {
-				for (i=1; i < obj->size; i++) {
-					/* as long as the function is falling, follow it */
-					if (real[i] < real[i-1]) continue; 
-					/* if not, check if it rises above the threshold */
-					for (k=i; k < obj->size; k++) {
-						if (real[k] < real[i-1]) break; // obviously not
-						if (real[i-1] - real[k] < threshold) {
-							peaks[m]=i-1; 
-							m++;
-							if (m == *n) return ERR_OK; //array is full
-							/* now find the next minimum */
-							for (i=k+1; i < obj->size; i++) {
-								if (real[i] < real[i-1]) break; 
-							}
-							break; 
-						}
-					}
-				}
+		case WAVE:
+			for (i=0; i < obj->size; i++) v[i]=sign*((const Real*) obj->data)[i];
+			break;
+		case POLAR:
+			polar=(const Polar*) obj->data;
+			for (i=0; i < obj->size; i++) v[i]=sign*polar[i].abs;
+			break;
+		case COMPLEX:
+			cpx=(const Complex*) obj->data;
+			for (i=0; i < obj->size; i++) v[i]=sign*sqrt(cpx[i].real*cpx[i].real+cpx[i].imag*cpx[i].imag);
+			break;
+		default:
+			free(v);
+			ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE);
+	}
+
+	ESWEEP_MALLOC(ext, obj->size, sizeof(int), ERR_MALLOC);
+	m=__esweep_peakExtrema(v, obj->size, ext);
+
+	/* hysteresis, cand[] are indices into ext[] */
+	ESWEEP_MALLOC(cand, m, sizeof(int), ERR_MALLOC);
+	mx=-HUGE_VAL;
+	mn=HUGE_VAL;
+	look_max=1;
+	for (k=0, kmax=0, p=0; k < m; k++) {
+		level=v[ext[k]];
+		if (level > mx) {
+			mx=level;
+			kmax=k;
+		}
+		if (level < mn) mn=level;
+		if (look_max) {
+			if (level < mx-thr) {
+				cand[p++]=kmax;
+				mn=level;
+				look_max=0;
 			}
-			break; 
-		case POLAR: 
-			polar=(Polar*) obj->data; 
-			if (threshold > 0) {
-				for (i=1; i < obj->size; i++) {
-					/* as long as the function is rising, follow it */
-					if (polar[i].abs > polar[i-1].abs) continue; 
-					/* if not, check if it drops below the threshold */
-					for (k=i; k < obj->size; k++) {
-						if (polar[k].abs > polar[i-1].abs) break; // obviously not
-						if (polar[i-1].abs - polar[k].abs > threshold) {
-							peaks[m]=i-1; 
-							m++;
-							if (m == *n) return ERR_OK; //array is full
-							/* now find the bottom of the hole */
-							for (i=k+1; i < obj->size; i++) {
-								if (polar[i].abs > polar[i-1].abs) break; 
-							}
-							break; 
-						}
-					}
-				}
-			} else {
-				for (i=1; i < obj->size; i++) {
-					/* as long as the function is falling, follow it */
-					if (polar[i].abs < polar[i-1].abs) continue; 
-					/* if not, check if it drops below the threshold */
-					for (k=i; k < obj->size; k++) {
-						if (polar[k].abs < polar[i-1].abs) break; // obviously not
-						if (polar[i-1].abs - polar[k].abs < threshold) {
-							peaks[m]=i-1; 
-							m++;
-							if (m == *n) return ERR_OK; //array is full
-							/* now find the next maximum */
-							for (i=k+1; i < obj->size; i++) {
-								if (polar[i].abs < polar[i-1].abs) break; 
-							}
-							break; 
-						}
-					}
-				}
+		} else if (level > mn+thr) {
+			mx=level;
+			kmax=k;
+			look_max=1;
+		}
+	}
+
+	/* prominence */
+	ESWEEP_MALLOC(left, m, sizeof(Real), ERR_MALLOC);
+	ESWEEP_MALLOC(right, m, sizeof(Real), ERR_MALLOC);
+	ESWEEP_MALLOC(seg_min, m, sizeof(Real), ERR_MALLOC);
+	ESWEEP_MALLOC(stack, m, sizeof(int), ERR_MALLOC);
+	__esweep_peakBases(v, ext, m, 1, stack, seg_min, left);
+	__esweep_peakBases(v, ext, m, -1, stack, seg_min, right);
+	for (j=0; j < p; j++) {
+		k=cand[j];
+		left[k]=v[ext[k]]-(left[k] > right[k] ? left[k] : right[k]);
+	}
+	for (j=0, q=0; j < p; j++) {
+		if (left[cand[j]] >= prominence) cand[q++]=cand[j];
+	}
+	p=q;
+
+	/* distance, the highest peaks first */
+	ESWEEP_MALLOC(removed, p > 0 ? p : 1, sizeof(char), ERR_MALLOC);
+	if (distance > 0 && p > 1) {
+		ESWEEP_MALLOC(rank, p, sizeof(peak_rank), ERR_MALLOC);
+		for (j=0; j < p; j++) {
+			rank[j].level=v[ext[cand[j]]];
+			rank[j].k=j;
+		}
+		qsort(rank, p, sizeof(peak_rank), __esweep_peakCompare);
+		for (j=0; j < p; j++) {
+			i=rank[j].k;
+			if (removed[i]) continue;
+			for (q=i-1; q >= 0 && ext[cand[i]]-ext[cand[q]] < distance; q--) removed[q]=1;
+			for (q=i+1; q < p && ext[cand[q]]-ext[cand[i]] < distance; q++) removed[q]=1;
+		}
+		free(rank);
+	}
+
+	/* output and interpolation */
+	for (j=0, q=0; j < p && q < *n; j++) {
+		if (removed[j]) continue;
+		k=cand[j];
+		i=ext[k];
+		d=0.0;
+		level=v[i];
+		if (interp > 0 && i > 0 && i < obj->size-1) {
+			a=v[i-1];
+			b=v[i];
+			c=v[i+1];
+			/* gaussian needs positive values, otherwise parabolic */
+			gauss=interp == 2 && a > 0 && b > 0 && c > 0;
+			if (gauss) {
+				a=log(a);
+				b=log(b);
+				c=log(c);
 			}
-			break; 
-		default: 
-			ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE); 
+			if (a-2*b+c < 0) {
+				d=0.5*(a-c)/(a-2*b+c);
+				level=b-0.25*(a-c)*d;
+				if (gauss) level=exp(level);
+			}
+		}
+		peaks[q].index=i;
+		peaks[q].position=i+d;
+		peaks[q].x=obj->type == WAVE ? peaks[q].position/obj->samplerate : peaks[q].position*obj->samplerate/obj->size;
+		peaks[q].level=sign*level;
+		peaks[q].prominence=left[k];
+		q++;
 	}
-	*n=m; 
+	*n=q;
+
+	free(v);
+	free(ext);
+	free(cand);
+	free(left);
+	free(right);
+	free(seg_min);
+	free(stack);
+	free(removed);
+	return ERR_OK;
+}
 
-	return ERR_OK; 
+int esweep_peakDetect(esweep_object *obj, Real threshold, int *peaks, int *n) {
+	esweep_peak *found;
+	int i;
+
+	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(n != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(*n > 1, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(peaks != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(threshold != 0, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(obj->type == WAVE || obj->type == POLAR, ERR_NOT_ON_THIS_TYPE);
+
+	ESWEEP_MALLOC(found, *n, sizeof(esweep_peak), ERR_MALLOC);
+	if (esweep_peakFind(obj, threshold, 0, 0, NULL, found, n) != ERR_OK) {
+		free(found);
+		return ERR_UNKNOWN;
+	}
+	for (i=0; i < *n; i++) peaks[i]=found[i].index;
+	free(found);
+
+	return ERR_OK;
 }
@@ -0,0 +1,710 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * src/esweep_eval.c:
+ * Compiled element-wise expressions
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esweep_priv.h"
+#include "esweep.h"
+
+/*
+ * An expression like "20*lg(abs(x))+k" is parsed into a small tree, constant subexpressions are folded,
+ * and the tree is emitted as code for a stack machine. The machine does not work on single values, but on
+ * chunks of EVAL_CHUNK elements: every instruction is a short loop over the chunk, which the compiler can
+ * vectorize, and the chunk stays in the cache while all instructions run over it. Binary operations with
+ * a constant or variable operand take it as an immediate, so the constant is not expanded into a chunk.
+ * Of two operands on the stack the one which needs more stack is evaluated first (Sethi-Ullman order),
+ * so the stack grows with the logarithm of the expression size, not with its nesting. EVAL_NODES bounds
+ * the depth to 8 chunks.
+ * So the whole expression costs one pass over the object, instead of one pass per esweep_* call.
+ * All chunks have the full length, so the compiler knows the trip count of the loops. The last one is
+ * padded with copies of the last element, which cannot raise other exceptions than the element itself.
+ *
+ * Compiled programs are immutable and cached by their source and the names of the variables.
+ */
+
+#define EVAL_CHUNK 256
+#define EVAL_STACK 8 /* chunks, enough for EVAL_NODES */
+#define EVAL_NODES 256
+#define EVAL_CODE 256
+#define EVAL_CONSTS 64
+#define EVAL_VARS 16
+#define EVAL_CACHE 32
+
+/* operations */
+enum {
+	/* leaves */
+	EVAL_X, EVAL_I, EVAL_CONST,
+	/* unary */
+	EVAL_NEG, EVAL_ABS, EVAL_SQRT, EVAL_SQR, EVAL_LG, EVAL_LN, EVAL_EXP,
+	EVAL_SIN, EVAL_COS, EVAL_TAN, EVAL_ATAN, EVAL_FLOOR, EVAL_CEIL,
+	/* binary */
+	EVAL_ADD, EVAL_SUB, EVAL_MUL, EVAL_DIV, EVAL_POW, EVAL_MIN, EVAL_MAX
+};
+
+#define EVAL_IS_UNARY(op) ((op) >= EVAL_NEG && (op) <= EVAL_CEIL)
+#define EVAL_COMMUTATIVE(op) ((op) == EVAL_ADD || (op) == EVAL_MUL || (op) == EVAL_MIN || (op) == EVAL_MAX)
+
+/* operands of binary instructions */
+#define EVAL_OPERAND_STACK 0 /* both on the stack */
+#define EVAL_OPERAND_RIGHT 1 /* right operand is the immediate */
+#define EVAL_OPERAND_LEFT 2 /* left operand is the immediate */
+#define EVAL_OPERAND_REVERSED 3 /* both on the stack, the right operand below the left one */
+
+#define EVAL_F_NEG(u) (-(u))
+#define EVAL_F_ABS(u) FABS(u)
+#define EVAL_F_SQRT(u) sqrt(u)
+#define EVAL_F_SQR(u) ((u)*(u))
+#define EVAL_F_LG(u) LG(u)
+#define EVAL_F_LN(u) LN(u)
+#define EVAL_F_EXP(u) EXP(u)
+#define EVAL_F_SIN(u) SIN(u)
+#define EVAL_F_COS(u) COS(u)
+#define EVAL_F_TAN(u) tan(u)
+#define EVAL_F_ATAN(u) atan(u)
+#define EVAL_F_FLOOR(u) floor(u)
+#define EVAL_F_CEIL(u) ceil(u)
+#define EVAL_F_ADD(u, v) ((u)+(v))
+#define EVAL_F_SUB(u, v) ((u)-(v))
+#define EVAL_F_MUL(u, v) ((u)*(v))
+#define EVAL_F_DIV(u, v) ((u)/(v))
+#define EVAL_F_POW(u, v) POW(u, v)
+#define EVAL_F_MIN(u, v) ((u) < (v) ? (u) : (v))
+#define EVAL_F_MAX(u, v) ((u) > (v) ? (u) : (v))
+
+static const struct {
+	const char *name;
+	int op;
+	int args;
+} eval_functions[] = {
+	{"abs", EVAL_ABS, 1},
+	{"sqrt", EVAL_SQRT, 1},
+	{"lg", EVAL_LG, 1},
+	{"ln", EVAL_LN, 1},
+	{"exp", EVAL_EXP, 1},
+	{"sin", EVAL_SIN, 1},
+	{"cos", EVAL_COS, 1},
+	{"tan", EVAL_TAN, 1},
+	{"atan", EVAL_ATAN, 1},
+	{"floor", EVAL_FLOOR, 1},
+	{"ceil", EVAL_CEIL, 1},
+	{"pow", EVAL_POW, 2},
+	{"min", EVAL_MIN, 2},
+	{"max", EVAL_MAX, 2},
+	{"clip", -1, 3}, /* clip(a, lo, hi) is min(max(a, lo), hi) */
+	{NULL, 0, 0}
+};
+
+typedef struct {
+	int op;
+	int left, right; /* child nodes */
+	int slot; /* EVAL_CONST: index into the constants */
+	int need; /* stack depth of the subtree */
+} eval_node;
+
+typedef struct {
+	int op;
+	int operand;
+	int slot; /* constant of EVAL_CONST and of immediate operands */
+} eval_ins;
+
+typedef struct {
+	char *key; /* source and variable names */
+	int refs;
+	unsigned long used;
+	int vars; /* the first constants are the variables */
+	int consts;
+	Real value[EVAL_CONSTS];
+	int size;
+	eval_ins code[EVAL_CODE];
+} eval_program;
+
+/* parser state */
+typedef struct {
+	const char *src;
+	const char *pos;
+	const char *error;
+	int n_names;
+	const char **names;
+	eval_node node[EVAL_NODES];
+	int nodes;
+	eval_program *prog;
+	int sp, depth;
+} eval_parser;
+
+static eval_program *eval_cache[EVAL_CACHE];
+static unsigned long eval_clock=0;
+static pthread_mutex_t eval_lock=PTHREAD_MUTEX_INITIALIZER;
+
+static Real __esweep_evalUnary(int op, Real u) {
+	switch (op) {
+		case EVAL_NEG: return EVAL_F_NEG(u);
+		case EVAL_ABS: return EVAL_F_ABS(u);
+		case EVAL_SQRT: return EVAL_F_SQRT(u);
+		case EVAL_SQR: return EVAL_F_SQR(u);
+		case EVAL_LG: return EVAL_F_LG(u);
+		case EVAL_LN: return EVAL_F_LN(u);
+		case EVAL_EXP: return EVAL_F_EXP(u);
+		case EVAL_SIN: return EVAL_F_SIN(u);
+		case EVAL_COS: return EVAL_F_COS(u);
+		case EVAL_TAN: return EVAL_F_TAN(u);
+		case EVAL_ATAN: return EVAL_F_ATAN(u);
+		case EVAL_FLOOR: return EVAL_F_FLOOR(u);
+		case EVAL_CEIL: return EVAL_F_CEIL(u);
+	}
+	return 0.0;
+}
+
+static Real __esweep_evalBinary(int op, Real u, Real v) {
+	switch (op) {
+		case EVAL_ADD: return EVAL_F_ADD(u, v);
+		case EVAL_SUB: return EVAL_F_SUB(u, v);
+		case EVAL_MUL: return EVAL_F_MUL(u, v);
+		case EVAL_DIV: return EVAL_F_DIV(u, v);
+		case EVAL_POW: return EVAL_F_POW(u, v);
+		case EVAL_MIN: return EVAL_F_MIN(u, v);
+		case EVAL_MAX: return EVAL_F_MAX(u, v);
+	}
+	return 0.0;
+}
+
+/*
+ * Parser
+ *
+ * expr    := term {("+" | "-") term}
+ * term    := unary {("*" | "/") unary}
+ * unary   := "-" unary | power
+ * power   := primary ["^" unary]
+ * primary := number | "x" | "i" | "pi" | variable | function "(" expr {"," expr} ")" | "(" expr ")"
+ */
+
+static int __esweep_evalExpr(eval_parser *p);
+
+static int __esweep_evalFail(eval_parser *p, const char *error) {
+	if (p->error == NULL) p->error=error;
+	return -1;
+}
+
+static void __esweep_evalSkip(eval_parser *p) {
+	while (*p->pos == ' ' || *p->pos == '\t' || *p->pos == '\n' || *p->pos == '\r') p->pos++;
+}
+
+static int __esweep_evalConst(eval_parser *p, Real value) {
+	eval_program *prog=p->prog;
+	int i;
+
+	/* reuse equal literals */
+	for (i=prog->vars; i < prog->consts; i++) {
+		if (prog->value[i] == value) return i;
+	}
+	if (prog->consts >= EVAL_CONSTS) return __esweep_evalFail(p, "too many constants");
+	prog->value[prog->consts]=value;
+	return prog->consts++;
+}
+
+/* stack depth of node n when __esweep_evalEmit() evaluates the deeper operand first */
+static int __esweep_evalNeed(const eval_parser *p, const eval_node *n) {
+	const eval_node *l, *r;
+
+	if (n->op == EVAL_X || n->op == EVAL_I || n->op == EVAL_CONST) return 1;
+	l=p->node+n->left;
+	if (EVAL_IS_UNARY(n->op)) return l->need;
+	r=p->node+n->right;
+	if (r->op == EVAL_CONST) return l->need;
+	if (l->op == EVAL_CONST) return r->need;
+	if (l->need == r->need) return l->need+1;
+	return l->need > r->need ? l->need : r->need;
+}
+
+static int __esweep_evalNode(eval_parser *p, int op, int left, int right, int slot) {
+	eval_node *n;
+
+	if (left < 0 || right < -1 || p->error != NULL) return __esweep_evalFail(p, "syntax error");
+	if (p->nodes >= EVAL_NODES) return __esweep_evalFail(p, "expression too long");
+	n=p->node+p->nodes;
+	n->op=op;
+	n->left=left;
+	n->right=right;
+	n->slot=slot;
+	n->need=__esweep_evalNeed(p, n);
+	return p->nodes++;
+}
+
+/* a constant node, slot is the index of the constant */
+static int __esweep_evalConstNode(eval_parser *p, int slot) {
+	if (slot < 0) return -1;
+	if (p->nodes >= EVAL_NODES) return __esweep_evalFail(p, "expression too long");
+	p->node[p->nodes].op=EVAL_CONST;
+	p->node[p->nodes].left=p->node[p->nodes].right=-1;
+	p->node[p->nodes].slot=slot;
+	p->node[p->nodes].need=1;
+	return p->nodes++;
+}
+
+/* literal constant, not a variable */
+#define EVAL_IS_LITERAL(p, n) ((p)->node[n].op == EVAL_CONST && (p)->node[n].slot >= (p)->prog->vars)
+
+/* create a unary or binary node, folding constants */
+static int __esweep_evalOp(eval_parser *p, int op, int left, int right) {
+	Real *value=p->prog->value;
+
+	if (left < 0 || (!EVAL_IS_UNARY(op) && right < 0)) return -1;
+	if (EVAL_IS_UNARY(op)) {
+		if (EVAL_IS_LITERAL(p, left)) {
+			return __esweep_evalConstNode(p, __esweep_evalConst(p, __esweep_evalUnary(op, value[p->node[left].slot])));
+		}
+		return __esweep_evalNode(p, op, left, -1, 0);
+	}
+	if (EVAL_IS_LITERAL(p, left) && EVAL_IS_LITERAL(p, right)) {
+		return __esweep_evalConstNode(p, __esweep_evalConst(p, __esweep_evalBinary(op, value[p->node[left].slot], value[p->node[right].slot])));
+	}
+	/* a^2 and a^0.5 are much cheaper than pow() */
+	if (op == EVAL_POW && EVAL_IS_LITERAL(p, right)) {
+		if (value[p->node[right].slot] == 2.0) return __esweep_evalNode(p, EVAL_SQR, left, -1, 0);
+		if (value[p->node[right].slot] == 0.5) return __esweep_evalNode(p, EVAL_SQRT, left, -1, 0);
+	}
+	return __esweep_evalNode(p, op, left, right, 0);
+}
+
+static int __esweep_evalPrimary(eval_parser *p) {
+	const char *start;
+	char *end;
+	char name[32];
+	int i, len, args[3], n;
+	Real value;
+
+	__esweep_evalSkip(p);
+	if (*p->pos == '(') {
+		p->pos++;
+		i=__esweep_evalExpr(p);
+		__esweep_evalSkip(p);
+		if (*p->pos != ')') return __esweep_evalFail(p, "missing \")\"");
+		p->pos++;
+		return i;
+	}
+	if ((*p->pos >= '0' && *p->pos <= '9') || *p->pos == '.') {
+		value=strtod(p->pos, &end);
+		if (end == p->pos) return __esweep_evalFail(p, "invalid number");
+		p->pos=end;
+		return __esweep_evalConstNode(p, __esweep_evalConst(p, value));
+	}
+	if (!((*p->pos >= 'a' && *p->pos <= 'z') || (*p->pos >= 'A' && *p->pos <= 'Z') || *p->pos == '_')) {
+		return __esweep_evalFail(p, "syntax error");
+	}
+
+	start=p->pos;
+	while ((*p->pos >= 'a' && *p->pos <= 'z') || (*p->pos >= 'A' && *p->pos <= 'Z')
+			|| (*p->pos >= '0' && *p->pos <= '9') || *p->pos == '_') p->pos++;
+	len=p->pos-start;
+	if (len >= (int) sizeof(name)) return __esweep_evalFail(p, "name too long");
+	memcpy(name, start, len);
+	name[len]='\0';
+	__esweep_evalSkip(p);
+
+	if (*p->pos == '(') {
+		for (i=0; eval_functions[i].name != NULL; i++) {
+			if (strcmp(name, eval_functions[i].name) == 0) break;
+		}
+		if (eval_functions[i].name == NULL) {
+			p->pos=start;
+			return __esweep_evalFail(p, "unknown function");
+		}
+		p->pos++;
+		for (n=0; n < eval_functions[i].args; n++) {
+			if (n > 0) {
+				__esweep_evalSkip(p);
+				if (*p->pos != ',') return __esweep_evalFail(p, "missing argument");
+				p->pos++;
+			}
+			args[n]=__esweep_evalExpr(p);
+		}
+		__esweep_evalSkip(p);
+		if (*p->pos != ')') return __esweep_evalFail(p, "missing \")\"");
+		p->pos++;
+		if (eval_functions[i].op < 0) {
+			return __esweep_evalOp(p, EVAL_MIN, __esweep_evalOp(p, EVAL_MAX, args[0], args[1]), args[2]);
+		}
+		return __esweep_evalOp(p, eval_functions[i].op, args[0], eval_functions[i].args > 1 ? args[1] : -1);
+	}
+
+	/* variables first, so they may hide the predefined names */
+	for (i=0; i < p->n_names; i++) {
+		if (strcmp(name, p->names[i]) == 0) return __esweep_evalConstNode(p, i);
+	}
+	if (strcmp(name, "x") == 0) return __esweep_evalNode(p, EVAL_X, 0, -1, 0);
+	if (strcmp(name, "i") == 0) return __esweep_evalNode(p, EVAL_I, 0, -1, 0);
+	if (strcmp(name, "pi") == 0) return __esweep_evalConstNode(p, __esweep_evalConst(p, M_PI));
+	p->pos=start;
+	return __esweep_evalFail(p, "unknown variable");
+}
+
+static int __esweep_evalUnaryExpr(eval_parser *p);
+
+static int __esweep_evalPower(eval_parser *p) {
+	int left=__esweep_evalPrimary(p);
+
+	__esweep_evalSkip(p);
+	if (*p->pos == '^') {
+		p->pos++;
+		/* right associative, and 2^-1 is allowed */
+		return __esweep_evalOp(p, EVAL_POW, left, __esweep_evalUnaryExpr(p));
+	}
+	return left;
+}
+
+static int __esweep_evalUnaryExpr(eval_parser *p) {
+	__esweep_evalSkip(p);
+	if (*p->pos == '-') {
+		p->pos++;
+		return __esweep_evalOp(p, EVAL_NEG, __esweep_evalUnaryExpr(p), -1);
+	}
+	if (*p->pos == '+') {
+		p->pos++;
+		return __esweep_evalUnaryExpr(p);
+	}
+	return __esweep_evalPower(p);
+}
+
+static int __esweep_evalTerm(eval_parser *p) {
+	int left=__esweep_evalUnaryExpr(p);
+
+	for (;;) {
+		__esweep_evalSkip(p);
+		if (*p->pos == '*') {
+			p->pos++;
+			left=__esweep_evalOp(p, EVAL_MUL, left, __esweep_evalUnaryExpr(p));
+		} else if (*p->pos == '/') {
+			p->pos++;
+			left=__esweep_evalOp(p, EVAL_DIV, left, __esweep_evalUnaryExpr(p));
+		} else {
+			return left;
+		}
+	}
+}
+
+static int __esweep_evalExpr(eval_parser *p) {
+	int left=__esweep_evalTerm(p);
+
+	for (;;) {
+		__esweep_evalSkip(p);
+		if (*p->pos == '+') {
+			p->pos++;
+			left=__esweep_evalOp(p, EVAL_ADD, left, __esweep_evalTerm(p));
+		} else if (*p->pos == '-') {
+			p->pos++;
+			left=__esweep_evalOp(p, EVAL_SUB, left, __esweep_evalTerm(p));
+		} else {
+			return left;
+		}
+	}
+}
+
+/*
+ * Code generation
+ */
+
+static void __esweep_evalEmitIns(eval_parser *p, int op, int operand, int slot, int push) {
+	eval_program *prog=p->prog;
+
+	if (prog->size >= EVAL_CODE) {
+		__esweep_evalFail(p, "expression too long");
+		return;
+	}
+	prog->code[prog->size].op=op;
+	prog->code[prog->size].operand=operand;
+	prog->code[prog->size].slot=slot;
+	prog->size++;
+	p->sp+=push;
+	if (p->sp > p->depth) p->depth=p->sp;
+}
+
+static void __esweep_evalEmit(eval_parser *p, int i) {
+	eval_node *n=p->node+i;
+	eval_node *l, *r;
+
+	if (n->op == EVAL_X || n->op == EVAL_I || n->op == EVAL_CONST) {
+		__esweep_evalEmitIns(p, n->op, EVAL_OPERAND_STACK, n->slot, 1);
+		return;
+	}
+	if (EVAL_IS_UNARY(n->op)) {
+		__esweep_evalEmit(p, n->left);
+		__esweep_evalEmitIns(p, n->op, EVAL_OPERAND_STACK, 0, 0);
+		return;
+	}
+	l=p->node+n->left;
+	r=p->node+n->right;
+	if (r->op == EVAL_CONST) {
+		__esweep_evalEmit(p, n->left);
+		__esweep_evalEmitIns(p, n->op, EVAL_OPERAND_RIGHT, r->slot, 0);
+	} else if (l->op == EVAL_CONST) {
+		__esweep_evalEmit(p, n->right);
+		if (EVAL_COMMUTATIVE(n->op)) __esweep_evalEmitIns(p, n->op, EVAL_OPERAND_RIGHT, l->slot, 0);
+		else __esweep_evalEmitIns(p, n->op, EVAL_OPERAND_LEFT, l->slot, 0);
+	} else if (r->need > l->need) {
+		__esweep_evalEmit(p, n->right);
+		__esweep_evalEmit(p, n->left);
+		__esweep_evalEmitIns(p, n->op, EVAL_OPERAND_REVERSED, 0, -1);
+	} else {
+		__esweep_evalEmit(p, n->left);
+		__esweep_evalEmit(p, n->right);
+		__esweep_evalEmitIns(p, n->op, EVAL_OPERAND_STACK, 0, -1);
+	}
+}
+
+static eval_program *__esweep_evalCompile(const char *src, int n, const char *names[], char *key) {
+	eval_parser *p;
+	eval_program *prog;
+	int root, i;
+
+	ESWEEP_ASSERT(n <= EVAL_VARS, NULL);
+	ESWEEP_MALLOC(p, 1, sizeof(eval_parser), NULL);
+	ESWEEP_MALLOC(prog, 1, sizeof(eval_program), NULL);
+	p->src=p->pos=src;
+	p->names=names;
+	p->n_names=n;
+	p->prog=prog;
+	prog->vars=prog->consts=n;
+
+	root=__esweep_evalExpr(p);
+	__esweep_evalSkip(p);
+	if (root >= 0 && *p->pos != '\0') __esweep_evalFail(p, "syntax error");
+	if (root >= 0 && p->error == NULL) __esweep_evalEmit(p, root);
+	if (p->error == NULL && p->depth > EVAL_STACK) __esweep_evalFail(p, "expression too deep");
+	if (p->error != NULL) {
+		snprintf(errmsg, 256, "%s:%i: %s: %s at position %i of \"%s\"\n", __FILE__, __LINE__, __func__, p->error, (int) (p->pos-src), src);
+		fprintf(stderr, errmsg);
+		free(prog);
+		free(p);
+		return NULL;
+	}
+	for (i=0; i < n; i++) prog->value[i]=0.0;
+	prog->key=key;
+	free(p);
+	return prog;
+}
+
+/* cached program for the source and the variable names, compiled if necessary */
+static eval_program *__esweep_evalGet(const char *src, int n, const char *names[]) {
+	eval_program *prog=NULL;
+	char *key;
+	int i, len, lru=-1;
+
+	len=strlen(src)+1;
+	for (i=0; i < n; i++) len+=strlen(names[i])+1;
+	ESWEEP_MALLOC(key, len, sizeof(char), NULL);
+	strcpy(key, src);
+	for (i=0; i < n; i++) {
+		strcat(key, "\n");
+		strcat(key, names[i]);
+	}
+
+	pthread_mutex_lock(&eval_lock);
+	for (i=0; i < EVAL_CACHE; i++) {
+		if (eval_cache[i] != NULL && strcmp(eval_cache[i]->key, key) == 0) {
+			prog=eval_cache[i];
+			break;
+		}
+	}
+	if (prog == NULL && (prog=__esweep_evalCompile(src, n, names, key)) != NULL) {
+		/* free slot or the least recently used program that is not running */
+		for (i=0; i < EVAL_CACHE; i++) {
+			if (eval_cache[i] == NULL) {
+				lru=i;
+				break;
+			}
+			if (eval_cache[i]->refs == 0 && (lru < 0 || eval_cache[i]->used < eval_cache[lru]->used)) lru=i;
+		}
+		if (lru >= 0) {
+			if (eval_cache[lru] != NULL) {
+				free(eval_cache[lru]->key);
+				free(eval_cache[lru]);
+			}
+			eval_cache[lru]=prog;
+		} else {
+			/* all programs are running, this one is freed after use */
+			prog->refs=-1;
+		}
+		key=NULL;
+	}
+	if (prog != NULL) {
+		if (prog->refs >= 0) prog->refs++;
+		prog->used=++eval_clock;
+	}
+	pthread_mutex_unlock(&eval_lock);
+	free(key);
+	return prog;
+}
+
+static void __esweep_evalRelease(eval_program *prog) {
+	pthread_mutex_lock(&eval_lock);
+	if (prog->refs < 0) {
+		free(prog->key);
+		free(prog);
+	} else {
+		prog->refs--;
+	}
+	pthread_mutex_unlock(&eval_lock);
+}
+
+/*
+ * Execution
+ */
+
+#define EVAL_UNARY_CASE(OP) \
+	case EVAL_##OP: \
+		for (k=0; k < EVAL_CHUNK; k++) top[k]=EVAL_F_##OP(top[k]); \
+		break;
+
+#define EVAL_BINARY_CASE(OP) \
+	case EVAL_##OP: \
+		switch (ins->operand) { \
+			case EVAL_OPERAND_RIGHT: \
+				for (k=0; k < EVAL_CHUNK; k++) top[k]=EVAL_F_##OP(top[k], c); \
+				break; \
+			case EVAL_OPERAND_LEFT: \
+				for (k=0; k < EVAL_CHUNK; k++) top[k]=EVAL_F_##OP(c, top[k]); \
+				break; \
+			case EVAL_OPERAND_REVERSED: \
+				below=stack[sp-2]; \
+				for (k=0; k < EVAL_CHUNK; k++) below[k]=EVAL_F_##OP(top[k], below[k]); \
+				sp--; \
+				break; \
+			default: \
+				below=stack[sp-2]; \
+				for (k=0; k < EVAL_CHUNK; k++) below[k]=EVAL_F_##OP(below[k], top[k]); \
+				sp--; \
+				break; \
+		} \
+		break;
+
+/* run the program over one chunk x of elements, starting at element index; the result is in stack[0] */
+static void __esweep_evalRun(const eval_program *prog, const Real *value, const Real *x, int index, Real stack[EVAL_STACK][EVAL_CHUNK]) {
+	const eval_ins *ins;
+	Real *top, *below, c;
+	int k, pc, sp=0;
+
+	for (pc=0; pc < prog->size; pc++) {
+		ins=prog->code+pc;
+		c=value[ins->slot];
+		switch (ins->op) {
+			case EVAL_X:
+				memcpy(stack[sp++], x, EVAL_CHUNK*sizeof(Real));
+				continue;
+			case EVAL_I:
+				top=stack[sp++];
+				for (k=0; k < EVAL_CHUNK; k++) top[k]=index+k;
+				continue;
+			case EVAL_CONST:
+				top=stack[sp++];
+				for (k=0; k < EVAL_CHUNK; k++) top[k]=c;
+				continue;
+		}
+		top=stack[sp-1];
+		switch (ins->op) {
+			EVAL_UNARY_CASE(NEG)
+			EVAL_UNARY_CASE(ABS)
+			EVAL_UNARY_CASE(SQRT)
+			EVAL_UNARY_CASE(SQR)
+			EVAL_UNARY_CASE(LG)
+			EVAL_UNARY_CASE(LN)
+			EVAL_UNARY_CASE(EXP)
+			EVAL_UNARY_CASE(SIN)
+			EVAL_UNARY_CASE(COS)
+			EVAL_UNARY_CASE(TAN)
+			EVAL_UNARY_CASE(ATAN)
+			EVAL_UNARY_CASE(FLOOR)
+			EVAL_UNARY_CASE(CEIL)
+			EVAL_BINARY_CASE(ADD)
+			EVAL_BINARY_CASE(SUB)
+			EVAL_BINARY_CASE(MUL)
+			EVAL_BINARY_CASE(DIV)
+			EVAL_BINARY_CASE(POW)
+			EVAL_BINARY_CASE(MIN)
+			EVAL_BINARY_CASE(MAX)
+		}
+	}
+}
+
+int esweep_eval(esweep_object *obj, const char *expr, int n, const char *names[], const Real values[]) {
+	eval_program *prog;
+	Surface *surf;
+	Real *data, value[EVAL_CONSTS];
+	Real x[EVAL_CHUNK], stack[EVAL_STACK][EVAL_CHUNK];
+	int i, k, m, size, stride;
+	esweep_nonFinite nf;
+
+	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(expr != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(n >= 0 && n <= EVAL_VARS, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(n == 0 || (names != NULL && values != NULL), ERR_BAD_ARGUMENT);
+
+	switch (obj->type) {
+		case WAVE:
+			data=(Real*) obj->data;
+			size=obj->size;
+			stride=1;
+			break;
+		case POLAR:
+			data=&((Polar*) obj->data)->abs;
+			size=obj->size;
+			stride=sizeof(Polar)/sizeof(Real);
+			break;
+		case SURFACE:
+			surf=(Surface*) obj->data;
+			ESWEEP_OBJ_ISVALID_SURFACE(obj, surf, ERR_NOT_ON_THIS_TYPE, ERR_OBJ_NOT_VALID);
+			data=surf->z;
+			size=surf->xsize*surf->ysize;
+			stride=1;
+			break;
+		default:
+			ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE);
+	}
+
+	if ((prog=__esweep_evalGet(expr, n, names)) == NULL) return ERR_BAD_ARGUMENT;
+	value[0]=0.0;
+	memcpy(value, prog->value, prog->consts*sizeof(Real));
+	for (i=0; i < n; i++) value[i]=values[i];
+
+	__esweep_nonFinite_enter(&nf);
+	for (i=0; i < size; i+=m) {
+		m=size-i < EVAL_CHUNK ? size-i : EVAL_CHUNK;
+		if (stride == 1) {
+			memcpy(x, data+i, m*sizeof(Real));
+		} else {
+			for (k=0; k < m; k++) x[k]=data[(i+k)*stride];
+		}
+		for (k=m; k < EVAL_CHUNK; k++) x[k]=x[m-1];
+		__esweep_evalRun(prog, value, x, i, stack);
+		__esweep_nonFinite_scan(&nf, stack[0], m);
+		if (stride == 1) {
+			memcpy(data+i, stack[0], m*sizeof(Real));
+		} else {
+			for (k=0; k < m; k++) data[(i+k)*stride]=stack[0][k];
+		}
+	}
+	__esweep_evalRelease(prog);
+
+	return __esweep_nonFinite_leave(&nf);
+}
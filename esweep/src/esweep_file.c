@@ -182,7 +182,7 @@ int esweep_load(esweep_object *output, const char *filename, char **meta) {
 	obj.size=ntohl(nl);
 
 	/* copy data */
-	if (output->data != NULL) free(output->data);
+	if (output->data != NULL) __esweep_freeData(output->data);
 	switch (obj.type) {
 		case WAVE:
 			/* create temporary data */
@@ -19,6 +19,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/mman.h>
+#endif
+
 #include "esweep_priv.h"
 
 #include "dsp.h"
@@ -231,23 +236,170 @@ static inline void interpolate(esweep_object *out, esweep_object *in, Complex *c
 static inline void decimate(esweep_object *out, esweep_object *in) {
 }
 
+/*
+ * Specialized biquad cascades
+ *
+ * The generic IIR loop below reloads the coefficients and the state of each section
+ * from memory for every sample. Most filters consist of only a few sections (e. g. the filters
+ * from esweep_createFilterFromCoeff() have 1 section, a cascade of them typically 2-8),
+ * so we emit a separate kernel for every section count up to ESWEEP_IIR_MAX_SECTIONS.
+ * These kernels run the sample loop outside and the (fully expanded) section loop inside.
+ * Coefficients and state are copied into locals before the block and the state is written
+ * back afterwards, so the compiler can keep them in registers.
+ * The order of the floating point operations is the same as in the generic loop, hence
+ * the results are bit-identical.
+ * dc is the denormal offset (see esweep_setDenormals()), it is 0 unless the "dc" policy is set.
+ */
+
+#define ESWEEP_IIR_MAX_SECTIONS 16
+
+/* one TF2 section, WAVE */
+#define IIR_SECTION(k) \
+	y=x*b0[k]+s1[k]; \
+	s1[k]=b1[k]*x-a1[k]*y+s2[k]; \
+	s2[k]=b2[k]*x-a2[k]*y+dc; \
+	x=y;
+
+/* one TF2 section, COMPLEX */
+#define IIR_SECTION_CPX(k) \
+	y.real=x.real*b0[k]+s1[k].real; \
+	y.imag=x.imag*b0[k]+s1[k].imag; \
+	s1[k].real=b1[k]*x.real-a1[k]*y.real+s2[k].real; \
+	s1[k].imag=b1[k]*x.imag-a1[k]*y.imag+s2[k].imag; \
+	s2[k].real=b2[k]*x.real-a2[k]*y.real+dc; \
+	s2[k].imag=b2[k]*x.imag-a2[k]*y.imag+dc; \
+	x=y;
+
+#define IIR_SECTIONS_1(S) S(0)
+#define IIR_SECTIONS_2(S) IIR_SECTIONS_1(S) S(1)
+#define IIR_SECTIONS_3(S) IIR_SECTIONS_2(S) S(2)
+#define IIR_SECTIONS_4(S) IIR_SECTIONS_3(S) S(3)
+#define IIR_SECTIONS_5(S) IIR_SECTIONS_4(S) S(4)
+#define IIR_SECTIONS_6(S) IIR_SECTIONS_5(S) S(5)
+#define IIR_SECTIONS_7(S) IIR_SECTIONS_6(S) S(6)
+#define IIR_SECTIONS_8(S) IIR_SECTIONS_7(S) S(7)
+#define IIR_SECTIONS_9(S) IIR_SECTIONS_8(S) S(8)
+#define IIR_SECTIONS_10(S) IIR_SECTIONS_9(S) S(9)
+#define IIR_SECTIONS_11(S) IIR_SECTIONS_10(S) S(10)
+#define IIR_SECTIONS_12(S) IIR_SECTIONS_11(S) S(11)
+#define IIR_SECTIONS_13(S) IIR_SECTIONS_12(S) S(12)
+#define IIR_SECTIONS_14(S) IIR_SECTIONS_13(S) S(13)
+#define IIR_SECTIONS_15(S) IIR_SECTIONS_14(S) S(14)
+#define IIR_SECTIONS_16(S) IIR_SECTIONS_15(S) S(15)
+
+/* load the coefficients of N sections into locals */
+#define IIR_LOAD_COEFFS(N) \
+	Real b0[N], b1[N], b2[N], a1[N], a2[N]; \
+	for (k=0; k < N; k++) { \
+		b0[k]=num[3*k]; \
+		b1[k]=num[3*k+1]; \
+		b2[k]=num[3*k+2]; \
+		a1[k]=denom[3*k+1]; \
+		a2[k]=denom[3*k+2]; \
+	}
+
+#define IIR_KERNEL(N) \
+static void __esweep_filter_iir_##N(Wave *wave, int size, const Real *num, const Real *denom, Complex *state, Real dc) { \
+	int i, k; \
+	Real x, y; \
+	Real s1[N], s2[N]; \
+	IIR_LOAD_COEFFS(N) \
+	for (k=0; k < N; k++) { \
+		s1[k]=state[3*k].real; \
+		s2[k]=state[3*k+1].real; \
+	} \
+	for (i=0; i < size; i++) { \
+		x=wave[i]; \
+		IIR_SECTIONS_##N(IIR_SECTION) \
+		wave[i]=x; \
+	} \
+	for (k=0; k < N; k++) { \
+		state[3*k].real=s1[k]; \
+		state[3*k+1].real=s2[k]; \
+	} \
+} \
+static void __esweep_filter_iir_cpx_##N(Complex *cpx, int size, const Real *num, const Real *denom, Complex *state, Real dc) { \
+	int i, k; \
+	Complex x, y; \
+	Complex s1[N], s2[N]; \
+	IIR_LOAD_COEFFS(N) \
+	for (k=0; k < N; k++) { \
+		s1[k]=state[3*k]; \
+		s2[k]=state[3*k+1]; \
+	} \
+	for (i=0; i < size; i++) { \
+		x=cpx[i]; \
+		IIR_SECTIONS_##N(IIR_SECTION_CPX) \
+		cpx[i]=x; \
+	} \
+	for (k=0; k < N; k++) { \
+		state[3*k]=s1[k]; \
+		state[3*k+1]=s2[k]; \
+	} \
+}
+
+IIR_KERNEL(1)
+IIR_KERNEL(2)
+IIR_KERNEL(3)
+IIR_KERNEL(4)
+IIR_KERNEL(5)
+IIR_KERNEL(6)
+IIR_KERNEL(7)
+IIR_KERNEL(8)
+IIR_KERNEL(9)
+IIR_KERNEL(10)
+IIR_KERNEL(11)
+IIR_KERNEL(12)
+IIR_KERNEL(13)
+IIR_KERNEL(14)
+IIR_KERNEL(15)
+IIR_KERNEL(16)
+
+typedef void (*iir_kernel_wave)(Wave*, int, const Real*, const Real*, Complex*, Real);
+typedef void (*iir_kernel_cpx)(Complex*, int, const Real*, const Real*, Complex*, Real);
+
+/* index is the number of sections */
+static const iir_kernel_wave iir_kernels_wave[ESWEEP_IIR_MAX_SECTIONS+1] = {
+	NULL,
+	__esweep_filter_iir_1, __esweep_filter_iir_2, __esweep_filter_iir_3, __esweep_filter_iir_4,
+	__esweep_filter_iir_5, __esweep_filter_iir_6, __esweep_filter_iir_7, __esweep_filter_iir_8,
+	__esweep_filter_iir_9, __esweep_filter_iir_10, __esweep_filter_iir_11, __esweep_filter_iir_12,
+	__esweep_filter_iir_13, __esweep_filter_iir_14, __esweep_filter_iir_15, __esweep_filter_iir_16
+};
+
+static const iir_kernel_cpx iir_kernels_cpx[ESWEEP_IIR_MAX_SECTIONS+1] = {
+	NULL,
+	__esweep_filter_iir_cpx_1, __esweep_filter_iir_cpx_2, __esweep_filter_iir_cpx_3, __esweep_filter_iir_cpx_4,
+	__esweep_filter_iir_cpx_5, __esweep_filter_iir_cpx_6, __esweep_filter_iir_cpx_7, __esweep_filter_iir_cpx_8,
+	__esweep_filter_iir_cpx_9, __esweep_filter_iir_cpx_10, __esweep_filter_iir_cpx_11, __esweep_filter_iir_cpx_12,
+	__esweep_filter_iir_cpx_13, __esweep_filter_iir_cpx_14, __esweep_filter_iir_cpx_15, __esweep_filter_iir_cpx_16
+};
+
 static inline void __esweep_filter_iir(esweep_object *in, esweep_object *filter[]) {
 	int i, j;
+	int sections=filter[0]->size/3;
 	Wave *wave, tmp;
 	Real *num=(filter[0])->data, *denom=(filter[1])->data;
 	Complex *state=(filter[2])->data;
 	Complex *cpx;
 	Real t_real, t_imag;
+	Real dc=__esweep_denormal_dc();
+	unsigned int csr;
 
+	ESWEEP_DENORMAL_ENTER(csr);
 	switch (in->type) {
 		case WAVE:
 			wave=in->data;
+			if (sections <= ESWEEP_IIR_MAX_SECTIONS) {
+				iir_kernels_wave[sections](wave, in->size, num, denom, state, dc);
+				break;
+			}
 			for (j=0; j < filter[0]->size; j+=3) {
 				for (i=0; i < in->size; i++) {
 					tmp=wave[i]*num[j]+state[j].real;
 
 					state[j].real=num[j+1]*wave[i]-denom[j+1]*tmp+state[j+1].real;
-					state[j+1].real=num[j+2]*wave[i]-denom[j+2]*tmp;
+					state[j+1].real=num[j+2]*wave[i]-denom[j+2]*tmp+dc;
 
 					wave[i]=tmp;
 				}
@@ -255,6 +407,10 @@ static inline void __esweep_filter_iir(esweep_object *in, esweep_object *filter[
 			break;
 		case COMPLEX:
 			cpx=in->data;
+			if (sections <= ESWEEP_IIR_MAX_SECTIONS) {
+				iir_kernels_cpx[sections](cpx, in->size, num, denom, state, dc);
+				break;
+			}
 			for (j=0; j < filter[0]->size; j+=3) {
 				for (i=0; i < in->size; i++) {
 					t_real=cpx[i].real*num[j]+state[j].real;
@@ -262,8 +418,8 @@ static inline void __esweep_filter_iir(esweep_object *in, esweep_object *filter[
 
 					state[j].real=num[j+1]*cpx[i].real-denom[j+1]*t_real+state[j+1].real;
 					state[j].imag=num[j+1]*cpx[i].imag-denom[j+1]*t_imag+state[j+1].imag;
-					state[j+1].real=num[j+2]*cpx[i].real-denom[j+2]*t_real;
-					state[j+1].imag=num[j+2]*cpx[i].imag-denom[j+2]*t_imag;
+					state[j+1].real=num[j+2]*cpx[i].real-denom[j+2]*t_real+dc;
+					state[j+1].imag=num[j+2]*cpx[i].imag-denom[j+2]*t_imag+dc;
 					cpx[i].real=t_real;
 					cpx[i].imag=t_imag;
 				}
@@ -272,6 +428,7 @@ static inline void __esweep_filter_iir(esweep_object *in, esweep_object *filter[
 		default:
 			break;
 	}
+	ESWEEP_DENORMAL_LEAVE(csr);
 }
 
 static inline void __esweep_filter_fir(esweep_object *in, esweep_object *filter[]) {
@@ -281,7 +438,9 @@ static inline void __esweep_filter_fir(esweep_object *in, esweep_object *filter[
 	Complex *state=filter[2]->data;
 	Complex *cpx;
 	Complex tmp[2];
+	unsigned int csr;
 
+	ESWEEP_DENORMAL_ENTER(csr);
 	switch (in->type) {
 		case WAVE:
 			wave=in->data;
@@ -318,6 +477,7 @@ static inline void __esweep_filter_fir(esweep_object *in, esweep_object *filter[
 		default:
 			break;
 	}
+	ESWEEP_DENORMAL_LEAVE(csr);
 }
 
 /*
@@ -673,7 +833,47 @@ int esweep_freeFilter(esweep_object *filter[]) {
 	return ERR_OK;
 }
 
-#define FILE_ID "esweep_filter"
+/*
+ * Filter files
+ *
+ * A filter file is a container with a fixed header, followed by the numerator, the denominator
+ * (IIR only), optional precomputed spectra (e. g. the partitions of a long FIR kernel for
+ * esweep_convolve()) and optional meta data. Each section starts at a multiple of FILTER_ALIGN bytes.
+ * The data is written in the native layout of the machine, the byte order and the size of Real
+ * are recorded in the header. When both match, the file is mapped into memory and the objects
+ * point directly into the mapping, otherwise the data is read and converted.
+ * The filter state is not stored, loaded filters are always reset.
+ * Files in the old format (LEGACY_FILE_ID) can still be loaded.
+ */
+
+#define LEGACY_FILE_ID "esweep_filter"
+
+#define FILTER_FILE_ID "esweepFC"
+#define FILTER_FILE_VERSION 1
+#define FILTER_BYTE_ORDER 0x01020304
+#define FILTER_ALIGN 64
+#define FILTER_ALIGNED(x) ((((x)+FILTER_ALIGN-1)/FILTER_ALIGN)*FILTER_ALIGN)
+
+/* 128 bytes */
+typedef struct {
+	char id[8];
+	u_int32_t version;
+	u_int32_t byte_order;
+	u_int32_t real_size;
+	int32_t samplerate;
+	int32_t size;
+	int32_t filter_type;
+	int32_t n_spectra;
+	int32_t fft_size;
+	u_int32_t meta_size;
+	u_int32_t reserved0;
+	u_int64_t num_offset;
+	u_int64_t denom_offset;
+	u_int64_t spectra_offset;
+	u_int64_t meta_offset;
+	u_int64_t file_size;
+	char reserved[40];
+} filter_header;
 
 /* helper functions */
 static int close_on_error(FILE *fp) {
@@ -684,116 +884,345 @@ static int close_on_error(FILE *fp) {
 static void *load_close_on_error(FILE *fp, esweep_object **filter) {
 	fclose(fp);
 	if (filter != NULL) {
-		esweep_free(filter[0]);
-		esweep_free(filter[1]);
-		esweep_free(filter[2]);
+		if (filter[0] != NULL) esweep_free(filter[0]);
+		if (filter[1] != NULL) esweep_free(filter[1]);
+		if (filter[2] != NULL) esweep_free(filter[2]);
+		free(filter);
 	}
 	return NULL;
 }
 
+/* as above, but also frees the spectra and a mapping which is not registered yet */
+static void *load_unmap_on_error(FILE *fp, esweep_object **filter, esweep_object **spec, int n, char *base, size_t length) {
+	int i;
+
+	if (spec != NULL) {
+		for (i=0; i < n; i++) {
+			if (spec[i] != NULL) esweep_free(spec[i]);
+		}
+		free(spec);
+	}
+#ifndef _WIN32
+	if (base != NULL) munmap(base, length);
+#endif
+	return load_close_on_error(fp, filter);
+}
+
+static u_int32_t swap32(u_int32_t x) {
+	return (x & 0xff) << 24 | (x & 0xff00) << 8 | (x & 0xff0000) >> 8 | (x & 0xff000000) >> 24;
+}
+
+static u_int64_t swap64(u_int64_t x) {
+	return (u_int64_t) swap32((u_int32_t) x) << 32 | swap32((u_int32_t) (x >> 32));
+}
+
+static void swap_header(filter_header *hdr) {
+	hdr->version=swap32(hdr->version);
+	hdr->byte_order=swap32(hdr->byte_order);
+	hdr->real_size=swap32(hdr->real_size);
+	hdr->samplerate=(int32_t) swap32((u_int32_t) hdr->samplerate);
+	hdr->size=(int32_t) swap32((u_int32_t) hdr->size);
+	hdr->filter_type=(int32_t) swap32((u_int32_t) hdr->filter_type);
+	hdr->n_spectra=(int32_t) swap32((u_int32_t) hdr->n_spectra);
+	hdr->fft_size=(int32_t) swap32((u_int32_t) hdr->fft_size);
+	hdr->meta_size=swap32(hdr->meta_size);
+	hdr->num_offset=swap64(hdr->num_offset);
+	hdr->denom_offset=swap64(hdr->denom_offset);
+	hdr->spectra_offset=swap64(hdr->spectra_offset);
+	hdr->meta_offset=swap64(hdr->meta_offset);
+	hdr->file_size=swap64(hdr->file_size);
+}
+
+/* pad the file with zeros up to offset, then write the section */
+static int write_section(FILE *fp, u_int64_t offset, const void *data, size_t size, size_t n) {
+	while ((u_int64_t) ftell(fp) < offset) {
+		if (fputc(0, fp) == EOF) return 0;
+	}
+	return fwrite(data, size, n, fp) == n;
+}
+
+/* read n reals of real_size bytes at offset and convert them to Real */
+static int read_section(FILE *fp, u_int64_t offset, Real *dst, int n, int real_size, int swap) {
+	union {
+		float f;
+		u_int32_t u;
+	} c32;
+	union {
+		double d;
+		u_int64_t u;
+	} c64;
+	char *buf;
+	int i;
+
+	if (fseek(fp, (long) offset, SEEK_SET) != 0) return 0;
+	if (real_size == sizeof(Real) && !swap) return fread(dst, sizeof(Real), n, fp) == n;
+
+	if ((buf=(char*) malloc(n*real_size)) == NULL) return 0;
+	if (fread(buf, real_size, n, fp) != n) {
+		free(buf);
+		return 0;
+	}
+	for (i=0; i < n; i++) {
+		if (real_size == 4) {
+			memcpy(&(c32.u), buf+4*i, 4);
+			if (swap) c32.u=swap32(c32.u);
+			dst[i]=c32.f;
+		} else {
+			memcpy(&(c64.u), buf+8*i, 8);
+			if (swap) c64.u=swap64(c64.u);
+			dst[i]=c64.d;
+		}
+	}
+	free(buf);
+	return 1;
+}
+
 int esweep_saveFilter(const char *filename, esweep_object *filter[]) {
+	return esweep_saveFilterExt(filename, filter, NULL, 0, NULL);
+}
+
+int esweep_saveFilterExt(const char *filename, esweep_object *filter[], esweep_object *spectra[], int n_spectra, const char *meta) {
 	FILE *fp;
-	const char *id=FILE_ID;
-	int filter_type=-1;
-	Real *wave;
-	Complex *cpx;
+	filter_header hdr;
+	u_int64_t offset;
+	int i;
 
 	ESWEEP_ASSERT(filename != NULL, ERR_BAD_ARGUMENT);
 	ESWEEP_ASSERT(strlen(filename) > 0, ERR_BAD_ARGUMENT);
 	ESWEEP_FILTER_CHECK(filter, ERR_EMPTY_OBJECT, ERR_DIFF_MAPPING, ERR_SIZE_MISMATCH, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_ASSERT(n_spectra >= 0, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(n_spectra == 0 || spectra != NULL, ERR_BAD_ARGUMENT);
+	for (i=0; i < n_spectra; i++) {
+		ESWEEP_OBJ_NOTEMPTY(spectra[i], ERR_EMPTY_OBJECT);
+		ESWEEP_ASSERT(spectra[i]->type == COMPLEX, ERR_NOT_ON_THIS_TYPE);
+		ESWEEP_SAME_MAPPING(filter[0], spectra[i], ERR_DIFF_MAPPING);
+		ESWEEP_ASSERT(spectra[i]->size == spectra[0]->size, ERR_SIZE_MISMATCH);
+	}
 
-	/* open file */
+	/* fill the header and calculate the layout */
+	memset(&hdr, 0, sizeof(filter_header));
+	memcpy(hdr.id, FILTER_FILE_ID, sizeof(hdr.id));
+	hdr.version=FILTER_FILE_VERSION;
+	hdr.byte_order=FILTER_BYTE_ORDER;
+	hdr.real_size=sizeof(Real);
+	hdr.samplerate=filter[0]->samplerate;
+	hdr.size=filter[0]->size;
+	hdr.filter_type=filter[1] == NULL ? ESWEEP_FILTER_FIR : ESWEEP_FILTER_IIR;
+	hdr.n_spectra=n_spectra;
+	hdr.fft_size=n_spectra > 0 ? spectra[0]->size : 0;
+	hdr.meta_size=meta != NULL ? strlen(meta) : 0;
+
+	/* offset is the end of the last section; the file ends there, without padding */
+	hdr.num_offset=FILTER_ALIGNED(sizeof(filter_header));
+	offset=hdr.num_offset+hdr.size*sizeof(Real);
+	if (hdr.filter_type == ESWEEP_FILTER_IIR) {
+		hdr.denom_offset=FILTER_ALIGNED(offset);
+		offset=hdr.denom_offset+hdr.size*sizeof(Real);
+	}
+	if (n_spectra > 0) {
+		hdr.spectra_offset=FILTER_ALIGNED(offset);
+		offset=hdr.spectra_offset+(u_int64_t) n_spectra*hdr.fft_size*sizeof(Complex);
+	}
+	if (hdr.meta_size > 0) {
+		hdr.meta_offset=FILTER_ALIGNED(offset);
+		offset=hdr.meta_offset+hdr.meta_size;
+	}
+	hdr.file_size=offset;
 
+	/* open file */
 	ESWEEP_ASSERT((fp = fopen(filename, "wb")) != NULL, ERR_UNKNOWN);
 
-	/* write file id */
-	ESWEEP_ASSERT(fwrite(id, strlen(id)*sizeof(char), 1, fp) == 1, close_on_error(fp));
-
-	/* write samplerate */
-	ESWEEP_ASSERT(fwrite(&(filter[0]->samplerate), sizeof(filter[0]->samplerate), 1, fp) == 1, close_on_error(fp));
-
-	/* write samples */
-	ESWEEP_ASSERT(fwrite(&(filter[0]->size), sizeof(filter[0]->size), 1, fp) == 1, close_on_error(fp));
-
-	/* write filter type */
-	if (filter[1]==NULL) filter_type=ESWEEP_FILTER_FIR;
-	else filter_type=ESWEEP_FILTER_IIR;
-	ESWEEP_ASSERT(fwrite(&filter_type, sizeof(filter_type), 1, fp) == 1, close_on_error(fp));
-
-	/* write data */
-	wave=filter[0]->data;
-	ESWEEP_ASSERT(fwrite(wave, sizeof(Real), filter[0]->size, fp) == filter[0]->size, close_on_error(fp));
-	if (filter_type == ESWEEP_FILTER_IIR) {
-		wave=filter[1]->data;
-		ESWEEP_ASSERT(fwrite(wave, sizeof(Real), filter[1]->size, fp) == filter[1]->size, close_on_error(fp));
+	ESWEEP_ASSERT(fwrite(&hdr, sizeof(filter_header), 1, fp) == 1, close_on_error(fp));
+	ESWEEP_ASSERT(write_section(fp, hdr.num_offset, filter[0]->data, sizeof(Real), hdr.size), close_on_error(fp));
+	if (hdr.filter_type == ESWEEP_FILTER_IIR) {
+		ESWEEP_ASSERT(write_section(fp, hdr.denom_offset, filter[1]->data, sizeof(Real), hdr.size), close_on_error(fp));
+	}
+	for (i=0; i < n_spectra; i++) {
+		ESWEEP_ASSERT(write_section(fp, hdr.spectra_offset+(u_int64_t) i*hdr.fft_size*sizeof(Complex), \
+					spectra[i]->data, sizeof(Complex), hdr.fft_size), close_on_error(fp));
+	}
+	if (hdr.meta_size > 0) {
+		ESWEEP_ASSERT(write_section(fp, hdr.meta_offset, meta, sizeof(char), hdr.meta_size), close_on_error(fp));
 	}
-	cpx=filter[2]->data;
-	ESWEEP_ASSERT(fwrite(cpx, sizeof(Complex), filter[2]->size, fp) == filter[2]->size, close_on_error(fp));
 
-	fclose(fp);
+	ESWEEP_ASSERT(fclose(fp) == 0, ERR_UNKNOWN);
 	return ERR_OK;
 }
 
+static esweep_object **load_legacy_filter(const char *filename);
+
 esweep_object **esweep_loadFilter(const char *filename) {
+	return esweep_loadFilterExt(filename, NULL, NULL, NULL);
+}
+
+esweep_object **esweep_loadFilterExt(const char *filename, esweep_object **spectra[], int *n_spectra, char **meta) {
 	FILE *fp;
-	int id_length=strlen(FILE_ID);
-	char *id=(char*) calloc(id_length+1, sizeof(char));
-	esweep_object **filter;
-	int filter_type=-1;
-	Real *wave;
-	Complex *cpx;
+	filter_header hdr;
+	esweep_object **filter=NULL, **spec=NULL;
+	char *base=NULL;
+	long file_size;
+	int swap, i, n, refcount=0;
 
 	ESWEEP_ASSERT(filename != NULL, NULL);
 	ESWEEP_ASSERT(strlen(filename) > 0, NULL);
+	if (spectra != NULL) *spectra=NULL;
+	if (n_spectra != NULL) *n_spectra=0;
+	if (meta != NULL) *meta=NULL;
 
 	/* open input file */
-
 	ESWEEP_ASSERT((fp = fopen(filename, "rb")) != NULL, NULL);
 
-	/* read file id */
-	ESWEEP_ASSERT(fread(id, sizeof(char), id_length, fp) == id_length, load_close_on_error(fp, NULL));
-	ESWEEP_ASSERT(strcmp(id, FILE_ID) == 0, load_close_on_error(fp, NULL));
-	free(id);
+	/* read header */
+	memset(&hdr, 0, sizeof(filter_header));
+	if (fread(&hdr, sizeof(filter_header), 1, fp) != 1 || memcmp(hdr.id, FILTER_FILE_ID, sizeof(hdr.id)) != 0) {
+		/* maybe the old format */
+		fclose(fp);
+		return load_legacy_filter(filename);
+	}
 
-	/* create a new filter object */
-	ESWEEP_MALLOC(filter, 3, sizeof(filter), NULL);
-	ESWEEP_MALLOC(filter[0], 1, sizeof(esweep_object), NULL);
+	if (hdr.byte_order == FILTER_BYTE_ORDER) {
+		swap=0;
+	} else {
+		ESWEEP_ASSERT(swap32(hdr.byte_order) == FILTER_BYTE_ORDER, load_close_on_error(fp, NULL));
+		swap_header(&hdr);
+		swap=1;
+	}
 
-	/* read samplerate */
-	ESWEEP_ASSERT(fread(&(filter[0]->samplerate), sizeof(filter[0]->samplerate), 1, fp) == 1, load_close_on_error(fp, filter));
+	/* validate the header */
+	ESWEEP_ASSERT(hdr.version <= FILTER_FILE_VERSION, load_close_on_error(fp, NULL));
+	ESWEEP_ASSERT(hdr.real_size == sizeof(float) || hdr.real_size == sizeof(double), load_close_on_error(fp, NULL));
+	ESWEEP_ASSERT(hdr.samplerate > 0, load_close_on_error(fp, NULL));
+	ESWEEP_ASSERT(hdr.size > 0 && hdr.size < ESWEEP_MAX_SIZE, load_close_on_error(fp, NULL));
+	ESWEEP_ASSERT(hdr.filter_type == ESWEEP_FILTER_FIR || hdr.filter_type == ESWEEP_FILTER_IIR, load_close_on_error(fp, NULL));
+	ESWEEP_ASSERT(hdr.filter_type == ESWEEP_FILTER_FIR || hdr.size % 3 == 0, load_close_on_error(fp, NULL));
+	ESWEEP_ASSERT(hdr.n_spectra >= 0 && hdr.fft_size >= 0 && hdr.fft_size < ESWEEP_MAX_SIZE, load_close_on_error(fp, NULL));
+	ESWEEP_ASSERT(hdr.n_spectra == 0 || hdr.fft_size > 0, load_close_on_error(fp, NULL));
+
+	ESWEEP_ASSERT(fseek(fp, 0, SEEK_END) == 0, load_close_on_error(fp, NULL));
+	file_size=ftell(fp);
+	ESWEEP_ASSERT(file_size > 0 && hdr.file_size <= (u_int64_t) file_size, load_close_on_error(fp, NULL));
+	ESWEEP_ASSERT(hdr.num_offset+(u_int64_t) hdr.size*hdr.real_size <= hdr.file_size, load_close_on_error(fp, NULL));
+	ESWEEP_ASSERT(hdr.filter_type == ESWEEP_FILTER_FIR || \
+			hdr.denom_offset+(u_int64_t) hdr.size*hdr.real_size <= hdr.file_size, load_close_on_error(fp, NULL));
+	ESWEEP_ASSERT(hdr.spectra_offset+(u_int64_t) hdr.n_spectra*hdr.fft_size*2*hdr.real_size <= hdr.file_size, load_close_on_error(fp, NULL));
+	ESWEEP_ASSERT(hdr.meta_offset+hdr.meta_size <= hdr.file_size, load_close_on_error(fp, NULL));
+
+#ifndef _WIN32
+	/* zero-copy when the layout matches; the mapping is private, modifications never reach the file */
+	if (!swap && hdr.real_size == sizeof(Real) && hdr.num_offset % sizeof(Real) == 0 \
+			&& hdr.denom_offset % sizeof(Real) == 0 && hdr.spectra_offset % sizeof(Real) == 0) {
+		base=(char*) mmap(NULL, (size_t) hdr.file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(fp), 0);
+		if (base == MAP_FAILED) base=NULL;
+	}
+#endif
+
+	ESWEEP_MALLOC(filter, 3, sizeof(esweep_object*), load_unmap_on_error(fp, NULL, NULL, 0, base, (size_t) hdr.file_size));
+	ESWEEP_ASSERT((filter[0]=esweep_create("wave", hdr.samplerate, base == NULL ? hdr.size : 0)) != NULL, \
+			load_unmap_on_error(fp, filter, NULL, 0, base, (size_t) hdr.file_size));
+	if (hdr.filter_type == ESWEEP_FILTER_IIR) {
+		ESWEEP_ASSERT((filter[1]=esweep_create("wave", hdr.samplerate, base == NULL ? hdr.size : 0)) != NULL, \
+				load_unmap_on_error(fp, filter, NULL, 0, base, (size_t) hdr.file_size));
+	}
+	/* the state is always allocated */
+	ESWEEP_ASSERT((filter[2]=esweep_create("complex", hdr.samplerate, hdr.size)) != NULL, \
+			load_unmap_on_error(fp, filter, NULL, 0, base, (size_t) hdr.file_size));
+
+	n=(spectra != NULL) ? hdr.n_spectra : 0;
+	if (n > 0) {
+		ESWEEP_MALLOC(spec, n, sizeof(esweep_object*), load_unmap_on_error(fp, filter, NULL, 0, base, (size_t) hdr.file_size));
+		for (i=0; i < n; i++) {
+			ESWEEP_ASSERT((spec[i]=esweep_create("complex", hdr.samplerate, base == NULL ? hdr.fft_size : 0)) != NULL, \
+					load_unmap_on_error(fp, filter, spec, n, base, (size_t) hdr.file_size));
+		}
+	}
 
-	/* read size */
-	ESWEEP_ASSERT(fread(&(filter[0]->size), sizeof(filter[0]->size), 1, fp) == 1, load_close_on_error(fp, filter));
+	if (base != NULL) {
+		/*
+		 * Register the mapping before any object points into it. From then on,
+		 * freeing the objects releases the mapping.
+		 */
+		refcount=1+(filter[1] != NULL)+n;
+		ESWEEP_ASSERT(__esweep_mapRegister(base, (size_t) hdr.file_size, refcount) == ERR_OK, \
+				load_unmap_on_error(fp, filter, spec, n, base, (size_t) hdr.file_size));
+		filter[0]->data=base+hdr.num_offset;
+		filter[0]->size=hdr.size;
+		if (filter[1] != NULL) {
+			filter[1]->data=base+hdr.denom_offset;
+			filter[1]->size=hdr.size;
+		}
+		for (i=0; i < n; i++) {
+			spec[i]->data=base+hdr.spectra_offset+(u_int64_t) i*hdr.fft_size*sizeof(Complex);
+			spec[i]->size=hdr.fft_size;
+		}
+	} else {
+		ESWEEP_ASSERT(read_section(fp, hdr.num_offset, (Real*) filter[0]->data, hdr.size, hdr.real_size, swap), \
+				load_unmap_on_error(fp, filter, spec, n, NULL, 0));
+		if (filter[1] != NULL) {
+			ESWEEP_ASSERT(read_section(fp, hdr.denom_offset, (Real*) filter[1]->data, hdr.size, hdr.real_size, swap), \
+					load_unmap_on_error(fp, filter, spec, n, NULL, 0));
+		}
+		for (i=0; i < n; i++) {
+			ESWEEP_ASSERT(read_section(fp, hdr.spectra_offset+(u_int64_t) i*hdr.fft_size*2*hdr.real_size, \
+						(Real*) spec[i]->data, 2*hdr.fft_size, hdr.real_size, swap), load_unmap_on_error(fp, filter, spec, n, NULL, 0));
+		}
+	}
 
-	/* read filter type */
-	ESWEEP_ASSERT(fread(&filter_type, sizeof(filter_type), 1, fp) == 1, load_close_on_error(fp, filter));
-	ESWEEP_ASSERT(filter_type == ESWEEP_FILTER_FIR || filter_type == ESWEEP_FILTER_IIR, NULL);
+	if (meta != NULL && hdr.meta_size > 0) {
+		/* a registered mapping is released with the objects */
+		ESWEEP_MALLOC(*meta, hdr.meta_size+1, sizeof(char), load_unmap_on_error(fp, filter, spec, n, NULL, 0));
+		if (base != NULL) {
+			memcpy(*meta, base+hdr.meta_offset, hdr.meta_size);
+		} else if (fseek(fp, (long) hdr.meta_offset, SEEK_SET) != 0 || fread(*meta, sizeof(char), hdr.meta_size, fp) != hdr.meta_size) {
+			free(*meta);
+			*meta=NULL;
+		}
+		ESWEEP_ASSERT(*meta != NULL, load_unmap_on_error(fp, filter, spec, n, NULL, 0));
+	}
 
-	/* read data */
-	filter[0]->type=WAVE;
-	ESWEEP_MALLOC(filter[0]->data, filter[0]->size, sizeof(Wave), NULL);
-	wave=filter[0]->data;
-	ESWEEP_ASSERT(fread(&wave, sizeof(Real), filter[0]->size, fp) == filter[0]->size, load_close_on_error(fp, filter));
+	if (spectra != NULL) *spectra=spec;
+	if (n_spectra != NULL) *n_spectra=n;
 
-	if (filter_type==ESWEEP_FILTER_IIR) {
-		ESWEEP_MALLOC(filter[1], 1, sizeof(esweep_object), NULL);
-		filter[1]->samplerate=filter[0]->samplerate;
-		filter[1]->type=WAVE;
-		filter[1]->size=filter[0]->size;
-		ESWEEP_MALLOC(filter[1]->data, filter[1]->size, sizeof(Wave), NULL);
-		wave=filter[1]->data;
-		ESWEEP_ASSERT(fread(&wave, sizeof(Real), filter[1]->size, fp) == filter[1]->size, load_close_on_error(fp, filter));
-	} else {filter[1]=NULL; }
+	/* the mapping stays valid after closing the file */
+	fclose(fp);
+	return filter;
+}
 
-	ESWEEP_MALLOC(filter[2], 1, sizeof(esweep_object), NULL);
-	filter[2]->samplerate=filter[0]->samplerate;
-	filter[2]->type=COMPLEX;
-	filter[2]->size=filter[0]->size;
-	ESWEEP_MALLOC(filter[2]->data, filter[2]->size, sizeof(Wave), NULL);
-	cpx=filter[2]->data;
-	ESWEEP_ASSERT(fread(&cpx, sizeof(Real), filter[2]->size, fp) == filter[2]->size, load_close_on_error(fp, filter));
+/* the old format: FILE_ID, samplerate, size, filter type, numerator, denominator, state */
+static esweep_object **load_legacy_filter(const char *filename) {
+	FILE *fp;
+	int id_length=strlen(LEGACY_FILE_ID);
+	char id[sizeof(LEGACY_FILE_ID)];
+	esweep_object **filter;
+	int samplerate, size, filter_type=-1;
+
+	/* open input file */
+	ESWEEP_ASSERT((fp = fopen(filename, "rb")) != NULL, NULL);
+
+	/* read file id */
+	memset(id, 0, sizeof(id));
+	ESWEEP_ASSERT(fread(id, sizeof(char), id_length, fp) == id_length, load_close_on_error(fp, NULL));
+	ESWEEP_ASSERT(strcmp(id, LEGACY_FILE_ID) == 0, load_close_on_error(fp, NULL));
+
+	/* read samplerate, size and filter type */
+	ESWEEP_ASSERT(fread(&samplerate, sizeof(samplerate), 1, fp) == 1, load_close_on_error(fp, NULL));
+	ESWEEP_ASSERT(fread(&size, sizeof(size), 1, fp) == 1, load_close_on_error(fp, NULL));
+	ESWEEP_ASSERT(fread(&filter_type, sizeof(filter_type), 1, fp) == 1, load_close_on_error(fp, NULL));
+	ESWEEP_ASSERT(samplerate > 0 && size > 0 && size < ESWEEP_MAX_SIZE, load_close_on_error(fp, NULL));
+	ESWEEP_ASSERT(filter_type == ESWEEP_FILTER_FIR || filter_type == ESWEEP_FILTER_IIR, load_close_on_error(fp, NULL));
+
+	/* create a new filter object and read the data */
+	ESWEEP_MALLOC(filter, 3, sizeof(esweep_object*), load_close_on_error(fp, NULL));
+	ESWEEP_ASSERT((filter[0]=esweep_create("wave", samplerate, size)) != NULL, load_close_on_error(fp, filter));
+	ESWEEP_ASSERT(fread(filter[0]->data, sizeof(Real), size, fp) == size, load_close_on_error(fp, filter));
+
+	if (filter_type == ESWEEP_FILTER_IIR) {
+		ESWEEP_ASSERT((filter[1]=esweep_create("wave", samplerate, size)) != NULL, load_close_on_error(fp, filter));
+		ESWEEP_ASSERT(fread(filter[1]->data, sizeof(Real), size, fp) == size, load_close_on_error(fp, filter));
+	}
+
+	ESWEEP_ASSERT((filter[2]=esweep_create("complex", samplerate, size)) != NULL, load_close_on_error(fp, filter));
+	ESWEEP_ASSERT(fread(filter[2]->data, sizeof(Complex), size, fp) == size, load_close_on_error(fp, filter));
 
 	fclose(fp);
 	return filter;
 }
-
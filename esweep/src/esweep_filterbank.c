@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * src/esweep_filterbank.c:
+ * Uniform polyphase DFT filter bank (analysis and synthesis)
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esweep_priv.h"
+#include "fft.h"
+
+/*
+ * The bank is implemented in the weighted overlap-add (WOLA) structure, which is equivalent to
+ * the polyphase structure but needs no per-branch state: every hop D, the last L input samples are
+ * weighted with the prototype filter h, folded into M points (this is the polyphase decomposition),
+ * circularly shifted by the start time of the block modulo M and transformed with one FFT of size M.
+ * The result is the complex baseband signal of each channel, decimated by D.
+ * Because the input is real, only the channels 0..M/2 are stored.
+ *
+ * The synthesis bank is the inverse: IFFT, circular shift, periodic extension to L samples,
+ * weighting with the synthesis prototype g and overlap-add with the hop D.
+ * Analysis and synthesis reconstruct the input if for every output sample n
+ *
+ * 	sum_m g[n-mD]*h[n-mD+kM] = 1 for k=0, and 0 otherwise (time domain aliasing).
+ *
+ * For the sample phases p=0..D-1 this is a small linear system in the taps g[p+jD] with one equation
+ * for each k. g is the minimum norm solution (the canonical dual of h), which is exact for D <= M/2 and a
+ * least squares approximation for critical sampling.
+ */
+
+struct __esweep_filterBank {
+	int samplerate;
+	int channels; /* M, power of 2 */
+	int hop; /* D */
+	int length; /* L, length of the prototype, multiple of M */
+	int bins; /* M/2+1 */
+	Real *h; /* analysis prototype */
+	Real *g; /* synthesis prototype */
+	Real *hist; /* last L input samples */
+	Real *ola; /* overlap-add buffer of the synthesis, L samples */
+	Real *v; /* one period of the synthesis block, M samples */
+	int pending; /* new samples in hist since the last block */
+	int ana_pos; /* start of the next analysis block, modulo M */
+	int syn_pos; /* start of the next synthesis block, modulo M */
+	Complex *buf;
+	Complex *table;
+};
+
+/* default prototypes */
+static void default_prototype(Real *h, int channels, int length) {
+	int i;
+	Real t;
+
+	if (length == channels) {
+		/* periodic sqrt-Hann, perfect reconstruction with D=M/2, M/4, ... */
+		for (i=0; i < length; i++) h[i]=sin(M_PI*i/length);
+	} else {
+		/* sinc lowpass with a cutoff of pi/M, Blackman window */
+		for (i=0; i < length; i++) {
+			t=M_PI*(i-length/2)/channels;
+			h[i]=(i == length/2 ? 1.0 : sin(t)/t)*
+				(0.42-0.5*cos(2*M_PI*i/length)+0.08*cos(4*M_PI*i/length));
+		}
+	}
+}
+
+/*
+ * solve the system A*x=b with Gaussian elimination; x is returned in b
+ * The systems are small, double precision is used regardless of Real.
+ */
+static void solve(double *A, double *b, int n) {
+	int i, j, k, pivot;
+	double t;
+
+	for (i=0; i < n; i++) {
+		for (pivot=i, j=i+1; j < n; j++) if (fabs(A[j*n+i]) > fabs(A[pivot*n+i])) pivot=j;
+		if (pivot != i) {
+			for (k=0; k < n; k++) {
+				t=A[i*n+k]; A[i*n+k]=A[pivot*n+k]; A[pivot*n+k]=t;
+			}
+			t=b[i]; b[i]=b[pivot]; b[pivot]=t;
+		}
+		for (j=i+1; j < n; j++) {
+			t=A[j*n+i]/A[i*n+i];
+			for (k=i; k < n; k++) A[j*n+k]-=t*A[i*n+k];
+			b[j]-=t*b[i];
+		}
+	}
+	for (i=n-1; i >= 0; i--) {
+		for (k=i+1; k < n; k++) b[i]-=A[i*n+k]*b[k];
+		b[i]/=A[i*n+i];
+	}
+}
+
+/* synthesis prototype g with perfect reconstruction for the analysis prototype h, see above */
+static int dual_prototype(Real *g, const Real *h, int channels, int hop, int length) {
+	int taps=length/channels;
+	int n=2*taps-1; /* number of equations: k=-(taps-1)..taps-1 */
+	int u=(length+hop-1)/hop; /* number of unknowns per phase */
+	int p, j, k, l, row, col;
+	double *A, *AAt, *b, trace, sum;
+
+	ESWEEP_MALLOC(A, n*u, sizeof(double), ERR_MALLOC);
+	ESWEEP_MALLOC(AAt, n*n, sizeof(double), ERR_MALLOC);
+	ESWEEP_MALLOC(b, n, sizeof(double), ERR_MALLOC);
+
+	for (p=0; p < hop; p++) {
+		/* A[k][j]=h[p+jD+kM] */
+		for (k=0; k < n; k++) {
+			for (j=0; j < u; j++) {
+				l=p+j*hop+(k-taps+1)*channels;
+				A[k*u+j]=(p+j*hop < length && l >= 0 && l < length) ? h[l] : 0.0;
+			}
+		}
+		/* g_p=A^T*inv(A*A^T+eps*I)*e_0, regularized for critical sampling */
+		for (trace=0.0, row=0; row < n; row++) {
+			for (col=0; col < n; col++) {
+				AAt[row*n+col]=0.0;
+				for (j=0; j < u; j++) AAt[row*n+col]+=A[row*u+j]*A[col*u+j];
+			}
+			trace+=AAt[row*n+row];
+			b[row]=row == taps-1 ? 1.0 : 0.0;
+		}
+		for (row=0; row < n; row++) AAt[row*n+row]+=1e-12*trace/n;
+		solve(AAt, b, n);
+		for (j=0; j < u && p+j*hop < length; j++) {
+			for (sum=0.0, k=0; k < n; k++) sum+=A[k*u+j]*b[k];
+			g[p+j*hop]=sum;
+		}
+	}
+
+	free(A);
+	free(AAt);
+	free(b);
+	return ERR_OK;
+}
+
+esweep_filterBank *esweep_filterBankCreate(int samplerate, int channels, int hop, int taps, esweep_object *prototype) {
+	esweep_filterBank *bank;
+	Real sum;
+	int i, length;
+
+	ESWEEP_ASSERT(samplerate > 0, NULL);
+	ESWEEP_ASSERT(channels >= 2 && channels <= ESWEEP_MAX_SIZE && (channels & (channels-1)) == 0, NULL);
+	ESWEEP_ASSERT(hop > 0 && hop <= channels, NULL);
+	if (prototype != NULL) {
+		ESWEEP_OBJ_NOTEMPTY(prototype, NULL);
+		ESWEEP_ASSERT(prototype->type == WAVE, NULL);
+		ESWEEP_ASSERT(prototype->size % channels == 0, NULL);
+		length=prototype->size;
+		/* the prototype is normalized to unity gain at DC below */
+		for (sum=0.0, i=0; i < prototype->size; i++) sum+=((Real*) prototype->data)[i];
+		ESWEEP_ASSERT(fabs(sum) > 0.0, NULL);
+	} else {
+		ESWEEP_ASSERT(taps > 0 && taps <= ESWEEP_MAX_SIZE/channels, NULL);
+		length=taps*channels;
+	}
+
+	ESWEEP_MALLOC(bank, 1, sizeof(esweep_filterBank), NULL);
+	bank->samplerate=samplerate;
+	bank->channels=channels;
+	bank->hop=hop;
+	bank->length=length;
+	bank->bins=channels/2+1;
+	ESWEEP_MALLOC(bank->h, length, sizeof(Real), NULL);
+	ESWEEP_MALLOC(bank->g, length, sizeof(Real), NULL);
+	ESWEEP_MALLOC(bank->hist, length, sizeof(Real), NULL);
+	ESWEEP_MALLOC(bank->ola, length, sizeof(Real), NULL);
+	ESWEEP_MALLOC(bank->v, channels, sizeof(Real), NULL);
+	ESWEEP_MALLOC(bank->buf, channels, sizeof(Complex), NULL);
+	ESWEEP_ASSERT((bank->table=fft_create_table(channels)) != NULL, NULL);
+
+	if (prototype != NULL) memcpy(bank->h, prototype->data, length*sizeof(Real));
+	else default_prototype(bank->h, channels, length);
+
+	/* unity gain of the analysis bank at DC */
+	for (sum=0.0, i=0; i < length; i++) sum+=bank->h[i];
+	for (i=0; i < length; i++) bank->h[i]/=sum;
+	if (dual_prototype(bank->g, bank->h, channels, hop, length) != ERR_OK) {
+		esweep_filterBankFree(bank);
+		return NULL;
+	}
+
+	esweep_filterBankReset(bank);
+	return bank;
+}
+
+int esweep_filterBankInfo(const esweep_filterBank *bank, int *bins, int *hop, int *latency) {
+	ESWEEP_ASSERT(bank != NULL, ERR_BAD_ARGUMENT);
+	if (bins != NULL) *bins=bank->bins;
+	if (hop != NULL) *hop=bank->hop;
+	if (latency != NULL) *latency=bank->length-bank->hop;
+	return ERR_OK;
+}
+
+int esweep_filterBankAnalyze(esweep_filterBank *bank, esweep_object *out, esweep_object *in, int *frames) {
+	Complex *X;
+	Real *x, v;
+	int i, q, r, n, frame, size;
+	int M, D, L, mask;
+
+	ESWEEP_ASSERT(bank != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_OBJ_NOTEMPTY(in, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(out != NULL, ERR_OBJ_IS_NULL);
+	ESWEEP_ASSERT(out != in, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(in->type == WAVE, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_ASSERT(in->samplerate == bank->samplerate, ERR_DIFF_MAPPING);
+
+	M=bank->channels;
+	D=bank->hop;
+	L=bank->length;
+	mask=M-1;
+	x=(Real*) in->data;
+
+	frame=(bank->pending+in->size)/D;
+	size=frame*bank->bins;
+	/* the output is only reallocated when it does not have the right type and size already */
+	if (out->type != COMPLEX || out->size != size || (size > 0 && out->data == NULL)) {
+		__esweep_freeObjectData(out);
+		out->type=COMPLEX;
+		out->size=size;
+		if (size > 0) ESWEEP_MALLOC(out->data, size, sizeof(Complex), ERR_MALLOC);
+	}
+	out->samplerate=bank->samplerate;
+	X=(Complex*) out->data;
+
+	for (i=0; i < in->size; i+=n) {
+		/* fill the history up to the next block */
+		n=D-bank->pending < in->size-i ? D-bank->pending : in->size-i;
+		memcpy(bank->hist+L-D+bank->pending, x+i, n*sizeof(Real));
+		bank->pending+=n;
+		if (bank->pending < D) break;
+
+		/* weight, fold and shift */
+		for (q=0; q < M; q++) {
+			for (v=0.0, r=q; r < L; r+=M) v+=bank->h[r]*bank->hist[r];
+			bank->buf[(q+bank->ana_pos) & mask].real=v;
+			bank->buf[(q+bank->ana_pos) & mask].imag=0.0;
+		}
+		fft(bank->buf, bank->table, M, FFT_FORWARD);
+		memcpy(X, bank->buf, bank->bins*sizeof(Complex));
+		X+=bank->bins;
+
+		memmove(bank->hist, bank->hist+D, (L-D)*sizeof(Real));
+		bank->pending=0;
+		bank->ana_pos=(bank->ana_pos+D) & mask;
+	}
+
+	if (frames != NULL) *frames=frame;
+	return ERR_OK;
+}
+
+int esweep_filterBankSynthesize(esweep_filterBank *bank, esweep_object *out, esweep_object *in) {
+	Complex *X;
+	Real *y, *v;
+	int k, l, frame, frames, size;
+	int M, D, L, mask;
+
+	ESWEEP_ASSERT(bank != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_OBJ_NOTEMPTY(in, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(out != NULL, ERR_OBJ_IS_NULL);
+	ESWEEP_ASSERT(out != in, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(in->type == COMPLEX, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_ASSERT(in->size % bank->bins == 0, ERR_SIZE_MISMATCH);
+
+	M=bank->channels;
+	D=bank->hop;
+	L=bank->length;
+	mask=M-1;
+	X=(Complex*) in->data;
+	frames=in->size/bank->bins;
+
+	size=frames*D;
+	if (out->type != WAVE || out->size != size || out->data == NULL) {
+		__esweep_freeObjectData(out);
+		out->type=WAVE;
+		out->size=size;
+		ESWEEP_MALLOC(out->data, size, sizeof(Real), ERR_MALLOC);
+	}
+	out->samplerate=bank->samplerate;
+	y=(Real*) out->data;
+	v=bank->v;
+
+	for (frame=0; frame < frames; frame++, X+=bank->bins, y+=D) {
+		/* restore the hermitian spectrum */
+		bank->buf[0]=X[0];
+		for (k=1; k < bank->bins; k++) {
+			bank->buf[k]=X[k];
+			bank->buf[M-k].real=X[k].real;
+			bank->buf[M-k].imag=-X[k].imag;
+		}
+		fft(bank->buf, bank->table, M, FFT_BACKWARD);
+		/* undo the circular shift */
+		for (k=0; k < M; k++) v[k]=bank->buf[(k+bank->syn_pos) & mask].real/M;
+
+		for (l=0; l < L; l++) bank->ola[l]+=bank->g[l]*v[l & mask];
+		memcpy(y, bank->ola, D*sizeof(Real));
+		memmove(bank->ola, bank->ola+D, (L-D)*sizeof(Real));
+		memset(bank->ola+L-D, 0, D*sizeof(Real));
+		bank->syn_pos=(bank->syn_pos+D) & mask;
+	}
+
+	return ERR_OK;
+}
+
+int esweep_filterBankReset(esweep_filterBank *bank) {
+	ESWEEP_ASSERT(bank != NULL, ERR_BAD_ARGUMENT);
+	memset(bank->hist, 0, bank->length*sizeof(Real));
+	memset(bank->ola, 0, bank->length*sizeof(Real));
+	bank->pending=0;
+	/* the first block starts at D-L, relative to the first input sample */
+	bank->ana_pos=bank->syn_pos=bank->hop & (bank->channels-1);
+	return ERR_OK;
+}
+
+int esweep_filterBankFree(esweep_filterBank *bank) {
+	ESWEEP_ASSERT(bank != NULL, ERR_BAD_ARGUMENT);
+	free(bank->h);
+	free(bank->g);
+	free(bank->hist);
+	free(bank->ola);
+	free(bank->v);
+	free(bank->buf);
+	free(bank->table);
+	free(bank);
+	return ERR_OK;
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * src/esweep_fp.c:
+ * Floating point environment of the library
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esweep_priv.h"
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+/* MXCSR bits */
+#define MXCSR_FTZ 0x8000
+#define MXCSR_DAZ 0x0040
+#endif
+
+/*
+ * The denormal policy is global for the library. The MXCSR register is thread local,
+ * so each kernel sets it on entry and restores the caller's value on exit. This way
+ * all threads which call into the library see the same policy, and the
+ * FP environment of the application is left untouched.
+ */
+static volatile int denormal_policy=ESWEEP_DENORMAL_FTZ;
+
+static const struct {
+	const char *name;
+	int policy;
+} denormal_modes[] = {
+	{"off", 0},
+	{"ftz", ESWEEP_DENORMAL_FTZ},
+	{"dc", ESWEEP_DENORMAL_DC},
+	{"all", ESWEEP_DENORMAL_FTZ | ESWEEP_DENORMAL_DC},
+	{NULL, 0}
+};
+
+int esweep_setDenormals(const char *mode) {
+	int i;
+	ESWEEP_ASSERT(mode != NULL, ERR_BAD_ARGUMENT);
+
+	for (i=0; denormal_modes[i].name != NULL; i++) {
+		if (strcmp(mode, denormal_modes[i].name) == 0) {
+			denormal_policy=denormal_modes[i].policy;
+			return ERR_OK;
+		}
+	}
+	snprintf(errmsg, 256, "%s:%i: %s: unknown denormal mode \"%s\"\n", __FILE__, __LINE__, __func__, mode);
+	fprintf(stderr, errmsg);
+	return ERR_BAD_ARGUMENT;
+}
+
+int esweep_getDenormals(const char *mode[]) {
+	int i, policy=denormal_policy;
+	ESWEEP_ASSERT(mode != NULL, ERR_BAD_ARGUMENT);
+
+	for (i=0; denormal_modes[i].name != NULL; i++) {
+		if (policy == denormal_modes[i].policy) {
+			*mode=denormal_modes[i].name;
+			return ERR_OK;
+		}
+	}
+	*mode=NULL;
+	return ERR_UNKNOWN;
+}
+
+__EXTERN_FUNC__ unsigned int __esweep_denormal_enter(void) {
+#ifdef __SSE__
+	unsigned int csr=_mm_getcsr();
+	if (denormal_policy & ESWEEP_DENORMAL_FTZ) _mm_setcsr(csr | MXCSR_FTZ | MXCSR_DAZ);
+	return csr;
+#else
+	return 0;
+#endif
+}
+
+__EXTERN_FUNC__ void __esweep_denormal_leave(unsigned int csr) {
+#ifdef __SSE__
+	if ((_mm_getcsr() & (MXCSR_FTZ | MXCSR_DAZ)) != (csr & (MXCSR_FTZ | MXCSR_DAZ))) {
+		/* keep the exception flags raised by the kernel, restore the modes of the caller */
+		_mm_setcsr((_mm_getcsr() & ~(MXCSR_FTZ | MXCSR_DAZ)) | (csr & (MXCSR_FTZ | MXCSR_DAZ)));
+	}
+#endif
+}
+
+__EXTERN_FUNC__ Real __esweep_denormal_dc(void) {
+	return (denormal_policy & ESWEEP_DENORMAL_DC) ? ESWEEP_DENORMAL_DC_OFFSET : 0.0;
+}
+
+/*
+ * Non-finite results of the math functions
+ * Like the denormal policy, this one is global; every call takes a snapshot of it on entry.
+ * The counters are global, too, they are only locked when a call has something to add.
+ */
+#ifdef REAL32
+	#define MAXREAL FLT_MAX
+#else
+	#define MAXREAL DBL_MAX
+#endif
+
+static volatile int nonfinite_policy=ESWEEP_NONFINITE_CLAMP;
+static long nonfinite_inf=0, nonfinite_nan=0, nonfinite_clamped=0;
+static pthread_mutex_t nonfinite_lock=PTHREAD_MUTEX_INITIALIZER;
+
+static const struct {
+	const char *name;
+	int policy;
+} nonfinite_modes[] = {
+	{"clamp", ESWEEP_NONFINITE_CLAMP},
+	{"propagate", ESWEEP_NONFINITE_PROPAGATE},
+	{"error", ESWEEP_NONFINITE_ERROR},
+	{NULL, 0}
+};
+
+int esweep_setNonFinite(const char *mode) {
+	int i;
+	ESWEEP_ASSERT(mode != NULL, ERR_BAD_ARGUMENT);
+
+	for (i=0; nonfinite_modes[i].name != NULL; i++) {
+		if (strcmp(mode, nonfinite_modes[i].name) == 0) {
+			nonfinite_policy=nonfinite_modes[i].policy;
+			return ERR_OK;
+		}
+	}
+	snprintf(errmsg, 256, "%s:%i: %s: unknown non-finite mode \"%s\"\n", __FILE__, __LINE__, __func__, mode);
+	fprintf(stderr, errmsg);
+	return ERR_BAD_ARGUMENT;
+}
+
+int esweep_getNonFinite(const char *mode[]) {
+	int i, policy=nonfinite_policy;
+	ESWEEP_ASSERT(mode != NULL, ERR_BAD_ARGUMENT);
+
+	for (i=0; nonfinite_modes[i].name != NULL; i++) {
+		if (policy == nonfinite_modes[i].policy) {
+			*mode=nonfinite_modes[i].name;
+			return ERR_OK;
+		}
+	}
+	*mode=NULL;
+	return ERR_UNKNOWN;
+}
+
+int esweep_getNonFiniteCount(long *inf, long *nan, long *clamped, int reset) {
+	pthread_mutex_lock(&nonfinite_lock);
+	if (inf != NULL) *inf=nonfinite_inf;
+	if (nan != NULL) *nan=nonfinite_nan;
+	if (clamped != NULL) *clamped=nonfinite_clamped;
+	if (reset) nonfinite_inf=nonfinite_nan=nonfinite_clamped=0;
+	pthread_mutex_unlock(&nonfinite_lock);
+	return ERR_OK;
+}
+
+__EXTERN_FUNC__ void __esweep_nonFinite_enter(esweep_nonFinite *nf) {
+	nf->policy=nonfinite_policy;
+	nf->inf=nf->nan=nf->clamped=0;
+}
+
+__EXTERN_FUNC__ int __esweep_nonFinite_leave(esweep_nonFinite *nf) {
+	if (nf->inf == 0 && nf->nan == 0) return ERR_OK;
+
+	pthread_mutex_lock(&nonfinite_lock);
+	nonfinite_inf+=nf->inf;
+	nonfinite_nan+=nf->nan;
+	nonfinite_clamped+=nf->clamped;
+	pthread_mutex_unlock(&nonfinite_lock);
+
+	switch (nf->policy) {
+		case ESWEEP_NONFINITE_PROPAGATE:
+			return ERR_OK;
+		case ESWEEP_NONFINITE_ERROR:
+			return ERR_FP;
+		case ESWEEP_NONFINITE_CLAMP:
+		default:
+			/* there is no sensible finite replacement for NaN */
+			return nf->nan > 0 ? ERR_FP : ERR_OK;
+	}
+}
+
+__EXTERN_FUNC__ Real __esweep_nonFinite_fix(esweep_nonFinite *nf, Real x) {
+	if (isnan(x)) {
+		nf->nan++;
+		return x;
+	}
+	nf->inf++;
+	if (nf->policy != ESWEEP_NONFINITE_CLAMP) return x;
+	nf->clamped++;
+	return signbit(x) ? -MAXREAL : MAXREAL;
+}
+
+__EXTERN_FUNC__ void __esweep_nonFinite_scan(esweep_nonFinite *nf, Real *data, int n) {
+	int i;
+
+	for (i=0; i < n; i++) {
+		ESWEEP_NONFINITE(*nf, data[i]);
+	}
+}
@@ -217,7 +217,7 @@ int esweep_genLogsweep(esweep_object *obj, Real locut, Real hicut, const char *s
 		cpx[i].imag=cpx[i].imag/scale; 
 	}
 	if (obj->type == COMPLEX) {
-		free(obj->data);
+		__esweep_freeData(obj->data);
 		obj->data=(void*) cpx; 
 		return ERR_OK; 
 	}
@@ -412,7 +412,7 @@ int esweep_genNoise(esweep_object *obj, Real locut, Real hicut, const char *spec
 	df=(Real) obj->samplerate/size;
 
 	/* unlike the sweeps, the noise must have a 2^n length, so we can free the data block anyways */
-	free(obj->data); 
+	__esweep_freeData(obj->data); 
 	obj->size=size; 
 
 	ESWEEP_MALLOC(polar, size, sizeof(Polar), ERR_MALLOC);
@@ -531,7 +531,7 @@ int esweep_concat(esweep_object *dst, esweep_object *src, int dst_pos, int src_p
 			wave=(Wave*) calloc(dst_pos+1+(*src).size-src_pos, sizeof(Wave));
 			memcpy(wave, (*dst).data, (dst_pos+1)*sizeof(Wave));
 			memcpy(&(wave[dst_pos+1]), (*src).data, ((*src).size-src_pos)*sizeof(Wave));
-			free((*dst).data);
+			__esweep_freeData((*dst).data);
 			(*dst).data=wave;
 			(*dst).size=dst_pos+(*src).size-src_pos;
 			break;
@@ -605,7 +605,7 @@ int esweep_pad(esweep_object *a, int size) { /* zero padding */
 		case WAVE:
 			wave=(Wave*) calloc(size, sizeof(Wave));
 			memcpy(wave, (Wave*) (*a).data, (*a).size*sizeof(Wave));
-			free((*a).data);
+			__esweep_freeData((*a).data);
 			(*a).data=wave;
 			(*a).size=size;
 			break;
@@ -0,0 +1,420 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * src/esweep_level.c:
+ * Streaming sound level logger with frequency and time weighting
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esweep_priv.h"
+#include "esweep.h"
+
+/*
+ * The input is frequency weighted with a cascade of biquads from esweep_createFilterFromCoeff(),
+ * using the pole frequencies of IEC 61672:
+ *
+ * C: double poles at 20.6 Hz and 12194 Hz, double zero at 0 Hz
+ * A: the same, plus single poles at 107.7 Hz and 737.9 Hz and two more zeros at 0 Hz
+ *
+ * The double poles at 20.6 Hz are a second order highpass with Q=0.5, the single poles first order highpasses,
+ * all bilinear transforms pre-warped at the pole frequency. The bilinear transform of the double pole at
+ * 12194 Hz would put a double zero at samplerate/2, 3 dB too much attenuation at 16 kHz at 48 kHz.
+ * So this lowpass is a matched design after M. Vicanek, "Matched Second Order Digital Filters" (2016):
+ * impulse invariant poles, and zeros which match the analog magnitude at 0 Hz, at the pole frequency
+ * and at samplerate/2. The deviation from IEC 61672 stays below 0.2 dB up to 16 kHz at 48 kHz
+ * (+0.8 dB at 20 kHz), and below 0.3 dB up to 16 kHz at 44.1 kHz (+1.3 dB at 20 kHz).
+ * The cascade is normalized to 0 dB at 1 kHz. Poles above samplerate/2 are left out.
+ *
+ * The squared weighted signal is smoothed with an exponential time weighting. Lmax and Lmin are taken
+ * from this smoothed mean square, the percentile levels from a histogram of it with a fixed resolution,
+ * so the memory does not depend on the duration of an interval. Leq and Lpeak use the weighted signal directly.
+ * Levels are in dB re 1.0 (full scale) plus the offset.
+ */
+
+#define LEVEL_Z 0
+#define LEVEL_A 1
+#define LEVEL_C 2
+
+#define LEVEL_FAST 0
+#define LEVEL_SLOW 1
+#define LEVEL_IMPULSE 2
+
+/* histogram of the time weighted level, LEVEL_HIST_MIN..LEVEL_HIST_MAX dB in steps of LEVEL_HIST_RES */
+#define LEVEL_HIST_MIN -200.0
+#define LEVEL_HIST_MAX 20.0
+#define LEVEL_HIST_RES 0.1
+#define LEVEL_BINS 2200
+
+/* mean squares below are treated as LEVEL_HIST_MIN */
+#define LEVEL_FLOOR 1e-20
+
+/* the input is filtered in blocks of this size */
+#define LEVEL_BLOCK 1024
+
+struct __esweep_levelLogger {
+	int samplerate;
+	int interval; /* samples */
+	Real offset; /* dB */
+	Real rise, fall; /* coefficients of the time weighting */
+	esweep_object **filter; /* NULL without frequency weighting */
+	esweep_object *buf;
+	int settled; /* the time weighting has been initialized */
+	double ms; /* time weighted mean square */
+	int records; /* completed intervals since the last reset */
+	/* current interval */
+	int count;
+	double sum, max, min, peak;
+	u_int64_t *hist;
+	/* completed intervals */
+	u_int64_t total_count;
+	double total_sum, total_max, total_min, total_peak;
+	u_int64_t *total_hist;
+};
+
+/*
+ * first order highpass (1-z^-1)/((1+K)+(K-1)*z^-1), K=tan(pi*f/samplerate), as a biquad section.
+ * The "differentiator" of esweep_createFilterFromCoeff() has the same response, but with a pole
+ * at z=-1 that is only cancelled by a zero; for hours of logging the section should be clean.
+ */
+static esweep_object **__esweep_levelHighpass(Real f, int samplerate) {
+	Real num[3], denom[3], K=tan(M_PI*f/samplerate);
+
+	num[0]=1.0/(1.0+K);
+	num[1]=-num[0];
+	num[2]=0.0;
+	denom[0]=1.0;
+	denom[1]=(K-1.0)/(K+1.0);
+	denom[2]=0.0;
+	return esweep_createFilterFromArray(num, denom, 3, samplerate);
+}
+
+/*
+ * second order lowpass with a double pole at f, matched to 1/(1+s/w)^2 (see above).
+ * The poles are exp(-w), w=2*pi*f/samplerate; b0+b1*z^-1 fits the magnitude at 0 Hz, at f
+ * and at samplerate/2. f must be below samplerate/2.
+ */
+static esweep_object **__esweep_levelLowpass(Real f, int samplerate) {
+	Real num[3], denom[3], w=2*M_PI*f/samplerate;
+	Real A0, A1, A2, phi0, phi1, phi2, B0, B1;
+
+	denom[0]=1.0;
+	denom[1]=-2.0*exp(-w);
+	denom[2]=exp(-2.0*w);
+	/* squared magnitude of the denominator at 0 Hz and samplerate/2, and its cross term */
+	A0=(1.0+denom[1]+denom[2])*(1.0+denom[1]+denom[2]);
+	A1=(1.0-denom[1]+denom[2])*(1.0-denom[1]+denom[2]);
+	A2=-4.0*denom[2];
+	phi1=sin(w/2)*sin(w/2);
+	phi0=1.0-phi1;
+	phi2=4.0*phi0*phi1;
+	/* squared magnitude of the numerator at 0 Hz and samplerate/2; Q=0.5, the analog gain at f is 1/2 */
+	B0=A0;
+	B1=((A0*phi0+A1*phi1+A2*phi2)*0.25-B0*phi0)/phi1;
+	num[0]=0.5*(sqrt(B0)+sqrt(B1));
+	num[1]=sqrt(B0)-num[0];
+	num[2]=0.0;
+	return esweep_createFilterFromArray(num, denom, 3, samplerate);
+}
+
+static esweep_object **__esweep_levelWeighting(int weighting, int samplerate) {
+	/* pole frequencies of IEC 61672 */
+	const Real f1=20.598997, f2=107.65265, f3=737.86223, f4=12194.217;
+	esweep_object **filter, **section;
+	Real *num, *denom, w, re, im, nre, nim, dre, dim, gain=1.0;
+	int k, sections;
+
+	if ((filter=esweep_createFilterFromCoeff("highpass", 1.0, 0.5, f1, 0.0, 0.0, samplerate)) == NULL) return NULL;
+	if (weighting == LEVEL_A) {
+		if ((section=__esweep_levelHighpass(f2, samplerate)) == NULL) return NULL;
+		esweep_appendFilter(filter, section);
+		esweep_freeFilter(section);
+		free(section);
+		if ((section=__esweep_levelHighpass(f3, samplerate)) == NULL) return NULL;
+		esweep_appendFilter(filter, section);
+		esweep_freeFilter(section);
+		free(section);
+	}
+	if (f4 < samplerate/2) {
+		if ((section=__esweep_levelLowpass(f4, samplerate)) == NULL) return NULL;
+		esweep_appendFilter(filter, section);
+		esweep_freeFilter(section);
+		free(section);
+	}
+
+	/* normalize to 0 dB at 1 kHz */
+	num=(Real*) filter[0]->data;
+	denom=(Real*) filter[1]->data;
+	sections=filter[0]->size/3;
+	w=2*M_PI*1000.0/samplerate;
+	for (k=0; k < sections; k++) {
+		/* b0+b1*z^-1+b2*z^-2 and 1+a1*z^-1+a2*z^-2 at z=exp(jw) */
+		nre=num[3*k]+num[3*k+1]*cos(w)+num[3*k+2]*cos(2*w);
+		nim=-num[3*k+1]*sin(w)-num[3*k+2]*sin(2*w);
+		dre=denom[3*k]+denom[3*k+1]*cos(w)+denom[3*k+2]*cos(2*w);
+		dim=-denom[3*k+1]*sin(w)-denom[3*k+2]*sin(2*w);
+		re=nre*nre+nim*nim;
+		im=dre*dre+dim*dim;
+		gain*=sqrt(re/im);
+	}
+	for (k=0; k < 3; k++) num[k]/=gain;
+
+	esweep_resetFilter(filter);
+	return filter;
+}
+
+static double __esweep_levelDB(double ms) {
+	return ms > LEVEL_FLOOR ? 10*log10(ms) : LEVEL_HIST_MIN;
+}
+
+static int __esweep_levelBin(double ms) {
+	int bin;
+
+	if (ms <= LEVEL_FLOOR) return 0;
+	bin=(int) ((10*log10(ms)-LEVEL_HIST_MIN)/LEVEL_HIST_RES);
+	if (bin < 0) return 0;
+	if (bin >= LEVEL_BINS) return LEVEL_BINS-1;
+	return bin;
+}
+
+/* level exceeded in percent of the time; hist2 may be NULL */
+static Real __esweep_levelPercentile(const u_int64_t *hist1, const u_int64_t *hist2, u_int64_t count, Real percent) {
+	double target=percent*count/100.0;
+	u_int64_t acc=0;
+	int bin;
+
+	for (bin=LEVEL_BINS-1; bin >= 0; bin--) {
+		acc+=hist1[bin];
+		if (hist2 != NULL) acc+=hist2[bin];
+		if (acc > 0 && acc >= target) break;
+	}
+	if (bin < 0) return LEVEL_HIST_MIN;
+	return LEVEL_HIST_MIN+(bin+0.5)*LEVEL_HIST_RES;
+}
+
+/* time weighting, statistics and histogram of n weighted samples */
+static void __esweep_levelAccumulate(esweep_levelLogger *lv, const Real *x, int n) {
+	double p, ms, sum=0.0, max=lv->max, min=lv->min, peak=lv->peak;
+	int i;
+
+	if (!lv->settled) {
+		/* start the time weighting with the mean square of the first block, not with silence */
+		for (i=0, ms=0.0; i < n; i++) ms+=x[i]*x[i];
+		lv->ms=ms/n;
+		lv->settled=1;
+	}
+
+	ms=lv->ms;
+	for (i=0; i < n; i++) {
+		p=x[i]*x[i];
+		sum+=p;
+		if (p > peak) peak=p;
+		ms+=(p > ms ? lv->rise : lv->fall)*(p-ms);
+		if (ms > max) max=ms;
+		if (ms < min) min=ms;
+		lv->hist[__esweep_levelBin(ms)]++;
+	}
+	lv->ms=ms;
+	lv->sum+=sum;
+	lv->max=max;
+	lv->min=min;
+	lv->peak=peak;
+	lv->count+=n;
+}
+
+static void __esweep_levelRecord(const esweep_levelLogger *lv, esweep_levelRecord *rec, double sum, u_int64_t count, double max, double min, double peak, const u_int64_t *hist1, const u_int64_t *hist2) {
+	rec->leq=__esweep_levelDB(count > 0 ? sum/count : 0.0)+lv->offset;
+	rec->lmax=__esweep_levelDB(max)+lv->offset;
+	rec->lmin=__esweep_levelDB(count > 0 ? min : 0.0)+lv->offset;
+	rec->lpeak=__esweep_levelDB(peak)+lv->offset;
+	rec->l10=__esweep_levelPercentile(hist1, hist2, count, 10)+lv->offset;
+	rec->l50=__esweep_levelPercentile(hist1, hist2, count, 50)+lv->offset;
+	rec->l90=__esweep_levelPercentile(hist1, hist2, count, 90)+lv->offset;
+}
+
+/* close the current interval */
+static void __esweep_levelInterval(esweep_levelLogger *lv, esweep_levelRecord *rec) {
+	int bin;
+
+	lv->records++;
+	rec->time=(Real) lv->records*lv->interval/lv->samplerate;
+	__esweep_levelRecord(lv, rec, lv->sum, lv->count, lv->max, lv->min, lv->peak, lv->hist, NULL);
+
+	lv->total_count+=lv->count;
+	lv->total_sum+=lv->sum;
+	if (lv->max > lv->total_max) lv->total_max=lv->max;
+	if (lv->min < lv->total_min) lv->total_min=lv->min;
+	if (lv->peak > lv->total_peak) lv->total_peak=lv->peak;
+	for (bin=0; bin < LEVEL_BINS; bin++) lv->total_hist[bin]+=lv->hist[bin];
+
+	lv->count=0;
+	lv->sum=0.0;
+	lv->max=0.0;
+	lv->min=HUGE_VAL;
+	lv->peak=0.0;
+	memset(lv->hist, 0, LEVEL_BINS*sizeof(u_int64_t));
+}
+
+esweep_levelLogger *esweep_levelLoggerCreate(int samplerate, const char *weighting, const char *time, Real interval, Real offset) {
+	esweep_levelLogger *lv;
+	Real tau_rise, tau_fall;
+	int weighting_type=LEVEL_A, time_type=LEVEL_FAST;
+
+	ESWEEP_ASSERT(samplerate > 0, NULL);
+	ESWEEP_ASSERT(interval > 0.0, NULL);
+
+	if (weighting != NULL) {
+		weighting_type=-1;
+		if (strcmp("A", weighting)==0) weighting_type=LEVEL_A;
+		if (strcmp("C", weighting)==0) weighting_type=LEVEL_C;
+		if (strcmp("Z", weighting)==0) weighting_type=LEVEL_Z;
+		ESWEEP_ASSERT(weighting_type >= 0, NULL);
+	}
+	if (time != NULL) {
+		time_type=-1;
+		if (strcmp("fast", time)==0) time_type=LEVEL_FAST;
+		if (strcmp("slow", time)==0) time_type=LEVEL_SLOW;
+		if (strcmp("impulse", time)==0) time_type=LEVEL_IMPULSE;
+		ESWEEP_ASSERT(time_type >= 0, NULL);
+	}
+	/* the weighting filters need the 1 kHz normalization frequency below samplerate/2 */
+	ESWEEP_ASSERT(weighting_type == LEVEL_Z || samplerate > 2000, NULL);
+
+	switch (time_type) {
+		case LEVEL_SLOW:
+			tau_rise=tau_fall=1.0;
+			break;
+		case LEVEL_IMPULSE:
+			tau_rise=0.035;
+			tau_fall=1.5;
+			break;
+		case LEVEL_FAST:
+		default:
+			tau_rise=tau_fall=0.125;
+			break;
+	}
+
+	ESWEEP_MALLOC(lv, 1, sizeof(esweep_levelLogger), NULL);
+	lv->samplerate=samplerate;
+	lv->interval=(int) (interval*samplerate+0.5);
+	if (lv->interval < 1) lv->interval=1;
+	lv->offset=offset;
+	lv->rise=1.0-exp(-1.0/(tau_rise*samplerate));
+	lv->fall=1.0-exp(-1.0/(tau_fall*samplerate));
+
+	if (weighting_type != LEVEL_Z) {
+		ESWEEP_ASSERT((lv->filter=__esweep_levelWeighting(weighting_type, samplerate)) != NULL, NULL);
+	}
+	ESWEEP_ASSERT((lv->buf=esweep_create("wave", samplerate, LEVEL_BLOCK)) != NULL, NULL);
+	ESWEEP_MALLOC(lv->hist, LEVEL_BINS, sizeof(u_int64_t), NULL);
+	ESWEEP_MALLOC(lv->total_hist, LEVEL_BINS, sizeof(u_int64_t), NULL);
+
+	esweep_levelLoggerReset(lv);
+	return lv;
+}
+
+int esweep_levelLoggerProcess(esweep_levelLogger *lv, const esweep_object *in, esweep_levelRecord *records, int *n) {
+	Complex *cpx;
+	Real *x;
+	int i, k, m, size, done=0;
+
+	ESWEEP_ASSERT(lv != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(n != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_OBJ_NOTEMPTY(in, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(in->type == WAVE || in->type == COMPLEX, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_ASSERT(in->samplerate == lv->samplerate, ERR_DIFF_MAPPING);
+	/* all intervals completed by this block must fit into records */
+	ESWEEP_ASSERT(*n >= (lv->count+in->size)/lv->interval, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(records != NULL || (lv->count+in->size)/lv->interval == 0, ERR_BAD_ARGUMENT);
+
+	x=(Real*) lv->buf->data;
+	cpx=(Complex*) in->data;
+	for (i=0; i < in->size; i+=m) {
+		/* never cross an interval boundary within a block */
+		m=in->size-i;
+		if (m > LEVEL_BLOCK) m=LEVEL_BLOCK;
+		if (m > lv->interval-lv->count) m=lv->interval-lv->count;
+
+		if (in->type == WAVE) memcpy(x, (Wave*) in->data+i, m*sizeof(Wave));
+		else for (k=0; k < m; k++) x[k]=cpx[i+k].real;
+		if (lv->filter != NULL) {
+			size=lv->buf->size;
+			lv->buf->size=m;
+			esweep_filter(lv->buf, lv->filter);
+			lv->buf->size=size;
+		}
+		__esweep_levelAccumulate(lv, x, m);
+
+		if (lv->count == lv->interval) __esweep_levelInterval(lv, records+done++);
+	}
+
+	*n=done;
+	return ERR_OK;
+}
+
+int esweep_levelLoggerTotal(const esweep_levelLogger *lv, esweep_levelRecord *total) {
+	double max, min, peak;
+
+	ESWEEP_ASSERT(lv != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(total != NULL, ERR_BAD_ARGUMENT);
+
+	/* the completed intervals and the current one */
+	max=lv->total_max > lv->max ? lv->total_max : lv->max;
+	min=lv->total_min < lv->min ? lv->total_min : lv->min;
+	peak=lv->total_peak > lv->peak ? lv->total_peak : lv->peak;
+	total->time=((Real) lv->records*lv->interval+lv->count)/lv->samplerate;
+	__esweep_levelRecord(lv, total, lv->total_sum+lv->sum, lv->total_count+lv->count, max, min, peak, lv->total_hist, lv->hist);
+	return ERR_OK;
+}
+
+int esweep_levelLoggerReset(esweep_levelLogger *lv) {
+	ESWEEP_ASSERT(lv != NULL, ERR_BAD_ARGUMENT);
+	if (lv->filter != NULL) esweep_resetFilter(lv->filter);
+	lv->settled=0;
+	lv->ms=0.0;
+	lv->records=0;
+	lv->count=0;
+	lv->sum=0.0;
+	lv->max=0.0;
+	lv->min=HUGE_VAL;
+	lv->peak=0.0;
+	memset(lv->hist, 0, LEVEL_BINS*sizeof(u_int64_t));
+	lv->total_count=0;
+	lv->total_sum=0.0;
+	lv->total_max=0.0;
+	lv->total_min=HUGE_VAL;
+	lv->total_peak=0.0;
+	memset(lv->total_hist, 0, LEVEL_BINS*sizeof(u_int64_t));
+	return ERR_OK;
+}
+
+int esweep_levelLoggerFree(esweep_levelLogger *lv) {
+	ESWEEP_ASSERT(lv != NULL, ERR_BAD_ARGUMENT);
+	if (lv->filter != NULL) {
+		esweep_freeFilter(lv->filter);
+		free(lv->filter);
+	}
+	esweep_free(lv->buf);
+	free(lv->hist);
+	free(lv->total_hist);
+	free(lv);
+	return ERR_OK;
+}
@@ -34,18 +34,27 @@
 
 #include "esweep_priv.h"
 #include "fft.h"
+#include "vmath.h"
 
 
-static inline Real __esweep_intern__sum(const esweep_object *obj);
-
-int esweep_max(const esweep_object *obj, int from, int to, Real *max) { /* UNTESTED */
-	Wave *wave;
-	Polar *polar;
+/*
+ * The reductions are done by esweep_stats.c, compensated and, for large objects, with several threads.
+ * For a SURFACE, from and to are ignored.
+ */
+static int __esweep_intern__stats(const esweep_object *obj, int from, int to, esweep_statistics *stats) {
 	Surface *surf;
-	Complex *cplx;
 
-	Real tmp;
-	int i, size;
+	if (obj->type == SURFACE) {
+		surf=(Surface*) obj->data;
+		ESWEEP_OBJ_ISVALID_SURFACE(obj, surf, ERR_NOT_ON_THIS_TYPE, ERR_OBJ_NOT_VALID);
+		return __esweep_stats(obj, 0, surf->xsize*surf->ysize, 0, stats);
+	}
+	return __esweep_stats(obj, from, to-from+1, 0, stats);
+}
+
+int esweep_max(const esweep_object *obj, int from, int to, Real *max) {
+	esweep_statistics stats;
+	int ret;
 
 	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
 	ESWEEP_ASSERT(from < obj->size, ERR_BAD_PARAMETER);
@@ -56,43 +65,14 @@ int esweep_max(const esweep_object *obj, int from, int to, Real *max) { /* UNTES
 
 	ESWEEP_ASSERT(to > from, ERR_BAD_PARAMETER);
 
-	switch (obj->type) {
-		case WAVE:
-			wave=(Wave*) obj->data;
-			for (i=from+1, *max=wave[from]; i <= to; i++)
-				if (wave[i]>*max) *max=wave[i];
-			break;
-		case COMPLEX:
-			cplx=(Complex*) obj->data;
-			for (i=from+1, *max=CABS(cplx[from]); i <= to; i++) {
-				tmp=CABS(cplx[i]);
-				if (tmp>*max) *max=tmp;
-			}
-			break;
-		case POLAR:
-			polar=(Polar*) obj->data;
-			for (i=from+1, *max=polar[from].abs; i <= to; i++)
-				if (polar[i].abs>*max) *max=polar[i].abs;
-			break;
-		case SURFACE:
-			surf=(Surface*) obj->data;
-			for (i=1, *max=surf->z[0], size=surf->xsize*surf->ysize; i < size; i++)
-				if (surf->z[i]>*max) *max=surf->z[i];
-			break;
-		default:
-			ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE);
-	}
+	if ((ret=__esweep_intern__stats(obj, from, to, &stats)) != ERR_OK) return ret;
+	*max=stats.max;
 	return ERR_OK;
 }
 
-int esweep_min(const esweep_object *obj, int from, int to, Real *min) { /* UNTESTED */
-	Wave *wave;
-	Polar *polar;
-	Surface *surf;
-	Complex *cplx;
-
-	Real tmp;
-	int i, size;
+int esweep_min(const esweep_object *obj, int from, int to, Real *min) {
+	esweep_statistics stats;
+	int ret;
 
 	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
 	ESWEEP_ASSERT(from < obj->size, ERR_BAD_PARAMETER);
@@ -103,43 +83,15 @@ int esweep_min(const esweep_object *obj, int from, int to, Real *min) { /* UNTES
 
 	ESWEEP_ASSERT(to > from, ERR_BAD_PARAMETER);
 
-	switch (obj->type) {
-		case WAVE:
-			wave=(Wave*) obj->data;
-			for (i=from+1, *min=wave[from];i<= to; i++)
-				if (wave[i]< *min) *min=wave[i];
-			break;
-		case COMPLEX:
-			cplx=(Complex*) obj->data;
-			for (i=from+1, *min=CABS(cplx[from]);i<= to; i++) {
-				tmp=CABS(cplx[i]);
-				if (tmp<*min) *min=tmp;
-			}
-			break;
-		case POLAR:
-			polar=(Polar*) obj->data;
-			for (i=from+1, *min=polar[from].abs;i<= to; i++)
-				if (polar[i].abs<*min) *min=polar[i].abs;
-			break;
-		case SURFACE:
-			surf=(Surface*) obj->data;
-			for (i=1, *min=surf->z[0], size=surf->xsize*surf->ysize;i<size;i++)
-				if (surf->z[i]<*min) *min=surf->z[i];
-			break;
-		default:
-			ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE);
-	}
+	if ((ret=__esweep_intern__stats(obj, from, to, &stats)) != ERR_OK) return ret;
+	*min=stats.min;
 	return ERR_OK;
 }
 
 
-int esweep_maxPos(const esweep_object *obj, int from, int to, int *pos) { /* UNTESTED */
-	Wave *wave;
-	Polar *polar;
-	Complex *cplx;
-
-	Real max, tmp;
-	int i;
+int esweep_maxPos(const esweep_object *obj, int from, int to, int *pos) {
+	esweep_statistics stats;
+	int ret;
 
 	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
 	ESWEEP_ASSERT(from < obj->size, ERR_BAD_PARAMETER);
@@ -150,47 +102,14 @@ int esweep_maxPos(const esweep_object *obj, int from, int to, int *pos) { /* UNT
 
 	ESWEEP_ASSERT(to > from, ERR_BAD_PARAMETER);
 
-	switch (obj->type) {
-		case WAVE:
-			wave=(Wave*) obj->data;
-			for (i=from+1, max=wave[from], *pos=0;i<= to; i++)
-				if (wave[i]>max) {
-					max=wave[i];
-					*pos=i;
-				}
-			break;
-		case COMPLEX:
-			cplx=(Complex*) obj->data;
-			for (i=from+1, *pos=0, max=CABS(cplx[from]);i<= to; i++) {
-				tmp=CABS(cplx[i]);
-				if (tmp>max) {
-					max=tmp;
-					*pos=i;
-				}
-			}
-			break;
-		case POLAR:
-			polar=(Polar*) obj->data;
-			for (i=from+1, *pos=0, max=polar[from].abs;i<= to; i++) {
-				if (polar[i].abs>max) {
-					max=polar[i].abs;
-					*pos=i;
-				}
-			}
-			break;
-		default:
-			ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE);
-	}
+	if ((ret=__esweep_intern__stats(obj, from, to, &stats)) != ERR_OK) return ret;
+	*pos=stats.argmax;
 	return ERR_OK;
 }
 
-int esweep_minPos(const esweep_object *obj, int from, int to, int *pos) { /* UNTESTED */
-	Wave *wave;
-	Polar *polar;
-	Complex *cplx;
-
-	Real min, tmp;
-	int i;
+int esweep_minPos(const esweep_object *obj, int from, int to, int *pos) {
+	esweep_statistics stats;
+	int ret;
 
 	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
 	ESWEEP_ASSERT(from < obj->size, ERR_BAD_PARAMETER);
@@ -201,217 +120,219 @@ int esweep_minPos(const esweep_object *obj, int from, int to, int *pos) { /* UNT
 
 	ESWEEP_ASSERT(to > from, ERR_BAD_PARAMETER);
 
-	switch (obj->type) {
-		case WAVE:
-			wave=(Wave*) obj->data;
-			for (i=from+1, *pos=0, min=wave[from];i<obj->size;i++)
-				if (wave[i]<min) {
-					min=wave[i];
-					*pos=i;
-				}
-			break;
-		case COMPLEX:
-			cplx=(Complex*) obj->data;
-			for (i=from+1, *pos=0, min=CABS(cplx[from]);i<obj->size;i++) {
-				tmp=CABS(cplx[i]);
-				if (tmp<min) {
-					min=tmp;
-					*pos=i;
-				}
-			}
-			break;
-		case POLAR:
-			polar=(Polar*) obj->data;
-			for (i=from+1, *pos=0, min=polar[from].abs;i<obj->size;i++) {
-				if (polar[i].abs<min) {
-					min=polar[i].abs;
-					*pos=i;
-				}
-			}
-			break;
-		default:
-			ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE);
-	}
+	if ((ret=__esweep_intern__stats(obj, from, to, &stats)) != ERR_OK) return ret;
+	*pos=stats.argmin;
 	return ERR_OK;
 }
 
-int esweep_avg(const esweep_object *obj, Real *avg) { /* UNTESTED */
-	Surface *surf;
-	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
-	if (obj->type == SURFACE) {
-		surf=(Surface*) obj->data;
-		ESWEEP_OBJ_ISVALID_SURFACE(obj, surf, ERR_NOT_ON_THIS_TYPE, ERR_OBJ_NOT_VALID);
-		*avg= __esweep_intern__sum(obj)/(surf->xsize*surf->ysize);
-	} else 	*avg= __esweep_intern__sum(obj)/obj->size;
-	return ERR_OK;
-}
+int esweep_avg(const esweep_object *obj, Real *avg) {
+	esweep_statistics stats;
+	int ret;
 
-int esweep_sum(const esweep_object *obj, Real *sum) { /* UNTESTED */
-	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
-	*sum= __esweep_intern__sum(obj);
+	if ((ret=esweep_stats(obj, &stats, 0)) != ERR_OK) return ret;
+	*avg=stats.mean;
 	return ERR_OK;
 }
 
-int esweep_sqsum(const esweep_object *obj, Real *sqsum) { /* UNTESTED */
-	Wave *wave;
-	Polar *polar;
-	Complex *cplx;
-	Surface *surf;
+int esweep_sum(const esweep_object *obj, Real *sum) {
+	esweep_statistics stats;
+	int ret;
 
-	int i, size;
-
-	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
+	if ((ret=esweep_stats(obj, &stats, 0)) != ERR_OK) return ret;
+	*sum=stats.sum;
+	return ERR_OK;
+}
 
-	*sqsum=0.0;
-	size=obj->size;
-	switch (obj->type) {
-		case WAVE:
-			wave=(Wave*) obj->data;
-			for (i=0;i<size;i++)
-				*sqsum+=wave[i]*wave[i];
-			break;
-		case POLAR:
-			polar=(Polar*) obj->data;
-			for (i=0;i<size;i++)
-				*sqsum+=polar[i].abs*polar[i].abs;
-			break;
-		case COMPLEX:
-			cplx=(Complex*) obj->data;
-			for (i=0;i<size;i++)
-				*sqsum+=cplx[i].real*cplx[i].real+cplx[i].imag*cplx[i].imag;;
-			break;
-		case SURFACE:
-			surf=(Surface*) obj->data;
-			for (i=0, size=surf->xsize*surf->ysize;i<size;i++)
-				*sqsum+=surf->z[i]*surf->z[i];
-			break;
-		default:
-			*sqsum=__NAN("");
-	}
+int esweep_sqsum(const esweep_object *obj, Real *sqsum) {
+	esweep_statistics stats;
+	int ret;
 
+	if ((ret=esweep_stats(obj, &stats, 0)) != ERR_OK) return ret;
+	*sqsum=stats.sqsum;
 	return ERR_OK;
 }
 
 int esweep_real(esweep_object *obj) { /* UNTESTED */
 	Complex *cpx;
 	Polar *polar;
+	Complex *cached;
 	int i;
+	esweep_nonFinite nf;
 
 	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
+	__esweep_nonFinite_enter(&nf);
 
 	switch (obj->type) {
 		case COMPLEX:
 			cpx=(Complex*) obj->data;
-			for (i=0;i<obj->size;i++) cpx[i].imag=0;
+			for (i=0;i<obj->size;i++) {
+				cpx[i].imag=0;
+				ESWEEP_NONFINITE(nf, cpx[i].real);
+			}
 			break;
 		case POLAR:
 			polar=(Polar*) obj->data;
 			cpx=(Complex*) polar;
-			for (i=0;i<obj->size;i++) {
-				cpx[i].real=polar[i].abs*COS(polar[i].arg);
-				cpx[i].imag=0;
+			if ((cached=(Complex*) __esweep_reprCached(obj)) != NULL) {
+				for (i=0;i<obj->size;i++) {
+					cpx[i].real=cached[i].real;
+					cpx[i].imag=0;
+					ESWEEP_NONFINITE(nf, cpx[i].real);
+				}
+			} else {
+				for (i=0;i<obj->size;i++) {
+					cpx[i].real=polar[i].abs*COS(polar[i].arg);
+					cpx[i].imag=0;
+					ESWEEP_NONFINITE(nf, cpx[i].real);
+				}
 			}
 			obj->type=COMPLEX;
 			break;
 		default:
 			ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE);
 	}
-	ESWEEP_ASSERT(correctFpException(obj), ERR_FP);
-	return ERR_OK;
+	return __esweep_nonFinite_leave(&nf);
 }
 
 int esweep_imag(esweep_object *obj) { /* UNTESTED */
 	Complex *cpx;
 	Polar *polar;
+	Complex *cached;
 	int i;
+	esweep_nonFinite nf;
 
 	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
+	__esweep_nonFinite_enter(&nf);
 
 	switch (obj->type) {
 		case COMPLEX:
 			cpx=(Complex*) obj->data;
-			for (i=0;i<obj->size;i++) cpx[i].real=0;
+			for (i=0;i<obj->size;i++) {
+				cpx[i].real=0;
+				ESWEEP_NONFINITE(nf, cpx[i].imag);
+			}
 			break;
 		case POLAR:
 			polar=(Polar*) obj->data;
 			cpx=(Complex*) polar;
-			for (i=0;i<obj->size;i++) {
-				cpx[i].imag=polar[i].abs*SIN(polar[i].arg);
-				cpx[i].real=0;
+			if ((cached=(Complex*) __esweep_reprCached(obj)) != NULL) {
+				for (i=0;i<obj->size;i++) {
+					cpx[i].imag=cached[i].imag;
+					cpx[i].real=0;
+					ESWEEP_NONFINITE(nf, cpx[i].imag);
+				}
+			} else {
+				for (i=0;i<obj->size;i++) {
+					cpx[i].imag=polar[i].abs*SIN(polar[i].arg);
+					cpx[i].real=0;
+					ESWEEP_NONFINITE(nf, cpx[i].imag);
+				}
 			}
 			obj->type=COMPLEX;
 			break;
 		default:
 			ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE);
 	}
-	ESWEEP_ASSERT(correctFpException(obj), ERR_FP);
-	return ERR_OK;
+	return __esweep_nonFinite_leave(&nf);
 }
 
 int esweep_abs(esweep_object *obj) { /* UNTESTED */
 	Complex *cpx;
 	Polar *polar;
+	Polar *cached;
 	Wave *wave;
 	Surface *surf;
 	int i, size;
+	esweep_nonFinite nf;
 
 	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
+	__esweep_nonFinite_enter(&nf);
 
 	switch (obj->type) {
 		case WAVE:
 			wave=(Wave*) obj->data;
-			for (i=0;i<obj->size;i++) wave[i]=FABS(wave[i]);
+			for (i=0;i<obj->size;i++) {
+				wave[i]=FABS(wave[i]);
+				ESWEEP_NONFINITE(nf, wave[i]);
+			}
 			break;
 		case COMPLEX:
 			cpx=(Complex*) obj->data;
 			polar=(Polar*) cpx;
-			for (i=0;i<obj->size;i++) {
-				polar[i].abs=CABS(cpx[i]);
-				polar[i].arg=0.0;
+			if ((cached=(Polar*) __esweep_reprCached(obj)) != NULL) {
+				for (i=0;i<obj->size;i++) {
+					polar[i].abs=cached[i].abs;
+					polar[i].arg=0.0;
+					ESWEEP_NONFINITE(nf, polar[i].abs);
+				}
+			} else {
+				for (i=0;i<obj->size;i++) {
+					polar[i].abs=CABS(cpx[i]);
+					polar[i].arg=0.0;
+					ESWEEP_NONFINITE(nf, polar[i].abs);
+				}
 			}
 			break;
 		case POLAR:
 			polar=(Polar*) obj->data;
-			for (i=0;i<obj->size;i++) polar[i].arg=0;
+			for (i=0;i<obj->size;i++) {
+				polar[i].arg=0;
+				ESWEEP_NONFINITE(nf, polar[i].abs);
+			}
 			break;
 		case SURFACE:
 			surf=(Surface*) obj->data;
 			ESWEEP_OBJ_ISVALID_SURFACE(obj, surf, ERR_NOT_ON_THIS_TYPE, ERR_OBJ_NOT_VALID);
-			for (i=0, size=surf->xsize*surf->ysize;i < size; i++)
+			for (i=0, size=surf->xsize*surf->ysize;i < size; i++) {
 				surf->z[i]=FABS(surf->z[i]);
+				ESWEEP_NONFINITE(nf, surf->z[i]);
+			}
 			break;
 		default:
 			ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE);
 	}
-	ESWEEP_ASSERT(correctFpException(obj), ERR_FP);
-	return ERR_OK;
+	return __esweep_nonFinite_leave(&nf);
 }
 
 int esweep_arg(esweep_object *obj) { /* UNTESTED */
 	Complex *cpx;
 	Polar *polar;
+	Polar *cached;
 	int i;
+	esweep_nonFinite nf;
 
 	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
+	__esweep_nonFinite_enter(&nf);
 
 	switch (obj->type) {
 		case COMPLEX:
 			cpx=(Complex*) obj->data;
 			polar=(Polar*) cpx;
-			for (i=0;i<obj->size;i++) {
-				polar[i].arg=ATAN2(cpx[i]);
-				polar[i].abs=0.0;
+			if ((cached=(Polar*) __esweep_reprCached(obj)) != NULL) {
+				for (i=0;i<obj->size;i++) {
+					polar[i].arg=cached[i].arg;
+					polar[i].abs=0.0;
+					ESWEEP_NONFINITE(nf, polar[i].arg);
+				}
+			} else {
+				for (i=0;i<obj->size;i++) {
+					polar[i].arg=ATAN2(cpx[i]);
+					polar[i].abs=0.0;
+					ESWEEP_NONFINITE(nf, polar[i].arg);
+				}
 			}
 			break;
 		case POLAR:
 			polar=(Polar*) obj->data;
-			for (i=0;i<obj->size;i++) polar[i].abs=0;
+			for (i=0;i<obj->size;i++) {
+				polar[i].abs=0;
+				ESWEEP_NONFINITE(nf, polar[i].arg);
+			}
 			break;
 		default:
 			return ERR_NOT_ON_THIS_TYPE;
 	}
-	ESWEEP_ASSERT(correctFpException(obj), ERR_FP);
-	return ERR_OK;
+	return __esweep_nonFinite_leave(&nf);
 }
 
 int esweep_clipLower(esweep_object *a, const esweep_object *b) {
@@ -597,73 +518,63 @@ int esweep_clipUpper(esweep_object *a, const esweep_object *b) {
 
 /* elementary math */
 
-#define CC(op, a, b, size_a, size_b, N) if (size_b == 1) { \
-						for (i=0;i < size_a;i++) { \
-							ESWEEP_MATH_CC_##op(a[i], b[0]); \
-						} \
+/*
+ * the element-wise operations run in the kernels of vmath.c,
+ * mixed Complex and Polar operands use the cached representation, see esweep_mem.c
+ */
+#define RR(op, a, b, size_a, size_b, N, nf) if (size_b == 1) { \
+						vmath_rp(VMATH_##op, a, b[0], b[0], size_a, nf); \
 					} else { \
 						N=size_a > size_b ? size_b : size_a; \
-						for (i=0;i < N;i++) { \
-							ESWEEP_MATH_CC_##op(a[i], b[i]); \
-						} \
+						vmath_rr(VMATH_##op, a, b, N, nf); \
 					}
 
-#define CP(op, a, b, size_a, size_b, N)	if (size_b == 1) { \
-						for (i=0;i < size_a;i++) { \
-							ESWEEP_MATH_CP_##op(a[i], b[0]); \
-						} \
+#define CC(op, a, b, size_a, size_b, N, nf) if (size_b == 1) { \
+						vmath_cs(VMATH_##op, a, b[0], size_a, nf); \
 					} else { \
 						N=size_a > size_b ? size_b : size_a; \
-						for (i=0;i < N;i++) { \
-							ESWEEP_MATH_CP_##op(a[i], b[i]); \
-						} \
+						vmath_cc(VMATH_##op, a, b, N, nf); \
 					}
 
-#define CR(op, a, b, size_a, size_b, N)	if (size_b == 1) { \
-						for (i=0;i < size_a;i++) { \
-							ESWEEP_MATH_CR_##op(a[i], b[0]); \
-						} \
+#define CR(op, a, b, size_a, size_b, N, nf)	if (size_b == 1) { \
+						vmath_crs(VMATH_##op, a, b[0], size_a, nf); \
 					} else { \
 						N=size_a > size_b ? size_b : size_a; \
-						for (i=0;i < N;i++) { \
-							ESWEEP_MATH_CR_##op(a[i], b[i]); \
-						} \
+						vmath_cr(VMATH_##op, a, b, N, nf); \
 					}
 
-#define PP(op, a, b, size_a, size_b, N)	if (size_b == 1) { \
-						for (i=0;i < size_a;i++) { \
-							ESWEEP_MATH_PP_##op(a[i], b[0]); \
-						} \
+#define PP(op, a, b, size_a, size_b, N, nf)	if (size_b == 1) { \
+						vmath_ps(VMATH_##op, a, b[0], size_a, nf); \
 					} else { \
 						N=size_a > size_b ? size_b : size_a; \
-						for (i=0;i < N;i++) { \
-							ESWEEP_MATH_PP_##op(a[i], b[i]); \
-						} \
+						vmath_pp(VMATH_##op, a, b, N, nf); \
 					}
 
-#define PR(op, a, b, size_a, size_b, N)	if (size_b == 1) { \
-						for (i=0;i < size_a;i++) { \
-							ESWEEP_MATH_PR_##op(a[i], b[0]); \
-						} \
+#define PR(op, a, b, size_a, size_b, N, nf)	if (size_b == 1) { \
+						vmath_prs(VMATH_##op, a, b[0], size_a, nf); \
 					} else { \
 						N=size_a > size_b ? size_b : size_a; \
-						for (i=0;i < N;i++) { \
-							ESWEEP_MATH_PR_##op(a[i], b[i]); \
-						} \
+						vmath_pr(VMATH_##op, a, b, N, nf); \
 					}
 
 
+/* b is const, but its cached representation is not part of its value */
+#define REPR_COMPLEX(b) __esweep_reprComplex((esweep_object*) b)
+#define REPR_POLAR(b) __esweep_reprPolar((esweep_object*) b)
+
 int esweep_add(esweep_object *a, const esweep_object *b) {
 	Wave *wave_a, *wave_b;
 	Complex *cpx_a, *cpx_b;
 	Polar *polar_a, *polar_b;
 	Surface *surf;
-	int i, N;
+	int N;
+	esweep_nonFinite nf;
 
 	ESWEEP_OBJ_NOTEMPTY(a, ERR_EMPTY_OBJECT);
 	ESWEEP_OBJ_NOTEMPTY(b, ERR_EMPTY_OBJECT);
 
 	ESWEEP_SAME_MAPPING(a, b, ERR_DIFF_MAPPING);
+	__esweep_nonFinite_enter(&nf);
 
 	switch (a->type) {
 		case WAVE:
@@ -671,27 +582,20 @@ int esweep_add(esweep_object *a, const esweep_object *b) {
 			switch (b->type) {
 				case WAVE:
 					wave_b=(Wave*) b->data;
-					if (b->size == 1) {
-						for (i=0;i < a->size;i++) {
-							wave_a[i] += wave_b[0];
-						}
-					} else {
-						N=a->size > b->size ? b->size : a->size;
-						for (i=0;i < N;i++) {
-							wave_a[i] += wave_b[i];
-						}
-					}
+					RR(ADD, wave_a, wave_b, a->size, b->size, N, &nf);
 					break;
 				case COMPLEX:
 					ESWEEP_CONV_WAVE2COMPLEX(a, cpx_a);
 					cpx_b=(Complex*) b->data;
-					CC(ADD, cpx_a, cpx_b, a->size, b->size, N);
+					CC(ADD, cpx_a, cpx_b, a->size, b->size, N, &nf);
 					break;
 				case POLAR:
 					ESWEEP_CONV_WAVE2COMPLEX(a, cpx_a);
-					polar_b=(Polar*) b->data;
-					CP(ADD, cpx_a, polar_b, a->size, b->size, N);
-					c2p((Polar*) cpx_a, cpx_a, a->size);
+					ESWEEP_ASSERT((cpx_b=REPR_COMPLEX(b)) != NULL, ERR_MALLOC);
+					CC(ADD, cpx_a, cpx_b, a->size, b->size, N, NULL);
+					/* the result is polar, keep the complex data as cache */
+					ESWEEP_ASSERT(__esweep_reprPolar(a) != NULL && __esweep_reprSwap(a), ERR_MALLOC);
+					__esweep_nonFinite_scan(&nf, (Real*) a->data, 2*a->size);
 					break;
 				default:
 					ESWEEP_NOT_THIS_TYPE(b->type, ERR_NOT_ON_THIS_TYPE);
@@ -702,17 +606,17 @@ int esweep_add(esweep_object *a, const esweep_object *b) {
 				case WAVE:
 					cpx_a=(Complex*) a->data;
 					wave_b=(Wave*) b->data;
-					CR(ADD, cpx_a, wave_b, a->size, b->size, N);
+					CR(ADD, cpx_a, wave_b, a->size, b->size, N, &nf);
 					break;
 				case COMPLEX:
 					cpx_a=(Complex*) a->data;
 					cpx_b=(Complex*) b->data;
-					CC(ADD, cpx_a, cpx_b, a->size, b->size, N);
+					CC(ADD, cpx_a, cpx_b, a->size, b->size, N, &nf);
 					break;
 				case POLAR:
 					cpx_a=(Complex*) a->data;
-					polar_b=(Polar*) b->data;
-					CP(ADD, cpx_a, polar_b, a->size, b->size, N);
+					ESWEEP_ASSERT((cpx_b=REPR_COMPLEX(b)) != NULL, ERR_MALLOC);
+					CC(ADD, cpx_a, cpx_b, a->size, b->size, N, &nf);
 					break;
 				default:
 					ESWEEP_NOT_THIS_TYPE(b->type, ERR_NOT_ON_THIS_TYPE);
@@ -722,22 +626,24 @@ int esweep_add(esweep_object *a, const esweep_object *b) {
 			polar_a=(Polar*) a->data;
 			switch (b->type) {
 				case WAVE:
-					cpx_a=(Complex*) polar_a;
-					p2c(cpx_a, polar_a, a->size);
+					ESWEEP_ASSERT((cpx_a=__esweep_reprComplex(a)) != NULL, ERR_MALLOC);
 					wave_b=(Wave*) b->data;
-					CR(ADD, cpx_a, wave_b, a->size, b->size, N);
+					CR(ADD, cpx_a, wave_b, a->size, b->size, N, NULL);
 					c2p(polar_a, cpx_a, a->size);
+					__esweep_reprValidate(a);
+					__esweep_nonFinite_scan(&nf, (Real*) polar_a, 2*a->size);
 					break;
 				case COMPLEX:
-					cpx_a=(Complex*) polar_a;
-					p2c(cpx_a, polar_a, a->size);
+					ESWEEP_ASSERT((cpx_a=__esweep_reprComplex(a)) != NULL, ERR_MALLOC);
 					cpx_b=(Complex*) b->data;
-					CC(ADD, cpx_a, cpx_b, a->size, b->size, N);
+					CC(ADD, cpx_a, cpx_b, a->size, b->size, N, NULL);
 					c2p(polar_a, cpx_a, a->size);
+					__esweep_reprValidate(a);
+					__esweep_nonFinite_scan(&nf, (Real*) polar_a, 2*a->size);
 					break;
 				case POLAR:
 					polar_b=(Polar*) b->data;
-					PP(ADD, polar_a, polar_b, a->size, b->size, N);
+					PP(ADD, polar_a, polar_b, a->size, b->size, N, &nf);
 					break;
 				default:
 					ESWEEP_NOT_THIS_TYPE(b->type, ERR_NOT_ON_THIS_TYPE);
@@ -749,10 +655,7 @@ int esweep_add(esweep_object *a, const esweep_object *b) {
 					ESWEEP_ASSERT(b->size == 1, ERR_SIZE_MISMATCH);
 					wave_b=(Wave*) b->data;
 					surf=(Surface*) a->data;
-					N=surf->xsize*surf->ysize;
-					for (i=0; i < N; i++) {
-						(surf->z)[i]+=wave_b[0];
-					}
+					vmath_rp(VMATH_ADD, surf->z, wave_b[0], wave_b[0], surf->xsize*surf->ysize, &nf);
 					break;
 				default:
 					ESWEEP_NOT_THIS_TYPE(b->type, ERR_NOT_ON_THIS_TYPE);
@@ -761,8 +664,7 @@ int esweep_add(esweep_object *a, const esweep_object *b) {
 		default:
 			ESWEEP_NOT_THIS_TYPE(a->type, ERR_NOT_ON_THIS_TYPE);
 	}
-	ESWEEP_ASSERT(correctFpException(a), ERR_FP);
-	return ERR_OK;
+	return __esweep_nonFinite_leave(&nf);
 }
 
 int esweep_sub(esweep_object *a, const esweep_object *b) {
@@ -770,12 +672,14 @@ int esweep_sub(esweep_object *a, const esweep_object *b) {
 	Complex *cpx_a, *cpx_b;
 	Polar *polar_a, *polar_b;
 	Surface *surf;
-	int i, N;
+	int N;
+	esweep_nonFinite nf;
 
 	ESWEEP_OBJ_NOTEMPTY(a, ERR_EMPTY_OBJECT);
 	ESWEEP_OBJ_NOTEMPTY(b, ERR_EMPTY_OBJECT);
 
 	ESWEEP_SAME_MAPPING(a, b, ERR_DIFF_MAPPING);
+	__esweep_nonFinite_enter(&nf);
 
 	switch (a->type) {
 		case WAVE:
@@ -783,27 +687,20 @@ int esweep_sub(esweep_object *a, const esweep_object *b) {
 			switch (b->type) {
 				case WAVE:
 					wave_b=(Wave*) b->data;
-					if (b->size == 1) {
-						for (i=0;i < a->size;i++) {
-							wave_a[i] -= wave_b[0];
-						}
-					} else {
-						N=a->size > b->size ? b->size : a->size;
-						for (i=0;i < N;i++) {
-							wave_a[i] -= wave_b[i];
-						}
-					}
+					RR(SUB, wave_a, wave_b, a->size, b->size, N, &nf);
 					break;
 				case COMPLEX:
 					ESWEEP_CONV_WAVE2COMPLEX(a, cpx_a);
 					cpx_b=(Complex*) b->data;
-					CC(SUB, cpx_a, cpx_b, a->size, b->size, N);
+					CC(SUB, cpx_a, cpx_b, a->size, b->size, N, &nf);
 					break;
 				case POLAR:
 					ESWEEP_CONV_WAVE2COMPLEX(a, cpx_a);
-					polar_b=(Polar*) b->data;
-					CP(SUB, cpx_a, polar_b, a->size, b->size, N);
-					c2p((Polar*) cpx_a, cpx_a, a->size);
+					ESWEEP_ASSERT((cpx_b=REPR_COMPLEX(b)) != NULL, ERR_MALLOC);
+					CC(SUB, cpx_a, cpx_b, a->size, b->size, N, NULL);
+					/* the result is polar, keep the complex data as cache */
+					ESWEEP_ASSERT(__esweep_reprPolar(a) != NULL && __esweep_reprSwap(a), ERR_MALLOC);
+					__esweep_nonFinite_scan(&nf, (Real*) a->data, 2*a->size);
 					break;
 				default:
 					ESWEEP_NOT_THIS_TYPE(b->type, ERR_NOT_ON_THIS_TYPE);
@@ -814,17 +711,17 @@ int esweep_sub(esweep_object *a, const esweep_object *b) {
 				case WAVE:
 					cpx_a=(Complex*) a->data;
 					wave_b=(Wave*) b->data;
-					CR(SUB, cpx_a, wave_b, a->size, b->size, N);
+					CR(SUB, cpx_a, wave_b, a->size, b->size, N, &nf);
 					break;
 				case COMPLEX:
 					cpx_a=(Complex*) a->data;
 					cpx_b=(Complex*) b->data;
-					CC(SUB, cpx_a, cpx_b, a->size, b->size, N);
+					CC(SUB, cpx_a, cpx_b, a->size, b->size, N, &nf);
 					break;
 				case POLAR:
 					cpx_a=(Complex*) a->data;
-					polar_b=(Polar*) b->data;
-					CP(SUB, cpx_a, polar_b, a->size, b->size, N);
+					ESWEEP_ASSERT((cpx_b=REPR_COMPLEX(b)) != NULL, ERR_MALLOC);
+					CC(SUB, cpx_a, cpx_b, a->size, b->size, N, &nf);
 					break;
 				default:
 					ESWEEP_NOT_THIS_TYPE(b->type, ERR_NOT_ON_THIS_TYPE);
@@ -834,22 +731,24 @@ int esweep_sub(esweep_object *a, const esweep_object *b) {
 			polar_a=(Polar*) a->data;
 			switch (b->type) {
 				case WAVE:
-					cpx_a=(Complex*) polar_a;
-					p2c(cpx_a, polar_a, a->size);
+					ESWEEP_ASSERT((cpx_a=__esweep_reprComplex(a)) != NULL, ERR_MALLOC);
 					wave_b=(Wave*) b->data;
-					CR(SUB, cpx_a, wave_b, a->size, b->size, N);
+					CR(SUB, cpx_a, wave_b, a->size, b->size, N, NULL);
 					c2p(polar_a, cpx_a, a->size);
+					__esweep_reprValidate(a);
+					__esweep_nonFinite_scan(&nf, (Real*) polar_a, 2*a->size);
 					break;
 				case COMPLEX:
-					cpx_a=(Complex*) polar_a;
-					p2c(cpx_a, polar_a, a->size);
+					ESWEEP_ASSERT((cpx_a=__esweep_reprComplex(a)) != NULL, ERR_MALLOC);
 					cpx_b=(Complex*) b->data;
-					CC(SUB, cpx_a, cpx_b, a->size, b->size, N);
+					CC(SUB, cpx_a, cpx_b, a->size, b->size, N, NULL);
 					c2p(polar_a, cpx_a, a->size);
+					__esweep_reprValidate(a);
+					__esweep_nonFinite_scan(&nf, (Real*) polar_a, 2*a->size);
 					break;
 				case POLAR:
 					polar_b=(Polar*) b->data;
-					PP(SUB, polar_a, polar_b, a->size, b->size, N);
+					PP(SUB, polar_a, polar_b, a->size, b->size, N, &nf);
 					break;
 				default:
 					ESWEEP_NOT_THIS_TYPE(b->type, ERR_NOT_ON_THIS_TYPE);
@@ -861,10 +760,7 @@ int esweep_sub(esweep_object *a, const esweep_object *b) {
 					ESWEEP_ASSERT(b->size == 1, ERR_SIZE_MISMATCH);
 					wave_b=(Wave*) b->data;
 					surf=(Surface*) a->data;
-					N=surf->xsize*surf->ysize;
-					for (i=0; i < N; i++) {
-						(surf->z)[i]-=wave_b[0];
-					}
+					vmath_rp(VMATH_SUB, surf->z, wave_b[0], wave_b[0], surf->xsize*surf->ysize, &nf);
 					break;
 				default:
 					ESWEEP_NOT_THIS_TYPE(b->type, ERR_NOT_ON_THIS_TYPE);
@@ -873,8 +769,7 @@ int esweep_sub(esweep_object *a, const esweep_object *b) {
 		default:
 			ESWEEP_NOT_THIS_TYPE(a->type, ERR_NOT_ON_THIS_TYPE);
 	}
-	ESWEEP_ASSERT(correctFpException(a), ERR_FP);
-	return ERR_OK;
+	return __esweep_nonFinite_leave(&nf);
 }
 
 int esweep_mul(esweep_object *a, const esweep_object *b) {
@@ -882,13 +777,14 @@ int esweep_mul(esweep_object *a, const esweep_object *b) {
 	Complex *cpx_a, *cpx_b;
 	Polar *polar_a, *polar_b;
 	Surface *surf;
-	int i, N;
-	Real tmp; // necessary for *_MUL macros
+	int N;
+	esweep_nonFinite nf;
 
 	ESWEEP_OBJ_NOTEMPTY(a, ERR_EMPTY_OBJECT);
 	ESWEEP_OBJ_NOTEMPTY(b, ERR_EMPTY_OBJECT);
 
 	ESWEEP_SAME_MAPPING(a, b, ERR_DIFF_MAPPING);
+	__esweep_nonFinite_enter(&nf);
 
 	switch (a->type) {
 		case WAVE:
@@ -896,26 +792,17 @@ int esweep_mul(esweep_object *a, const esweep_object *b) {
 			switch (b->type) {
 				case WAVE:
 					wave_b=(Wave*) b->data;
-					if (b->size == 1) {
-						for (i=0;i < a->size;i++) {
-							wave_a[i] *= wave_b[0];
-						}
-					} else {
-						N=a->size > b->size ? b->size : a->size;
-						for (i=0;i < N;i++) {
-							wave_a[i] *= wave_b[i];
-						}
-					}
+					RR(MUL, wave_a, wave_b, a->size, b->size, N, &nf);
 					break;
 				case COMPLEX:
 					ESWEEP_CONV_WAVE2COMPLEX(a, cpx_a);
 					cpx_b=(Complex*) b->data;
-					CC(MUL, cpx_a, cpx_b, a->size, b->size, N);
+					CC(MUL, cpx_a, cpx_b, a->size, b->size, N, &nf);
 					break;
 				case POLAR:
 					ESWEEP_CONV_WAVE2POLAR(a, polar_a);
 					polar_b=(Polar*) b->data;
-					PP(MUL, polar_a, polar_b, a->size, b->size, N);
+					PP(MUL, polar_a, polar_b, a->size, b->size, N, &nf);
 					break;
 				default:
 					ESWEEP_NOT_THIS_TYPE(b->type, ERR_NOT_ON_THIS_TYPE);
@@ -926,18 +813,16 @@ int esweep_mul(esweep_object *a, const esweep_object *b) {
 			switch (b->type) {
 				case WAVE:
 					wave_b=(Wave*) b->data;
-					CR(MUL, cpx_a, wave_b, a->size, b->size, N);
+					CR(MUL, cpx_a, wave_b, a->size, b->size, N, &nf);
 					break;
 				case COMPLEX:
 					cpx_b=(Complex*) b->data;
-					CC(MUL, cpx_a, cpx_b, a->size, b->size, N);
+					CC(MUL, cpx_a, cpx_b, a->size, b->size, N, &nf);
 					break;
 				case POLAR:
-					polar_a=(Polar*) cpx_a;
-					c2p(polar_a, cpx_a, a->size);
-					polar_b=(Polar*) b->data;
-					PP(MUL, polar_a, polar_b, a->size, b->size, N);
-					p2c(cpx_a, polar_a, a->size);
+					/* cheaper than the polar way, cos() and sin() of b are cached */
+					ESWEEP_ASSERT((cpx_b=REPR_COMPLEX(b)) != NULL, ERR_MALLOC);
+					CC(MUL, cpx_a, cpx_b, a->size, b->size, N, &nf);
 					break;
 				default:
 					ESWEEP_NOT_THIS_TYPE(b->type, ERR_NOT_ON_THIS_TYPE);
@@ -948,18 +833,15 @@ int esweep_mul(esweep_object *a, const esweep_object *b) {
 			switch (b->type) {
 				case WAVE:
 					wave_b=(Wave*) b->data;
-					PR(MUL, polar_a, wave_b, a->size, b->size, N);
+					PR(MUL, polar_a, wave_b, a->size, b->size, N, &nf);
 					break;
 				case COMPLEX:
-					cpx_b=(Complex*) b->data;
-					polar_b=(Polar*) b->data;
-					c2p(polar_b, cpx_b, b->size);
-					PP(MUL, polar_a, polar_b, a->size, b->size, N);
-					p2c(cpx_b, polar_b, b->size);
+					ESWEEP_ASSERT((polar_b=REPR_POLAR(b)) != NULL, ERR_MALLOC);
+					PP(MUL, polar_a, polar_b, a->size, b->size, N, &nf);
 					break;
 				case POLAR:
 					polar_b=(Polar*) b->data;
-					PP(MUL, polar_a, polar_b, a->size, b->size, N);
+					PP(MUL, polar_a, polar_b, a->size, b->size, N, &nf);
 					break;
 				default:
 					ESWEEP_NOT_THIS_TYPE(b->type, ERR_NOT_ON_THIS_TYPE);
@@ -971,10 +853,7 @@ int esweep_mul(esweep_object *a, const esweep_object *b) {
 					ESWEEP_ASSERT(b->size == 1, ERR_SIZE_MISMATCH);
 					wave_b=(Wave*) b->data;
 					surf=(Surface*) a->data;
-					N=surf->xsize*surf->ysize;
-					for (i=0; i < N; i++) {
-						(surf->z)[i]*=wave_b[0];
-					}
+					vmath_rp(VMATH_MUL, surf->z, wave_b[0], wave_b[0], surf->xsize*surf->ysize, &nf);
 					break;
 				default:
 					ESWEEP_NOT_THIS_TYPE(b->type, ERR_NOT_ON_THIS_TYPE);
@@ -983,8 +862,7 @@ int esweep_mul(esweep_object *a, const esweep_object *b) {
 		default:
 			ESWEEP_NOT_THIS_TYPE(a->type, ERR_NOT_ON_THIS_TYPE);
 	}
-	ESWEEP_ASSERT(correctFpException(a), ERR_FP);
-	return ERR_OK;
+	return __esweep_nonFinite_leave(&nf);
 }
 
 int esweep_div(esweep_object *a, const esweep_object *b) {
@@ -992,13 +870,14 @@ int esweep_div(esweep_object *a, const esweep_object *b) {
 	Complex *cpx_a, *cpx_b;
 	Polar *polar_a, *polar_b;
 	Surface *surf;
-	int i, N;
-	Real tmp, denom; // necessary for *_DIV macros
+	int N;
+	esweep_nonFinite nf;
 
 	ESWEEP_OBJ_NOTEMPTY(a, ERR_EMPTY_OBJECT);
 	ESWEEP_OBJ_NOTEMPTY(b, ERR_EMPTY_OBJECT);
 
 	ESWEEP_SAME_MAPPING(a, b, ERR_DIFF_MAPPING);
+	__esweep_nonFinite_enter(&nf);
 
 	switch (a->type) {
 		case WAVE:
@@ -1006,26 +885,17 @@ int esweep_div(esweep_object *a, const esweep_object *b) {
 			switch (b->type) {
 				case WAVE:
 					wave_b=(Wave*) b->data;
-					if (b->size == 1) {
-						for (i=0;i < a->size;i++) {
-							wave_a[i] /= wave_b[0];
-						}
-					} else {
-						N=a->size > b->size ? b->size : a->size;
-						for (i=0;i < N;i++) {
-							wave_a[i] /= wave_b[i];
-						}
-					}
+					RR(DIV, wave_a, wave_b, a->size, b->size, N, &nf);
 					break;
 				case COMPLEX:
 					ESWEEP_CONV_WAVE2COMPLEX(a, cpx_a);
 					cpx_b=(Complex*) b->data;
-					CC(DIV, cpx_a, cpx_b, a->size, b->size, N);
+					CC(DIV, cpx_a, cpx_b, a->size, b->size, N, &nf);
 					break;
 				case POLAR:
 					ESWEEP_CONV_WAVE2POLAR(a, polar_a);
 					polar_b=(Polar*) b->data;
-					PP(DIV, polar_a, polar_b, a->size, b->size, N);
+					PP(DIV, polar_a, polar_b, a->size, b->size, N, &nf);
 					break;
 				default:
 					ESWEEP_NOT_THIS_TYPE(b->type, ERR_NOT_ON_THIS_TYPE);
@@ -1036,18 +906,20 @@ int esweep_div(esweep_object *a, const esweep_object *b) {
 			switch (b->type) {
 				case WAVE:
 					wave_b=(Wave*) b->data;
-					CR(DIV, cpx_a, wave_b, a->size, b->size, N);
+					CR(DIV, cpx_a, wave_b, a->size, b->size, N, &nf);
 					break;
 				case COMPLEX:
 					cpx_b=(Complex*) b->data;
-					CC(DIV, cpx_a, cpx_b, a->size, b->size, N);
+					CC(DIV, cpx_a, cpx_b, a->size, b->size, N, &nf);
 					break;
 				case POLAR:
-					polar_a=(Polar*) cpx_a;
-					c2p(polar_a, cpx_a, a->size);
+					/* the polar way, which gives inf instead of NaN when |b| is zero */
+					ESWEEP_ASSERT((polar_a=__esweep_reprPolar(a)) != NULL, ERR_MALLOC);
 					polar_b=(Polar*) b->data;
-					PP(DIV, polar_a, polar_b, a->size, b->size, N);
+					PP(DIV, polar_a, polar_b, a->size, b->size, N, NULL);
 					p2c(cpx_a, polar_a, a->size);
+					__esweep_reprValidate(a);
+					__esweep_nonFinite_scan(&nf, (Real*) cpx_a, 2*a->size);
 					break;
 				default:
 					ESWEEP_NOT_THIS_TYPE(b->type, ERR_NOT_ON_THIS_TYPE);
@@ -1058,18 +930,15 @@ int esweep_div(esweep_object *a, const esweep_object *b) {
 			switch (b->type) {
 				case WAVE:
 					wave_b=(Wave*) b->data;
-					PR(DIV, polar_a, wave_b, a->size, b->size, N);
+					PR(DIV, polar_a, wave_b, a->size, b->size, N, &nf);
 					break;
 				case COMPLEX:
-					cpx_b=(Complex*) b->data;
-					polar_b=(Polar*) b->data;
-					c2p(polar_b, cpx_b, b->size);
-					PP(DIV, polar_a, polar_b, a->size, b->size, N);
-					p2c(cpx_b, polar_b, b->size);
+					ESWEEP_ASSERT((polar_b=REPR_POLAR(b)) != NULL, ERR_MALLOC);
+					PP(DIV, polar_a, polar_b, a->size, b->size, N, &nf);
 					break;
 				case POLAR:
 					polar_b=(Polar*) b->data;
-					PP(DIV, polar_a, polar_b, a->size, b->size, N);
+					PP(DIV, polar_a, polar_b, a->size, b->size, N, &nf);
 					break;
 				default:
 					ESWEEP_NOT_THIS_TYPE(b->type, ERR_NOT_ON_THIS_TYPE);
@@ -1081,10 +950,7 @@ int esweep_div(esweep_object *a, const esweep_object *b) {
 					ESWEEP_ASSERT(b->size == 1, ERR_SIZE_MISMATCH);
 					wave_b=(Wave*) b->data;
 					surf=(Surface*) a->data;
-					N=surf->xsize*surf->ysize;
-					for (i=0; i < N; i++) {
-						(surf->z)[i]*=wave_b[0];
-					}
+					vmath_rp(VMATH_DIV, surf->z, wave_b[0], wave_b[0], surf->xsize*surf->ysize, &nf);
 					break;
 				default:
 					ESWEEP_NOT_THIS_TYPE(b->type, ERR_NOT_ON_THIS_TYPE);
@@ -1093,8 +959,7 @@ int esweep_div(esweep_object *a, const esweep_object *b) {
 		default:
 			ESWEEP_NOT_THIS_TYPE(a->type, ERR_NOT_ON_THIS_TYPE);
 	}
-	ESWEEP_ASSERT(correctFpException(a), ERR_FP);
-	return ERR_OK;
+	return __esweep_nonFinite_leave(&nf);
 }
 
 /* power, exponentiation, logarithm */
@@ -1106,26 +971,33 @@ int esweep_ln(esweep_object *obj) { /* natural logarithm */
 	Complex *cpx;
 	int i, zsize;
 	Real abs, arg;
+	esweep_nonFinite nf;
 
 	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
+	__esweep_nonFinite_enter(&nf);
 
 	switch (obj->type) {
 		case WAVE:
 			wave=(Wave*) obj->data;
 			for (i=0;i<obj->size;i++) {
 				wave[i]=LN(FABS(wave[i]));
+				ESWEEP_NONFINITE(nf, wave[i]);
 			}
 			break;
 		case POLAR:
 			polar=(Polar*) obj->data;
 			for (i=0;i<obj->size;i++) {
 				polar[i].abs=LN(polar[i].abs);
+				ESWEEP_NONFINITE(nf, polar[i].abs);
 			}
 			break;
 		case SURFACE:
 			surface=(Surface*) obj->data;
 			zsize=surface->xsize*(surface->ysize);
-			for (i=0;i<zsize;i++) surface->z[i]=LN(surface->z[i]);
+			for (i=0;i<zsize;i++) {
+				surface->z[i]=LN(surface->z[i]);
+				ESWEEP_NONFINITE(nf, surface->z[i]);
+			}
 			break;
 		case COMPLEX:
 			cpx=(Complex*) obj->data;
@@ -1134,13 +1006,13 @@ int esweep_ln(esweep_object *obj) { /* natural logarithm */
 				arg=ATAN2(cpx[i]);
 				cpx[i].real=LN(abs);
 				cpx[i].imag=arg;
+				ESWEEP_NONFINITE(nf, cpx[i].real);
 			}
 			break;
 		default:
 			ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE);
 	}
-	ESWEEP_ASSERT(correctFpException(obj), ERR_FP);
-	return ERR_OK;
+	return __esweep_nonFinite_leave(&nf);
 }
 
 int esweep_lg(esweep_object *obj) { /* logarithm to base 10 */
@@ -1150,26 +1022,33 @@ int esweep_lg(esweep_object *obj) { /* logarithm to base 10 */
 	Complex *cpx;
 	int i, zsize;
 	Real abs, arg;
+	esweep_nonFinite nf;
 
 	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
+	__esweep_nonFinite_enter(&nf);
 
 	switch (obj->type) {
 		case WAVE:
 			wave=(Wave*) obj->data;
 			for (i=0;i<obj->size;i++) {
 				wave[i]=LG(FABS(wave[i]));
+				ESWEEP_NONFINITE(nf, wave[i]);
 			}
 			break;
 		case POLAR:
 			polar=(Polar*) obj->data;
 			for (i=0;i<obj->size;i++) {
 				polar[i].abs=LG(polar[i].abs);
+				ESWEEP_NONFINITE(nf, polar[i].abs);
 			}
 			break;
 		case SURFACE:
 			surface=(Surface*) obj->data;
 			zsize=surface->xsize*(surface->ysize);
-			for (i=0;i<zsize;i++) surface->z[i]=LG(surface->z[i]);
+			for (i=0;i<zsize;i++) {
+				surface->z[i]=LG(surface->z[i]);
+				ESWEEP_NONFINITE(nf, surface->z[i]);
+			}
 			break;
 		case COMPLEX:
 			cpx=(Complex*) obj->data;
@@ -1178,14 +1057,13 @@ int esweep_lg(esweep_object *obj) { /* logarithm to base 10 */
 				arg=ATAN2(cpx[i]);
 				cpx[i].real=LG(abs);
 				cpx[i].imag=arg;
+				ESWEEP_NONFINITE(nf, cpx[i].real);
 			}
 			break;
 		default:
 			ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE);
 	}
-	ESWEEP_ASSERT(correctFpException(obj), ERR_FP);
-
-	return ERR_OK;
+	return __esweep_nonFinite_leave(&nf);
 }
 
 int esweep_exp(esweep_object *obj) { /* e^obj */
@@ -1195,26 +1073,33 @@ int esweep_exp(esweep_object *obj) { /* e^obj */
 	Complex *cpx;
 	int i, zsize;
 	Real abs, arg;
+	esweep_nonFinite nf;
 
 	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
+	__esweep_nonFinite_enter(&nf);
 
 	switch (obj->type) {
 		case WAVE:
 			wave=(Wave*) obj->data;
 			for (i=0;i<obj->size;i++) {
 				wave[i]=EXP(wave[i]);
+				ESWEEP_NONFINITE(nf, wave[i]);
 			}
 			break;
 		case POLAR:
 			polar=(Polar*) obj->data;
 			for (i=0;i<obj->size;i++) {
 				polar[i].abs=EXP(polar[i].abs);
+				ESWEEP_NONFINITE(nf, polar[i].abs);
 			}
 			break;
 		case SURFACE:
 			surface=(Surface*) obj->data;
 			zsize=surface->xsize*(surface->ysize);
-			for (i=0;i<zsize;i++) surface->z[i]=EXP(surface->z[i]);
+			for (i=0;i<zsize;i++) {
+				surface->z[i]=EXP(surface->z[i]);
+				ESWEEP_NONFINITE(nf, surface->z[i]);
+			}
 			break;
 		case COMPLEX:
 			cpx=(Complex*) obj->data;
@@ -1223,13 +1108,14 @@ int esweep_exp(esweep_object *obj) { /* e^obj */
 				arg=cpx[i].imag;
 				cpx[i].real=abs*COS(arg);
 				cpx[i].imag=abs*SIN(arg);
+				ESWEEP_NONFINITE(nf, cpx[i].real);
+				ESWEEP_NONFINITE(nf, cpx[i].imag);
 			}
 			break;
 		default:
 			ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE);
 	}
-	ESWEEP_ASSERT(correctFpException(obj), ERR_FP);
-	return ERR_OK;
+	return __esweep_nonFinite_leave(&nf);
 }
 
 int esweep_pow(esweep_object *obj, Real x) { /* obj^x */
@@ -1237,33 +1123,39 @@ int esweep_pow(esweep_object *obj, Real x) { /* obj^x */
 	Polar *polar;
 	Surface *surface;
 	int i, zsize;
+	esweep_nonFinite nf;
 
 	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
+	__esweep_nonFinite_enter(&nf);
 
 	switch (obj->type) {
 		case WAVE:
 			wave=(Wave*) obj->data;
 			for (i=0;i<obj->size;i++) {
 				wave[i]=POW(wave[i], x);
+				ESWEEP_NONFINITE(nf, wave[i]);
 			}
 			break;
 		case POLAR:
 			polar=(Polar*) obj->data;
 			for (i=0;i<obj->size;i++) {
 				polar[i].abs=POW(polar[i].abs, x);
+				ESWEEP_NONFINITE(nf, polar[i].abs);
 			}
 			break;
 		case SURFACE:
 			surface=(Surface*) obj->data;
 			zsize=surface->xsize*(surface->ysize);
-			for (i=0;i<zsize;i++) surface->z[i]=POW(surface->z[i], x);
+			for (i=0;i<zsize;i++) {
+				surface->z[i]=POW(surface->z[i], x);
+				ESWEEP_NONFINITE(nf, surface->z[i]);
+			}
 			break;
 		case COMPLEX:
 		default:
 			ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE);
 	}
-	ESWEEP_ASSERT(correctFpException(obj), ERR_FP);
-	return ERR_OK;
+	return __esweep_nonFinite_leave(&nf);
 }
 
 /*
@@ -1271,65 +1163,31 @@ calculates the schroeder integral of a WAVE
 this is not the real schroeder equation, but the backward integral
 to get the energy decay curve you have to square the impulse response with
 esweep_pow(a, 2)
+the running sum is compensated (Neumaier), so the tail keeps its precision
+even when the sum is dominated by the direct sound
 */
 int esweep_schroeder(esweep_object *obj) {
-	Wave *wave, *wave_out;
-	int i, j;
+	Wave *wave;
+	double sum=0.0, c=0.0, t;
+	int i;
+	esweep_nonFinite nf;
 
 	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
+	__esweep_nonFinite_enter(&nf);
 
-	if (obj->type != WAVE) ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_ASSERT(obj->type == WAVE, ERR_NOT_ON_THIS_TYPE);
 
 	wave=(Wave*) obj->data;
-	wave_out=(Wave*) calloc(obj->size, sizeof(Wave));
 
-	for (i=0;i<obj->size;i++) {
-		for (j=i;j<obj->size;j++) {
-			wave_out[i]+=wave[j];
-		}
+	for (i=obj->size-1;i>=0;i--) {
+		t=sum+wave[i];
+		if (fabs(sum) >= fabs(wave[i])) c+=(sum-t)+wave[i];
+		else c+=(wave[i]-t)+sum;
+		sum=t;
+		wave[i]=sum+c;
+		ESWEEP_NONFINITE(nf, wave[i]);
 	}
 
-	free(obj->data);
-	obj->data=wave_out;
-
-	ESWEEP_ASSERT(correctFpException(obj), ERR_FP);
-	return ERR_OK;
-}
-
-static inline Real __esweep_intern__sum(const esweep_object *obj) {
-	Wave *wave;
-	Polar *polar;
-	Complex *cplx;
-	Surface *surf;
-
-	int i, size;
-	Real sum=0.0;
-
-	size=obj->size;
-	switch (obj->type) {
-		case WAVE:
-			wave=(Wave*) obj->data;
-			for (i=0;i<size;i++)
-				sum+=wave[i];
-			break;
-		case POLAR:
-			polar=(Polar*) obj->data;
-			for (i=0;i<size;i++)
-				sum+=polar[i].abs;
-			break;
-		case COMPLEX:
-			cplx=(Complex*) obj->data;
-			for (i=0;i<size;i++)
-				sum+=CABS(cplx[i]);
-			break;
-		case SURFACE:
-			surf=(Surface*) obj->data;
-			for (i=0, size=surf->xsize*surf->ysize;i<size;i++)
-				sum+=surf->z[i];
-			break;
-		default:
-			return __NAN("");
-	}
-	return sum;
+	return __esweep_nonFinite_leave(&nf);
 }
 
@@ -25,6 +25,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/mman.h>
+#endif
 
 #include "esweep_priv.h"
 
@@ -127,19 +133,215 @@ int esweep_sparseSurface(esweep_object *obj, int xsize, int ysize) { /* TEST: OK
 	return ERR_OK;
 }
 
-esweep_object *esweep_free(esweep_object *a) { /* TEST: OK */
-	ESWEEP_ASSERT(a!=NULL, NULL);
+/*
+ * Registry of memory mapped files (see esweep_loadFilterExt()).
+ * The data of an object may point into a mapping; the mapping is released when the last of these
+ * objects is freed. Whoever replaces or frees obj->data must do it with __esweep_freeData().
+ */
+typedef struct __esweep_mapping {
+	char *base;
+	size_t length;
+	int refcount;
+	struct __esweep_mapping *next;
+} esweep_mapping;
+
+static esweep_mapping *mappings=NULL;
+static pthread_mutex_t mappings_lock=PTHREAD_MUTEX_INITIALIZER;
+
+__EXTERN_FUNC__ int __esweep_mapRegister(void *base, size_t length, int refcount) {
+	esweep_mapping *m;
+
+	ESWEEP_ASSERT(base != NULL && length > 0 && refcount > 0, ERR_BAD_ARGUMENT);
+	ESWEEP_MALLOC(m, 1, sizeof(esweep_mapping), ERR_MALLOC);
+	m->base=(char*) base;
+	m->length=length;
+	m->refcount=refcount;
+	pthread_mutex_lock(&mappings_lock);
+	m->next=mappings;
+	mappings=m;
+	pthread_mutex_unlock(&mappings_lock);
+	return ERR_OK;
+}
 
-	Surface *surface;
-	if (a->data!=NULL) {
-		if (a->type==SURFACE) {
-			surface=(Surface*) a->data;
-			free(surface->x);
-			free(surface->y);
-			free(surface->z);
+/* returns 1 if data belongs to a mapping, 0 otherwise */
+__EXTERN_FUNC__ int __esweep_mapRelease(void *data) {
+	esweep_mapping *m, *prev=NULL;
+	char *d=(char*) data;
+
+	pthread_mutex_lock(&mappings_lock);
+	for (m=mappings; m != NULL; prev=m, m=m->next) {
+		if (d >= m->base && d < m->base+m->length) {
+			if (--(m->refcount) == 0) {
+#ifndef _WIN32
+				munmap(m->base, m->length);
+#endif
+				if (prev == NULL) mappings=m->next;
+				else prev->next=m->next;
+				free(m);
+			}
+			pthread_mutex_unlock(&mappings_lock);
+			return 1;
 		}
-		free(a->data);
 	}
+	pthread_mutex_unlock(&mappings_lock);
+	return 0;
+}
+
+/* free(), but data which belongs to a mapping only releases it */
+__EXTERN_FUNC__ void __esweep_freeData(void *data) {
+	if (data != NULL && !__esweep_mapRelease(data)) free(data);
+}
+
+__EXTERN_FUNC__ void __esweep_freeObjectData(esweep_object *obj) {
+	Surface *surface;
+
+	if (obj->data == NULL) return;
+	if (obj->type == SURFACE) {
+		surface=(Surface*) obj->data;
+		free(surface->x);
+		free(surface->y);
+		free(surface->z);
+	}
+	__esweep_freeData(obj->data);
+	obj->data=NULL;
+}
+
+/*
+ * Dual representation of COMPLEX and POLAR data.
+ * Math operations which need the other representation of an object keep the conversion
+ * in obj->repr instead of converting obj->data in-place and back. The cache remembers a hash
+ * of obj->data; it is valid only if type, size and hash still match. This catches every write
+ * to obj->data, whether it happens in the library or through the pointer in user code.
+ * The hash costs a fraction of the hypot()/atan2() or cos()/sin() per sample it saves.
+ */
+typedef struct {
+	int type; /* of data, i. e. COMPLEX if obj->type == POLAR and vice versa */
+	int size;
+	u_int64_t hash;
+	void *data;
+} esweep_repr;
+
+#define REPR_MUL 0x9E3779B97F4A7C15ULL
+
+/* four interleaved multiply-xorshift lanes over the raw words */
+static u_int64_t repr_hash(const void *data, int size) {
+	const char *p=(const char*) data;
+	size_t i, n=(size_t) size*sizeof(Complex)/sizeof(u_int64_t);
+	u_int64_t h0=1, h1=2, h2=3, h3=4, w[4];
+
+	for (i=0; i+4 <= n; i+=4) {
+		memcpy(w, p+i*sizeof(u_int64_t), sizeof(w));
+		h0=(h0 ^ w[0])*REPR_MUL; h0^=h0 >> 29;
+		h1=(h1 ^ w[1])*REPR_MUL; h1^=h1 >> 29;
+		h2=(h2 ^ w[2])*REPR_MUL; h2^=h2 >> 29;
+		h3=(h3 ^ w[3])*REPR_MUL; h3^=h3 >> 29;
+	}
+	for (; i < n; i++) {
+		memcpy(w, p+i*sizeof(u_int64_t), sizeof(u_int64_t));
+		h0=(h0 ^ w[0])*REPR_MUL; h0^=h0 >> 29;
+	}
+	h0^=(h1*REPR_MUL) ^ (h2 >> 17) ^ (h3*REPR_MUL >> 31) ^ (u_int64_t) size;
+	h0^=h0 >> 33; h0*=0xFF51AFD7ED558CCDULL; h0^=h0 >> 33;
+	return h0;
+}
+
+static int repr_valid(const esweep_object *obj) {
+	const esweep_repr *r=(const esweep_repr*) obj->repr;
+
+	if (r == NULL || r->data == NULL || obj->data == NULL || obj->size <= 0) return 0;
+	if (obj->type != COMPLEX && obj->type != POLAR) return 0;
+	if (r->type == obj->type || r->size != obj->size) return 0;
+	return r->hash == repr_hash(obj->data, obj->size);
+}
+
+/* the cache with room for obj->size samples; the content is undefined */
+static esweep_repr *repr_alloc(esweep_object *obj) {
+	esweep_repr *r=(esweep_repr*) obj->repr;
+
+	if (r == NULL) {
+		ESWEEP_MALLOC(r, 1, sizeof(esweep_repr), NULL);
+		obj->repr=r;
+	}
+	if (r->data == NULL || r->size != obj->size) {
+		__esweep_freeData(r->data);
+		r->data=NULL;
+		r->size=0;
+		ESWEEP_MALLOC(r->data, obj->size, sizeof(Complex), NULL);
+		r->size=obj->size;
+	}
+	return r;
+}
+
+__EXTERN_FUNC__ Complex *__esweep_reprComplex(esweep_object *obj) {
+	esweep_repr *r;
+
+	if (obj->type == COMPLEX) return (Complex*) obj->data;
+	ESWEEP_ASSERT(obj->type == POLAR, NULL);
+	if (repr_valid(obj)) return (Complex*) ((esweep_repr*) obj->repr)->data;
+
+	if ((r=repr_alloc(obj)) == NULL) return NULL;
+	p2c((Complex*) r->data, (Polar*) obj->data, obj->size);
+	r->type=COMPLEX;
+	r->hash=repr_hash(obj->data, obj->size);
+	return (Complex*) r->data;
+}
+
+__EXTERN_FUNC__ Polar *__esweep_reprPolar(esweep_object *obj) {
+	esweep_repr *r;
+
+	if (obj->type == POLAR) return (Polar*) obj->data;
+	ESWEEP_ASSERT(obj->type == COMPLEX, NULL);
+	if (repr_valid(obj)) return (Polar*) ((esweep_repr*) obj->repr)->data;
+
+	if ((r=repr_alloc(obj)) == NULL) return NULL;
+	c2p((Polar*) r->data, (Complex*) obj->data, obj->size);
+	r->type=POLAR;
+	r->hash=repr_hash(obj->data, obj->size);
+	return (Polar*) r->data;
+}
+
+__EXTERN_FUNC__ void *__esweep_reprCached(const esweep_object *obj) {
+	return repr_valid(obj) ? ((esweep_repr*) obj->repr)->data : NULL;
+}
+
+__EXTERN_FUNC__ void __esweep_reprValidate(esweep_object *obj) {
+	esweep_repr *r=(esweep_repr*) obj->repr;
+
+	if (r == NULL || r->data == NULL || r->size != obj->size) return;
+	r->type=obj->type == COMPLEX ? POLAR : COMPLEX;
+	r->hash=repr_hash(obj->data, obj->size);
+}
+
+__EXTERN_FUNC__ int __esweep_reprSwap(esweep_object *obj) {
+	esweep_repr *r=(esweep_repr*) obj->repr;
+	void *data;
+	int type;
+
+	if (!repr_valid(obj)) return 0;
+	data=obj->data;
+	type=obj->type;
+	obj->data=r->data;
+	obj->type=r->type;
+	r->data=data;
+	r->type=type;
+	r->hash=repr_hash(obj->data, obj->size);
+	return 1;
+}
+
+__EXTERN_FUNC__ void __esweep_reprFree(esweep_object *obj) {
+	esweep_repr *r=(esweep_repr*) obj->repr;
+
+	if (r == NULL) return;
+	__esweep_freeData(r->data);
+	free(r);
+	obj->repr=NULL;
+}
+
+esweep_object *esweep_free(esweep_object *a) { /* TEST: OK */
+	ESWEEP_ASSERT(a!=NULL, NULL);
+
+	__esweep_freeObjectData(a);
+	__esweep_reprFree(a);
 	free(a);
 	return NULL;
 }
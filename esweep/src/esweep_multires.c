@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * src/esweep_multires.c:
+ * Multi resolution frequency response with frequency dependent gating
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esweep_priv.h"
+#include "fft.h"
+
+/*
+ * The impulse response is decimated by 2 per octave with a cascade of zero phase halfband filters. Level j has
+ * the samplerate sr/2^j, and the same gate of G samples is used on every level, so the gate halves with every
+ * octave up. Level j is the response at the frequency f_j=sr/(6*2^j), where the gate is "cycles" periods long,
+ * hence G=6*cycles. Between f_j+1 and f_j, the responses of both levels are crossfaded in log frequency.
+ *
+ * Level j is used up to f_j-1=sr_j/3. The halfband filters pass 0.175*sr_j-1 and stop above 0.325*sr_j-1,
+ * so the response of a level is free of aliasing up to 0.35*sr_j.
+ * The responses are evaluated exactly at the output frequencies with a direct DFT of the G gated samples,
+ * which is cheaper than FFTs of the short frames plus interpolation. Every level keeps MR_PRE samples before t=0,
+ * they hold the pre-ringing of the decimation filters and are not gated.
+ */
+
+#define MR_TAPS 23 /* one sided length of the halfband filter */
+#define MR_MAX_LEVELS 30
+#define MR_PRE ((MR_TAPS+1)/2) /* samples before t=0 on every level */
+
+/*
+ * zero phase halfband lowpass and decimation by 2
+ * Both signals start MR_PRE samples before t=0, to keep the pre-ringing of the filters
+ */
+static void __esweep_mrDecimate(Real *out, int out_size, const Real *in, int in_size, const Real *h) {
+	int n, k, m;
+	Real acc;
+
+	for (n=0; n < out_size; n++) {
+		/* the time of out[n] is n-MR_PRE, so the same as in[2*n-MR_PRE] */
+		m=2*n-MR_PRE;
+		acc=m >= 0 && m < in_size ? h[0]*in[m] : 0.0;
+		/* the even taps besides the center are 0 */
+		for (k=1; k <= MR_TAPS; k+=2) {
+			if (m-k >= 0 && m-k < in_size) acc+=h[k]*in[m-k];
+			if (m+k >= 0 && m+k < in_size) acc+=h[k]*in[m+k];
+		}
+		out[n]=acc;
+	}
+}
+
+/*
+ * DFT at the normalized angular frequency w of the MR_PRE samples before t=0 and the size gated samples after it
+ */
+static void __esweep_mrDFT(Complex *X, const Real *x, const Real *win, int size, Real w) {
+	Real c=cos(w), s=-sin(w), p_re=cos(w*MR_PRE), p_im=sin(w*MR_PRE), t, v;
+	int n;
+
+	X->real=X->imag=0.0;
+	for (n=0; n < MR_PRE+size; n++) {
+		v=n < MR_PRE ? x[n] : win[n-MR_PRE]*x[n];
+		X->real+=v*p_re;
+		X->imag+=v*p_im;
+		t=p_re*c-p_im*s;
+		p_im=p_re*s+p_im*c;
+		p_re=t;
+	}
+}
+
+int esweep_multiResolution(esweep_object *out, const esweep_object *ir, Real cycles, Real f1, Real f2, int points, Real *freq) {
+	Real *level[MR_MAX_LEVELS], *win, h[MR_TAPS+1];
+	int size[MR_MAX_LEVELS];
+	Polar *polar;
+	Complex H, H2;
+	Real f, f0, p, frac, norm;
+	int i, j, k, G, levels, ret=ERR_OK;
+
+	ESWEEP_OBJ_NOTEMPTY(ir, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(ir->type == WAVE, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_ASSERT(out != NULL, ERR_OBJ_IS_NULL);
+	ESWEEP_ASSERT(cycles >= 1.0, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(f1 > 0.0 && f1 < f2 && f2 <= ir->samplerate/2.0, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(points >= 2, ERR_BAD_ARGUMENT);
+
+	G=(int) (6.0*cycles+0.5);
+	f0=ir->samplerate/6.0;
+
+	/* blackman windowed halfband sinc */
+	for (norm=h[0]=0.5, k=1; k <= MR_TAPS; k++) {
+		h[k]=k % 2 ? sin(M_PI*k/2)/(M_PI*k)*(0.42+0.5*cos(M_PI*k/(MR_TAPS+1))+0.08*cos(2*M_PI*k/(MR_TAPS+1))) : 0.0;
+		norm+=2*h[k];
+	}
+	for (k=0; k <= MR_TAPS; k++) h[k]/=norm;
+
+	/* gate: flat for the first half, then the right half of a Hann window */
+	ESWEEP_MALLOC(win, G, sizeof(Real), ERR_MALLOC);
+	for (i=0; i < G; i++) win[i]=1.0;
+	window(win, G/2, G, WIN_RIGHT, WIN_HANN);
+
+	/*
+	 * go down until the frequency of the level is below f1,
+	 * or until the whole response fits into the flat part of the gate
+	 */
+	levels=0;
+	size[0]=ir->size;
+	if ((level[0]=(Real*) calloc(MR_PRE+size[0], sizeof(Real))) == NULL) {
+		ret=ERR_MALLOC;
+		goto error;
+	}
+	memcpy(level[0]+MR_PRE, ir->data, size[0]*sizeof(Real));
+	for (levels=1; levels < MR_MAX_LEVELS && f0/(1 << (levels-1)) > f1 && size[levels-1] > G/2; levels++) {
+		size[levels]=(size[levels-1]+1)/2;
+		if ((level[levels]=(Real*) malloc((MR_PRE+size[levels])*sizeof(Real))) == NULL) {
+			ret=ERR_MALLOC;
+			goto error;
+		}
+		__esweep_mrDecimate(level[levels], MR_PRE+size[levels], level[levels-1], MR_PRE+size[levels-1], h);
+	}
+
+	if (out->type != POLAR || out->size != points || out->data == NULL) {
+		__esweep_freeData(out->data);
+		out->data=NULL;
+		out->type=POLAR;
+		out->size=points;
+		if ((out->data=calloc(points, sizeof(Polar))) == NULL) {
+			ret=ERR_MALLOC;
+			goto error;
+		}
+	}
+	out->samplerate=ir->samplerate;
+	polar=(Polar*) out->data;
+
+	for (i=0; i < points; i++) {
+		f=f1*pow(f2/f1, (Real) i/(points-1));
+		if (freq != NULL) freq[i]=f;
+		/* the level j and the weight frac of the next level */
+		p=log2(f0/f);
+		if (p <= 0.0) {
+			j=0;
+			frac=0.0;
+		} else {
+			j=(int) p;
+			frac=p-j;
+		}
+		if (j >= levels-1) {
+			j=levels-1;
+			frac=0.0;
+		}
+		/* the DFT of the decimated signal is 2^j times smaller */
+		__esweep_mrDFT(&H, level[j], win, G < size[j] ? G : size[j], 2*M_PI*f*(1 << j)/ir->samplerate);
+		H.real*=1 << j;
+		H.imag*=1 << j;
+		if (frac > 0.0) {
+			__esweep_mrDFT(&H2, level[j+1], win, G < size[j+1] ? G : size[j+1], 2*M_PI*f*(1 << (j+1))/ir->samplerate);
+			H.real+=frac*((1 << (j+1))*H2.real-H.real);
+			H.imag+=frac*((1 << (j+1))*H2.imag-H.imag);
+		}
+		polar[i].abs=sqrt(H.real*H.real+H.imag*H.imag);
+		polar[i].arg=atan2(H.imag, H.real);
+	}
+
+error:
+	for (j=0; j < levels; j++) free(level[j]);
+	free(win);
+	return ret;
+}
@@ -26,6 +26,7 @@
 #include <fenv.h>
 #include <float.h>
 #include <math.h>
+#include <stddef.h>
 
 /* Errors */
 #define ERR_OK			0
@@ -375,6 +376,8 @@ typedef struct __esweep_object {
 	int size;
 	/* The raw data, my be NULL, but not for surface. Then a struct surface is allocated.  */
 	void *data;
+	/* COMPLEX and POLAR: cached data in the other representation, may be NULL, see esweep_mem.c */
+	void *repr;
 } esweep_object;
 
 typedef	int (*audio_query_ptr)(const void*, const char*, int*);
@@ -455,6 +458,70 @@ typedef struct __esweep_audio {
 	audio_close_ptr audio_close;
 } esweep_audio;
 
+/* delay line, opaque */
+typedef struct __esweep_delayLine esweep_delayLine;
+
+/* polyphase filter bank, opaque */
+typedef struct __esweep_filterBank esweep_filterBank;
+
+/* averaged spectrum, opaque */
+typedef struct __esweep_spectrum esweep_spectrum;
+
+/* dual channel transfer function estimator, opaque */
+typedef struct __esweep_transfer esweep_transfer;
+
+/* short time fourier transform, opaque */
+typedef struct __esweep_stftEngine esweep_stftEngine;
+
+/* constant Q transform, opaque */
+typedef struct __esweep_cqt esweep_cqt;
+
+/* sound level logger, opaque */
+typedef struct __esweep_levelLogger esweep_levelLogger;
+
+/* room acoustic parameters of one band, NAN if not available */
+typedef struct {
+	Real fc; /* band center frequency, 0 for broadband */
+	Real onset; /* s */
+	Real edt; /* s */
+	Real t20; /* s */
+	Real t30; /* s */
+	Real c50; /* dB */
+	Real c80; /* dB */
+	Real d50;
+	Real ts; /* s */
+	Real noise; /* dB re peak */
+	Real crosspoint; /* s, from the onset */
+} esweep_roomParams;
+
+/* a peak found by esweep_peakFind() */
+typedef struct {
+	int index; /* sample or bin */
+	Real position; /* interpolated index */
+	Real x; /* interpolated time in s (WAVE) or frequency in Hz */
+	Real level; /* interpolated value */
+	Real prominence; /* height above the higher of the two bases */
+} esweep_peak;
+
+/* levels of one interval of the sound level logger, in dB */
+typedef struct {
+	Real time; /* s since the last reset, end of the interval */
+	Real leq; /* equivalent continuous level */
+	Real lmax, lmin; /* maximum and minimum of the time weighted level */
+	Real l10, l50, l90; /* time weighted level exceeded 10, 50 and 90 % of the time */
+	Real lpeak; /* peak level of the frequency weighted signal */
+} esweep_levelRecord;
+
+/* result of esweep_stats(), of the magnitudes for COMPLEX and POLAR objects */
+typedef struct {
+	int n; /* number of values */
+	Real sum, sqsum;
+	Real mean, rms;
+	Real min, max; /* NaN are ignored */
+	int argmin, argmax; /* index of the first minimum/maximum */
+	Real crest; /* peak/rms, 0 if rms is 0 */
+} esweep_statistics;
+
 typedef struct __Complex {
 	Real real;
 	Real imag;
@@ -499,20 +566,101 @@ __EXTERN_FUNC__ void c2p(Polar *output, Complex *input, int input_size); /* Comp
 /* And some conversion macros */
 #define ESWEEP_CONV_WAVE2COMPLEX(obj, cpx) 	ESWEEP_MALLOC(cpx, obj->size, sizeof(Complex), ERR_MALLOC); \
 						r2c(cpx, (Wave*) obj->data, obj->size); \
-					 	free(obj->data); \
+					 	__esweep_freeData(obj->data); \
 						obj->type=COMPLEX; \
 						obj->data=cpx;
 
 #define ESWEEP_CONV_WAVE2POLAR(obj, polar) 	ESWEEP_MALLOC(polar, obj->size, sizeof(Polar), ERR_MALLOC); \
 						r2p(polar, (Wave*) obj->data, obj->size); \
-					 	free(obj->data); \
+					 	__esweep_freeData(obj->data); \
 						obj->type=POLAR; \
 						obj->data=polar;
 
+/*
+ * Objects with memory mapped data, see esweep_mem.c
+ * Register a mapping of length bytes at base, which is shared by refcount objects.
+ * esweep_free() releases the mapping when the last object is freed.
+ * Code which replaces obj->data must release the old data with __esweep_freeData(), never with free().
+ */
+__EXTERN_FUNC__ int __esweep_mapRegister(void *base, size_t length, int refcount);
+__EXTERN_FUNC__ int __esweep_mapRelease(void *data);
+__EXTERN_FUNC__ void __esweep_freeData(void *data);
+/* releases obj->data including the arrays of a surface, obj->data is NULL afterwards */
+__EXTERN_FUNC__ void __esweep_freeObjectData(esweep_object *obj);
+
+/*
+ * Dual representation of COMPLEX and POLAR objects, see esweep_mem.c
+ * obj->data is always valid, obj->repr caches the same data in the other representation.
+ * The cache is valid as long as obj->data is unchanged, every write invalidates it.
+ *
+ * __esweep_reprComplex()/__esweep_reprPolar(): obj->data if obj has this type,
+ * otherwise the cached conversion, which is computed when it is not valid. NULL on error.
+ * __esweep_reprCached(): the cached conversion if it is valid, NULL otherwise.
+ * __esweep_reprValidate(): the caller has written obj->data from the cached representation,
+ * which is now valid again.
+ * __esweep_reprSwap(): exchange data and cache, i. e. convert obj to the other representation,
+ * when the cache is valid. Returns 1 on success, 0 if the cache is not valid.
+ */
+__EXTERN_FUNC__ Complex *__esweep_reprComplex(esweep_object *obj);
+__EXTERN_FUNC__ Polar *__esweep_reprPolar(esweep_object *obj);
+__EXTERN_FUNC__ void *__esweep_reprCached(const esweep_object *obj);
+__EXTERN_FUNC__ void __esweep_reprValidate(esweep_object *obj);
+__EXTERN_FUNC__ int __esweep_reprSwap(esweep_object *obj);
+__EXTERN_FUNC__ void __esweep_reprFree(esweep_object *obj);
+
 /* Math macros */
 
-/* test for and correct floating point exceptions */
-__EXTERN_FUNC__ int correctFpException(esweep_object* obj);
+/*
+ * Non-finite results of the math functions, see esweep_setNonFinite() and esweep_fp.c
+ * Each function takes a snapshot of the policy on entry with __esweep_nonFinite_enter(),
+ * checks its results while they are still in the cache, and __esweep_nonFinite_leave()
+ * adds the counts to the global counters and returns ERR_OK or ERR_FP.
+ */
+#define ESWEEP_NONFINITE_CLAMP 0
+#define ESWEEP_NONFINITE_PROPAGATE 1
+#define ESWEEP_NONFINITE_ERROR 2
+
+typedef struct {
+	int policy;
+	long inf; /* infinite results */
+	long nan; /* NaN results */
+	long clamped; /* infinite results replaced by the largest finite number */
+} esweep_nonFinite;
+
+__EXTERN_FUNC__ void __esweep_nonFinite_enter(esweep_nonFinite *nf);
+__EXTERN_FUNC__ int __esweep_nonFinite_leave(esweep_nonFinite *nf);
+/* count x, which is not finite, and return the value according to the policy */
+__EXTERN_FUNC__ Real __esweep_nonFinite_fix(esweep_nonFinite *nf, Real x);
+/* check and fix n Reals */
+__EXTERN_FUNC__ void __esweep_nonFinite_scan(esweep_nonFinite *nf, Real *data, int n);
+
+/* check and fix a single result in scalar loops; x must be an lvalue */
+#define ESWEEP_NONFINITE(nf, x) do { if (!isfinite(x)) (x)=__esweep_nonFinite_fix(&(nf), (x)); } while (0)
+
+/*
+ * Reduction over the n values starting at from (of z for a SURFACE), see esweep_stats.c
+ * threads <= 0 selects the number of threads by n
+ */
+__EXTERN_FUNC__ int __esweep_stats(const esweep_object *obj, int from, int n, int threads, esweep_statistics *stats);
+
+/*
+ * Denormal policy, see esweep_setDenormals()
+ * ESWEEP_DENORMAL_FTZ: flush denormals to zero (FTZ/DAZ) inside the kernels
+ * ESWEEP_DENORMAL_DC: inject a tiny DC offset into the state of recursive filters
+ */
+#define ESWEEP_DENORMAL_FTZ 0x01
+#define ESWEEP_DENORMAL_DC 0x02
+
+/* about -400 dB, far below the resolution of any signal, but a normal number in single precision */
+#define ESWEEP_DENORMAL_DC_OFFSET 1e-20
+
+__EXTERN_FUNC__ unsigned int __esweep_denormal_enter(void);
+__EXTERN_FUNC__ void __esweep_denormal_leave(unsigned int csr);
+__EXTERN_FUNC__ Real __esweep_denormal_dc(void);
+
+/* wrap hot kernels with these; csr is an unsigned int which holds the FP state of the caller */
+#define ESWEEP_DENORMAL_ENTER(csr) csr=__esweep_denormal_enter();
+#define ESWEEP_DENORMAL_LEAVE(csr) __esweep_denormal_leave(csr);
 
 /*
  * Math function definitions for single or double FP arithmetic
@@ -578,7 +726,7 @@ __EXTERN_FUNC__ int correctFpException(esweep_object* obj);
 /* multiply complex number a with complex number b; result is in a; needs a temporary real storage */
 #define ESWEEP_MATH_CC_MUL(a, b) tmp=a.real * b.real - a.imag * b.imag; a.imag=a.imag * b.real + a.real * b.imag; a.real=tmp;
 /* divide complex number a by complex number b; result is complex and in out; needs two temporary real storages (denom, tmp)*/
-#define ESWEEP_MATH_CC_DIV(a, b) denom=b.real * b.real - b.imag * b.imag; \
+#define ESWEEP_MATH_CC_DIV(a, b) denom=b.real * b.real + b.imag * b.imag; \
 						tmp=(a.real * b.real + a.imag * b.imag) / denom; \
 						a.imag=(a.imag * b.real - a.real * b.imag) / denom; \
 						a.real=tmp;
@@ -0,0 +1,365 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * src/esweep_room.c:
+ * Room acoustic parameters from impulse responses (ISO 3382)
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esweep_priv.h"
+#include "esweep.h"
+
+/*
+ * Each band is processed independently:
+ * 1. octave band filtering of the time-reversed IR (reduces the influence of the filter decay)
+ * 2. squaring, starting at the onset of the broadband IR (first sample 20 dB below the peak)
+ * 3. noise floor and truncation point after Lundeby et al. (1995): the decay and the background noise are
+ *    estimated alternately from block averages of the squared IR, until the crosspoint of the decay
+ *    and the noise converges
+ * 4. Schroeder backward integration up to the crosspoint, plus the energy of the
+ *    fitted decay beyond it
+ * 5. decay times by linear regression on the decay curve, energy ratios from the same curve
+ */
+
+#define ROOM_ONSET_DB -20.0 /* onset threshold re peak */
+#define ROOM_BLOCK_TIME 0.01 /* initial block length of the Lundeby iteration */
+#define ROOM_BLOCKS_PER_10DB 5 /* block length of the following iterations */
+#define ROOM_ITERATIONS 5
+#define ROOM_NA __NAN("") /* any finite value may be a valid result in dB */
+
+typedef struct {
+	/* input */
+	const Real *ir;
+	int size;
+	int samplerate;
+	int onset;
+	/* next band to process, shared by the threads */
+	int next;
+	int n_bands;
+	esweep_roomParams *params;
+	pthread_mutex_t lock;
+} room_job;
+
+/* least squares fit of level[k] (dB) over time k*dt+t0, returns the slope in dB/s */
+static int regression(const double *level, int first, int last, double dt, double t0, double *slope, double *icpt) {
+	double sx=0.0, sy=0.0, sxx=0.0, sxy=0.0, x, n;
+	int k;
+
+	if (last-first < 1) return 0;
+	for (k=first; k <= last; k++) {
+		x=t0+k*dt;
+		sx+=x;
+		sy+=level[k];
+		sxx+=x*x;
+		sxy+=x*level[k];
+	}
+	n=last-first+1;
+	if (n*sxx-sx*sx <= 0.0) return 0;
+	*slope=(n*sxy-sx*sy)/(n*sxx-sx*sx);
+	*icpt=(sy-*slope*sx)/n;
+	return 1;
+}
+
+/* block averages of e in dB, block k is centered at (k+0.5)*block samples */
+static int block_levels(const double *e, int n, int block, double *level) {
+	int k, i, blocks=n/block;
+	double sum;
+
+	for (k=0; k < blocks; k++) {
+		for (sum=0.0, i=k*block; i < (k+1)*block; i++) sum+=e[i];
+		level[k]=10*log10(sum/block+1e-300);
+	}
+	return blocks;
+}
+
+static double mean_level(const double *e, int from, int to) {
+	double sum=0.0;
+	int i;
+	if (to <= from) return -300.0;
+	for (i=from; i < to; i++) sum+=e[i];
+	return 10*log10(sum/(to-from)+1e-300);
+}
+
+/*
+ * Lundeby iteration; returns the crosspoint in samples, the noise level and the fitted late decay
+ * (level in dB of the energy per sample at time t is icpt+slope*t)
+ */
+static int lundeby(const double *e, int n, int samplerate, double *noise, double *slope, double *icpt) {
+	double *level;
+	double fs=samplerate, m, a, tc, tc_old;
+	int block, blocks, k, first, last, i, cross, peak;
+
+	ESWEEP_MALLOC(level, n, sizeof(double), -1);
+
+	/* 1. block averages, 2. noise from the last 10 % */
+	block=(int) (ROOM_BLOCK_TIME*fs) > 0 ? (int) (ROOM_BLOCK_TIME*fs) : 1;
+	blocks=block_levels(e, n, block, level);
+	*noise=mean_level(e, n-n/10, n);
+
+	/* 3. regression from the peak down to 10 dB above the noise */
+	for (first=0, k=1; k < blocks; k++) if (level[k] > level[first]) first=k;
+	for (last=first; last+1 < blocks && level[last+1] > *noise+10.0; last++);
+	if (!regression(level, first, last, block/fs, 0.5*block/fs, &m, &a) || m >= 0.0) {
+		free(level);
+		*slope=0.0;
+		return n;
+	}
+	/* 4. preliminary crosspoint */
+	tc=(*noise-a)/m;
+
+	for (i=0; i < ROOM_ITERATIONS; i++) {
+		/* 5. new block length, some blocks per 10 dB of decay */
+		block=(int) (-10.0/m/ROOM_BLOCKS_PER_10DB*fs);
+		block=block < 1 ? 1 : block > n/4 ? n/4 : block;
+		if (block < 1) break;
+		blocks=block_levels(e, n, block, level);
+
+		/* 6. noise from 10 dB below the crosspoint on, at least the last 10 % */
+		cross=(int) ((tc-10.0/m)*fs);
+		*noise=mean_level(e, cross < n-n/10 && cross > 0 ? cross : n-n/10, n);
+
+		/* 7. late decay, from 25 dB to 5 dB above the noise; if the peak is lower, from the peak on */
+		for (peak=0, k=1; k < blocks; k++) if (level[k] > level[peak]) peak=k;
+		for (first=peak; first < blocks && level[first] > *noise+25.0; first++);
+		if (first == blocks) first=peak;
+		for (last=first; last+1 < blocks && level[last+1] > *noise+5.0; last++);
+		if (!regression(level, first, last, block/fs, 0.5*block/fs, &m, &a) || m >= 0.0) break;
+		*slope=m;
+		*icpt=a;
+
+		/* 8. new crosspoint */
+		tc_old=tc;
+		tc=(*noise-a)/m;
+		if (fabs(tc-tc_old) < block/fs) break;
+	}
+	*slope=m;
+	*icpt=a;
+
+	free(level);
+	cross=(int) (tc*fs);
+	return cross < 1 ? 1 : cross > n ? n : cross;
+}
+
+/* decay time for 60 dB from a regression of the decay curve between l1 and l2 (dB) */
+static Real decay_time(const double *edc, int n, int samplerate, double l1, double l2) {
+	double sx=0.0, sy=0.0, sxx=0.0, sxy=0.0, x, cnt=0.0, m;
+	int i;
+
+	if (edc[n-1] > l2) return ROOM_NA; /* the decay curve does not reach l2 */
+	for (i=0; i < n && edc[i] > l2; i++) {
+		if (edc[i] > l1) continue;
+		x=(double) i/samplerate;
+		sx+=x;
+		sy+=edc[i];
+		sxx+=x*x;
+		sxy+=x*edc[i];
+		cnt+=1.0;
+	}
+	if (cnt < 2 || cnt*sxx-sx*sx <= 0.0) return ROOM_NA;
+	m=(cnt*sxy-sx*sy)/(cnt*sxx-sx*sx);
+	return m < 0.0 ? -60.0/m : ROOM_NA;
+}
+
+static int __esweep_roomBand(room_job *job, esweep_roomParams *par) {
+	esweep_object *obj, **filter=NULL, **f;
+	Wave *wave, t;
+	double *e, *edc;
+	double fs=job->samplerate, noise=0.0, slope=0.0, icpt=0.0, k, tail=0.0, tail_t=0.0, sum, c, s, tc;
+	double early, e50, e80, total, ts;
+	int i, n, cross, i50, i80;
+	Real fl, fu;
+
+	/* copy and filter the IR */
+	ESWEEP_MALLOC(obj, 1, sizeof(esweep_object), ERR_MALLOC);
+	obj->type=WAVE;
+	obj->samplerate=job->samplerate;
+	obj->size=job->size;
+	ESWEEP_MALLOC(obj->data, job->size, sizeof(Wave), ERR_MALLOC);
+	wave=(Wave*) obj->data;
+	memcpy(wave, job->ir, job->size*sizeof(Wave));
+
+	if (par->fc > 0.0) {
+		/* 6th order bandpass, 3rd order Butterworth high- and lowpass at the band edges */
+		fl=par->fc/M_SQRT2;
+		fu=par->fc*M_SQRT2;
+		filter=esweep_createFilterFromCoeff("highpass", 1.0, 1.0, fl, 0, 0, job->samplerate);
+		f=esweep_createFilterFromCoeff("differentiator", 1.0, 0, fl, 0, 0, job->samplerate);
+		if (filter != NULL && f != NULL) esweep_appendFilter(filter, f);
+		if (f != NULL) esweep_freeFilter(f);
+		if (fu < 0.45*job->samplerate) {
+			f=esweep_createFilterFromCoeff("lowpass", 1.0, 1.0, fu, 0, 0, job->samplerate);
+			if (filter != NULL && f != NULL) esweep_appendFilter(filter, f);
+			if (f != NULL) esweep_freeFilter(f);
+			f=esweep_createFilterFromCoeff("integrator", 1.0, 0, fu, 0, 0, job->samplerate);
+			if (filter != NULL && f != NULL) esweep_appendFilter(filter, f);
+			if (f != NULL) esweep_freeFilter(f);
+		}
+		if (filter == NULL) {
+			esweep_free(obj);
+			return ERR_UNKNOWN;
+		}
+		/* time-reversed filtering */
+		for (i=0; i < obj->size/2; i++) {
+			t=wave[i]; wave[i]=wave[obj->size-1-i]; wave[obj->size-1-i]=t;
+		}
+		esweep_filter(obj, filter);
+		for (i=0; i < obj->size/2; i++) {
+			t=wave[i]; wave[i]=wave[obj->size-1-i]; wave[obj->size-1-i]=t;
+		}
+		esweep_freeFilter(filter);
+	}
+
+	/* squared IR from the onset */
+	n=job->size-job->onset;
+	ESWEEP_MALLOC(e, n, sizeof(double), ERR_MALLOC);
+	ESWEEP_MALLOC(edc, n, sizeof(double), ERR_MALLOC);
+	for (i=0; i < n; i++) e[i]=(double) wave[job->onset+i]*wave[job->onset+i];
+	esweep_free(obj);
+
+	cross=lundeby(e, n, job->samplerate, &noise, &slope, &icpt);
+	if (cross < 0) {
+		free(e);
+		free(edc);
+		return ERR_MALLOC;
+	}
+
+	/* energy of the fitted decay beyond the crosspoint, and its first moment for Ts */
+	if (slope < 0.0 && cross < n) {
+		k=-slope*M_LN10/10.0; /* decay constant of the energy, 1/s */
+		tc=cross/fs;
+		tail=pow(10.0, (icpt+slope*tc)/10.0)*fs/k;
+		tail_t=tail*(tc+1.0/k);
+	}
+
+	/* Schroeder integral with Neumaier summation */
+	for (sum=tail, c=0.0, i=cross-1; i >= 0; i--) {
+		s=sum+e[i];
+		if (fabs(sum) >= e[i]) c+=(sum-s)+e[i];
+		else c+=(e[i]-s)+sum;
+		sum=s;
+		edc[i]=sum+c;
+	}
+	total=edc[0];
+	for (ts=tail_t, i=0; i < cross; i++) ts+=e[i]*i/fs;
+
+	/* noise relative to the peak of the band */
+	for (s=0.0, i=0; i < n; i++) if (e[i] > s) s=e[i];
+	par->noise=s > 0.0 ? noise-10*log10(s) : ROOM_NA;
+	par->crosspoint=cross/fs;
+	if (total <= 0.0 || cross < 2) {
+		/* the remaining parameters stay NAN */
+		free(e);
+		free(edc);
+		return ERR_OK;
+	}
+	/* energy ratios */
+	i50=(int) (0.05*fs+0.5);
+	i80=(int) (0.08*fs+0.5);
+	e50=i50 < cross ? edc[i50] : tail*pow(10.0, slope*(i50-cross)/fs/10.0);
+	e80=i80 < cross ? edc[i80] : tail*pow(10.0, slope*(i80-cross)/fs/10.0);
+	early=total-e50;
+	par->d50=early/total;
+	par->c50=e50 > 0.0 ? 10*log10(early/e50) : ROOM_NA;
+	par->c80=e80 > 0.0 ? 10*log10((total-e80)/e80) : ROOM_NA;
+	par->ts=ts/total;
+
+	/* decay times */
+	for (i=0; i < cross; i++) edc[i]=10*log10(edc[i]/total+1e-300);
+	par->edt=decay_time(edc, cross, job->samplerate, 0.0, -10.0);
+	par->t20=decay_time(edc, cross, job->samplerate, -5.0, -25.0);
+	par->t30=decay_time(edc, cross, job->samplerate, -5.0, -35.0);
+
+	free(e);
+	free(edc);
+	return ERR_OK;
+}
+
+static void *__esweep_roomWorker(void *arg) {
+	room_job *job=(room_job*) arg;
+	int band;
+
+	for (;;) {
+		pthread_mutex_lock(&job->lock);
+		band=job->next++;
+		pthread_mutex_unlock(&job->lock);
+		if (band >= job->n_bands) break;
+		__esweep_roomBand(job, &job->params[band]);
+	}
+	return NULL;
+}
+
+int esweep_roomAcoustics(esweep_object *ir, const Real *fc, int n_bands, int threads, esweep_roomParams *params) {
+	room_job job;
+	pthread_t *tid;
+	Wave *wave;
+	Real peak;
+	int i;
+
+	ESWEEP_OBJ_NOTEMPTY(ir, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(ir->type == WAVE, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_ASSERT(fc != NULL && params != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(n_bands > 0, ERR_BAD_ARGUMENT);
+	for (i=0; i < n_bands; i++) ESWEEP_ASSERT(fc[i] < 0.45*ir->samplerate*M_SQRT2, ERR_BAD_ARGUMENT);
+
+	/* onset of the broadband IR */
+	wave=(Wave*) ir->data;
+	for (peak=0.0, i=0; i < ir->size; i++) if (wave[i]*wave[i] > peak) peak=wave[i]*wave[i];
+	ESWEEP_ASSERT(peak > 0.0, ERR_BAD_ARGUMENT);
+	for (i=0; wave[i]*wave[i] < peak*pow(10.0, ROOM_ONSET_DB/10.0); i++);
+
+	job.ir=wave;
+	job.size=ir->size;
+	job.samplerate=ir->samplerate;
+	job.onset=i;
+	job.next=0;
+	job.n_bands=n_bands;
+	job.params=params;
+	/* a band whose analysis fails keeps NAN in every parameter */
+	for (i=0; i < n_bands; i++) {
+		params[i].fc=fc[i];
+		params[i].onset=(Real) job.onset/ir->samplerate;
+		params[i].edt=params[i].t20=params[i].t30=ROOM_NA;
+		params[i].c50=params[i].c80=params[i].d50=params[i].ts=ROOM_NA;
+		params[i].noise=params[i].crosspoint=ROOM_NA;
+	}
+
+	if (threads <= 0 || threads > n_bands) threads=n_bands;
+	/* the worker locks the job, even without other threads */
+	pthread_mutex_init(&job.lock, NULL);
+	if (threads == 1) {
+		__esweep_roomWorker(&job);
+	} else {
+		tid=(pthread_t*) calloc(threads, sizeof(pthread_t));
+		if (tid == NULL) threads=0;
+		for (i=0; i < threads; i++) {
+			if (pthread_create(&tid[i], NULL, __esweep_roomWorker, &job) != 0) break;
+		}
+		/* if not all threads could be created, this thread takes part */
+		if (i < threads || threads == 0) __esweep_roomWorker(&job);
+		threads=i;
+		for (i=0; i < threads; i++) pthread_join(tid[i], NULL);
+		free(tid);
+	}
+	pthread_mutex_destroy(&job.lock);
+
+	return ERR_OK;
+}
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * src/esweep_spectrum.c:
+ * Streaming averaged spectrum (Welch) for real time analyzers
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esweep_priv.h"
+#include "fft.h"
+
+/*
+ * The input is collected in a buffer of one FFT length N. Whenever it is full, the buffer is windowed
+ * and transformed, and the buffer is shifted by the hop N*(1-overlap). The averages are kept
+ * as power spectra |X[k]|^2 of the bins 0..N/2, so reading them out never needs to touch the input.
+ * The real FFT packs the even samples into the real part and the odd samples into the imaginary part
+ * of a complex FFT of size N/2, see fft_real().
+ */
+
+#define SPECTRUM_LINEAR 0
+#define SPECTRUM_EXPONENTIAL 1
+#define SPECTRUM_PEAK 2
+
+struct __esweep_spectrum {
+	int samplerate;
+	int size; /* N, power of 2 */
+	int hop;
+	int bins; /* N/2+1 */
+	int average;
+	Real alpha; /* weight of a new frame with exponential averaging */
+	Real *win;
+	double win_sum; /* coherent gain */
+	double win_pow; /* sum of w^2, for the PSD */
+	Real *hist; /* input buffer */
+	int fill;
+	int frames; /* frames since the last reset */
+	double *power; /* averaged |X[k]|^2 */
+	Complex *buf;
+	Complex *X;
+	Complex *twiddle;
+	Complex *table;
+};
+
+static void __esweep_spectrumFrame(esweep_spectrum *spec) {
+	Complex *Z=spec->buf, *X=spec->X;
+	Real *w=spec->win, *h=spec->hist;
+	double p, q;
+	int k, half=spec->size/2;
+
+	for (k=0; k < half; k++) {
+		Z[k].real=w[2*k]*h[2*k];
+		Z[k].imag=w[2*k+1]*h[2*k+1];
+	}
+	fft_real(X, Z, spec->table, spec->twiddle, spec->size);
+
+	spec->frames++;
+	q=1.0/spec->frames;
+	for (k=0; k < spec->bins; k++) {
+		p=X[k].real*X[k].real+X[k].imag*X[k].imag;
+
+		switch (spec->average) {
+			case SPECTRUM_EXPONENTIAL:
+				if (spec->frames > 1) {
+					spec->power[k]+=spec->alpha*(p-spec->power[k]);
+					break;
+				}
+				/* FALLTHROUGH, the first frame initializes the average */
+			case SPECTRUM_LINEAR:
+				spec->power[k]+=q*(p-spec->power[k]);
+				break;
+			case SPECTRUM_PEAK:
+				if (p > spec->power[k]) spec->power[k]=p;
+				break;
+		}
+	}
+}
+
+esweep_spectrum *esweep_spectrumCreate(int samplerate, int size, Real overlap, const char *win_name, const char *average, Real tau) {
+	esweep_spectrum *spec;
+	int i, win_type=WIN_HANN, avg_type=SPECTRUM_LINEAR;
+	Real win_param=0.0;
+
+	ESWEEP_ASSERT(samplerate > 0, NULL);
+	ESWEEP_ASSERT(size >= 4 && size <= ESWEEP_MAX_SIZE && (size & (size-1)) == 0, NULL);
+	ESWEEP_ASSERT(overlap >= 0.0 && overlap < 100.0, NULL);
+
+	if (win_name != NULL) {
+		win_type=window_parse(win_name, &win_param);
+		ESWEEP_ASSERT(win_type != WIN_NOWIN, NULL);
+	}
+	if (average != NULL) {
+		avg_type=-1;
+		if (strcmp("linear", average)==0) avg_type=SPECTRUM_LINEAR;
+		if (strcmp("exponential", average)==0) avg_type=SPECTRUM_EXPONENTIAL;
+		if (strcmp("peak", average)==0) avg_type=SPECTRUM_PEAK;
+		ESWEEP_ASSERT(avg_type >= 0, NULL);
+	}
+	ESWEEP_ASSERT(avg_type != SPECTRUM_EXPONENTIAL || tau > 0.0, NULL);
+
+	ESWEEP_MALLOC(spec, 1, sizeof(esweep_spectrum), NULL);
+	spec->average=avg_type;
+	spec->samplerate=samplerate;
+	spec->size=size;
+	spec->hop=(int) (size*(1.0-overlap/100.0)+0.5);
+	if (spec->hop < 1) spec->hop=1;
+	spec->bins=size/2+1;
+	/* time constant tau for the hop as sample interval */
+	spec->alpha=spec->average == SPECTRUM_EXPONENTIAL ? 1.0-exp(-spec->hop/(tau*samplerate)) : 0.0;
+
+	ESWEEP_MALLOC(spec->win, size, sizeof(Real), NULL);
+	ESWEEP_MALLOC(spec->hist, size, sizeof(Real), NULL);
+	ESWEEP_MALLOC(spec->power, spec->bins, sizeof(double), NULL);
+	ESWEEP_MALLOC(spec->buf, size/2, sizeof(Complex), NULL);
+	ESWEEP_MALLOC(spec->X, size/2+1, sizeof(Complex), NULL);
+	ESWEEP_ASSERT((spec->twiddle=fft_create_real_table(size)) != NULL, NULL);
+	ESWEEP_ASSERT((spec->table=fft_create_table(size/2)) != NULL, NULL);
+
+	/* the same symmetric windows as esweep_window() with 50 % left and right */
+	for (i=0; i < size; i++) spec->win[i]=1.0;
+	window_ext(spec->win, 0, size/2, WIN_LEFT, win_type, win_param);
+	window_ext(spec->win, size/2, size, WIN_RIGHT, win_type, win_param);
+	for (spec->win_sum=spec->win_pow=0.0, i=0; i < size; i++) {
+		spec->win_sum+=spec->win[i];
+		spec->win_pow+=spec->win[i]*spec->win[i];
+	}
+	esweep_spectrumReset(spec);
+	return spec;
+}
+
+int esweep_spectrumInfo(const esweep_spectrum *spec, int *size, int *hop, int *frames) {
+	ESWEEP_ASSERT(spec != NULL, ERR_BAD_ARGUMENT);
+	if (size != NULL) *size=spec->size;
+	if (hop != NULL) *hop=spec->hop;
+	if (frames != NULL) *frames=spec->frames;
+	return ERR_OK;
+}
+
+int esweep_spectrumProcess(esweep_spectrum *spec, const esweep_object *in) {
+	Wave *wave;
+	Complex *cpx;
+	int i, j, n;
+
+	ESWEEP_ASSERT(spec != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_OBJ_NOTEMPTY(in, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(in->type == WAVE || in->type == COMPLEX, ERR_NOT_ON_THIS_TYPE);
+
+	wave=(Wave*) in->data;
+	cpx=(Complex*) in->data;
+	for (i=0; i < in->size; ) {
+		n=spec->size-spec->fill;
+		if (n > in->size-i) n=in->size-i;
+		if (in->type == WAVE) memcpy(spec->hist+spec->fill, wave+i, n*sizeof(Wave));
+		else for (j=0; j < n; j++) spec->hist[spec->fill+j]=cpx[i+j].real; /* the real part, as recorded by esweep_audioIn() */
+		spec->fill+=n;
+		i+=n;
+		if (spec->fill == spec->size) {
+			__esweep_spectrumFrame(spec);
+			memmove(spec->hist, spec->hist+spec->hop, (spec->size-spec->hop)*sizeof(Real));
+			spec->fill=spec->size-spec->hop;
+		}
+	}
+	return ERR_OK;
+}
+
+int esweep_spectrumRead(const esweep_spectrum *spec, esweep_object *out, const char *mode, int *frames) {
+	Polar *polar;
+	double scale;
+	int k, N, root=0;
+
+	ESWEEP_ASSERT(spec != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(out != NULL, ERR_OBJ_IS_NULL);
+	ESWEEP_ASSERT(mode != NULL, ERR_BAD_ARGUMENT);
+
+	/* single sided spectra */
+	if (strcmp(mode, "magnitude") == 0) {
+		/* the peak amplitude of a sine at the center of a bin */
+		scale=2.0/spec->win_sum;
+		root=1;
+	} else if (strcmp(mode, "power") == 0) {
+		/* the power of a sine at the center of a bin, i. e. the squared RMS */
+		scale=2.0/(spec->win_sum*spec->win_sum);
+	} else if (strcmp(mode, "psd") == 0) {
+		/* power spectral density, units^2/Hz */
+		scale=2.0/(spec->win_pow*spec->samplerate);
+	} else {
+		ESWEEP_ASSERT(0, ERR_BAD_ARGUMENT);
+	}
+
+	N=spec->size;
+	/* the output is only reallocated when it does not have the right type and size already */
+	if (out->type != POLAR || out->size != N || out->data == NULL) {
+		__esweep_freeObjectData(out);
+		out->type=POLAR;
+		out->size=N;
+		ESWEEP_MALLOC(out->data, N, sizeof(Polar), ERR_MALLOC);
+	}
+	out->samplerate=spec->samplerate;
+	polar=(Polar*) out->data;
+
+	for (k=0; k < spec->bins; k++) {
+		polar[k].abs=root ? scale*sqrt(spec->power[k]) : scale*spec->power[k];
+		polar[k].arg=0.0;
+	}
+	/* DC and Nyquist have no mirror image */
+	polar[0].abs*=0.5;
+	polar[N/2].abs*=0.5;
+	/* the bins above N/2 are the mirror image */
+	for (k=1; k < N/2; k++) polar[N-k]=polar[k];
+
+	if (frames != NULL) *frames=spec->frames;
+	return ERR_OK;
+}
+
+int esweep_spectrumReset(esweep_spectrum *spec) {
+	ESWEEP_ASSERT(spec != NULL, ERR_BAD_ARGUMENT);
+	memset(spec->hist, 0, spec->size*sizeof(Real));
+	memset(spec->power, 0, spec->bins*sizeof(double));
+	spec->fill=0;
+	spec->frames=0;
+	return ERR_OK;
+}
+
+int esweep_spectrumFree(esweep_spectrum *spec) {
+	ESWEEP_ASSERT(spec != NULL, ERR_BAD_ARGUMENT);
+	free(spec->win);
+	free(spec->hist);
+	free(spec->power);
+	free(spec->buf);
+	free(spec->X);
+	free(spec->twiddle);
+	free(spec->table);
+	free(spec);
+	return ERR_OK;
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * src/esweep_stats.c:
+ * Reductions over the values of an object: sum, sum of squares, minimum and maximum
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esweep_priv.h"
+#include "esweep.h"
+#include "vmath.h"
+
+/*
+ * The values are split into blocks of STATS_BLOCK, which are reduced by vmath_reduce().
+ * Complex and polar values are first copied into a buffer of this size, so it stays in the L1 cache.
+ * The partial results of the blocks are combined in the order of the blocks, the sums with
+ * compensated (Neumaier) summation. The blocks do not depend on the number of threads,
+ * so the results are the same for any number of threads.
+ */
+#define STATS_BLOCK 2048
+/* blocks a thread takes at once */
+#define STATS_GRAB 16
+/* below this number of values, starting threads costs more than it gains */
+#define STATS_THREAD_MIN (1 << 20)
+#define STATS_THREAD_MAX 8
+
+typedef struct {
+	const esweep_object *obj;
+	const Real *z; /* the values of a SURFACE */
+	int from, n;
+	vmath_reduction *part;
+	/* next block to process, shared by the threads */
+	int next;
+	int blocks;
+	pthread_mutex_t lock;
+} stats_job;
+
+static void __esweep_statsBlock(stats_job *job, int block) {
+	Real buf[STATS_BLOCK];
+	const Real *x;
+	const Polar *polar;
+	const Complex *cpx;
+	vmath_reduction *part=&job->part[block];
+	int i, start=job->from+block*STATS_BLOCK;
+	int m=job->n-block*STATS_BLOCK < STATS_BLOCK ? job->n-block*STATS_BLOCK : STATS_BLOCK;
+
+	switch (job->obj->type) {
+		case WAVE:
+			x=(const Wave*) job->obj->data+start;
+			break;
+		case POLAR:
+			polar=(const Polar*) job->obj->data+start;
+			for (i=0; i < m; i++) buf[i]=polar[i].abs;
+			x=buf;
+			break;
+		case COMPLEX:
+			cpx=(const Complex*) job->obj->data+start;
+			for (i=0; i < m; i++) buf[i]=CABS(cpx[i]);
+			x=buf;
+			break;
+		case SURFACE:
+		default:
+			x=job->z+start;
+			break;
+	}
+	vmath_reduce(x, m, part);
+	/* indices relative to job->from */
+	if (part->imin >= 0) part->imin+=block*STATS_BLOCK;
+	if (part->imax >= 0) part->imax+=block*STATS_BLOCK;
+}
+
+static void *__esweep_statsWorker(void *arg) {
+	stats_job *job=(stats_job*) arg;
+	int block, last;
+
+	for (;;) {
+		pthread_mutex_lock(&job->lock);
+		block=job->next;
+		job->next+=STATS_GRAB;
+		pthread_mutex_unlock(&job->lock);
+		if (block >= job->blocks) break;
+		last=block+STATS_GRAB < job->blocks ? block+STATS_GRAB : job->blocks;
+		for (; block < last; block++) __esweep_statsBlock(job, block);
+	}
+	return NULL;
+}
+
+static int __esweep_statsThreads(int threads, int n) {
+	if (threads > 0) return threads;
+	if (n < STATS_THREAD_MIN) return 1;
+	threads=1;
+#ifdef _SC_NPROCESSORS_ONLN
+	threads=(int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	if (threads < 1) threads=1;
+	if (threads > STATS_THREAD_MAX) threads=STATS_THREAD_MAX;
+	return threads;
+}
+
+#define NEUMAIER(sum, c, x) { \
+	t=sum+(x); \
+	if (fabs(sum) >= fabs(x)) c+=(sum-t)+(x); \
+	else c+=((x)-t)+sum; \
+	sum=t; \
+}
+
+__EXTERN_FUNC__ int __esweep_stats(const esweep_object *obj, int from, int n, int threads, esweep_statistics *stats) {
+	stats_job job;
+	pthread_t *tid;
+	Surface *surf;
+	const vmath_reduction *part;
+	double sum=0.0, sc=0.0, sqsum=0.0, qc=0.0, t, peak;
+	int i;
+
+	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(stats != NULL, ERR_BAD_ARGUMENT);
+
+	job.z=NULL;
+	switch (obj->type) {
+		case WAVE:
+		case POLAR:
+		case COMPLEX:
+			ESWEEP_ASSERT(from >= 0 && n > 0 && from+n <= obj->size, ERR_BAD_PARAMETER);
+			break;
+		case SURFACE:
+			surf=(Surface*) obj->data;
+			ESWEEP_OBJ_ISVALID_SURFACE(obj, surf, ERR_NOT_ON_THIS_TYPE, ERR_OBJ_NOT_VALID);
+			ESWEEP_ASSERT(from >= 0 && n > 0 && from+n <= surf->xsize*surf->ysize, ERR_BAD_PARAMETER);
+			job.z=surf->z;
+			break;
+		default:
+			ESWEEP_NOT_THIS_TYPE(obj->type, ERR_NOT_ON_THIS_TYPE);
+	}
+
+	job.obj=obj;
+	job.from=from;
+	job.n=n;
+	job.next=0;
+	job.blocks=(n+STATS_BLOCK-1)/STATS_BLOCK;
+	ESWEEP_MALLOC(job.part, job.blocks, sizeof(vmath_reduction), ERR_MALLOC);
+
+	threads=__esweep_statsThreads(threads, n);
+	if (threads > (job.blocks+STATS_GRAB-1)/STATS_GRAB) threads=(job.blocks+STATS_GRAB-1)/STATS_GRAB;
+	if (threads <= 1) {
+		for (i=0; i < job.blocks; i++) __esweep_statsBlock(&job, i);
+	} else {
+		pthread_mutex_init(&job.lock, NULL);
+		tid=(pthread_t*) calloc(threads, sizeof(pthread_t));
+		if (tid == NULL) threads=0;
+		for (i=0; i < threads; i++) {
+			if (pthread_create(&tid[i], NULL, __esweep_statsWorker, &job) != 0) break;
+		}
+		/* if not all threads could be created, this thread takes part */
+		if (i < threads || threads == 0) __esweep_statsWorker(&job);
+		threads=i;
+		for (i=0; i < threads; i++) pthread_join(tid[i], NULL);
+		free(tid);
+		pthread_mutex_destroy(&job.lock);
+	}
+
+	stats->n=n;
+	stats->min=stats->max=__NAN("");
+	stats->argmin=stats->argmax=-1;
+	for (i=0, part=job.part; i < job.blocks; i++, part++) {
+		NEUMAIER(sum, sc, part->sum);
+		NEUMAIER(sqsum, qc, part->sqsum);
+		/* strict compares, so the first of equal values wins */
+		if (part->imin >= 0 && (stats->argmin < 0 || part->min < stats->min)) {
+			stats->min=part->min;
+			stats->argmin=from+part->imin;
+		}
+		if (part->imax >= 0 && (stats->argmax < 0 || part->max > stats->max)) {
+			stats->max=part->max;
+			stats->argmax=from+part->imax;
+		}
+	}
+	free(job.part);
+
+	/* with inf in the sum, the correction is NaN */
+	stats->sum=isfinite(sum) ? sum+sc : sum;
+	stats->sqsum=isfinite(sqsum) ? sqsum+qc : sqsum;
+	stats->mean=stats->sum/n;
+	stats->rms=sqrt(stats->sqsum/n);
+	peak=FABS(stats->min) > FABS(stats->max) ? FABS(stats->min) : FABS(stats->max);
+	stats->crest=stats->rms > 0.0 ? peak/stats->rms : 0.0;
+
+	return ERR_OK;
+}
+
+int esweep_stats(const esweep_object *obj, esweep_statistics *stats, int threads) {
+	Surface *surf;
+
+	ESWEEP_OBJ_NOTEMPTY(obj, ERR_EMPTY_OBJECT);
+	if (obj->type == SURFACE) {
+		surf=(Surface*) obj->data;
+		ESWEEP_OBJ_ISVALID_SURFACE(obj, surf, ERR_NOT_ON_THIS_TYPE, ERR_OBJ_NOT_VALID);
+		return __esweep_stats(obj, 0, surf->xsize*surf->ysize, threads, stats);
+	}
+	return __esweep_stats(obj, 0, obj->size, threads, stats);
+}
@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * src/esweep_stft.c:
+ * Short time Fourier transform (spectrogram) into SURFACE objects
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esweep_priv.h"
+#include "fft.h"
+
+/*
+ * The frames start every hop samples, each frame is windowed and transformed with fft_real().
+ * Input which does not fill a complete frame is kept until the next call, so the signal may
+ * arrive in blocks of any size. The magnitudes are written directly into the rows of a SURFACE,
+ * x is the frequency axis and y the time axis (centre of the frame), like with esweep_csd().
+ * When the surface is full, it scrolls: the oldest rows are dropped.
+ *
+ * With the logarithmic frequency axis, each output bin covers the band between the geometric
+ * means of its neighbours. If there are FFT bins in this band, the output is their RMS, otherwise the
+ * magnitude is interpolated linearly between the FFT bins around the centre frequency.
+ *
+ * The frames of one call are independent, they are distributed over a pool of threads.
+ */
+
+#define STFT_LINEAR 0
+#define STFT_LOG 1
+
+struct __esweep_stftEngine {
+	int samplerate;
+	int size; /* N, power of 2 */
+	int hop;
+	int axis;
+	int bins; /* output bins */
+	Real *freq; /* frequencies of the output bins */
+	int *first; /* log axis: first FFT bin of the band, or the lower bin of the interpolation */
+	int *count; /* log axis: number of FFT bins in the band, 0 for interpolation */
+	Real *frac; /* log axis: interpolation factor */
+	Real *win;
+	double scale; /* magnitude of a sine of amplitude 1 */
+	Real *pend; /* input of the next frame, less than N samples */
+	int npend;
+	long frames; /* frames since the last reset */
+	int rows; /* filled rows of the surface */
+	Complex *table;
+	Complex *twiddle;
+};
+
+typedef struct {
+	const esweep_stftEngine *stft;
+	const Real *signal;
+	Real *z; /* z of the first frame */
+	int first; /* first frame, relative to signal */
+	int frames;
+	int next;
+	int err;
+	pthread_mutex_t lock;
+} stft_job;
+
+static void __esweep_stftFrame(const esweep_stftEngine *stft, const Real *x, Real *row, Complex *z, Complex *X, Real *mag) {
+	const Real *w=stft->win;
+	double p;
+	int k, j, half=stft->size/2;
+
+	for (k=0; k < half; k++) {
+		z[k].real=w[2*k]*x[2*k];
+		z[k].imag=w[2*k+1]*x[2*k+1];
+	}
+	fft_real(X, z, stft->table, stft->twiddle, stft->size);
+	for (k=0; k <= half; k++) mag[k]=stft->scale*sqrt(X[k].real*X[k].real+X[k].imag*X[k].imag);
+	mag[0]*=0.5;
+	mag[half]*=0.5;
+
+	if (stft->axis == STFT_LINEAR) {
+		memcpy(row, mag, (half+1)*sizeof(Real));
+		return;
+	}
+	for (k=0; k < stft->bins; k++) {
+		if (stft->count[k] > 0) {
+			for (p=0.0, j=stft->first[k]; j < stft->first[k]+stft->count[k]; j++) p+=mag[j]*mag[j];
+			row[k]=sqrt(p/stft->count[k]);
+		} else {
+			j=stft->first[k];
+			row[k]=mag[j]+stft->frac[k]*(mag[j+1]-mag[j]);
+		}
+	}
+}
+
+static void *__esweep_stftWorker(void *arg) {
+	stft_job *job=(stft_job*) arg;
+	const esweep_stftEngine *stft=job->stft;
+	Complex *z, *X;
+	Real *mag;
+	int m, half=stft->size/2;
+
+	z=(Complex*) calloc(half, sizeof(Complex));
+	X=(Complex*) calloc(half+1, sizeof(Complex));
+	mag=(Real*) calloc(half+1, sizeof(Real));
+	if (z == NULL || X == NULL || mag == NULL) {
+		pthread_mutex_lock(&job->lock);
+		job->err=ERR_MALLOC;
+		pthread_mutex_unlock(&job->lock);
+	} else {
+		for (;;) {
+			pthread_mutex_lock(&job->lock);
+			m=job->next++;
+			pthread_mutex_unlock(&job->lock);
+			if (m >= job->frames) break;
+			__esweep_stftFrame(stft, job->signal+(long) (job->first+m)*stft->hop, job->z+(long) m*stft->bins, z, X, mag);
+		}
+	}
+	free(z);
+	free(X);
+	free(mag);
+	return NULL;
+}
+
+esweep_stftEngine *esweep_stftCreate(int samplerate, int size, int hop, const char *win_name, const char *axis, Real f1, Real f2, int bins) {
+	esweep_stftEngine *stft;
+	Real df, lo, hi, f, r;
+	int i, k, win_type=WIN_HANN, axis_type=STFT_LINEAR;
+	Real win_param=0.0;
+
+	ESWEEP_ASSERT(samplerate > 0, NULL);
+	ESWEEP_ASSERT(size >= 4 && size <= ESWEEP_MAX_SIZE && (size & (size-1)) == 0, NULL);
+	ESWEEP_ASSERT(hop > 0 && hop <= size, NULL);
+	if (win_name != NULL) {
+		win_type=window_parse(win_name, &win_param);
+		ESWEEP_ASSERT(win_type != WIN_NOWIN, NULL);
+	}
+	if (axis != NULL) {
+		axis_type=-1;
+		if (strcmp(axis, "linear") == 0) axis_type=STFT_LINEAR;
+		if (strcmp(axis, "log") == 0) axis_type=STFT_LOG;
+		ESWEEP_ASSERT(axis_type >= 0, NULL);
+	}
+	if (axis_type == STFT_LOG) {
+		ESWEEP_ASSERT(f1 > 0.0 && f2 > f1 && 2*f2 <= samplerate, NULL);
+		ESWEEP_ASSERT(bins >= 2 && bins <= size, NULL);
+	}
+
+	ESWEEP_MALLOC(stft, 1, sizeof(esweep_stftEngine), NULL);
+	stft->samplerate=samplerate;
+	stft->size=size;
+	stft->hop=hop;
+	stft->axis=axis_type;
+	stft->bins=axis_type == STFT_LINEAR ? size/2+1 : bins;
+	ESWEEP_MALLOC(stft->freq, stft->bins, sizeof(Real), NULL);
+	ESWEEP_MALLOC(stft->first, stft->bins, sizeof(int), NULL);
+	ESWEEP_MALLOC(stft->count, stft->bins, sizeof(int), NULL);
+	ESWEEP_MALLOC(stft->frac, stft->bins, sizeof(Real), NULL);
+	ESWEEP_MALLOC(stft->win, size, sizeof(Real), NULL);
+	ESWEEP_MALLOC(stft->pend, size, sizeof(Real), NULL);
+	stft->table=fft_create_table(size/2);
+	stft->twiddle=fft_create_real_table(size);
+
+	df=(Real) samplerate/size;
+	if (axis_type == STFT_LINEAR) {
+		for (k=0; k < stft->bins; k++) stft->freq[k]=k*df;
+	} else {
+		r=pow(f2/f1, 1.0/(bins-1));
+		for (k=0; k < bins; k++) stft->freq[k]=f1*pow(r, k);
+		for (k=0; k < bins; k++) {
+			f=stft->freq[k];
+			lo=f/sqrt(r);
+			hi=f*sqrt(r);
+			/* FFT bins in [lo, hi) */
+			stft->first[k]=(int) ceil(lo/df);
+			stft->count[k]=(int) ceil(hi/df)-stft->first[k];
+			if (stft->first[k]+stft->count[k] > size/2+1) stft->count[k]=size/2+1-stft->first[k];
+			if (stft->count[k] <= 0) {
+				stft->count[k]=0;
+				stft->first[k]=(int) (f/df);
+				if (stft->first[k] >= size/2) stft->first[k]=size/2-1;
+				stft->frac[k]=f/df-stft->first[k];
+			}
+		}
+	}
+
+	/* the same symmetric windows as esweep_window() with 50 % left and right */
+	for (i=0; i < size; i++) stft->win[i]=1.0;
+	window_ext(stft->win, 0, size/2, WIN_LEFT, win_type, win_param);
+	window_ext(stft->win, size/2, size, WIN_RIGHT, win_type, win_param);
+	for (stft->scale=0.0, i=0; i < size; i++) stft->scale+=stft->win[i];
+	stft->scale=2.0/stft->scale;
+
+	esweep_stftReset(stft);
+	return stft;
+}
+
+int esweep_stftInfo(const esweep_stftEngine *stft, int *bins, long *frames) {
+	ESWEEP_ASSERT(stft != NULL, ERR_BAD_ARGUMENT);
+	if (bins != NULL) *bins=stft->bins;
+	if (frames != NULL) *frames=stft->frames;
+	return ERR_OK;
+}
+
+int esweep_stftProcess(esweep_stftEngine *stft, esweep_object *out, const esweep_object *in, int threads, int *frames) {
+	Surface *surf;
+	stft_job job;
+	pthread_t *tid;
+	Real *signal;
+	Complex *cpx;
+	int i, total, n, first, new_rows, scroll, err=ERR_OK;
+
+	ESWEEP_ASSERT(stft != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_OBJ_NOTEMPTY(in, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(in->type == WAVE || in->type == COMPLEX, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_OBJ_NOTEMPTY(out, ERR_EMPTY_OBJECT);
+	surf=(Surface*) out->data;
+	ESWEEP_OBJ_ISVALID_SURFACE(out, surf, ERR_NOT_ON_THIS_TYPE, ERR_OBJ_NOT_VALID);
+	ESWEEP_ASSERT(surf->xsize == stft->bins && surf->ysize > 0, ERR_SIZE_MISMATCH);
+
+	/* the pending samples and the new input in one buffer */
+	total=stft->npend+in->size;
+	ESWEEP_MALLOC(signal, total, sizeof(Real), ERR_MALLOC);
+	memcpy(signal, stft->pend, stft->npend*sizeof(Real));
+	if (in->type == WAVE) {
+		memcpy(signal+stft->npend, in->data, in->size*sizeof(Real));
+	} else {
+		cpx=(Complex*) in->data;
+		for (i=0; i < in->size; i++) signal[stft->npend+i]=cpx[i].real;
+	}
+
+	n=total >= stft->size ? (total-stft->size)/stft->hop+1 : 0;
+	/* only the last ysize frames end up in the surface */
+	first=n > surf->ysize ? n-surf->ysize : 0;
+	new_rows=n-first;
+
+	if (new_rows > 0) {
+		/* scroll */
+		scroll=stft->rows+new_rows-surf->ysize;
+		if (scroll > 0) {
+			memmove(surf->z, surf->z+(long) scroll*surf->xsize, (long) (stft->rows-scroll)*surf->xsize*sizeof(Real));
+			memmove(surf->y, surf->y+scroll, (stft->rows-scroll)*sizeof(Real));
+			stft->rows-=scroll;
+		}
+		for (i=0; i < new_rows; i++) {
+			surf->y[stft->rows+i]=((stft->frames+first+i)*(double) stft->hop+0.5*stft->size)/stft->samplerate;
+		}
+		memcpy(surf->x, stft->freq, stft->bins*sizeof(Real));
+		out->samplerate=stft->samplerate;
+
+		job.stft=stft;
+		job.signal=signal;
+		job.z=surf->z+(long) stft->rows*surf->xsize;
+		job.first=first;
+		job.frames=new_rows;
+		job.next=0;
+		job.err=ERR_OK;
+		if (threads <= 0) threads=1;
+		if (threads > new_rows) threads=new_rows;
+		pthread_mutex_init(&job.lock, NULL);
+		if (threads == 1) {
+			__esweep_stftWorker(&job);
+		} else {
+			tid=(pthread_t*) calloc(threads, sizeof(pthread_t));
+			if (tid == NULL) threads=0;
+			for (i=0; i < threads; i++) {
+				if (pthread_create(&tid[i], NULL, __esweep_stftWorker, &job) != 0) break;
+			}
+			/* if not all threads could be created, this thread takes part */
+			if (i < threads || threads == 0) __esweep_stftWorker(&job);
+			threads=i;
+			for (i=0; i < threads; i++) pthread_join(tid[i], NULL);
+			free(tid);
+		}
+		pthread_mutex_destroy(&job.lock);
+		err=job.err;
+		stft->rows+=new_rows;
+	}
+
+	/* keep the input of the next frame */
+	stft->frames+=n;
+	stft->npend=total-n*stft->hop;
+	memcpy(stft->pend, signal+n*stft->hop, stft->npend*sizeof(Real));
+	free(signal);
+
+	/* a worker without memory skips its frames, but the stream stays consistent */
+	ESWEEP_ASSERT(err == ERR_OK, err);
+	if (frames != NULL) *frames=new_rows;
+	return ERR_OK;
+}
+
+int esweep_stftReset(esweep_stftEngine *stft) {
+	ESWEEP_ASSERT(stft != NULL, ERR_BAD_ARGUMENT);
+	stft->npend=0;
+	stft->frames=0;
+	stft->rows=0;
+	return ERR_OK;
+}
+
+int esweep_stftFree(esweep_stftEngine *stft) {
+	ESWEEP_ASSERT(stft != NULL, ERR_BAD_ARGUMENT);
+	free(stft->freq);
+	free(stft->first);
+	free(stft->count);
+	free(stft->frac);
+	free(stft->win);
+	free(stft->pend);
+	free(stft->table);
+	free(stft->twiddle);
+	free(stft);
+	return ERR_OK;
+}
+
+int esweep_stft(esweep_object *out, const esweep_object *in, const char *window, int fft_size, int hop, int threads) {
+	esweep_stftEngine *stft;
+	int ret;
+
+	ESWEEP_OBJ_NOTEMPTY(in, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(in->type == WAVE || in->type == COMPLEX, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_ASSERT(out != NULL && out->type == SURFACE, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_ASSERT(in->size >= fft_size, ERR_BAD_ARGUMENT);
+
+	if ((stft=esweep_stftCreate(in->samplerate, fft_size, hop, window, "linear", 0, 0, 0)) == NULL) return ERR_BAD_ARGUMENT;
+	if ((ret=esweep_sparseSurface(out, stft->bins, (in->size-fft_size)/hop+1)) == ERR_OK) {
+		ret=esweep_stftProcess(stft, out, in, threads, NULL);
+	}
+	esweep_stftFree(stft);
+	return ret;
+}
@@ -15,6 +15,7 @@
  */
 
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -27,133 +28,343 @@
 calculate the classic CSD from WAVE "in"
 output in "out" is of type SURFACE
 see theory section in doc
+
+Each step is the spectrum of the tail of the impulse response, starting "time_step" later than the
+previous one and zero padded to the FFT size, with a Blackman rise window at the start of the tail.
+The steps are independent of each other and are computed by a pool of threads, which share the FFT table.
+With "points" > 0, only the magnitudes at logarithmically spaced frequencies are computed.
+Without smoothing these are single DFT bins of the tail (Goertzel), so the work shrinks with the tail.
 */
 
-int esweep_csd(esweep_object *out, esweep_object *in, Real time_step, int steps, Real rise_time, Real smooth_factor) {
-	Complex *complex;
-	Polar *polar;
-	Wave *wave;
+typedef struct {
+	const esweep_object *in;
 	Surface *surf;
-	int fft_size, i, j;
-	int rise_samples, step_samples;
-	Complex *fft_table;
-	Real df;
-
-	if ((in==NULL) || ((*in).data==NULL) || ((*in).size<=0)) return ERR_EMPTY_OBJECT;
-	if (out==NULL) return ERR_EMPTY_OBJECT;
-	if (((*in).type!=WAVE) || ((*out).type!=SURFACE)) return ERR_NOT_ON_THIS_TYPE;
-
-	fft_size=(int) (pow(2, ceil(log((*in).size)/log(2)))+0.5);
-	df=(Real) (*in).samplerate/fft_size;
-
-	/* check arguments */
-
-	if (!(time_step>0.0)) return ERR_BAD_ARGUMENT;
-	if (steps<=0) return ERR_BAD_ARGUMENT;
-	if (steps*time_step/1000>1/df) return ERR_BAD_ARGUMENT;
-
-	rise_samples=(int) (rise_time/1000*(*in).samplerate+0.5);
-	if ((rise_samples<0) || (rise_samples > (*in).size)) return ERR_BAD_ARGUMENT;
-	if (smooth_factor<0.1) return ERR_BAD_ARGUMENT;
-
-	/* allocate enough space for the resultant surface */
+	int fft_size;
+	int step_samples;
+	int rise_samples;
+	Real smooth_factor;
+	Real f1, f2;
+	int points;
+	Complex *table;
+	Complex *twiddle;
+	int next;
+	int err;
+	pthread_mutex_t lock;
+} csd_job;
+
+static int __esweep_csdStep(csd_job *job, int step, Real *tail, Complex *z, esweep_object *spectrum, Real *freq, Polar *log_spectrum) {
+	const esweep_object *in=job->in;
+	esweep_object wave;
+	Surface *surf=job->surf;
+	Real *row=surf->z+(long) step*surf->xsize;
+	Complex *X;
+	Polar *polar;
+	Real scale;
+	int i, size, rise, half=job->fft_size/2;
+
+	/* the tail, the remainder of the FFT size is zero */
+	size=in->size-step*job->step_samples;
+	memcpy(tail, (Real*) in->data+step*job->step_samples, size*sizeof(Real));
+	rise=job->rise_samples < size ? job->rise_samples : size;
+	window(tail, 0, rise, WIN_LEFT, WIN_BLACK);
+
+	if (job->points > 0 && job->smooth_factor == 0) {
+		wave.type=WAVE;
+		wave.samplerate=in->samplerate;
+		wave.size=size;
+		wave.data=tail;
+		wave.repr=NULL;
+		if (esweep_toneAnalyze(&wave, surf->x, job->points, log_spectrum) != ERR_OK) return ERR_UNKNOWN;
+		/* esweep_toneAnalyze() returns amplitudes, but we want |X| like the FFT */
+		for (i=0; i < job->points; i++) {
+			scale=2*surf->x[i] < in->samplerate ? 0.5*size : size;
+			row[i]=scale*log_spectrum[i].abs;
+		}
+		return ERR_OK;
+	}
 
-	surf=(Surface*) (*out).data;
-	if ((*out).data!=NULL) {
-		free((*surf).x);
-		free((*surf).y);
-		free((*surf).z);
-		free(surf);
+	memset(tail+size, 0, (job->fft_size-size)*sizeof(Real));
+	for (i=0; i < half; i++) {
+		z[i].real=tail[2*i];
+		z[i].imag=tail[2*i+1];
+	}
+	X=(Complex*) spectrum->data;
+	fft_real(X, z, job->table, job->twiddle, job->fft_size);
+	/* we need only the lower half, no phase */
+	polar=(Polar*) X;
+	for (i=0; i <= half; i++) {
+		polar[i].abs=sqrt(X[i].real*X[i].real+X[i].imag*X[i].imag);
+		polar[i].arg=0.0;
 	}
 
-	surf=(Surface*) calloc(1, sizeof(Surface));
-	(*out).data=surf;
-	(*out).samplerate=(*in).samplerate;
+	if (job->smooth_factor == 0) {
+		for (i=0; i <= half; i++) row[i]=polar[i].abs;
+	} else if (job->points > 0) {
+		if (esweep_smoothLog(spectrum, job->smooth_factor, NULL, job->f1, job->f2, job->points, freq, log_spectrum) != ERR_OK) return ERR_UNKNOWN;
+		for (i=0; i < job->points; i++) row[i]=log_spectrum[i].abs;
+	} else {
+		/* esweep_smooth() reallocates the data */
+		if (esweep_smooth(spectrum, job->smooth_factor) != ERR_OK) return ERR_UNKNOWN;
+		polar=(Polar*) spectrum->data;
+		for (i=0; i <= half; i++) row[i]=polar[i].abs;
+	}
+	return ERR_OK;
+}
 
-	/* the x-vector is the frequency axis, we do not save the hermitian redundancy */
+static void *__esweep_csdWorker(void *arg) {
+	csd_job *job=(csd_job*) arg;
+	esweep_object *spectrum;
+	Polar *log_spectrum;
+	Complex *z;
+	Real *tail, *freq;
+	int step, err=ERR_OK;
+
+	tail=(Real*) calloc(job->fft_size, sizeof(Real));
+	z=(Complex*) calloc(job->fft_size/2, sizeof(Complex));
+	freq=(Real*) calloc(job->points > 0 ? job->points : 1, sizeof(Real));
+	log_spectrum=(Polar*) calloc(job->points > 0 ? job->points : 1, sizeof(Polar));
+	spectrum=esweep_create("polar", job->in->samplerate, job->fft_size);
+
+	if (tail == NULL || z == NULL || freq == NULL || log_spectrum == NULL || spectrum == NULL) err=ERR_MALLOC;
+	while (err == ERR_OK) {
+		pthread_mutex_lock(&job->lock);
+		step=job->err == ERR_OK ? job->next++ : job->surf->ysize;
+		pthread_mutex_unlock(&job->lock);
+		if (step >= job->surf->ysize) break;
+		err=__esweep_csdStep(job, step, tail, z, spectrum, freq, log_spectrum);
+	}
+	if (err != ERR_OK) {
+		pthread_mutex_lock(&job->lock);
+		job->err=err;
+		pthread_mutex_unlock(&job->lock);
+	}
 
-	(*surf).xsize=fft_size/2+1;
-	(*surf).x=(Real*) calloc((*surf).xsize, sizeof(Real));
+	free(tail);
+	free(z);
+	free(freq);
+	free(log_spectrum);
+	if (spectrum != NULL) esweep_free(spectrum);
+	return NULL;
+}
 
-	/* the y-vector is the time axis */
+int esweep_csd(esweep_object *out, esweep_object *in, Real time_step, int steps, Real rise_time, Real smooth_factor) {
+	return esweep_csdExt(out, in, time_step, steps, rise_time, smooth_factor, 0, 0, 0, 1);
+}
 
-	(*surf).ysize=steps;
-	(*surf).y=(Real*) calloc((*surf).ysize, sizeof(Real));
+int esweep_csdExt(esweep_object *out, const esweep_object *in, Real time_step, int steps, Real rise_time, Real smooth_factor,
+		Real f1, Real f2, int points, int threads) {
+	Surface *surf;
+	csd_job job;
+	pthread_t *tid;
+	int i, n;
 
-	/* the z vector is the dependent part */
-	(*surf).z=(Real*) calloc((*surf).xsize*(*surf).ysize, sizeof(Real));
+	ESWEEP_OBJ_NOTEMPTY(in, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(in->type == WAVE, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_ASSERT(out != NULL && out->type == SURFACE, ERR_NOT_ON_THIS_TYPE);
 
-	/* fill the x vector */
+	for (job.fft_size=4; job.fft_size < in->size; job.fft_size*=2);
+	ESWEEP_ASSERT(job.fft_size <= ESWEEP_MAX_SIZE, ERR_BAD_ARGUMENT);
 
-	for (i=0;i<(*surf).xsize;i++) {
-		(*surf).x[i]=i*df;
+	/* check arguments */
+	ESWEEP_ASSERT(time_step > 0.0, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(steps > 0, ERR_BAD_ARGUMENT);
+	job.step_samples=(int) (time_step/1000*in->samplerate+0.5);
+	ESWEEP_ASSERT(job.step_samples > 0 && (steps-1)*job.step_samples < in->size, ERR_BAD_ARGUMENT);
+	job.rise_samples=(int) (rise_time/1000*in->samplerate+0.5);
+	ESWEEP_ASSERT(job.rise_samples >= 0 && job.rise_samples <= in->size, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(smooth_factor == 0 || smooth_factor >= 1, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(points >= 0, ERR_BAD_ARGUMENT);
+	if (points > 0) {
+		ESWEEP_ASSERT(points >= 2 && f1 > 0.0 && f1 < f2 && 2*f2 <= in->samplerate, ERR_BAD_ARGUMENT);
 	}
 
-	/* fill the y vector */
-
-	for (i=0;i<(*surf).ysize;i++) {
-		(*surf).y[i]=i*time_step/1000;
+	/* the x-vector is the frequency axis, we do not save the hermitian redundancy */
+	if (esweep_sparseSurface(out, points > 0 ? points : job.fft_size/2+1, steps) != ERR_OK) return ERR_MALLOC;
+	out->samplerate=in->samplerate;
+	surf=(Surface*) out->data;
+	for (i=0; i < surf->xsize; i++) {
+		surf->x[i]=points > 0 ? f1*pow(f2/f1, (Real) i/(points-1)) : (Real) i*in->samplerate/job.fft_size;
+	}
+	/* the y-vector is the time axis */
+	for (i=0; i < surf->ysize; i++) surf->y[i]=(Real) i*job.step_samples/in->samplerate;
+
+	job.in=in;
+	job.surf=surf;
+	job.smooth_factor=smooth_factor;
+	job.f1=f1;
+	job.f2=f2;
+	job.points=points;
+	job.next=0;
+	job.err=ERR_OK;
+	job.table=fft_create_table(job.fft_size/2);
+	job.twiddle=fft_create_real_table(job.fft_size);
+	ESWEEP_ASSERT(job.table != NULL && job.twiddle != NULL, ERR_MALLOC);
+	pthread_mutex_init(&job.lock, NULL);
+
+	if (threads > steps) threads=steps;
+	if (threads <= 1) {
+		__esweep_csdWorker(&job);
+	} else {
+		ESWEEP_MALLOC(tid, threads, sizeof(pthread_t), ERR_MALLOC);
+		for (n=0; n < threads; n++) {
+			if (pthread_create(&tid[n], NULL, __esweep_csdWorker, &job) != 0) break;
+		}
+		/* if not all threads could be created, this thread takes part */
+		if (n < threads) __esweep_csdWorker(&job);
+		for (i=0; i < n; i++) pthread_join(tid[i], NULL);
+		free(tid);
 	}
 
-	/* set up fft table */
+	pthread_mutex_destroy(&job.lock);
+	free(job.table);
+	free(job.twiddle);
+	ESWEEP_ASSERT(job.err == ERR_OK, job.err);
+	return ERR_OK;
+}
 
-	fft_table=fft_create_table(fft_size);
+/*
+calculate the burst decay from WAVE "in"
+it is a convolution of "in" with Morlet-Wavelets of various center frequencies
 
-	complex=(Complex*) calloc(fft_size, sizeof(Complex));
-	polar=(Polar*) complex;
-	wave=(Wave*) (*in).data;
+The convolution is the multiplication of the spectrum of "in" with the spectrum of the wavelet,
+a gaussian around the center frequency. Only the bins where the gaussian is above 1e-7 of its maximum
+are used, and only the output samples which end up in the surface are computed: each one is the inverse DFT
+of the band at this sample (Horner's scheme). If there are more output samples than the inverse FFT of the
+whole spectrum would cost, the band is transformed with the FFT instead.
+The frequencies are independent of each other and are computed by a pool of threads.
+*/
 
-	for (i=0, step_samples=0;i<steps;i++, step_samples+=(int) (time_step/1000*(*in).samplerate+0.5)) {
-		/* copy part of input wave into temporary complex array */
-		r2c(complex, &(wave[step_samples]), (*in).size-step_samples);
+/* the gaussian is exp(-CBSD_SUPPORT) at the edge of the band, about 1e-7 */
+#define CBSD_SUPPORT 16.0
 
-		/* windowing of the rise time, we use a blackman window */
-		window_complex(complex, 0, rise_samples, WIN_LEFT, WIN_BLACK);
+typedef struct {
+	Surface *surf;
+	int samplerate;
+	int fft_size;
+	int resolution;
+	int steps;
+	char time_shift;
+	const Complex *spectrum; /* bins 0..fft_size/2 of the input */
+	Complex *table;
+	int next;
+	int err;
+	pthread_mutex_t lock;
+} cbsd_job;
+
+static void __esweep_cbsdFrequency(cbsd_job *job, int i, Complex *band, Complex *wave_out) {
+	Surface *surf=job->surf;
+	const Complex *X=job->spectrum;
+	Complex x, w, acc;
+	Real freq=surf->x[i], omega=2*M_PI*freq;
+	Real tau, dw, step_width, mag, arg, re, im;
+	int j, k, first, last, size, n;
+
+	/* time constant of the gaussian window */
+	tau=2.35482*job->resolution/omega;
+	dw=2*M_PI*job->samplerate/job->fft_size;
+
+	/* the band where the gaussian is not negligible */
+	first=(int) ceil((omega-2*sqrt(CBSD_SUPPORT)/tau)/dw);
+	last=(int) floor((omega+2*sqrt(CBSD_SUPPORT)/tau)/dw);
+	first=first < 0 ? 0 : first;
+	last=last >= job->fft_size ? job->fft_size-1 : last;
+	size=last-first+1;
 
-		/* in-place fft */
-		fft(complex, fft_table, fft_size, FFT_FORWARD);
+	/*
+	The spectrum of the wavelet, multiplied with the input.
+	The wavelet is shifted "resolution" periods of the actual frequency
+	towards positive times
+	*/
+	for (j=first; j <= last; j++) {
+		/* the input is real, the upper half is the conjugate of the lower half */
+		if (2*j <= job->fft_size) {
+			x=X[j];
+		} else {
+			x.real=X[job->fft_size-j].real;
+			x.imag=-X[job->fft_size-j].imag;
+		}
+		mag=tau*exp(-((j*dw-omega)*(j*dw-omega))*tau*tau/4);
+		if (job->time_shift == 'y') {
+			arg=-j*dw*job->resolution/freq;
+			re=mag*cos(arg);
+			im=mag*sin(arg);
+		} else {
+			re=mag;
+			im=0.0;
+		}
+		band[j-first].real=re*x.real-im*x.imag;
+		band[j-first].imag=im*x.real+re*x.imag;
+	}
 
-		/* converting to polar */
-		c2p(polar, complex, fft_size);
+	step_width=(Real) job->samplerate/(job->steps*freq);
+	if ((double) surf->ysize*size < (double) job->fft_size*log2(job->fft_size)) {
+		/* direct inverse DFT of the band, the magnitude does not depend on the offset "first" */
+		for (k=0; k < surf->ysize; k++) {
+			n=(int) (k*step_width+0.5);
+			w.real=cos(2*M_PI*n/job->fft_size);
+			w.imag=sin(2*M_PI*n/job->fft_size);
+			acc=band[size-1];
+			for (j=size-2; j >= 0; j--) {
+				re=acc.real*w.real-acc.imag*w.imag+band[j].real;
+				acc.imag=acc.real*w.imag+acc.imag*w.real+band[j].imag;
+				acc.real=re;
+			}
+			surf->z[i+k*surf->xsize]=2*hypot(acc.real, acc.imag)/job->fft_size;
+		}
+	} else {
+		memset(wave_out, 0, job->fft_size*sizeof(Complex));
+		memcpy(wave_out+first, band, size*sizeof(Complex));
+		fft(wave_out, job->table, job->fft_size, FFT_BACKWARD);
+		for (k=0; k < surf->ysize; k++) {
+			n=(int) (k*step_width+0.5);
+			surf->z[i+k*surf->xsize]=2*hypot(wave_out[n].real, wave_out[n].imag)/job->fft_size;
+		}
+	}
+}
 
-		/* smoothing */
-		smooth(polar, smooth_factor, fft_size);
+static void *__esweep_cbsdWorker(void *arg) {
+	cbsd_job *job=(cbsd_job*) arg;
+	Complex *band, *wave_out;
+	int i;
 
-		/* copy to surface structure, no redundancy, no phase*/
-		for (j=0;j<(*surf).xsize;j++) {
-			(*surf).z[i+j*(*surf).ysize]=polar[j].abs;
+	band=(Complex*) calloc(job->fft_size, sizeof(Complex));
+	wave_out=(Complex*) calloc(job->fft_size, sizeof(Complex));
+	if (band == NULL || wave_out == NULL) {
+		pthread_mutex_lock(&job->lock);
+		job->err=ERR_MALLOC;
+		pthread_mutex_unlock(&job->lock);
+	} else {
+		for (;;) {
+			pthread_mutex_lock(&job->lock);
+			i=job->next++;
+			pthread_mutex_unlock(&job->lock);
+			if (i >= job->surf->xsize) break;
+			__esweep_cbsdFrequency(job, i, band, wave_out);
 		}
-
-		/* zero-out complex array */
-		memset(complex, 0, fft_size*sizeof(Complex));
 	}
-	free(fft_table);
-	free(complex);
-	return ERR_OK;
+	free(band);
+	free(wave_out);
+	return NULL;
 }
 
-/*
-calculate the burst decay from WAVE "in"
-it is a convolution of "in" with Morlet-Wavelets of various center frequencies
-*/
-
 int esweep_cbsd(esweep_object *out, esweep_object *in, Real f1, Real f2, int resolution, int periods, int steps, char time_shift) {
+	return esweep_cbsdExt(out, in, f1, f2, resolution, periods, steps, time_shift, 1);
+}
+
+int esweep_cbsdExt(esweep_object *out, const esweep_object *in, Real f1, Real f2, int resolution, int periods, int steps, char time_shift, int threads) {
 	Surface *surf;
-	Complex *wave;
-	Complex *wave_out;
-	Complex *fft_table;
-	int fft_size, i, j;
-	Real freq, omega, dw;
-	Real tau; /* time constant auf gaussian window */
-	Real step_width;
-	Real re, im; /* temporary variables */
-
-	if ((in==NULL) || ((*in).data==NULL) || ((*in).size<=0)) return ERR_EMPTY_OBJECT;
-	if (out==NULL) return ERR_EMPTY_OBJECT;
-	if (((*in).type!=WAVE) || ((*out).type!=SURFACE)) return ERR_NOT_ON_THIS_TYPE;
-
-	if ((periods<1) || (steps<1) || (resolution<2)) return ERR_BAD_ARGUMENT;
-	if ((f2<f1) || (f2>=(*in).samplerate/2) || (f1<(*in).samplerate/(*in).size)) return ERR_BAD_ARGUMENT;
+	cbsd_job job;
+	pthread_t *tid;
+	Complex *z, *spectrum, *twiddle;
+	Real freq;
+	int fft_size, i, n;
+
+	ESWEEP_OBJ_NOTEMPTY(in, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(in->type == WAVE, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_ASSERT(out != NULL && out->type == SURFACE, ERR_NOT_ON_THIS_TYPE);
+
+	ESWEEP_ASSERT(periods >= 1 && steps >= 1 && resolution >= 2, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(f2 >= f1 && f2 < in->samplerate/2.0 && f1 >= (Real) in->samplerate/in->size, ERR_BAD_ARGUMENT);
 
 	/*
 	The morlet wavelet is of infinite length,
@@ -164,99 +375,70 @@ int esweep_cbsd(esweep_object *out, esweep_object *in, Real f1, Real f2, int res
 	length of the input array"+1.
 	Or, if we need more space to get all periods in the output array, use that size
 	*/
-	fft_size=(int) ((*in).samplerate*2*resolution/f1+(*in).size+1+0.5);
-	if ((int)((*in).samplerate*periods/f1+0.5) > fft_size) fft_size=(int)((*in).samplerate*periods/f1+0.5);
+	fft_size=(int) (in->samplerate*2*resolution/f1+in->size+1+0.5);
+	if ((int) (in->samplerate*periods/f1+0.5) > fft_size) fft_size=(int) (in->samplerate*periods/f1+0.5);
 
 	/* make this a power of 2 */
-	fft_size=(int) (pow(2, ceil(log(fft_size)/log(2)))+0.5);
-
-	surf=(Surface*) (*out).data;
-	if ((*out).data!=NULL) {
-		free((*surf).x);
-		free((*surf).y);
-		free((*surf).z);
-		free(surf);
-	}
-
-	surf=(Surface*) calloc(1, sizeof(Surface));
-	(*out).data=surf;
-	(*out).samplerate=(*in).samplerate;
+	for (n=4; n < fft_size; n*=2);
+	fft_size=n;
+	ESWEEP_ASSERT(fft_size <= ESWEEP_MAX_SIZE, ERR_BAD_ARGUMENT);
 
 	/*
 	the x-vector is the frequency axis
 	the frequencies are spaced so that the spectra of the wavelets cross at -3dB
+	the y-vector is the period axis
 	*/
-	(*surf).xsize=(int) (log(f2/f1)/log(1+0.5/resolution)+0.5);
-	(*surf).x=(Real*) calloc((*surf).xsize, sizeof(Real));
-
-	/* the y-vector is the period axis */
-	(*surf).ysize=steps*periods;
-	(*surf).y=(Real*) calloc((*surf).ysize, sizeof(Real));
-
-	/* fill y array */
-	for (i=0;i<(*surf).ysize;i++) {
-		(*surf).y[i]=(Real) i/steps;
+	n=(int) (log(f2/f1)/log(1+0.5/resolution)+0.5);
+	if (esweep_sparseSurface(out, n > 0 ? n : 1, steps*periods) != ERR_OK) return ERR_MALLOC;
+	out->samplerate=in->samplerate;
+	surf=(Surface*) out->data;
+	for (i=0, freq=f1; i < surf->xsize; i++, freq=freq*(1+0.5/resolution)) surf->x[i]=freq;
+	for (i=0; i < surf->ysize; i++) surf->y[i]=(Real) i/steps;
+
+	/* the spectrum of the input, we need only the lower half */
+	ESWEEP_MALLOC(z, fft_size/2+1, sizeof(Complex), ERR_MALLOC);
+	ESWEEP_MALLOC(spectrum, fft_size/2+1, sizeof(Complex), ERR_MALLOC);
+	for (i=0; i < in->size; i++) {
+		if (i & 1) z[i/2].imag=((Real*) in->data)[i];
+		else z[i/2].real=((Real*) in->data)[i];
 	}
-
-	/* the z vector is the dependent part */
-	(*surf).z=(Real*) calloc((*surf).xsize*(*surf).ysize, sizeof(Real));
-
-	/* allocate temporary arrays */
-	wave=(Complex*) calloc(fft_size, sizeof(Complex));
-	wave_out=(Complex*) calloc(fft_size, sizeof(Complex));
-
-	/* set up fft table */
-	fft_table=fft_create_table(fft_size);
-
-	/* copy input to wave and fft it */
-	r2c(wave, (Wave*) (*in).data, (*in).size);
-	fft(wave, fft_table, fft_size, FFT_FORWARD);
-	dw=2*M_PI*(*in).samplerate/fft_size;
-	for (i=0, freq=f1;i<(*surf).xsize;i++, freq=freq*(1+0.5/resolution)) {
-		omega=2*M_PI*freq;
-
-		/* calculate the time constant of the gaussian window */
-		tau=2.35482*resolution/omega;
-
-		/*
-		the convolution is now the simple complex multiplication
-		of the FFTed input wave with the spectrum of the morlet wavelet.
-		The wavelet is shifted "resolution" periods of the actual frequency
-		towards positive times
-		*/
-		if (time_shift=='y') {
-			for (j=0;j<fft_size;j++) {
-				re=tau*exp(-((j*dw-omega)*(j*dw-omega))*tau*tau/4); /* magnitude of the wavelet spectrum */
-				im=-re*sin(j*dw*resolution/freq);
-				re=re*cos(j*dw*resolution/freq);
-
-				wave_out[j].real=re*wave[j].real-im*wave[j].imag;
-				wave_out[j].imag=im*wave[j].real+re*wave[j].imag;
-			}
-		} else {
-			for (j=0;j<fft_size;j++) {
-				re=tau*exp(-((j*dw-omega)*(j*dw-omega))*tau*tau/4); /* magnitude of the wavelet spectrum */
-
-				wave_out[j].real=re*wave[j].real;
-				wave_out[j].imag=re*wave[j].imag;
-			}
+	job.table=fft_create_table(fft_size/2);
+	twiddle=fft_create_real_table(fft_size);
+	fft_real(spectrum, z, job.table, twiddle, fft_size);
+	free(z);
+	free(twiddle);
+	free(job.table);
+
+	job.spectrum=spectrum;
+	job.surf=surf;
+	job.samplerate=in->samplerate;
+	job.fft_size=fft_size;
+	job.resolution=resolution;
+	job.steps=steps;
+	job.time_shift=time_shift;
+	job.table=fft_create_table(fft_size);
+	job.next=0;
+	job.err=ERR_OK;
+	pthread_mutex_init(&job.lock, NULL);
+
+	if (threads > surf->xsize) threads=surf->xsize;
+	if (threads <= 1) {
+		__esweep_cbsdWorker(&job);
+	} else {
+		ESWEEP_MALLOC(tid, threads, sizeof(pthread_t), ERR_MALLOC);
+		for (n=0; n < threads; n++) {
+			if (pthread_create(&tid[n], NULL, __esweep_cbsdWorker, &job) != 0) break;
 		}
-
-		/* now the inverse fourier transform */
-		fft(wave_out, fft_table, fft_size, FFT_BACKWARD);
-
-		/* the magnitude of wave_out is what we need */
-		step_width=(Real) (*in).samplerate/(steps*freq);
-		for (j=0;j<(*surf).ysize;j++) {
-			(*surf).z[j+i*(*surf).ysize]=2*hypot(wave_out[(int)(j*step_width+0.5)].real, wave_out[(int)(j*step_width+0.5)].imag)/fft_size;
-		}
-		(*surf).x[i]=freq;
+		/* if not all threads could be created, this thread takes part */
+		if (n < threads) __esweep_cbsdWorker(&job);
+		for (i=0; i < n; i++) pthread_join(tid[i], NULL);
+		free(tid);
 	}
 
-	free(wave);
-	free(wave_out);
-	free(fft_table);
-
+	pthread_mutex_destroy(&job.lock);
+	free(spectrum);
+	free(job.table);
+	ESWEEP_ASSERT(job.err == ERR_OK, job.err);
 	return ERR_OK;
 }
 
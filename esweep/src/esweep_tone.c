@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * src/esweep_tone.c:
+ * Tone analysis at arbitrary frequencies: harmonic and intermodulation distortion
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esweep_priv.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * The tones are evaluated with a bank of Goertzel filters, one 2nd order resonator per tone:
+ *
+ * 	s[i]=x[i]+2*cos(w)*s[i-1]-s[i-2]
+ *
+ * After the last sample, X(w)=exp(-i*w*(N-1))*(s[N-1]-exp(-i*w)*s[N-2]) is the DFT of the signal at w,
+ * w needs not to be a multiple of 2*pi/N. The signal is read once, and each sample updates the
+ * resonators of all tones; the states are kept in double precision and updated two tones at once with SSE2.
+ * The same pass sums up x and x^2 for THD+N.
+ *
+ * Without a window, the DFT is exact only if the signal has an integer number of periods of each tone,
+ * as the signals of esweep_generate() have. Otherwise the leakage of strong tones limits the dynamic range.
+ */
+
+typedef struct {
+	int n; /* number of tones, rounded up to a multiple of 2 */
+	double *coeff; /* 2*cos(w) */
+	double *s1;
+	double *s2;
+	double sum; /* sum of x */
+	double sqsum; /* sum of x^2 */
+} goertzel_bank;
+
+static int goertzel(goertzel_bank *bank, const esweep_object *in, const Real *freqs, int n) {
+	const Wave *x=(const Wave*) in->data;
+	double xi, sum=0.0, sqsum=0.0;
+	int i, k;
+
+	bank->n=(n+1) & ~1;
+	ESWEEP_MALLOC(bank->coeff, bank->n, sizeof(double), ERR_MALLOC);
+	ESWEEP_MALLOC(bank->s1, bank->n, sizeof(double), ERR_MALLOC);
+	ESWEEP_MALLOC(bank->s2, bank->n, sizeof(double), ERR_MALLOC);
+	for (k=0; k < n; k++) bank->coeff[k]=2*cos(2*M_PI*freqs[k]/in->samplerate);
+
+	for (i=0; i < in->size; i++) {
+		xi=x[i];
+		sum+=xi;
+		sqsum+=xi*xi;
+#if defined(__SSE2__)
+		{
+			__m128d vx=_mm_set1_pd(xi), s1, s2;
+			for (k=0; k < bank->n; k+=2) {
+				s1=_mm_loadu_pd(bank->s1+k);
+				s2=_mm_loadu_pd(bank->s2+k);
+				_mm_storeu_pd(bank->s2+k, s1);
+				_mm_storeu_pd(bank->s1+k, _mm_sub_pd(_mm_add_pd(vx, _mm_mul_pd(_mm_loadu_pd(bank->coeff+k), s1)), s2));
+			}
+		}
+#else
+		{
+			double s;
+			for (k=0; k < bank->n; k++) {
+				s=xi+bank->coeff[k]*bank->s1[k]-bank->s2[k];
+				bank->s2[k]=bank->s1[k];
+				bank->s1[k]=s;
+			}
+		}
+#endif
+	}
+	bank->sum=sum;
+	bank->sqsum=sqsum;
+	return ERR_OK;
+}
+
+/* amplitude and phase of the cosine at frequency f */
+static Polar goertzel_tone(const goertzel_bank *bank, int k, Real f, const esweep_object *in) {
+	double w=2*M_PI*f/in->samplerate, re, im, c, s;
+	Polar p;
+
+	re=bank->s1[k]-cos(w)*bank->s2[k];
+	im=sin(w)*bank->s2[k];
+	/* shift to the first sample */
+	c=cos(w*(in->size-1));
+	s=-sin(w*(in->size-1));
+	p.abs=sqrt(re*re+im*im)/in->size;
+	p.arg=atan2(im*c+re*s, re*c-im*s);
+	/* one sided, except at DC and Nyquist */
+	if (f > 0.0 && 2*f < in->samplerate) p.abs*=2;
+	return p;
+}
+
+static void goertzel_free(goertzel_bank *bank) {
+	free(bank->coeff);
+	free(bank->s1);
+	free(bank->s2);
+}
+
+int esweep_toneAnalyze(const esweep_object *in, const Real *freqs, int n, Polar *out) {
+	goertzel_bank bank;
+	int k;
+
+	ESWEEP_OBJ_NOTEMPTY(in, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(in->type == WAVE, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_ASSERT(freqs != NULL && out != NULL && n > 0, ERR_BAD_ARGUMENT);
+	for (k=0; k < n; k++) ESWEEP_ASSERT(freqs[k] >= 0.0 && 2*freqs[k] <= in->samplerate, ERR_BAD_ARGUMENT);
+
+	if (goertzel(&bank, in, freqs, n) != ERR_OK) return ERR_MALLOC;
+	for (k=0; k < n; k++) out[k]=goertzel_tone(&bank, k, freqs[k], in);
+	goertzel_free(&bank);
+	return ERR_OK;
+}
+
+int esweep_thd(const esweep_object *in, Real f0, int harmonics, Real *thd, Real *thdn, Polar *out) {
+	goertzel_bank bank;
+	Real *freqs;
+	Polar p;
+	double fund=0.0, dist=0.0, mean, total;
+	int k, n;
+
+	ESWEEP_OBJ_NOTEMPTY(in, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(in->type == WAVE, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_ASSERT(f0 > 0.0 && 2*f0 < in->samplerate, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(harmonics > 0, ERR_BAD_ARGUMENT);
+
+	/* the harmonics below Nyquist */
+	n=(int) ((0.5*in->samplerate-1e-9)/f0);
+	n=n < harmonics ? n : harmonics;
+	ESWEEP_MALLOC(freqs, n, sizeof(Real), ERR_MALLOC);
+	for (k=0; k < n; k++) freqs[k]=(k+1)*f0;
+
+	if (goertzel(&bank, in, freqs, n) != ERR_OK) {
+		free(freqs);
+		return ERR_MALLOC;
+	}
+	for (k=0; k < harmonics; k++) {
+		if (k < n) p=goertzel_tone(&bank, k, freqs[k], in);
+		else p.abs=p.arg=0.0;
+		if (k == 0) fund=p.abs*p.abs;
+		else dist+=p.abs*p.abs;
+		if (out != NULL) out[k]=p;
+	}
+
+	/* power of the signal without DC, and of the residual after removing the fundamental */
+	mean=bank.sum/in->size;
+	total=bank.sqsum/in->size-mean*mean;
+	if (thd != NULL) *thd=fund > 0.0 ? sqrt(dist/fund) : 0.0;
+	if (thdn != NULL) *thdn=total > 0.0 && total > 0.5*fund ? sqrt((total-0.5*fund)/total) : 0.0;
+
+	goertzel_free(&bank);
+	free(freqs);
+	return ERR_OK;
+}
+
+int esweep_imd(const esweep_object *in, Real f1, Real f2, int order, Real *imd) {
+	goertzel_bank bank;
+	Real *freqs, f;
+	double ref, dist=0.0;
+	Polar p;
+	int m, k, j, n=0, max_n;
+
+	ESWEEP_OBJ_NOTEMPTY(in, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(in->type == WAVE, ERR_NOT_ON_THIS_TYPE);
+	ESWEEP_ASSERT(f1 > 0.0 && 2*f1 < in->samplerate, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(f2 > 0.0 && 2*f2 < in->samplerate && f1 != f2, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(order >= 2, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(imd != NULL, ERR_BAD_ARGUMENT);
+
+	/* f2 and the products |m*f2+k*f1|, m, k != 0, |m|+|k| <= order */
+	max_n=1+2*order*order;
+	ESWEEP_MALLOC(freqs, max_n, sizeof(Real), ERR_MALLOC);
+	freqs[n++]=f2;
+	for (m=1; m < order; m++) {
+		for (k=-(order-m); k <= order-m; k++) {
+			if (k == 0) continue;
+			f=fabs(m*f2+k*f1);
+			if (f <= 0.0 || 2*f >= in->samplerate) continue;
+			if (fabs(f-f1) < 1e-6*f1 || fabs(f-f2) < 1e-6*f2) continue;
+			/* each product only once */
+			for (j=1; j < n && fabs(freqs[j]-f) >= 1e-6*f; j++);
+			if (j == n) freqs[n++]=f;
+		}
+	}
+
+	if (goertzel(&bank, in, freqs, n) != ERR_OK) {
+		free(freqs);
+		return ERR_MALLOC;
+	}
+	p=goertzel_tone(&bank, 0, f2, in);
+	ref=p.abs*p.abs;
+	for (j=1; j < n; j++) {
+		p=goertzel_tone(&bank, j, freqs[j], in);
+		dist+=p.abs*p.abs;
+	}
+	*imd=ref > 0.0 ? sqrt(dist/ref) : 0.0;
+
+	goertzel_free(&bank);
+	free(freqs);
+	return ERR_OK;
+}
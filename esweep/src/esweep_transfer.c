@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * src/esweep_transfer.c:
+ * Streaming dual channel transfer function and coherence (H1/H2) estimator
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esweep_priv.h"
+#include "fft.h"
+
+/*
+ * The reference x and the measurement channels y are buffered like in esweep_spectrum.c. Whenever a frame is
+ * complete, the reference is transformed once and the auto and cross spectra
+ *
+ * Gxx=|X|^2, Gyy=|Y|^2, Gxy=conj(X)*Y
+ *
+ * of all channels are averaged in place. The estimators only need these averages:
+ *
+ * H1=Gxy/Gxx, H2=Gyy/conj(Gxy), coherence=|Gxy|^2/(Gxx*Gyy)
+ *
+ * The window gain cancels in all of them, so the averages are not scaled.
+ */
+
+#define TRANSFER_LINEAR 0
+#define TRANSFER_EXPONENTIAL 1
+
+struct __esweep_transfer {
+	int samplerate;
+	int size; /* N, power of 2 */
+	int hop;
+	int bins; /* N/2+1 */
+	int channels;
+	int average;
+	Real alpha; /* weight of a new frame with exponential averaging */
+	Real *win;
+	Real *hist_x; /* reference input buffer */
+	Real *hist_y; /* measurement input buffers, channels*size */
+	int fill;
+	int frames; /* frames since the last reset */
+	double *gxx; /* averaged auto spectrum of the reference */
+	double *gyy; /* averaged auto spectra of the channels, channels*bins */
+	Complex *gxy; /* averaged cross spectra, channels*bins */
+	Complex *buf;
+	Complex *X; /* spectrum of the reference frame */
+	Complex *Y;
+	Complex *twiddle;
+	Complex *table;
+};
+
+static void __esweep_transferFFT(esweep_transfer *tf, const Real *h, Complex *out) {
+	Complex *Z=tf->buf;
+	Real *w=tf->win;
+	int k, half=tf->size/2;
+
+	for (k=0; k < half; k++) {
+		Z[k].real=w[2*k]*h[2*k];
+		Z[k].imag=w[2*k+1]*h[2*k+1];
+	}
+	fft_real(out, Z, tf->table, tf->twiddle, tf->size);
+}
+
+static void __esweep_transferFrame(esweep_transfer *tf) {
+	Complex *X=tf->X, *Y=tf->Y, *gxy;
+	double *gyy, q, p, re, im;
+	int k, c;
+
+	tf->frames++;
+	if (tf->average == TRANSFER_EXPONENTIAL && tf->frames > 1) q=tf->alpha;
+	else q=1.0/tf->frames; /* the first frame always initializes the average */
+
+	__esweep_transferFFT(tf, tf->hist_x, X);
+	for (k=0; k < tf->bins; k++) {
+		p=X[k].real*X[k].real+X[k].imag*X[k].imag;
+		tf->gxx[k]+=q*(p-tf->gxx[k]);
+	}
+
+	for (c=0; c < tf->channels; c++) {
+		__esweep_transferFFT(tf, tf->hist_y+c*tf->size, Y);
+		gyy=tf->gyy+c*tf->bins;
+		gxy=tf->gxy+c*tf->bins;
+		for (k=0; k < tf->bins; k++) {
+			p=Y[k].real*Y[k].real+Y[k].imag*Y[k].imag;
+			gyy[k]+=q*(p-gyy[k]);
+			/* conj(X)*Y */
+			re=X[k].real*Y[k].real+X[k].imag*Y[k].imag;
+			im=X[k].real*Y[k].imag-X[k].imag*Y[k].real;
+			gxy[k].real+=q*(re-gxy[k].real);
+			gxy[k].imag+=q*(im-gxy[k].imag);
+		}
+	}
+}
+
+/* copy n samples of a WAVE or the real part of a COMPLEX object */
+static void __esweep_transferCopy(Real *dst, const esweep_object *obj, int offset, int n) {
+	Complex *cpx=(Complex*) obj->data;
+	int i;
+
+	if (obj->type == WAVE) memcpy(dst, (Wave*) obj->data+offset, n*sizeof(Wave));
+	else for (i=0; i < n; i++) dst[i]=cpx[offset+i].real;
+}
+
+esweep_transfer *esweep_transferCreate(int samplerate, int size, Real overlap, const char *win_name, int channels, const char *average, Real tau) {
+	esweep_transfer *tf;
+	int i, win_type=WIN_HANN, avg_type=TRANSFER_LINEAR;
+	Real win_param=0.0;
+
+	ESWEEP_ASSERT(samplerate > 0, NULL);
+	ESWEEP_ASSERT(size >= 4 && size <= ESWEEP_MAX_SIZE && (size & (size-1)) == 0, NULL);
+	ESWEEP_ASSERT(overlap >= 0.0 && overlap < 100.0, NULL);
+	ESWEEP_ASSERT(channels > 0, NULL);
+
+	if (win_name != NULL) {
+		win_type=window_parse(win_name, &win_param);
+		ESWEEP_ASSERT(win_type != WIN_NOWIN, NULL);
+	}
+	if (average != NULL) {
+		avg_type=-1;
+		if (strcmp("linear", average)==0) avg_type=TRANSFER_LINEAR;
+		if (strcmp("exponential", average)==0) avg_type=TRANSFER_EXPONENTIAL;
+		ESWEEP_ASSERT(avg_type >= 0, NULL);
+	}
+	ESWEEP_ASSERT(avg_type != TRANSFER_EXPONENTIAL || tau > 0.0, NULL);
+
+	ESWEEP_MALLOC(tf, 1, sizeof(esweep_transfer), NULL);
+	tf->average=avg_type;
+	tf->samplerate=samplerate;
+	tf->size=size;
+	tf->channels=channels;
+	tf->hop=(int) (size*(1.0-overlap/100.0)+0.5);
+	if (tf->hop < 1) tf->hop=1;
+	tf->bins=size/2+1;
+	tf->alpha=tf->average == TRANSFER_EXPONENTIAL ? 1.0-exp(-tf->hop/(tau*samplerate)) : 0.0;
+
+	ESWEEP_MALLOC(tf->win, size, sizeof(Real), NULL);
+	ESWEEP_MALLOC(tf->hist_x, size, sizeof(Real), NULL);
+	ESWEEP_MALLOC(tf->hist_y, channels*size, sizeof(Real), NULL);
+	ESWEEP_MALLOC(tf->gxx, tf->bins, sizeof(double), NULL);
+	ESWEEP_MALLOC(tf->gyy, channels*tf->bins, sizeof(double), NULL);
+	ESWEEP_MALLOC(tf->gxy, channels*tf->bins, sizeof(Complex), NULL);
+	ESWEEP_MALLOC(tf->buf, size/2, sizeof(Complex), NULL);
+	ESWEEP_MALLOC(tf->X, tf->bins, sizeof(Complex), NULL);
+	ESWEEP_MALLOC(tf->Y, tf->bins, sizeof(Complex), NULL);
+	tf->twiddle=fft_create_real_table(size);
+	tf->table=fft_create_table(size/2);
+
+	for (i=0; i < size; i++) tf->win[i]=1.0;
+	window_ext(tf->win, 0, size/2, WIN_LEFT, win_type, win_param);
+	window_ext(tf->win, size/2, size, WIN_RIGHT, win_type, win_param);
+	esweep_transferReset(tf);
+	return tf;
+}
+
+int esweep_transferInfo(const esweep_transfer *tf, int *size, int *hop, int *channels, int *frames) {
+	ESWEEP_ASSERT(tf != NULL, ERR_BAD_ARGUMENT);
+	if (size != NULL) *size=tf->size;
+	if (hop != NULL) *hop=tf->hop;
+	if (channels != NULL) *channels=tf->channels;
+	if (frames != NULL) *frames=tf->frames;
+	return ERR_OK;
+}
+
+int esweep_transferProcess(esweep_transfer *tf, const esweep_object *ref, const esweep_object *meas[]) {
+	int i, c, n, size;
+
+	ESWEEP_ASSERT(tf != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(meas != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_OBJ_NOTEMPTY(ref, ERR_EMPTY_OBJECT);
+	ESWEEP_ASSERT(ref->type == WAVE || ref->type == COMPLEX, ERR_NOT_ON_THIS_TYPE);
+	for (c=0; c < tf->channels; c++) {
+		ESWEEP_OBJ_NOTEMPTY(meas[c], ERR_EMPTY_OBJECT);
+		ESWEEP_ASSERT(meas[c]->type == WAVE || meas[c]->type == COMPLEX, ERR_NOT_ON_THIS_TYPE);
+		/* the channels must be sample synchronous with the reference */
+		ESWEEP_ASSERT(meas[c]->size == ref->size, ERR_SIZE_MISMATCH);
+	}
+
+	size=tf->size;
+	for (i=0; i < ref->size; ) {
+		n=size-tf->fill;
+		if (n > ref->size-i) n=ref->size-i;
+		__esweep_transferCopy(tf->hist_x+tf->fill, ref, i, n);
+		for (c=0; c < tf->channels; c++) __esweep_transferCopy(tf->hist_y+c*size+tf->fill, meas[c], i, n);
+		tf->fill+=n;
+		i+=n;
+		if (tf->fill == size) {
+			__esweep_transferFrame(tf);
+			memmove(tf->hist_x, tf->hist_x+tf->hop, (size-tf->hop)*sizeof(Real));
+			for (c=0; c < tf->channels; c++) memmove(tf->hist_y+c*size, tf->hist_y+c*size+tf->hop, (size-tf->hop)*sizeof(Real));
+			tf->fill=size-tf->hop;
+		}
+	}
+	return ERR_OK;
+}
+
+int esweep_transferRead(const esweep_transfer *tf, int channel, esweep_object *out, const char *mode, int *frames) {
+	Complex *cpx, *gxy;
+	Polar *polar;
+	double *gyy, d;
+	int k, N, type;
+
+	ESWEEP_ASSERT(tf != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(channel >= 0 && channel < tf->channels, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(out != NULL, ERR_OBJ_IS_NULL);
+	ESWEEP_ASSERT(mode != NULL, ERR_BAD_ARGUMENT);
+	ESWEEP_ASSERT(strcmp(mode, "h1") == 0 || strcmp(mode, "h2") == 0 || strcmp(mode, "coherence") == 0, ERR_BAD_ARGUMENT);
+
+	N=tf->size;
+	type=strcmp(mode, "coherence") == 0 ? POLAR : COMPLEX;
+	/* the output is only reallocated when it does not have the right type and size already */
+	if (out->type != type || out->size != N || out->data == NULL) {
+		__esweep_freeData(out->data);
+		out->data=NULL;
+		out->type=type;
+		out->size=N;
+		ESWEEP_MALLOC(out->data, N, sizeof(Complex), ERR_MALLOC); /* sizeof(Polar) is the same */
+	}
+	out->samplerate=tf->samplerate;
+
+	gyy=tf->gyy+channel*tf->bins;
+	gxy=tf->gxy+channel*tf->bins;
+	/* bins without excitation or without response are set to 0 */
+	if (type == POLAR) {
+		polar=(Polar*) out->data;
+		for (k=0; k < tf->bins; k++) {
+			d=tf->gxx[k]*gyy[k];
+			polar[k].abs=d > 0.0 ? (gxy[k].real*gxy[k].real+gxy[k].imag*gxy[k].imag)/d : 0.0;
+			polar[k].arg=0.0;
+		}
+		for (k=1; k < N/2; k++) polar[N-k]=polar[k];
+	} else {
+		cpx=(Complex*) out->data;
+		if (strcmp(mode, "h1") == 0) {
+			for (k=0; k < tf->bins; k++) {
+				d=tf->gxx[k];
+				cpx[k].real=d > 0.0 ? gxy[k].real/d : 0.0;
+				cpx[k].imag=d > 0.0 ? gxy[k].imag/d : 0.0;
+			}
+		} else {
+			/* Gyy/conj(Gxy)=Gyy*Gxy/|Gxy|^2 */
+			for (k=0; k < tf->bins; k++) {
+				d=gxy[k].real*gxy[k].real+gxy[k].imag*gxy[k].imag;
+				cpx[k].real=d > 0.0 ? gyy[k]*gxy[k].real/d : 0.0;
+				cpx[k].imag=d > 0.0 ? gyy[k]*gxy[k].imag/d : 0.0;
+			}
+		}
+		/* the transfer function of a real system is hermitian */
+		for (k=1; k < N/2; k++) {
+			cpx[N-k].real=cpx[k].real;
+			cpx[N-k].imag=-cpx[k].imag;
+		}
+	}
+
+	if (frames != NULL) *frames=tf->frames;
+	return ERR_OK;
+}
+
+int esweep_transferReset(esweep_transfer *tf) {
+	ESWEEP_ASSERT(tf != NULL, ERR_BAD_ARGUMENT);
+	memset(tf->hist_x, 0, tf->size*sizeof(Real));
+	memset(tf->hist_y, 0, tf->channels*tf->size*sizeof(Real));
+	memset(tf->gxx, 0, tf->bins*sizeof(double));
+	memset(tf->gyy, 0, tf->channels*tf->bins*sizeof(double));
+	memset(tf->gxy, 0, tf->channels*tf->bins*sizeof(Complex));
+	tf->fill=0;
+	tf->frames=0;
+	return ERR_OK;
+}
+
+int esweep_transferFree(esweep_transfer *tf) {
+	ESWEEP_ASSERT(tf != NULL, ERR_BAD_ARGUMENT);
+	free(tf->win);
+	free(tf->hist_x);
+	free(tf->hist_y);
+	free(tf->gxx);
+	free(tf->gyy);
+	free(tf->gxy);
+	free(tf->buf);
+	free(tf->X);
+	free(tf->Y);
+	free(tf->twiddle);
+	free(tf->table);
+	free(tf);
+	return ERR_OK;
+}
@@ -441,7 +441,7 @@ static int readChannel(esweep_object *wave, void *chunk, int ch, int channels, i
 		if (wave->type!=WAVE) return ERR_NOT_ON_THIS_TYPE;
 		wave->samplerate=samplerate;
 		if (wave->data!=NULL) {
-			free(wave->data);
+			__esweep_freeData(wave->data);
 		}
 		w=(Wave*) calloc(samples, sizeof(Wave));
 		wave->data=w;
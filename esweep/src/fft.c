@@ -24,10 +24,15 @@
  * */
 
 #include <math.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
+#if defined(__SSE2__) && !defined(REAL32)
+#include <emmintrin.h>
+#endif
+
 #include "esweep.h"
 #include "dsp.h"
 #include "fft.h"
@@ -260,65 +265,144 @@ Complex *fft_create_table(int input_size) {
 	return table;
 }
 
-/* see literature */
+/*
+ * The even samples are the real part, the odd samples the imaginary part of z. With Z=FFT(z):
+ * X[k]=(Z[k]+conj(Z[N/2-k]))/2 - i*W^k*(Z[k]-conj(Z[N/2-k]))/2, W=exp(-2*pi*i/N)
+ */
+void fft_real(Complex *X, Complex *z, Complex *table, Complex *twiddle, u_int size) {
+	u_int k, half=size/2;
+	Complex a, b;
 
-void window(Real *data, int start, int stop, int dir, int type) {
-	Real alpha;
-	Real beta;
-	Real mu;
-	Real eta;
+	fft(z, table, half, FFT_FORWARD);
+
+	/* DC and Nyquist */
+	X[0].real=z[0].real+z[0].imag;
+	X[0].imag=0.0;
+	X[half].real=z[0].real-z[0].imag;
+	X[half].imag=0.0;
+	for (k=1; k < half; k++) {
+		a.real=0.5*(z[k].real+z[half-k].real); /* even part */
+		a.imag=0.5*(z[k].imag-z[half-k].imag);
+		b.real=0.5*(z[k].imag+z[half-k].imag); /* odd part */
+		b.imag=-0.5*(z[k].real-z[half-k].real);
+		X[k].real=a.real+twiddle[k].real*b.real-twiddle[k].imag*b.imag;
+		X[k].imag=a.imag+twiddle[k].real*b.imag+twiddle[k].imag*b.real;
+	}
+}
+
+void fft_real_inverse(Complex *z, Complex *X, Complex *table, Complex *twiddle, u_int size) {
+	u_int k, half=size/2;
+	Complex a, b;
+
+	for (k=0; k < half; k++) {
+		a.real=X[k].real+X[half-k].real; /* even part */
+		a.imag=X[k].imag-X[half-k].imag;
+		b.real=X[k].real-X[half-k].real; /* odd part, times exp(2*pi*i*k/N) */
+		b.imag=X[k].imag+X[half-k].imag;
+		z[k].real=a.real-(twiddle[k].real*b.imag-twiddle[k].imag*b.real);
+		z[k].imag=a.imag+twiddle[k].real*b.real+twiddle[k].imag*b.imag;
+	}
+
+	fft(z, table, half, FFT_BACKWARD);
+}
+
+Complex *fft_create_real_table(int size) {
 	int i;
+	Complex *table=(Complex*) calloc(size/2, sizeof(Complex));
+
+	for (i=0;i<size/2;i++) {
+		table[i].real=cos(2*M_PI*i/size);
+		table[i].imag=-sin(2*M_PI*i/size);
+	}
+	return table;
+}
+
+int window_parse(const char *name, Real *param) {
+	const char *colon=strchr(name, ':');
+	size_t len=colon != NULL ? (size_t) (colon-name) : strlen(name);
+	char *end;
+	Real p;
+	int type=WIN_NOWIN;
+
+	if (len == 4 && strncmp("rect", name, len)==0) type=WIN_RECT;
+	else if (len == 8 && strncmp("bartlett", name, len)==0) type=WIN_BART;
+	else if (len == 4 && strncmp("hann", name, len)==0) type=WIN_HANN;
+	else if (len == 7 && strncmp("hamming", name, len)==0) type=WIN_HAMM;
+	else if (len == 8 && strncmp("blackman", name, len)==0) type=WIN_BLACK;
+	else if (len == 14 && strncmp("blackmanharris", name, len)==0) type=WIN_BHARRIS;
+	else if (len == 7 && strncmp("flattop", name, len)==0) type=WIN_FLATTOP;
+	else if (len == 6 && strncmp("kaiser", name, len)==0) type=WIN_KAISER;
+	else if (len == 5 && strncmp("tukey", name, len)==0) type=WIN_TUKEY;
+	else if (len == 5 && strncmp("gauss", name, len)==0) type=WIN_GAUSS;
+	if (type == WIN_NOWIN) return WIN_NOWIN;
+
+	p=window_default_param(type);
+	if (colon != NULL) {
+		/* only the parametric windows take a parameter */
+		if (type != WIN_KAISER && type != WIN_TUKEY && type != WIN_GAUSS) return WIN_NOWIN;
+		p=strtod(colon+1, &end);
+		if (end == colon+1 || *end != '\0') return WIN_NOWIN;
+		if (type == WIN_KAISER && p < 0.0) return WIN_NOWIN;
+		if (type == WIN_TUKEY && (p <= 0.0 || p > 1.0)) return WIN_NOWIN;
+		if (type == WIN_GAUSS && p <= 0.0) return WIN_NOWIN;
+	}
+	if (param != NULL) *param=p;
+	return type;
+}
+
+int window_type(const char *name) {
+	return window_parse(name, NULL);
+}
+
+Real window_default_param(int type) {
 	switch (type) {
-		case WIN_BART:
-			alpha=1.0;
-			beta=-1.0;
-			mu=0.0;
-			eta=0.0;
-			break;
-			
-		case WIN_HANN:
-			alpha=0.5;
-			beta=0.0;
-			mu=0.5;
-			eta=0.0;
-			break;
-		
-		case WIN_HAMM:
-			alpha=0.54;
-			beta=0.0;
-			mu=0.46;
-			eta=0.0;
-			break;
-			
-		case WIN_BLACK:
-			alpha=0.42;
-			beta=0.0;
-			mu=0.5;
-			eta=0.08;
-			break;
-			
-			case WIN_NOWIN: /* FALLTHROUGH */
-				case WIN_RECT: /* FALLTHROUGH */
+		case WIN_KAISER:
+			return 8.6; /* about the sidelobes of the Blackman window */
+		case WIN_TUKEY:
+			return 0.5;
+		case WIN_GAUSS:
+			return 0.4;
 		default:
-			alpha=1.0;
-			beta=0.0;
-			mu=0.0;
-			eta=0.0;
-			break;	
+			return 0.0;
 	}
-	
-	if (dir==WIN_LEFT) {
-		for (i=start;i<stop;i++) {
-			data[i]*=(alpha+beta*abs(i-stop-1)/(stop-start)+mu*cos(M_PI*(i-stop)/(stop-start))+eta*cos(2*M_PI*(i-stop)/(stop-start)));
-		}
-	} else {
-		for (i=start;i<stop;i++) {
-			data[i]*=(alpha+beta*abs(i-start)/(stop-start)+mu*cos(M_PI*(i-start)/((stop-start)))+eta*cos(2*M_PI*(i-start)/(stop-start)));
-		}
+}
+
+/* modified bessel function of the first kind and order 0, power series */
+static double window_bessel_i0(double x) {
+	double sum=1.0, term=1.0, q=0.25*x*x;
+	int k;
+
+	for (k=1; k < 500 && term > 1e-17*sum; k++) {
+		term*=q/((double) k*k);
+		sum+=term;
 	}
+	return sum;
 }
 
-void window_complex(Complex *data, int start, int stop, int dir, int type) {
+/*
+ * The value of the half window at the relative distance x from its peak, 0 <= x <= 1.
+ * The cosine sums are the usual full windows, centered at their peak.
+ */
+static Real window_value(int type, Real param, Real x) {
+	switch (type) {
+		case WIN_BHARRIS:
+			return 0.35875+0.48829*cos(M_PI*x)+0.14128*cos(2*M_PI*x)+0.01168*cos(3*M_PI*x);
+		case WIN_FLATTOP:
+			return 0.21557895+0.41663158*cos(M_PI*x)+0.277263158*cos(2*M_PI*x)
+				+0.083578947*cos(3*M_PI*x)+0.006947368*cos(4*M_PI*x);
+		case WIN_KAISER:
+			return window_bessel_i0(param*sqrt(1.0-x*x > 0.0 ? 1.0-x*x : 0.0))/window_bessel_i0(param);
+		case WIN_TUKEY:
+			return x <= 1.0-param ? 1.0 : 0.5+0.5*cos(M_PI*(x-1.0+param)/param);
+		case WIN_GAUSS:
+			return exp(-0.5*(x/param)*(x/param));
+		default:
+			return 1.0;
+	}
+}
+
+/* see literature; the values from..from+n-1 of the window with size values */
+static void window_fill(Real *w, int from, int n, int size, int dir, int type, Real param) {
 	Real alpha;
 	Real beta;
 	Real mu;
@@ -352,6 +436,16 @@ void window_complex(Complex *data, int start, int stop, int dir, int type) {
 			mu=0.5;
 			eta=0.08;
 			break;
+
+		case WIN_BHARRIS:
+		case WIN_FLATTOP:
+		case WIN_KAISER:
+		case WIN_TUKEY:
+		case WIN_GAUSS:
+			for (i=from; i < from+n; i++) {
+				w[i-from]=window_value(type, param, dir == WIN_LEFT ? (Real) (size-i)/size : (Real) i/size);
+			}
+			return;
 			
 			case WIN_NOWIN: /* FALLTHROUGH */
 				case WIN_RECT: /* FALLTHROUGH */
@@ -364,14 +458,187 @@ void window_complex(Complex *data, int start, int stop, int dir, int type) {
 	}
 	
 	if (dir==WIN_LEFT) {
-		for (i=start;i<stop;i++) {
-			data[i].real*=(alpha+beta*abs(i-stop-1)/(stop-start)+mu*cos(M_PI*(i-stop)/(stop-start))+eta*cos(2*M_PI*(i-stop)/(stop-start)));
-			data[i].imag*=(alpha+beta*abs(i-stop-1)/(stop-start)+mu*cos(M_PI*(i-stop)/(stop-start))+eta*cos(2*M_PI*(i-stop)/(stop-start)));
+		for (i=from;i<from+n;i++) {
+			w[i-from]=(alpha+beta*abs(i-size-1)/size+mu*cos(M_PI*(i-size)/size)+eta*cos(2*M_PI*(i-size)/size));
 		}
 	} else {
-		for (i=start;i<stop;i++) {
-			data[i].real*=(alpha+beta*abs(i-start)/(stop-start)+mu*cos(M_PI*(i-start)/((stop-start)))+eta*cos(2*M_PI*(i-start)/(stop-start)));
-			data[i].imag*=(alpha+beta*abs(i-start)/(stop-start)+mu*cos(M_PI*(i-start)/((stop-start)))+eta*cos(2*M_PI*(i-start)/(stop-start)));
+		for (i=from;i<from+n;i++) {
+			w[i-from]=(alpha+beta*abs(i)/size+mu*cos(M_PI*i/size)+eta*cos(2*M_PI*i/size));
+		}
+	}
+}
+
+/*
+ * Cache of the window tables. The windows only depend on the type, the parameter, the direction and the
+ * length, so the same tables are used again and again by the analyzers. A table is reference counted
+ * while it is applied, the least recently used unreferenced tables beyond WINDOW_CACHE_BYTES are freed.
+ * Windows larger than the cache, or without memory for a table, are computed in blocks on the stack.
+ */
+
+#define WINDOW_CACHE_BYTES 0x00400000 /* 4 MB */
+#define WINDOW_BLOCK 256
+
+typedef struct __window_table {
+	int type;
+	int dir;
+	int size;
+	Real param;
+	Real *w;
+	int refs;
+	struct __window_table *next;
+} window_table;
+
+static window_table *window_cache=NULL;
+static pthread_mutex_t window_lock=PTHREAD_MUTEX_INITIALIZER;
+
+/* NULL if the window is not cached */
+static window_table *window_get(int size, int dir, int type, Real param) {
+	window_table *table, **p;
+	size_t n;
+
+	pthread_mutex_lock(&window_lock);
+	for (p=&window_cache; *p != NULL; p=&(*p)->next) {
+		table=*p;
+		if (table->type == type && table->dir == dir && table->size == size && table->param == param) {
+			/* move to the front */
+			*p=table->next;
+			table->next=window_cache;
+			window_cache=table;
+			table->refs++;
+			pthread_mutex_unlock(&window_lock);
+			return table;
 		}
 	}
+	pthread_mutex_unlock(&window_lock);
+
+	if ((size_t) size*sizeof(Real) > WINDOW_CACHE_BYTES) return NULL;
+	if ((table=(window_table*) calloc(1, sizeof(window_table))) == NULL) return NULL;
+	if ((table->w=(Real*) malloc(size*sizeof(Real))) == NULL) {
+		free(table);
+		return NULL;
+	}
+	table->type=type;
+	table->dir=dir;
+	table->size=size;
+	table->param=param;
+	table->refs=1;
+	window_fill(table->w, 0, size, size, dir, type, param);
+
+	pthread_mutex_lock(&window_lock);
+	table->next=window_cache;
+	window_cache=table;
+	/* free the unreferenced tables beyond the cache size, the least recently used are at the end */
+	for (p=&window_cache, n=0; *p != NULL; ) {
+		n+=(*p)->size*sizeof(Real);
+		if (n > WINDOW_CACHE_BYTES && (*p)->refs == 0) {
+			table=*p;
+			*p=table->next;
+			free(table->w);
+			free(table);
+		} else {
+			p=&(*p)->next;
+		}
+	}
+	table=window_cache;
+	pthread_mutex_unlock(&window_lock);
+	return table;
+}
+
+static void window_release(window_table *table) {
+	pthread_mutex_lock(&window_lock);
+	table->refs--;
+	pthread_mutex_unlock(&window_lock);
+}
+
+static void window_apply(Real *data, const Real *w, int size) {
+	int i=0;
+
+#if defined(__SSE2__) && !defined(REAL32)
+	for (; i+1 < size; i+=2) {
+		_mm_storeu_pd(data+i, _mm_mul_pd(_mm_loadu_pd(data+i), _mm_loadu_pd(w+i)));
+	}
+#endif
+	for (; i < size; i++) data[i]*=w[i];
+}
+
+static void window_apply_complex(Complex *data, const Real *w, int size) {
+	int i;
+
+#if defined(__SSE2__) && !defined(REAL32)
+	/* real and imaginary part with the same factor */
+	for (i=0; i < size; i++) {
+		_mm_storeu_pd((double*) (data+i), _mm_mul_pd(_mm_loadu_pd((double*) (data+i)), _mm_set1_pd(w[i])));
+	}
+#else
+	for (i=0; i < size; i++) {
+		data[i].real*=w[i];
+		data[i].imag*=w[i];
+	}
+#endif
+}
+
+void window_ext(Real *data, int start, int stop, int dir, int type, Real param) {
+	window_table *table;
+	Real w[WINDOW_BLOCK];
+	int i, n, size=stop-start;
+
+	if (size <= 0) return;
+	data+=start;
+	if ((table=window_get(size, dir, type, param)) != NULL) {
+		window_apply(data, table->w, size);
+		window_release(table);
+		return;
+	}
+	for (i=0; i < size; i+=n) {
+		n=size-i < WINDOW_BLOCK ? size-i : WINDOW_BLOCK;
+		window_fill(w, i, n, size, dir, type, param);
+		window_apply(data+i, w, n);
+	}
+}
+
+void window_complex_ext(Complex *data, int start, int stop, int dir, int type, Real param) {
+	window_table *table;
+	Real w[WINDOW_BLOCK];
+	int i, n, size=stop-start;
+
+	if (size <= 0) return;
+	data+=start;
+	if ((table=window_get(size, dir, type, param)) != NULL) {
+		window_apply_complex(data, table->w, size);
+		window_release(table);
+		return;
+	}
+	for (i=0; i < size; i+=n) {
+		n=size-i < WINDOW_BLOCK ? size-i : WINDOW_BLOCK;
+		window_fill(w, i, n, size, dir, type, param);
+		window_apply_complex(data+i, w, n);
+	}
+}
+
+void window(Real *data, int start, int stop, int dir, int type) {
+	window_ext(data, start, stop, dir, type, window_default_param(type));
+}
+
+void window_complex(Complex *data, int start, int stop, int dir, int type) {
+	window_complex_ext(data, start, stop, dir, type, window_default_param(type));
+}
+
+int window_gains(int type, Real param, int size, Real *coherent_gain, Real *enbw) {
+	Real *w;
+	double sum=0.0, sqsum=0.0;
+	int i;
+
+	if (size < 2 || (w=(Real*) malloc(size*sizeof(Real))) == NULL) return -1;
+	/* the symmetric window of the analyzers, left half and right half */
+	for (i=0; i < size; i++) w[i]=1.0;
+	window_ext(w, 0, size/2, WIN_LEFT, type, param);
+	window_ext(w, size/2, size, WIN_RIGHT, type, param);
+	for (i=0; i < size; i++) {
+		sum+=w[i];
+		sqsum+=w[i]*w[i];
+	}
+	free(w);
+	if (coherent_gain != NULL) *coherent_gain=sum/size;
+	if (enbw != NULL) *enbw=sum > 0.0 ? size*sqsum/(sum*sum) : 0.0;
+	return 0;
 }
@@ -43,9 +43,15 @@ enum Window {
 	WIN_BART,
 	WIN_HANN,
 	WIN_HAMM,
-	WIN_BLACK
+	WIN_BLACK,
+	WIN_BHARRIS, /* 4 term Blackman-Harris */
+	WIN_FLATTOP,
+	WIN_KAISER, /* parameter beta */
+	WIN_TUKEY, /* parameter: tapered fraction of the half window */
+	WIN_GAUSS /* parameter: standard deviation relative to the half window */
 };
 
+
 /*
  * in-place FFT
 */
@@ -63,6 +69,23 @@ void fft_rc(Complex *output, Wave *input, Complex *table, u_int input_size, u_in
 /* create a coefficient lookup table for fft() */
 Complex *fft_create_table(int input_size);
 
+/*
+ * FFT of a real signal of size N with a complex FFT of size N/2
+ * z: N/2 elements, z[k]=x[2k]+i*x[2k+1] on input, destroyed on output
+ * X: N/2+1 elements, the spectrum from DC to Nyquist
+ * table: fft_create_table(N/2), twiddle: fft_create_real_table(N)
+ */
+void fft_real(Complex *X, Complex *z, Complex *table, Complex *twiddle, u_int size);
+
+/*
+ * inverse of fft_real(), X: N/2+1 elements of a hermitian spectrum, preserved
+ * z: N/2 elements, z[k]=N*(x[2k]+i*x[2k+1]) on output, i. e. unnormalized like fft() with FFT_BACKWARD
+ */
+void fft_real_inverse(Complex *z, Complex *X, Complex *table, Complex *twiddle, u_int size);
+
+/* create the twiddle factors exp(-2*pi*i*k/N), k=0..N/2-1, for fft_real() and fft_real_inverse() */
+Complex *fft_create_real_table(int size);
+
 void smooth(Polar *polar, Real factor, int size); /* polar smoothing */
 
 /*
@@ -75,7 +98,33 @@ dir: left or rigth window
 
 */
 
+/*
+ * the window type for the names "rect", "bartlett", "hann", "hamming", "blackman", "blackmanharris", "flattop",
+ * "kaiser", "tukey" and "gauss", WIN_NOWIN if unknown. The last three may have a parameter, like "kaiser:6.5",
+ * which is stored in param (may be NULL), otherwise the default parameter.
+ */
+int window_parse(const char *name, Real *param);
+
+/* same as window_parse(), without returning the parameter */
+int window_type(const char *name);
+
+/* the parameter of the windows without an explicit one */
+Real window_default_param(int type);
+
 void window(Real *data, int start, int stop, int dir, int type);
 void window_complex(Complex *data, int start, int stop, int dir, int type);
 
+/*
+ * the same with a window parameter. The window tables are cached per type, parameter, direction and length,
+ * so applying the same window again only costs a multiplication per sample.
+ */
+void window_ext(Real *data, int start, int stop, int dir, int type, Real param);
+void window_complex_ext(Complex *data, int start, int stop, int dir, int type, Real param);
+
+/*
+ * coherent gain (mean of the window) and equivalent noise bandwidth in bins of the symmetric window of size N,
+ * the left half over N/2 samples and the right half over the rest. Returns 0, or -1 on error
+ */
+int window_gains(int type, Real param, int size, Real *coherent_gain, Real *enbw);
+
 #endif /* FFT_H */
@@ -0,0 +1,438 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * Element-wise arithmetic kernels, see vmath.h
+ *
+ * The scalar kernels expand the ESWEEP_MATH_* macros, the SIMD kernels
+ * are generated from vmath_simd.h for SSE2 and AVX2. On x86 both are compiled
+ * with a target attribute, so they are available regardless of the build
+ * flags, and the best one the CPU supports is selected on the first call.
+ * No FMA is used, the results of all versions are identical.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esweep_priv.h"
+#include "vmath.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) && !defined(REAL32)
+	#define VMATH_X86 1
+	#include <immintrin.h>
+#endif
+
+typedef struct {
+	const char *isa;
+	void (*rr[4])(Real*, const Real*, int);
+	void (*rp[4])(Real*, Real, Real, int);
+	/* only mul and div, add and sub are done with rr and rp */
+	void (*cc[2])(Complex*, const Complex*, int);
+	void (*cs[2])(Complex*, Complex, int);
+	void (*cr[4])(Complex*, const Real*, int);
+	void (*pp[2])(Polar*, const Polar*, int);
+	void (*ps[2])(Polar*, Polar, int);
+	void (*pr[2])(Polar*, const Real*, int);
+	/* 1 if all n Reals are finite */
+	int (*finite)(const Real*, int);
+	void (*reduce)(const Real*, int, vmath_reduction*);
+} vmath_kernels;
+
+/* lane j of a reduction holds the elements j, j+VMATH_LANES, ... */
+typedef struct {
+	Real s[VMATH_LANES], q[VMATH_LANES];
+	Real mn[VMATH_LANES], mx[VMATH_LANES];
+} vmath_lanes;
+
+/* Reals per block for the non-finite check, small enough to stay in L1 */
+#define VMATH_BLOCK 2048
+
+#define VM_STR2(x) #x
+#define VM_STR(x) VM_STR2(x)
+
+/* scalar kernels */
+
+#define SCALAR_RR(op, expr) \
+static void rr_##op##_scalar(Real *a, const Real *b, int n) { \
+	int i; \
+	for (i=0; i < n; i++) a[i] expr b[i]; \
+}
+
+#define SCALAR_RP(op, expr) \
+static void rp_##op##_scalar(Real *a, Real p0, Real p1, int n) { \
+	int i; \
+	for (i=0; i+1 < n; i+=2) { \
+		a[i] expr p0; \
+		a[i+1] expr p1; \
+	} \
+	if (i < n) a[i] expr p0; \
+}
+
+/* type is CC, CR, PP or PR, suffix is the kernel name, idx is [i] for arrays or empty for a single b */
+#define SCALAR_XX(name, type, op, Ta, Tb, idx) \
+static void name##_scalar(Ta *a, Tb b, int n) { \
+	Real tmp, denom; \
+	int i; \
+	for (i=0; i < n; i++) { \
+		ESWEEP_MATH_##type##_##op(a[i], b idx); \
+	} \
+	(void) tmp; (void) denom; \
+}
+
+SCALAR_RR(add, +=)
+SCALAR_RR(sub, -=)
+SCALAR_RR(mul, *=)
+SCALAR_RR(div, /=)
+
+SCALAR_RP(add, +=)
+SCALAR_RP(sub, -=)
+SCALAR_RP(mul, *=)
+SCALAR_RP(div, /=)
+
+SCALAR_XX(cc_mul, CC, MUL, Complex, const Complex*, [i])
+SCALAR_XX(cc_div, CC, DIV, Complex, const Complex*, [i])
+SCALAR_XX(cs_mul, CC, MUL, Complex, Complex, )
+SCALAR_XX(cs_div, CC, DIV, Complex, Complex, )
+SCALAR_XX(cr_add, CR, ADD, Complex, const Real*, [i])
+SCALAR_XX(cr_sub, CR, SUB, Complex, const Real*, [i])
+SCALAR_XX(cr_mul, CR, MUL, Complex, const Real*, [i])
+SCALAR_XX(cr_div, CR, DIV, Complex, const Real*, [i])
+SCALAR_XX(pp_mul, PP, MUL, Polar, const Polar*, [i])
+SCALAR_XX(pp_div, PP, DIV, Polar, const Polar*, [i])
+SCALAR_XX(ps_mul, PP, MUL, Polar, Polar, )
+SCALAR_XX(ps_div, PP, DIV, Polar, Polar, )
+SCALAR_XX(pr_mul, PR, MUL, Polar, const Real*, [i])
+SCALAR_XX(pr_div, PR, DIV, Polar, const Real*, [i])
+
+static int finite_scalar(const Real *a, int n) {
+	int i, finite=1;
+	for (i=0; i < n; i++) finite&=isfinite(a[i]) != 0;
+	return finite;
+}
+
+/* adds the elements i...n-1 to their lanes */
+static void reduce_lanes(vmath_lanes *l, const Real *x, int i, int n) {
+	int j;
+	for (; i < n; i++) {
+		j=i%VMATH_LANES;
+		l->s[j]+=x[i];
+		l->q[j]+=x[i]*x[i];
+		if (x[i] < l->mn[j]) l->mn[j]=x[i];
+		if (x[i] > l->mx[j]) l->mx[j]=x[i];
+	}
+}
+
+static void reduce_init(vmath_lanes *l) {
+	int j;
+	for (j=0; j < VMATH_LANES; j++) {
+		l->s[j]=l->q[j]=0.0;
+		l->mn[j]=INFINITY;
+		l->mx[j]=-INFINITY;
+	}
+}
+
+static int find_scalar(const Real *x, int n, Real v) {
+	int i;
+	for (i=0; i < n; i++) if (x[i] == v) return i;
+	return -1;
+}
+
+/*
+ * Pairwise sum of the lanes. The positions of the minimum and maximum are searched afterwards,
+ * which is cheaper than tracking them, as x is still in the cache. Searching with == finds the first
+ * of equal values (also of -0 and 0) and never NaN; if there are only NaN, nothing is found.
+ */
+static void reduce_finish(const vmath_lanes *l, const Real *x, int n, vmath_reduction *r, int (*find)(const Real*, int, Real)) {
+	Real s[VMATH_LANES], q[VMATH_LANES], mn, mx;
+	int j, k;
+
+	memcpy(s, l->s, sizeof(s));
+	memcpy(q, l->q, sizeof(q));
+	for (k=VMATH_LANES/2; k > 0; k/=2) {
+		for (j=0; j < k; j++) {
+			s[j]+=s[j+k];
+			q[j]+=q[j+k];
+		}
+	}
+	r->sum=s[0];
+	r->sqsum=q[0];
+
+	for (mn=l->mn[0], mx=l->mx[0], j=1; j < VMATH_LANES; j++) {
+		if (l->mn[j] < mn) mn=l->mn[j];
+		if (l->mx[j] > mx) mx=l->mx[j];
+	}
+	r->imin=find(x, n, mn);
+	r->imax=find(x, n, mx);
+	r->min=r->imin >= 0 ? x[r->imin] : NAN;
+	r->max=r->imax >= 0 ? x[r->imax] : NAN;
+}
+
+static void reduce_scalar(const Real *x, int n, vmath_reduction *r) {
+	vmath_lanes l;
+	reduce_init(&l);
+	reduce_lanes(&l, x, 0, n);
+	reduce_finish(&l, x, n, r, find_scalar);
+}
+
+static const vmath_kernels vmath_kernels_scalar = {
+	"scalar",
+	{rr_add_scalar, rr_sub_scalar, rr_mul_scalar, rr_div_scalar},
+	{rp_add_scalar, rp_sub_scalar, rp_mul_scalar, rp_div_scalar},
+	{cc_mul_scalar, cc_div_scalar},
+	{cs_mul_scalar, cs_div_scalar},
+	{cr_add_scalar, cr_sub_scalar, cr_mul_scalar, cr_div_scalar},
+	{pp_mul_scalar, pp_div_scalar},
+	{ps_mul_scalar, ps_div_scalar},
+	{pr_mul_scalar, pr_div_scalar},
+	finite_scalar,
+	reduce_scalar
+};
+
+#ifdef VMATH_X86
+
+/* non-finite numbers have all exponent bits set; integer compares never raise FP exceptions */
+#define VM_EXPONENT 0x7FF0000000000000LL
+
+static __attribute__((target("sse2"))) int finite_sse2(const Real *a, int n) {
+	const __m128i e=_mm_set1_epi64x(VM_EXPONENT);
+	__m128i acc=_mm_setzero_si128();
+	int i;
+	for (i=0; i+2 <= n; i+=2) {
+		acc=_mm_or_si128(acc, _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128((const __m128i*) (a+i)), e), e));
+	}
+	/* only the upper halves hold the exponent, the lower halves always compare equal */
+	if (_mm_movemask_ps(_mm_castsi128_ps(acc)) & 0xA) return 0;
+	return finite_scalar(a+i, n-i);
+}
+
+static __attribute__((target("avx2"))) int finite_avx2(const Real *a, int n) {
+	const __m256i e=_mm256_set1_epi64x(VM_EXPONENT);
+	__m256i acc=_mm256_setzero_si256();
+	int i;
+	for (i=0; i+4 <= n; i+=4) {
+		acc=_mm256_or_si256(acc, _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_loadu_si256((const __m256i*) (a+i)), e), e));
+	}
+	if (!_mm256_testz_si256(acc, acc)) return 0;
+	return finite_scalar(a+i, n-i);
+}
+
+#if defined(__clang__) || __GNUC__ >= 8
+	#define VM_UNROLL _Pragma("GCC unroll 8")
+#else
+	#define VM_UNROLL
+#endif
+
+/* SSE2, one Complex per vector */
+#define VM_ISA sse2
+#define VM_TARGET __attribute__((target("sse2")))
+#define V __m128d
+#define VW 2
+#define VLOAD(p) _mm_loadu_pd(p)
+#define VSTORE(p, x) _mm_storeu_pd(p, x)
+#define VADD(x, y) _mm_add_pd(x, y)
+#define VSUB(x, y) _mm_sub_pd(x, y)
+#define VMUL(x, y) _mm_mul_pd(x, y)
+#define VDIV(x, y) _mm_div_pd(x, y)
+#define VXOR(x, y) _mm_xor_pd(x, y)
+#define VSETP(p0, p1) _mm_setr_pd(p0, p1)
+#define VDUPE(v) _mm_unpacklo_pd(v, v)
+#define VDUPO(v) _mm_unpackhi_pd(v, v)
+#define VSWAP(v) _mm_shuffle_pd(v, v, 1)
+#define VBLEND(x, y) _mm_move_sd(y, x)
+#define VREXP(p) _mm_set1_pd(*(p))
+#define VMIN(x, y) _mm_min_pd(x, y)
+#define VMAX(x, y) _mm_max_pd(x, y)
+#define VANYEQ(x, y) _mm_movemask_pd(_mm_cmpeq_pd(x, y))
+
+#include "vmath_simd.h"
+
+#undef VM_ISA
+#undef VM_TARGET
+#undef V
+#undef VW
+#undef VLOAD
+#undef VSTORE
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VDIV
+#undef VXOR
+#undef VSETP
+#undef VDUPE
+#undef VDUPO
+#undef VSWAP
+#undef VBLEND
+#undef VREXP
+#undef VMIN
+#undef VMAX
+#undef VANYEQ
+
+/* AVX2, two Complex per vector */
+#define VM_ISA avx2
+#define VM_TARGET __attribute__((target("avx2")))
+#define V __m256d
+#define VW 4
+#define VLOAD(p) _mm256_loadu_pd(p)
+#define VSTORE(p, x) _mm256_storeu_pd(p, x)
+#define VADD(x, y) _mm256_add_pd(x, y)
+#define VSUB(x, y) _mm256_sub_pd(x, y)
+#define VMUL(x, y) _mm256_mul_pd(x, y)
+#define VDIV(x, y) _mm256_div_pd(x, y)
+#define VXOR(x, y) _mm256_xor_pd(x, y)
+#define VSETP(p0, p1) _mm256_setr_pd(p0, p1, p0, p1)
+#define VDUPE(v) _mm256_movedup_pd(v)
+#define VDUPO(v) _mm256_permute_pd(v, 0xF)
+#define VSWAP(v) _mm256_permute_pd(v, 0x5)
+#define VBLEND(x, y) _mm256_blend_pd(y, x, 0x5)
+#define VREXP(p) _mm256_permute4x64_pd(_mm256_castpd128_pd256(_mm_loadu_pd(p)), 0x50)
+#define VMIN(x, y) _mm256_min_pd(x, y)
+#define VMAX(x, y) _mm256_max_pd(x, y)
+#define VANYEQ(x, y) _mm256_movemask_pd(_mm256_cmp_pd(x, y, _CMP_EQ_OQ))
+
+#include "vmath_simd.h"
+
+#endif /* VMATH_X86 */
+
+/* runtime dispatch */
+
+static const vmath_kernels *vmath_ops=NULL;
+
+static const vmath_kernels *vmath_select(void) {
+#ifdef VMATH_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return &vmath_kernels_avx2;
+	if (__builtin_cpu_supports("sse2")) return &vmath_kernels_sse2;
+#endif
+	return &vmath_kernels_scalar;
+}
+
+/* the selection is idempotent, so concurrent first calls are harmless */
+#define VMATH_OPS (vmath_ops != NULL ? vmath_ops : (vmath_ops=vmath_select()))
+
+const char *vmath_isa(void) {
+	return VMATH_OPS->isa;
+}
+
+int vmath_setIsa(const char *isa) {
+	if (isa == NULL) {
+		vmath_ops=vmath_select();
+		return 1;
+	}
+	if (strcmp(isa, "scalar") == 0) {
+		vmath_ops=&vmath_kernels_scalar;
+		return 1;
+	}
+#ifdef VMATH_X86
+	__builtin_cpu_init();
+	if (strcmp(isa, "sse2") == 0 && __builtin_cpu_supports("sse2")) {
+		vmath_ops=&vmath_kernels_sse2;
+		return 1;
+	}
+	if (strcmp(isa, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+		vmath_ops=&vmath_kernels_avx2;
+		return 1;
+	}
+#endif
+	return 0;
+}
+
+/*
+ * Run the kernel on blocks of the output and check each block right after it was written.
+ * a is the output, n its length in units of type T, r the number of Reals per unit.
+ */
+#define VMATH_BLOCKED(ops, nf, T, a, n, r, call) { \
+	T *_a=a; \
+	int _i, _m, _n=n; \
+	if (nf == NULL) { \
+		_i=0; _m=_n; call; \
+	} else { \
+		for (_i=0; _i < _n; _i+=_m) { \
+			_m=_n-_i < VMATH_BLOCK/r ? _n-_i : VMATH_BLOCK/r; \
+			call; \
+			if (!ops->finite((Real*) (_a+_i), r*_m)) __esweep_nonFinite_scan(nf, (Real*) (_a+_i), r*_m); \
+		} \
+	} \
+}
+
+void vmath_rr(int op, Real *a, const Real *b, int n, esweep_nonFinite *nf) {
+	const vmath_kernels *ops=VMATH_OPS;
+	VMATH_BLOCKED(ops, nf, Real, a, n, 1, ops->rr[op](_a+_i, b+_i, _m));
+}
+
+void vmath_rp(int op, Real *a, Real p0, Real p1, int n, esweep_nonFinite *nf) {
+	const vmath_kernels *ops=VMATH_OPS;
+	/* blocks start at even positions, so the pairs stay in place */
+	VMATH_BLOCKED(ops, nf, Real, a, n, 1, ops->rp[op](_a+_i, p0, p1, _m));
+}
+
+void vmath_cc(int op, Complex *a, const Complex *b, int n, esweep_nonFinite *nf) {
+	const vmath_kernels *ops=VMATH_OPS;
+	if (op < VMATH_MUL) vmath_rr(op, (Real*) a, (const Real*) b, 2*n, nf);
+	else VMATH_BLOCKED(ops, nf, Complex, a, n, 2, ops->cc[op-VMATH_MUL](_a+_i, b+_i, _m));
+}
+
+void vmath_cs(int op, Complex *a, Complex b, int n, esweep_nonFinite *nf) {
+	const vmath_kernels *ops=VMATH_OPS;
+	if (op < VMATH_MUL) vmath_rp(op, (Real*) a, b.real, b.imag, 2*n, nf);
+	else VMATH_BLOCKED(ops, nf, Complex, a, n, 2, ops->cs[op-VMATH_MUL](_a+_i, b, _m));
+}
+
+void vmath_cr(int op, Complex *a, const Real *b, int n, esweep_nonFinite *nf) {
+	const vmath_kernels *ops=VMATH_OPS;
+	VMATH_BLOCKED(ops, nf, Complex, a, n, 2, ops->cr[op](_a+_i, b+_i, _m));
+}
+
+void vmath_crs(int op, Complex *a, Real b, int n, esweep_nonFinite *nf) {
+	/* the imaginary part stays untouched: x+(-0) and x-0 are exactly x */
+	switch (op) {
+		case VMATH_ADD:
+			vmath_rp(op, (Real*) a, b, -0.0, 2*n, nf);
+			break;
+		case VMATH_SUB:
+			vmath_rp(op, (Real*) a, b, 0.0, 2*n, nf);
+			break;
+		default:
+			vmath_rp(op, (Real*) a, b, b, 2*n, nf);
+			break;
+	}
+}
+
+void vmath_pp(int op, Polar *a, const Polar *b, int n, esweep_nonFinite *nf) {
+	const vmath_kernels *ops=VMATH_OPS;
+	if (op < VMATH_MUL) vmath_rr(op, (Real*) a, (const Real*) b, 2*n, nf);
+	else VMATH_BLOCKED(ops, nf, Polar, a, n, 2, ops->pp[op-VMATH_MUL](_a+_i, b+_i, _m));
+}
+
+void vmath_ps(int op, Polar *a, Polar b, int n, esweep_nonFinite *nf) {
+	const vmath_kernels *ops=VMATH_OPS;
+	if (op < VMATH_MUL) vmath_rp(op, (Real*) a, b.abs, b.arg, 2*n, nf);
+	else VMATH_BLOCKED(ops, nf, Polar, a, n, 2, ops->ps[op-VMATH_MUL](_a+_i, b, _m));
+}
+
+void vmath_pr(int op, Polar *a, const Real *b, int n, esweep_nonFinite *nf) {
+	const vmath_kernels *ops=VMATH_OPS;
+	VMATH_BLOCKED(ops, nf, Polar, a, n, 2, ops->pr[op-VMATH_MUL](_a+_i, b+_i, _m));
+}
+
+void vmath_prs(int op, Polar *a, Real b, int n, esweep_nonFinite *nf) {
+	/* the phase stays untouched: x*1 and x/1 are exactly x */
+	vmath_rp(op, (Real*) a, b, 1.0, 2*n, nf);
+}
+
+void vmath_reduce(const Real *x, int n, vmath_reduction *r) {
+	VMATH_OPS->reduce(x, n, r);
+}
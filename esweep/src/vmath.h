@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+#ifndef VMATH_H
+
+#define VMATH_H
+
+#include "esweep.h"
+
+/*
+ * Element-wise arithmetic kernels for esweep_add(), esweep_sub(), esweep_mul() and esweep_div().
+ * All operations are in-place (a op= b). The SSE2 or AVX2 version is selected at runtime
+ * on the first call; results are identical to the scalar code in any case.
+ * With nf != NULL the results are checked for non-finite numbers block by block, while the
+ * block is still in the cache, and fixed according to the policy in nf (see esweep_fp.c).
+ */
+
+#define VMATH_ADD 0
+#define VMATH_SUB 1
+#define VMATH_MUL 2
+#define VMATH_DIV 3
+
+/* n Reals with n Reals; also used for Complex/Polar add and sub with 2*n Reals */
+void vmath_rr(int op, Real *a, const Real *b, int n, esweep_nonFinite *nf);
+/* n Reals with the repeating pair (p0, p1), i. e. a[2*i] op= p0, a[2*i+1] op= p1; with p0 == p1 a scalar */
+void vmath_rp(int op, Real *a, Real p0, Real p1, int n, esweep_nonFinite *nf);
+
+/* n Complex with n Complex or with a single Complex */
+void vmath_cc(int op, Complex *a, const Complex *b, int n, esweep_nonFinite *nf);
+void vmath_cs(int op, Complex *a, Complex b, int n, esweep_nonFinite *nf);
+/* n Complex with n Reals or with a single Real */
+void vmath_cr(int op, Complex *a, const Real *b, int n, esweep_nonFinite *nf);
+void vmath_crs(int op, Complex *a, Real b, int n, esweep_nonFinite *nf);
+
+/* n Polar with n Polar or with a single Polar */
+void vmath_pp(int op, Polar *a, const Polar *b, int n, esweep_nonFinite *nf);
+void vmath_ps(int op, Polar *a, Polar b, int n, esweep_nonFinite *nf);
+/* n Polar with n Reals or with a single Real; only VMATH_MUL and VMATH_DIV */
+void vmath_pr(int op, Polar *a, const Real *b, int n, esweep_nonFinite *nf);
+void vmath_prs(int op, Polar *a, Real b, int n, esweep_nonFinite *nf);
+
+/*
+ * Sum, sum of squares, minimum and maximum of n Reals, for the reductions in esweep_stats.c.
+ * The values are summed in VMATH_LANES interleaved lanes, which are added pairwise at the end.
+ * The order is the same for all instruction sets, so are the results.
+ * NaN are ignored by min and max, but not by the sums.
+ */
+#define VMATH_LANES 8
+
+typedef struct {
+	Real sum, sqsum;
+	Real min, max;
+	int imin, imax; /* first index of the minimum/maximum, -1 if there are only NaN */
+} vmath_reduction;
+
+void vmath_reduce(const Real *x, int n, vmath_reduction *r);
+
+/*
+ * The selected instruction set: "scalar", "sse2" or "avx2".
+ * vmath_setIsa() forces one of them (NULL reverts to the runtime selection);
+ * it returns 0 if the CPU or the build does not support it. Used by the benchmarks.
+ */
+const char *vmath_isa(void);
+int vmath_setIsa(const char *isa);
+
+#endif /* VMATH_H */
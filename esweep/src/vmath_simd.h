@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * Kernel template for vmath.c, included once per instruction set.
+ * The includer defines
+ *
+ * VM_ISA: suffix of the generated functions
+ * VM_TARGET: function attribute which enables the instruction set
+ * V, VW: vector type and number of Reals per vector (even)
+ * VLOAD, VSTORE, VADD, VSUB, VMUL, VDIV, VXOR: unaligned load/store and arithmetic
+ * VSETP(p0, p1): the pair (p0, p1) repeated over the vector
+ * VDUPE(v), VDUPO(v): the even/odd Reals of each pair duplicated, e. g. the real/imag part
+ * VSWAP(v): the Reals of each pair swapped
+ * VBLEND(x, y): even Reals from x, odd Reals from y
+ * VREXP(p): VW/2 Reals at p, each one duplicated
+ * VMIN(x, y), VMAX(x, y): x if x < y (x > y), y otherwise
+ * VANYEQ(x, y): not 0 if any Real of x equals the one in y (quiet compare)
+ * VM_UNROLL: pragma for the complete unrolling of the following loop
+ * and the non-finite check finite_<isa>()
+ *
+ * Each kernel handles the full vectors and leaves the tail to the scalar version.
+ * Lanes which are not part of the result are computed with neutral operands
+ * (x+(-0), x-0, x*1, x/1), so they never raise floating point exceptions
+ * which the scalar code does not raise.
+ */
+
+#define VM_CAT2(name, isa) name##_##isa
+#define VM_CAT(name, isa) VM_CAT2(name, isa)
+#define VM_NAME(name) VM_CAT(name, VM_ISA)
+
+/* complex numbers per vector */
+#define VC (VW/2)
+
+#define VM_RR(op, vop) \
+static VM_TARGET void VM_NAME(rr_##op)(Real *a, const Real *b, int n) { \
+	int i; \
+	for (i=0; i+VW <= n; i+=VW) { \
+		VSTORE(a+i, vop(VLOAD(a+i), VLOAD(b+i))); \
+	} \
+	rr_##op##_scalar(a+i, b+i, n-i); \
+}
+
+#define VM_RP(op, vop) \
+static VM_TARGET void VM_NAME(rp_##op)(Real *a, Real p0, Real p1, int n) { \
+	V p=VSETP(p0, p1); \
+	int i; \
+	for (i=0; i+VW <= n; i+=VW) { \
+		VSTORE(a+i, vop(VLOAD(a+i), p)); \
+	} \
+	rp_##op##_scalar(a+i, p0, p1, n-i); \
+}
+
+VM_RR(add, VADD)
+VM_RR(sub, VSUB)
+VM_RR(mul, VMUL)
+VM_RR(div, VDIV)
+
+VM_RP(add, VADD)
+VM_RP(sub, VSUB)
+VM_RP(mul, VMUL)
+VM_RP(div, VDIV)
+
+/*
+ * (ar+j*ai)*(br+j*bi): [ar*br, ai*br] + [-(ai*bi), ar*bi]
+ * x+(-y) is exactly x-y, so this is the same as ESWEEP_MATH_CC_MUL
+ */
+static VM_TARGET void VM_NAME(cc_mul)(Complex *a, const Complex *b, int n) {
+	const V sign=VSETP(-0.0, 0.0);
+	V x, y;
+	int i;
+	for (i=0; i+VC <= n; i+=VC) {
+		x=VLOAD((Real*) (a+i));
+		y=VLOAD((const Real*) (b+i));
+		x=VADD(VMUL(x, VDUPE(y)), VXOR(VMUL(VSWAP(x), VDUPO(y)), sign));
+		VSTORE((Real*) (a+i), x);
+	}
+	cc_mul_scalar(a+i, b+i, n-i);
+}
+
+/* (ar+j*ai)/(br+j*bi): ([ar*br, ai*br] + [ai*bi, -(ar*bi)]) / (br*br+bi*bi) */
+static VM_TARGET void VM_NAME(cc_div)(Complex *a, const Complex *b, int n) {
+	const V sign=VSETP(0.0, -0.0);
+	V x, y, sq;
+	int i;
+	for (i=0; i+VC <= n; i+=VC) {
+		x=VLOAD((Real*) (a+i));
+		y=VLOAD((const Real*) (b+i));
+		sq=VMUL(y, y);
+		x=VADD(VMUL(x, VDUPE(y)), VXOR(VMUL(VSWAP(x), VDUPO(y)), sign));
+		VSTORE((Real*) (a+i), VDIV(x, VADD(VDUPE(sq), VDUPO(sq))));
+	}
+	cc_div_scalar(a+i, b+i, n-i);
+}
+
+static VM_TARGET void VM_NAME(cs_mul)(Complex *a, Complex b, int n) {
+	const V sign=VSETP(-0.0, 0.0);
+	const V re=VSETP(b.real, b.real), im=VSETP(b.imag, b.imag);
+	V x;
+	int i;
+	for (i=0; i+VC <= n; i+=VC) {
+		x=VLOAD((Real*) (a+i));
+		x=VADD(VMUL(x, re), VXOR(VMUL(VSWAP(x), im), sign));
+		VSTORE((Real*) (a+i), x);
+	}
+	cs_mul_scalar(a+i, b, n-i);
+}
+
+static VM_TARGET void VM_NAME(cs_div)(Complex *a, Complex b, int n) {
+	const V sign=VSETP(0.0, -0.0);
+	const V re=VSETP(b.real, b.real), im=VSETP(b.imag, b.imag);
+	const V denom=VADD(VMUL(re, re), VMUL(im, im));
+	V x;
+	int i;
+	for (i=0; i+VC <= n; i+=VC) {
+		x=VLOAD((Real*) (a+i));
+		x=VADD(VMUL(x, re), VXOR(VMUL(VSWAP(x), im), sign));
+		VSTORE((Real*) (a+i), VDIV(x, denom));
+	}
+	cs_div_scalar(a+i, b, n-i);
+}
+
+/* Complex with Real: add and sub touch only the real part */
+static VM_TARGET void VM_NAME(cr_add)(Complex *a, const Real *b, int n) {
+	const V zero=VSETP(-0.0, -0.0);
+	int i;
+	for (i=0; i+VC <= n; i+=VC) {
+		VSTORE((Real*) (a+i), VADD(VLOAD((Real*) (a+i)), VBLEND(VREXP(b+i), zero)));
+	}
+	cr_add_scalar(a+i, b+i, n-i);
+}
+
+static VM_TARGET void VM_NAME(cr_sub)(Complex *a, const Real *b, int n) {
+	const V zero=VSETP(0.0, 0.0);
+	int i;
+	for (i=0; i+VC <= n; i+=VC) {
+		VSTORE((Real*) (a+i), VSUB(VLOAD((Real*) (a+i)), VBLEND(VREXP(b+i), zero)));
+	}
+	cr_sub_scalar(a+i, b+i, n-i);
+}
+
+static VM_TARGET void VM_NAME(cr_mul)(Complex *a, const Real *b, int n) {
+	int i;
+	for (i=0; i+VC <= n; i+=VC) {
+		VSTORE((Real*) (a+i), VMUL(VLOAD((Real*) (a+i)), VREXP(b+i)));
+	}
+	cr_mul_scalar(a+i, b+i, n-i);
+}
+
+static VM_TARGET void VM_NAME(cr_div)(Complex *a, const Real *b, int n) {
+	int i;
+	for (i=0; i+VC <= n; i+=VC) {
+		VSTORE((Real*) (a+i), VDIV(VLOAD((Real*) (a+i)), VREXP(b+i)));
+	}
+	cr_div_scalar(a+i, b+i, n-i);
+}
+
+/* Polar with Polar: the absolute values are multiplied/divided, the phases added/subtracted */
+static VM_TARGET void VM_NAME(pp_mul)(Polar *a, const Polar *b, int n) {
+	const V one=VSETP(1.0, 1.0), zero=VSETP(-0.0, -0.0);
+	V x, y;
+	int i;
+	for (i=0; i+VC <= n; i+=VC) {
+		x=VLOAD((Real*) (a+i));
+		y=VLOAD((const Real*) (b+i));
+		VSTORE((Real*) (a+i), VBLEND(VMUL(x, VBLEND(y, one)), VADD(x, VBLEND(zero, y))));
+	}
+	pp_mul_scalar(a+i, b+i, n-i);
+}
+
+static VM_TARGET void VM_NAME(pp_div)(Polar *a, const Polar *b, int n) {
+	const V one=VSETP(1.0, 1.0), zero=VSETP(0.0, 0.0);
+	V x, y;
+	int i;
+	for (i=0; i+VC <= n; i+=VC) {
+		x=VLOAD((Real*) (a+i));
+		y=VLOAD((const Real*) (b+i));
+		VSTORE((Real*) (a+i), VBLEND(VDIV(x, VBLEND(y, one)), VSUB(x, VBLEND(zero, y))));
+	}
+	pp_div_scalar(a+i, b+i, n-i);
+}
+
+static VM_TARGET void VM_NAME(ps_mul)(Polar *a, Polar b, int n) {
+	const V f=VSETP(b.abs, 1.0), s=VSETP(-0.0, b.arg);
+	V x;
+	int i;
+	for (i=0; i+VC <= n; i+=VC) {
+		x=VLOAD((Real*) (a+i));
+		VSTORE((Real*) (a+i), VBLEND(VMUL(x, f), VADD(x, s)));
+	}
+	ps_mul_scalar(a+i, b, n-i);
+}
+
+static VM_TARGET void VM_NAME(ps_div)(Polar *a, Polar b, int n) {
+	const V f=VSETP(b.abs, 1.0), s=VSETP(0.0, b.arg);
+	V x;
+	int i;
+	for (i=0; i+VC <= n; i+=VC) {
+		x=VLOAD((Real*) (a+i));
+		VSTORE((Real*) (a+i), VBLEND(VDIV(x, f), VSUB(x, s)));
+	}
+	ps_div_scalar(a+i, b, n-i);
+}
+
+/* Polar with Real: only the absolute value */
+static VM_TARGET void VM_NAME(pr_mul)(Polar *a, const Real *b, int n) {
+	const V one=VSETP(1.0, 1.0);
+	int i;
+	for (i=0; i+VC <= n; i+=VC) {
+		VSTORE((Real*) (a+i), VMUL(VLOAD((Real*) (a+i)), VBLEND(VREXP(b+i), one)));
+	}
+	pr_mul_scalar(a+i, b+i, n-i);
+}
+
+static VM_TARGET void VM_NAME(pr_div)(Polar *a, const Real *b, int n) {
+	const V one=VSETP(1.0, 1.0);
+	int i;
+	for (i=0; i+VC <= n; i+=VC) {
+		VSTORE((Real*) (a+i), VDIV(VLOAD((Real*) (a+i)), VBLEND(VREXP(b+i), one)));
+	}
+	pr_div_scalar(a+i, b+i, n-i);
+}
+
+/*
+ * The VMATH_LANES lanes of reduce_lanes() in VMATH_LANES/VW vectors.
+ * VMIN(x, mn) is x < mn ? x : mn, exactly the scalar compare, also for NaN and -0.
+ */
+#define VL (VMATH_LANES/VW)
+
+static VM_TARGET int VM_NAME(find)(const Real *x, int n, Real v) {
+	const V c=VSETP(v, v);
+	int i;
+	for (i=0; i+VW <= n; i+=VW) {
+		if (VANYEQ(VLOAD(x+i), c)) break;
+	}
+	for (; i < n; i++) if (x[i] == v) return i;
+	return -1;
+}
+
+static VM_TARGET void VM_NAME(reduce)(const Real *x, int n, vmath_reduction *r) {
+	V s[VL], q[VL], mn[VL], mx[VL], v;
+	vmath_lanes l;
+	int i, k;
+
+	reduce_init(&l);
+	for (k=0; k < VL; k++) {
+		s[k]=VLOAD(l.s+k*VW);
+		q[k]=VLOAD(l.q+k*VW);
+		mn[k]=VLOAD(l.mn+k*VW);
+		mx[k]=VLOAD(l.mx+k*VW);
+	}
+	for (i=0; i+VMATH_LANES <= n; i+=VMATH_LANES) {
+		/* unrolled, so the lanes stay in registers */
+		VM_UNROLL
+		for (k=0; k < VL; k++) {
+			v=VLOAD(x+i+k*VW);
+			s[k]=VADD(s[k], v);
+			q[k]=VADD(q[k], VMUL(v, v));
+			mn[k]=VMIN(v, mn[k]);
+			mx[k]=VMAX(v, mx[k]);
+		}
+	}
+	for (k=0; k < VL; k++) {
+		VSTORE(l.s+k*VW, s[k]);
+		VSTORE(l.q+k*VW, q[k]);
+		VSTORE(l.mn+k*VW, mn[k]);
+		VSTORE(l.mx+k*VW, mx[k]);
+	}
+	reduce_lanes(&l, x, i, n);
+	reduce_finish(&l, x, n, r, VM_NAME(find));
+}
+
+static const vmath_kernels VM_NAME(vmath_kernels) = {
+	VM_STR(VM_ISA),
+	{VM_NAME(rr_add), VM_NAME(rr_sub), VM_NAME(rr_mul), VM_NAME(rr_div)},
+	{VM_NAME(rp_add), VM_NAME(rp_sub), VM_NAME(rp_mul), VM_NAME(rp_div)},
+	{VM_NAME(cc_mul), VM_NAME(cc_div)},
+	{VM_NAME(cs_mul), VM_NAME(cs_div)},
+	{VM_NAME(cr_add), VM_NAME(cr_sub), VM_NAME(cr_mul), VM_NAME(cr_div)},
+	{VM_NAME(pp_mul), VM_NAME(pp_div)},
+	{VM_NAME(ps_mul), VM_NAME(ps_div)},
+	{VM_NAME(pr_mul), VM_NAME(pr_div)},
+	VM_NAME(finite),
+	VM_NAME(reduce)
+};
+
+#undef VM_RR
+#undef VM_RP
+#undef VC
+#undef VL
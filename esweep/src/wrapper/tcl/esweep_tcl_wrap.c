@@ -67,13 +67,21 @@ static command_info mod_commands[] = {
 	{"::esweep::createFFTTable", esweepCreateFFTTable, NULL},
 	{"::esweep::delay", esweepDelay, NULL},
 	{"::esweep::smooth", esweepSmooth, NULL},
+	{"::esweep::smoothLog", esweepSmoothLog, NULL},
+	{"::esweep::logResample", esweepLogResample, NULL},
+	{"::esweep::toneAnalyze", esweepToneAnalyze, NULL},
+	{"::esweep::thd", esweepThd, NULL},
+	{"::esweep::imd", esweepImd, NULL},
 	{"::esweep::unwrapPhase", esweepUnwrapPhase, NULL},
 	{"::esweep::wrapPhase", esweepWrapPhase, NULL},
 	{"::esweep::restoreHermitian", esweepRestoreHermitian, NULL},
 	{"::esweep::window", esweepWindow, NULL},
+	{"::esweep::windowInfo", esweepWindowInfo, NULL},
 	{"::esweep::peakDetect", esweepPeakDetect, NULL},
+	{"::esweep::peakFind", esweepPeakFind, NULL},
 	{"::esweep::integrate", esweepIntegrate, NULL},
 	{"::esweep::differentiate", esweepDifferentiate, NULL},
+	{"::esweep::envelope", esweepEnvelope, NULL},
 
 	{"::esweep::createFilterFromCoeff", esweepCreateFilterFromCoeff, NULL},
 	{"::esweep::createFilterFromList", esweepCreateFilterFromList, NULL},
@@ -95,6 +103,7 @@ static command_info mod_commands[] = {
 	{"::esweep::avg", esweepAvg, NULL},
 	{"::esweep::sum", esweepSum, NULL},
 	{"::esweep::sqsum", esweepSqsum, NULL},
+	{"::esweep::stats", esweepStats, NULL},
 	{"::esweep::real", esweepReal, NULL},
 	{"::esweep::imag", esweepImag, NULL},
 	{"::esweep::abs", esweepAbs, NULL},
@@ -104,6 +113,55 @@ static command_info mod_commands[] = {
 	{"::esweep::exp", esweepExp, NULL},
 	{"::esweep::pow", esweepPow, NULL},
 	{"::esweep::schroeder", esweepSchroeder, NULL},
+	{"::esweep::eval", esweepEval, NULL},
+	{"::esweep::roomAcoustics", esweepRoomAcoustics, NULL},
+
+	{"::esweep::denormals", esweepDenormals, NULL},
+	{"::esweep::nonFinite", esweepNonFinite, NULL},
+
+	{"::esweep::delayLineCreate", esweepDelayLineCreate, NULL},
+	{"::esweep::delayLineSet", esweepDelayLineSet, NULL},
+	{"::esweep::delayLineGet", esweepDelayLineGet, NULL},
+	{"::esweep::delayLineProcess", esweepDelayLineProcess, NULL},
+	{"::esweep::delayLineReset", esweepDelayLineReset, NULL},
+
+	{"::esweep::filterBankCreate", esweepFilterBankCreate, NULL},
+	{"::esweep::filterBankInfo", esweepFilterBankInfo, NULL},
+	{"::esweep::filterBankAnalyze", esweepFilterBankAnalyze, NULL},
+	{"::esweep::filterBankSynthesize", esweepFilterBankSynthesize, NULL},
+	{"::esweep::filterBankReset", esweepFilterBankReset, NULL},
+
+	{"::esweep::spectrumCreate", esweepSpectrumCreate, NULL},
+	{"::esweep::spectrumInfo", esweepSpectrumInfo, NULL},
+	{"::esweep::spectrumProcess", esweepSpectrumProcess, NULL},
+	{"::esweep::spectrumRead", esweepSpectrumRead, NULL},
+	{"::esweep::spectrumReset", esweepSpectrumReset, NULL},
+	{"::esweep::transferCreate", esweepTransferCreate, NULL},
+	{"::esweep::transferInfo", esweepTransferInfo, NULL},
+	{"::esweep::transferProcess", esweepTransferProcess, NULL},
+	{"::esweep::transferRead", esweepTransferRead, NULL},
+	{"::esweep::transferReset", esweepTransferReset, NULL},
+	{"::esweep::multiResolution", esweepMultiResolution, NULL},
+
+	{"::esweep::stftCreate", esweepStftCreate, NULL},
+	{"::esweep::stftInfo", esweepStftInfo, NULL},
+	{"::esweep::stftProcess", esweepStftProcess, NULL},
+	{"::esweep::stftReset", esweepStftReset, NULL},
+	{"::esweep::stft", esweepStft, NULL},
+
+	{"::esweep::cqtCreate", esweepCqtCreate, NULL},
+	{"::esweep::cqtInfo", esweepCqtInfo, NULL},
+	{"::esweep::cqt", esweepCqt, NULL},
+	{"::esweep::cqtSurface", esweepCqtSurface, NULL},
+
+	{"::esweep::levelLoggerCreate", esweepLevelLoggerCreate, NULL},
+	{"::esweep::levelLoggerProcess", esweepLevelLoggerProcess, NULL},
+	{"::esweep::levelLoggerTotal", esweepLevelLoggerTotal, NULL},
+	{"::esweep::levelLoggerReset", esweepLevelLoggerReset, NULL},
+
+	{"::esweep::csd", esweepCsd, NULL},
+	{"::esweep::cbsd", esweepCbsd, NULL},
+
 #ifndef NOAUDIO
 	{"::esweep::audioOpen", esweepAudioOpen, NULL},
 	{"::esweep::audioQuery", esweepAudioQuery, NULL},
@@ -360,6 +418,63 @@ static void UpdateStringOfEsweepObj(Tcl_Obj *esweepObjPtr) {
 			break;
 	}
 }
+
+/*
+ * Definition of tclEsweepHandleType
+ */
+
+static void DupEsweepHandle(Tcl_Obj *srcPtr, Tcl_Obj *copyPtr);
+static void UpdateStringOfEsweepHandleObj(Tcl_Obj *objPtr);
+static void FreeEsweepHandle(Tcl_Obj *objPtr);
+
+const Tcl_ObjType tclEsweepHandleType = {
+	ESWEEP_TYPE_NAME"_handle", /* name */
+	FreeEsweepHandle, /* freeIntRepProc */
+	DupEsweepHandle, /* dupIntRepProc */
+	UpdateStringOfEsweepHandleObj, /* updateStringProc */
+	NULL
+};
+
+Tcl_Obj *esweepNewHandleObj(const char *kind, void *handle, int (*freeProc)(void*)) {
+	TclEsweepHandle *eh;
+	Tcl_Obj *ret;
+
+	ESWEEP_MALLOC(eh, 1, sizeof(TclEsweepHandle), NULL);
+	eh->refCount=1;
+	eh->kind=kind;
+	eh->handle=handle;
+	eh->freeProc=freeProc;
+	ret=Tcl_NewObj();
+	ret->internalRep.otherValuePtr=eh;
+	ret->typePtr=&tclEsweepHandleType;
+	Tcl_InvalidateStringRep(ret);
+	return ret;
+}
+
+static void DupEsweepHandle(Tcl_Obj *srcPtr, Tcl_Obj *copyPtr) {
+	TclEsweepHandle *eh=(TclEsweepHandle*) srcPtr->internalRep.otherValuePtr;
+	copyPtr->internalRep.otherValuePtr=(void*) eh;
+	eh->refCount++;
+}
+
+static void UpdateStringOfEsweepHandleObj(Tcl_Obj *objPtr) {
+	/* kind and pointer address */
+	TclEsweepHandle *eh=(TclEsweepHandle*) objPtr->internalRep.otherValuePtr;
+	char pstr[64];
+	snprintf(pstr, sizeof(pstr), "%.24s%p", eh->kind, eh->handle);
+	objPtr->length=STRLEN(pstr, sizeof(pstr));
+	objPtr->bytes=ckalloc((unsigned) objPtr->length+1);
+	STRCPY(objPtr->bytes, pstr, objPtr->length+1);
+	objPtr->bytes[objPtr->length]='\0';
+}
+
+static void FreeEsweepHandle(Tcl_Obj *objPtr) {
+	TclEsweepHandle *eh=(TclEsweepHandle*) objPtr->internalRep.otherValuePtr;
+	if (--eh->refCount > 0) return;
+	eh->freeProc(eh->handle);
+	free(eh);
+}
+
 #ifndef NOAUDIO
 
 /*
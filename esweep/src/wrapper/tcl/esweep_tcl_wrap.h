@@ -66,6 +66,13 @@
 			return TCL_ERROR; \
 		} else {obj=(esweep_audio*) ((TclEsweepAudio*) (objv[idx]->internalRep.otherValuePtr))->handle;}
 
+/* Again, this time for the generic handles of the processing engines; name is the kind of the handle */
+#define CHECK_ESWEEP_HANDLE(idx, name, obj) if (objv[idx]->typePtr != &tclEsweepHandleType || \
+			strcmp(((TclEsweepHandle*) (objv[idx]->internalRep.otherValuePtr))->kind, name)) { \
+			Tcl_SetObjResult(interp, Tcl_ObjPrintf("Parameter %i not an esweep %s handle", idx, name)); \
+			return TCL_ERROR; \
+		} else {obj=((TclEsweepHandle*) (objv[idx]->internalRep.otherValuePtr))->handle;}
+
 /*
  * execute the esweep function and, if failed, create an error message and return TCL_ERROR;
  */
@@ -106,6 +113,7 @@
 
 extern const Tcl_ObjType tclEsweepObjType;
 extern const Tcl_ObjType tclEsweepAudioType;
+extern const Tcl_ObjType tclEsweepHandleType;
 
 /* this struct is needed to allow Tcl work flawless with the tclEsweepAudioType */
 typedef struct {
@@ -121,6 +129,19 @@ typedef struct {
 						} \
 					}
 
+/*
+ * The same for all other handles (delay lines etc.).
+ * The handle is freed with freeProc when the last Tcl object referencing it is gone.
+ */
+typedef struct {
+	int refCount;
+	const char *kind;
+	void *handle;
+	int (*freeProc)(void*);
+} TclEsweepHandle;
+
+Tcl_Obj *esweepNewHandleObj(const char *kind, void *handle, int (*freeProc)(void*));
+
 /* Command prototypes */
 
 /* mem */
@@ -154,13 +175,21 @@ int esweepIFFT(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CON
 int esweepCreateFFTTable(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 int esweepDelay(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 int esweepSmooth(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepSmoothLog(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepLogResample(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepToneAnalyze(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepThd(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepImd(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 int esweepUnwrapPhase(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 int esweepWrapPhase(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 int esweepRestoreHermitian(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 int esweepWindow(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepWindowInfo(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 int esweepPeakDetect(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepPeakFind(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 int esweepIntegrate(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 int esweepDifferentiate(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepEnvelope(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 
 /* filter */
 int esweepCreateFilterFromCoeff(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
@@ -185,6 +214,7 @@ int esweepMaxPos(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *C
 int esweepAvg(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 int esweepSum(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 int esweepSqsum(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepStats(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 int esweepReal(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 int esweepImag(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 int esweepAbs(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
@@ -194,6 +224,66 @@ int esweepLn(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST
 int esweepExp(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 int esweepPow(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 int esweepSchroeder(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepEval(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepRoomAcoustics(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+
+/* fp */
+int esweepDenormals(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepNonFinite(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+
+/* delay line */
+int esweepDelayLineCreate(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepDelayLineSet(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepDelayLineGet(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepDelayLineProcess(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepDelayLineReset(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+
+/* filter bank */
+int esweepFilterBankCreate(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepFilterBankInfo(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepFilterBankAnalyze(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepFilterBankSynthesize(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepFilterBankReset(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+
+/* spectrum */
+int esweepSpectrumCreate(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepSpectrumInfo(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepSpectrumProcess(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepSpectrumRead(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepSpectrumReset(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+
+/* transfer function */
+int esweepTransferCreate(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepTransferInfo(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepTransferProcess(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepTransferRead(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepTransferReset(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+
+/* multi resolution frequency response */
+int esweepMultiResolution(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+
+/* short time fourier transform */
+int esweepStftCreate(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepStftInfo(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepStftProcess(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepStftReset(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepStft(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+
+/* constant Q transform */
+int esweepCqtCreate(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepCqtInfo(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepCqt(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepCqtSurface(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+
+/* sound level logger */
+int esweepLevelLoggerCreate(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepLevelLoggerProcess(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepLevelLoggerTotal(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepLevelLoggerReset(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+
+/* surface */
+int esweepCsd(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int esweepCbsd(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 
 /* audio */
 int esweepAudioOpen(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
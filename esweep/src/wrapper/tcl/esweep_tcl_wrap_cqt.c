@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * esweep_tcl_wrap_cqt.c
+ * Wraps the esweep_cqt.c source file
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <tcl.h>
+#include "esweep_tcl_wrap.h"
+
+#define CQT_HANDLE "cqt"
+
+static int freeCqt(void *cqt) {
+	return esweep_cqtFree((esweep_cqt*) cqt);
+}
+
+/*
+ * ::esweep::cqtCreate -samplerate sr -range {f1 f2} ?-bpo bins? ?-window type? ?-threshold value?
+ * The default is 24 bins per octave, a Hann window and a threshold of 0.0054
+ */
+int esweepCqtCreate(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_cqt *cqt;
+	Tcl_Obj *ret;
+	Tcl_Obj **range;
+	const char *opts[] = {"-samplerate", "-range", "-bpo", "-window", "-threshold", NULL};
+	int optMask[] = {1, 1, 0, 0, 0, 0}; // necessary options
+	enum optIdx {srIdx, rangeIdx, bpoIdx, winIdx, thresIdx};
+	int obji;
+	int index;
+	int samplerate=0, bpo=24, n;
+	double f1=0.0, f2=0.0, threshold=0.0054;
+	const char *win="hann";
+
+	CHECK_NUM_ARGS(objc >= 5 && objc <= 11 && (objc-1)%2 == 0, "-samplerate value -range {f1 f2} ?-bpo bins? ?-window type? ?-threshold value?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case srIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &samplerate)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -samplerate invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case rangeIdx:
+				if (Tcl_ListObjGetElements(NULL, objv[obji+1], &n, &range)!=TCL_OK || n != 2 ||
+				    Tcl_GetDoubleFromObj(NULL, range[0], &f1)!=TCL_OK ||
+				    Tcl_GetDoubleFromObj(NULL, range[1], &f2)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -range invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case bpoIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &bpo)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -bpo invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case winIdx:
+				win=Tcl_GetString(objv[obji+1]);
+				break;
+			case thresIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &threshold)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -threshold invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT((cqt=esweep_cqtCreate(samplerate, f1, f2, bpo, win, threshold)) != NULL);
+	if ((ret=esweepNewHandleObj(CQT_HANDLE, cqt, freeCqt)) == NULL) {
+		esweep_cqtFree(cqt);
+		return TCL_ERROR;
+	}
+	Tcl_SetObjResult(interp, ret);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::cqtInfo -cqt handle
+ * Returns the list {bins value size value frequencies list}
+ */
+int esweepCqtInfo(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_cqt *cqt=NULL;
+	Tcl_Obj *listPtr, *freqPtr;
+	const char *opts[] = {"-cqt", NULL};
+	int optMask[] = {1, 0}; // necessary options
+	enum optIdx {cqtIdx};
+	int obji;
+	int index;
+	int bins, size, i;
+	Real *freq;
+
+	CHECK_NUM_ARGS(objc == 3, "-cqt handle");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case cqtIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, CQT_HANDLE, cqt);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_cqtInfo(cqt, &bins, &size, NULL) == ERR_OK);
+	ESWEEP_MALLOC(freq, bins, sizeof(Real), TCL_ERROR);
+	esweep_cqtInfo(cqt, NULL, NULL, freq);
+	freqPtr=Tcl_NewListObj(0, NULL);
+	for (i=0; i < bins; i++) Tcl_ListObjAppendElement(NULL, freqPtr, Tcl_NewDoubleObj(freq[i]));
+	free(freq);
+
+	listPtr=Tcl_NewListObj(0, NULL);
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("bins", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewIntObj(bins));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("size", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewIntObj(size));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("frequencies", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, freqPtr);
+	Tcl_SetObjResult(interp, listPtr);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::cqt -cqt handle -signal obj ?-start sample? ?-obj objVarName?
+ * Returns a polar object with one element per bin. If -obj is given, the result is
+ * written into this object, which is only reallocated when its size does not match.
+ */
+int esweepCqt(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_cqt *cqt=NULL;
+	esweep_object *in=NULL, *out=NULL;
+	Tcl_Obj *tclObj=NULL;
+	const char *opts[] = {"-cqt", "-signal", "-start", "-obj", NULL};
+	int optMask[] = {1, 1, 0, 0, 0}; // necessary options
+	enum optIdx {cqtIdx, sigIdx, startIdx, objIdx};
+	int obji;
+	int index;
+	int start=0;
+
+	CHECK_NUM_ARGS(objc >= 5 && objc <= 9 && (objc-1)%2 == 0, "-cqt handle -signal obj ?-start sample? ?-obj objVarName?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case cqtIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, CQT_HANDLE, cqt);
+				break;
+			case sigIdx:
+				CHECK_ESWEEP_OBJECT(obji+1, in);
+				break;
+			case startIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &start)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -start invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case objIdx:
+				CHECK_ESWEEP_OBJECT2(obji+1, tclObj, out);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	if (tclObj != NULL) {
+		DUPLICATE_WHEN_SHARED(tclObj, out);
+		ESWEEP_TCL_ASSERT(esweep_cqtAnalyze(cqt, in, start, out) == ERR_OK);
+	} else {
+		ESWEEP_TCL_ASSERT((out=esweep_create("polar", in->samplerate, 0))!=NULL);
+		if (esweep_cqtAnalyze(cqt, in, start, out) != ERR_OK) {
+			esweep_free(out);
+			Tcl_SetObjResult(interp, Tcl_NewStringObj(errmsg, -1));
+			return TCL_ERROR;
+		}
+		tclObj=Tcl_NewObj();
+		tclObj->internalRep.otherValuePtr=out;
+		tclObj->typePtr=(Tcl_ObjType*) &tclEsweepObjType;
+	}
+	Tcl_InvalidateStringRep(tclObj);
+	Tcl_SetObjResult(interp, tclObj);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::cqtSurface -cqt handle -signal obj -surface objVarName -row n ?-start sample?
+ * Writes the magnitudes of the frame into a row of the surface
+ */
+int esweepCqtSurface(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_cqt *cqt=NULL;
+	esweep_object *in=NULL, *out=NULL;
+	Tcl_Obj *tclObj=NULL;
+	const char *opts[] = {"-cqt", "-signal", "-surface", "-row", "-start", NULL};
+	int optMask[] = {1, 1, 1, 1, 0, 0}; // necessary options
+	enum optIdx {cqtIdx, sigIdx, surfIdx, rowIdx, startIdx};
+	int obji;
+	int index;
+	int row=0, start=0;
+
+	CHECK_NUM_ARGS(objc == 9 || objc == 11, "-cqt handle -signal obj -surface objVarName -row n ?-start sample?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case cqtIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, CQT_HANDLE, cqt);
+				break;
+			case sigIdx:
+				CHECK_ESWEEP_OBJECT(obji+1, in);
+				break;
+			case surfIdx:
+				CHECK_ESWEEP_OBJECT2(obji+1, tclObj, out);
+				break;
+			case rowIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &row)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -row invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case startIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &start)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -start invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	DUPLICATE_WHEN_SHARED(tclObj, out);
+	ESWEEP_TCL_ASSERT(esweep_cqtSurface(cqt, in, start, out, row) == ERR_OK);
+	Tcl_InvalidateStringRep(tclObj);
+	return TCL_OK;
+}
@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * esweep_tcl_wrap_delayline.c
+ * Wraps the esweep_delayline.c source file
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <tcl.h>
+#include "esweep_tcl_wrap.h"
+
+#define DELAYLINE_HANDLE "delayLine"
+
+static int freeDelayLine(void *line) {
+	return esweep_delayLineFree((esweep_delayLine*) line);
+}
+
+/*
+ * ::esweep::delayLineCreate -samplerate sr -channels n -maxDelay samples
+ * The delay line is freed when the handle is no longer referenced
+ */
+int esweepDelayLineCreate(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_delayLine *line;
+	Tcl_Obj *ret;
+	const char *opts[] = {"-samplerate", "-channels", "-maxDelay", NULL};
+	int optMask[] = {1, 1, 1, 0}; // necessary options
+	enum optIdx {srIdx, channelsIdx, maxDelayIdx};
+	int obji;
+	int index;
+	int samplerate=0, channels=0;
+	double max_delay=0.0;
+
+	CHECK_NUM_ARGS(objc == 7, "-samplerate value -channels value -maxDelay value");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case srIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &samplerate)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -samplerate invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case channelsIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &channels)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -channels invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case maxDelayIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &max_delay)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -maxDelay invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT((line=esweep_delayLineCreate(samplerate, channels, (Real) max_delay)) != NULL);
+	if ((ret=esweepNewHandleObj(DELAYLINE_HANDLE, line, freeDelayLine)) == NULL) {
+		esweep_delayLineFree(line);
+		return TCL_ERROR;
+	}
+	Tcl_SetObjResult(interp, ret);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::delayLineSet -line handle -delay samples ?-channel c? ?-ramp samples?
+ * Without -channel all channels are set
+ */
+int esweepDelayLineSet(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_delayLine *line=NULL;
+	const char *opts[] = {"-line", "-delay", "-channel", "-ramp", NULL};
+	int optMask[] = {1, 1, 0, 0, 0}; // necessary options
+	enum optIdx {lineIdx, delayIdx, channelIdx, rampIdx};
+	int obji;
+	int index;
+	int channel=-1, ramp=0;
+	double delay=0.0;
+
+	CHECK_NUM_ARGS(objc == 5 || objc == 7 || objc == 9, "-line handle -delay value ?-channel value? ?-ramp value?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case lineIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, DELAYLINE_HANDLE, line);
+				break;
+			case delayIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &delay)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -delay invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case channelIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &channel)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -channel invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case rampIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &ramp)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -ramp invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_delayLineSet(line, channel, (Real) delay, ramp) == ERR_OK);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::delayLineGet -line handle -channel c
+ * Returns the current delay of the channel in samples
+ */
+int esweepDelayLineGet(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_delayLine *line=NULL;
+	const char *opts[] = {"-line", "-channel", NULL};
+	int optMask[] = {1, 1, 0}; // necessary options
+	enum optIdx {lineIdx, channelIdx};
+	int obji;
+	int index;
+	int channel=0;
+	Real delay;
+
+	CHECK_NUM_ARGS(objc == 5, "-line handle -channel value");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case lineIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, DELAYLINE_HANDLE, line);
+				break;
+			case channelIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &channel)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -channel invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_delayLineGet(line, channel, &delay) == ERR_OK);
+	Tcl_SetObjResult(interp, Tcl_NewDoubleObj(delay));
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::delayLineProcess -line handle -signals list
+ * The signals are delayed in place, one per channel
+ */
+int esweepDelayLineProcess(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_delayLine *line=NULL;
+	esweep_object **signal=NULL;
+	Tcl_Obj *tclObj;
+	Tcl_Obj *list=NULL;
+	const char *opts[] = {"-line", "-signals", NULL};
+	int optMask[] = {1, 1, 0}; // necessary options
+	enum optIdx {lineIdx, signalsIdx};
+	int obji;
+	int index, i;
+	int channels=0;
+
+	CHECK_NUM_ARGS(objc == 5, "-line handle -signals list");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case lineIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, DELAYLINE_HANDLE, line);
+				break;
+			case signalsIdx:
+				if (Tcl_ListObjLength(NULL, objv[obji+1], &channels)!=TCL_OK) {
+					Tcl_SetResult(interp, "parameter of option -signals is not a list", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				if (channels <= 0) {
+					Tcl_SetResult(interp, "no signals defined", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				list=objv[obji+1];
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_MALLOC(signal, channels, sizeof(*signal), TCL_ERROR);
+	for (i=0; i < channels; i++) {
+		Tcl_ListObjIndex(interp, list, i, &tclObj);
+		if (tclObj->typePtr != &tclEsweepObjType) {
+			free(signal);
+			Tcl_SetObjResult(interp, Tcl_NewStringObj("List contains non-esweep objects", -1));
+			return TCL_ERROR;
+		} else {signal[i]=(esweep_object*) tclObj->internalRep.otherValuePtr;}
+	}
+
+	if (esweep_delayLineProcess(line, signal, channels) != ERR_OK) {
+		free(signal);
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(errmsg, -1));
+		return TCL_ERROR;
+	}
+	free(signal);
+	/* the objects have been changed in place */
+	for (i=0; i < channels; i++) {
+		Tcl_ListObjIndex(interp, list, i, &tclObj);
+		Tcl_InvalidateStringRep(tclObj);
+	}
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::delayLineReset -line handle
+ */
+int esweepDelayLineReset(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_delayLine *line=NULL;
+	const char *opts[] = {"-line", NULL};
+	int optMask[] = {1, 0}; // necessary options
+	enum optIdx {lineIdx};
+	int obji;
+	int index;
+
+	CHECK_NUM_ARGS(objc == 3, "-line handle");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case lineIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, DELAYLINE_HANDLE, line);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_delayLineReset(line) == ERR_OK);
+	return TCL_OK;
+}
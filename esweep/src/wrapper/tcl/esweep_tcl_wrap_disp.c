@@ -43,6 +43,7 @@ static void inline waveLinLin(const esweep_object *obj, Tcl_Obj *listPtr, const
 static void inline waveLogLin(const esweep_object *obj, Tcl_Obj *listPtr, const double screen[], const double world[]);
 static void inline polarLogLin(const esweep_object *obj, Tcl_Obj *listPtr, const double screen[], const double world[], int option);
 static void inline polarLinLin(const esweep_object *obj, Tcl_Obj *listPtr, const double screen[], const double world[], int option);
+static void inline surfaceRow(const esweep_object *obj, Tcl_Obj *listPtr, const double screen[], const double world[], int xlog);
 
 int esweepGetCoords(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
 	const char *opts[] = {"-obj", "-screen", "-world", "-log", "-opt", NULL};
@@ -166,6 +167,14 @@ int esweepGetCoords(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj
 			if (xlog == 0 && ylog == 0) polarLinLin(obj, listPtr, screen, world, optDef);
 			else if (xlog == 1 && ylog == 0) polarLogLin(obj, listPtr, screen, world, optDef);
 			break;
+		case SURFACE:
+			/* only surfaces with one row, like from esweep_logResample(), the x coordinates are the abscissa */
+			if (((Surface*) obj->data)->ysize != 1) {
+				Tcl_SetResult(interp, "Only surfaces with one row can be converted", TCL_STATIC);
+				return TCL_ERROR;
+			}
+			if (ylog == 0) surfaceRow(obj, listPtr, screen, world, xlog);
+			break;
 		default:
 			Tcl_SetResult(interp, "Unknown type of esweep object", TCL_STATIC);
 			return TCL_ERROR;
@@ -313,3 +322,20 @@ static void inline polarLinLin(const esweep_object *obj, Tcl_Obj *listPtr, const
 	}
 }
 
+static void inline surfaceRow(const esweep_object *obj, Tcl_Obj *listPtr, const double screen[], const double world[], int xlog) {
+	int i;
+	int x, y;
+	double xscale, yscale;
+	Surface *surf=(Surface*) obj->data;
+
+	xscale=xlog ? (screen[2]-screen[0])/(log10(world[2]/world[0])) : (screen[2]-screen[0])/(world[2]-world[0]);
+	yscale=(screen[3]-screen[1])/(world[3]-world[1]);
+
+	for (i=0; i < surf->xsize; i++) {
+		if (xlog && surf->x[i] <= 0.0) continue;
+		x=(int) (0.5+(xlog ? xscale*log10(surf->x[i]/world[0]) : xscale*(surf->x[i]-world[0]))+screen[0]);
+		y=(int) (0.5+yscale*(world[3]-surf->z[i])+screen[1]);
+		Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewIntObj(x));
+		Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewIntObj(y));
+	}
+}
@@ -264,14 +264,15 @@ int esweepDelay(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CO
 int esweepSmooth(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
 	esweep_object *obj=NULL; 
 	Tcl_Obj *tclObj=NULL; 
-	const char *opts[] = {"-obj", "-factor", NULL};
-	int optMask[] = {1, 1}; // necessary options
-	enum optIdx {objIdx, factorIdx};
+	const char *opts[] = {"-obj", "-factor", "-mode", NULL};
+	int optMask[] = {1, 1, 0}; // necessary options
+	enum optIdx {objIdx, factorIdx, modeIdx};
 	int obji;
 	int index; 
 	double factor; 
+	const char *mode=NULL; 
 
-	CHECK_NUM_ARGS(objc == 5, "-obj objVarName -factor value"); 
+	CHECK_NUM_ARGS(objc == 5 || objc == 7, "-obj objVarName -factor value ?-mode magnitude|power|complex?"); 
 
 	for (obji=1; obji < objc; obji+=2) {
 		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
@@ -287,6 +288,9 @@ int esweepSmooth(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *C
 					return TCL_ERROR;
 				}
 				break; 
+			case modeIdx:
+				mode=Tcl_GetString(objv[obji+1]); 
+				break; 
 		}
 		optMask[index]=0; 
 	}
@@ -294,12 +298,347 @@ int esweepSmooth(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *C
 
 	DUPLICATE_WHEN_SHARED(tclObj, in);
 
-	ESWEEP_TCL_ASSERT(esweep_smooth(obj, factor) == ERR_OK); 
+	ESWEEP_TCL_ASSERT(esweep_smoothExt(obj, factor, mode) == ERR_OK); 
 	Tcl_SetObjResult(interp, tclObj); 
 	Tcl_InvalidateStringRep(tclObj);  
 	return TCL_OK; 
 }
 
+/*
+ * ::esweep::smoothLog -obj obj -factor value -from f1 -to f2 -points n ?-mode magnitude|power|complex?
+ * Returns the flat list {freq abs arg freq abs arg ...}
+ */
+int esweepSmoothLog(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_object *obj=NULL; 
+	Tcl_Obj *listPtr; 
+	const char *opts[] = {"-obj", "-factor", "-from", "-to", "-points", "-mode", NULL};
+	int optMask[] = {1, 1, 1, 1, 1, 0}; // necessary options
+	enum optIdx {objIdx, factorIdx, fromIdx, toIdx, pointsIdx, modeIdx};
+	int obji;
+	int index, i; 
+	double factor, f1, f2; 
+	int points=0; 
+	const char *mode=NULL; 
+	Real *freq; 
+	Polar *out; 
+
+	CHECK_NUM_ARGS(objc == 11 || objc == 13, "-obj obj -factor value -from value -to value -points value ?-mode magnitude|power|complex?"); 
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR; 
+		}
+		switch (index) {
+			case objIdx: 
+				CHECK_ESWEEP_OBJECT(obji+1, obj); 
+				break;
+			case factorIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &factor)==TCL_ERROR) {
+					Tcl_SetResult(interp, "option -factor invalid", TCL_STATIC); 
+					return TCL_ERROR;
+				}
+				break; 
+			case fromIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &f1)==TCL_ERROR) {
+					Tcl_SetResult(interp, "option -from invalid", TCL_STATIC); 
+					return TCL_ERROR;
+				}
+				break; 
+			case toIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &f2)==TCL_ERROR) {
+					Tcl_SetResult(interp, "option -to invalid", TCL_STATIC); 
+					return TCL_ERROR;
+				}
+				break; 
+			case pointsIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &points)==TCL_ERROR || points < 2) {
+					Tcl_SetResult(interp, "option -points invalid", TCL_STATIC); 
+					return TCL_ERROR;
+				}
+				break; 
+			case modeIdx:
+				mode=Tcl_GetString(objv[obji+1]); 
+				break; 
+		}
+		optMask[index]=0; 
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index); 
+
+	ESWEEP_MALLOC(freq, points, sizeof(Real), TCL_ERROR); 
+	ESWEEP_MALLOC(out, points, sizeof(Polar), TCL_ERROR); 
+	if (esweep_smoothLog(obj, factor, mode, f1, f2, points, freq, out) != ERR_OK) {
+		free(freq); 
+		free(out); 
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(errmsg, -1)); 
+		return TCL_ERROR; 
+	}
+	listPtr=Tcl_NewListObj(0, NULL); 
+	for (i=0; i < points; i++) {
+		Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj(freq[i])); 
+		Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj(out[i].abs)); 
+		Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj(out[i].arg)); 
+	}
+	free(freq); 
+	free(out); 
+	Tcl_SetObjResult(interp, listPtr); 
+	return TCL_OK; 
+}
+
+/*
+ * ::esweep::logResample -obj obj -range {fmin fmax} -ppo n ?-mode power|max? ?-surface objVarName?
+ * Returns a surface with one row, the frequencies are the x coordinates. If -surface is given,
+ * the result is written into this object, which is only reallocated when its size does not match.
+ */
+int esweepLogResample(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_object *in=NULL, *out=NULL;
+	Tcl_Obj *tclObj=NULL;
+	Tcl_Obj **range;
+	const char *opts[] = {"-obj", "-range", "-ppo", "-mode", "-surface", NULL};
+	int optMask[] = {1, 1, 1, 0, 0, 0}; // necessary options
+	enum optIdx {objIdx, rangeIdx, ppoIdx, modeIdx, surfIdx};
+	int obji;
+	int index, n;
+	int ppo=0;
+	double fmin=0.0, fmax=0.0;
+	const char *mode=NULL;
+
+	CHECK_NUM_ARGS(objc >= 7 && objc <= 11 && (objc-1)%2 == 0, "-obj obj -range {fmin fmax} -ppo n ?-mode power|max? ?-surface objVarName?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case objIdx:
+				CHECK_ESWEEP_OBJECT(obji+1, in);
+				break;
+			case rangeIdx:
+				if (Tcl_ListObjGetElements(NULL, objv[obji+1], &n, &range)!=TCL_OK || n != 2 ||
+				    Tcl_GetDoubleFromObj(NULL, range[0], &fmin)!=TCL_OK ||
+				    Tcl_GetDoubleFromObj(NULL, range[1], &fmax)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -range invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case ppoIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &ppo)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -ppo invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case modeIdx:
+				mode=Tcl_GetString(objv[obji+1]);
+				break;
+			case surfIdx:
+				CHECK_ESWEEP_OBJECT2(obji+1, tclObj, out);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	if (tclObj != NULL) {
+		DUPLICATE_WHEN_SHARED(tclObj, out);
+		ESWEEP_TCL_ASSERT(esweep_logResample(out, in, fmin, fmax, ppo, mode) == ERR_OK);
+	} else {
+		ESWEEP_TCL_ASSERT((out=esweep_create("surface", in->samplerate, 0))!=NULL);
+		if (esweep_logResample(out, in, fmin, fmax, ppo, mode) != ERR_OK) {
+			esweep_free(out);
+			Tcl_SetObjResult(interp, Tcl_NewStringObj(errmsg, -1));
+			return TCL_ERROR;
+		}
+		tclObj=Tcl_NewObj();
+		tclObj->internalRep.otherValuePtr=out;
+		tclObj->typePtr=(Tcl_ObjType*) &tclEsweepObjType;
+	}
+	Tcl_InvalidateStringRep(tclObj);
+	Tcl_SetObjResult(interp, tclObj);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::toneAnalyze -obj obj -frequencies list
+ * Returns the flat list {freq abs arg freq abs arg ...}
+ */
+int esweepToneAnalyze(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_object *obj=NULL; 
+	Tcl_Obj *listPtr, **freqObjs=NULL; 
+	const char *opts[] = {"-obj", "-frequencies", NULL};
+	int optMask[] = {1, 1}; // necessary options
+	enum optIdx {objIdx, freqIdx};
+	int obji;
+	int index, i, n=0; 
+	double value; 
+	Real *freq; 
+	Polar *out; 
+
+	CHECK_NUM_ARGS(objc == 5, "-obj obj -frequencies list"); 
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR; 
+		}
+		switch (index) {
+			case objIdx: 
+				CHECK_ESWEEP_OBJECT(obji+1, obj); 
+				break;
+			case freqIdx:
+				if (Tcl_ListObjGetElements(interp, objv[obji+1], &n, &freqObjs) != TCL_OK || n < 1) {
+					Tcl_SetResult(interp, "option -frequencies invalid", TCL_STATIC); 
+					return TCL_ERROR;
+				}
+				break; 
+		}
+		optMask[index]=0; 
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index); 
+
+	ESWEEP_MALLOC(freq, n, sizeof(Real), TCL_ERROR); 
+	for (i=0; i < n; i++) {
+		if (Tcl_GetDoubleFromObj(NULL, freqObjs[i], &value)==TCL_ERROR) {
+			free(freq); 
+			Tcl_SetResult(interp, "option -frequencies invalid", TCL_STATIC); 
+			return TCL_ERROR;
+		}
+		freq[i]=value; 
+	}
+	ESWEEP_MALLOC(out, n, sizeof(Polar), TCL_ERROR); 
+	if (esweep_toneAnalyze(obj, freq, n, out) != ERR_OK) {
+		free(freq); 
+		free(out); 
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(errmsg, -1)); 
+		return TCL_ERROR; 
+	}
+	listPtr=Tcl_NewListObj(0, NULL); 
+	for (i=0; i < n; i++) {
+		Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj(freq[i])); 
+		Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj(out[i].abs)); 
+		Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj(out[i].arg)); 
+	}
+	free(freq); 
+	free(out); 
+	Tcl_SetObjResult(interp, listPtr); 
+	return TCL_OK; 
+}
+
+/*
+ * ::esweep::thd -obj obj -frequency f0 ?-harmonics n?
+ * Returns the list {thd value thdn value harmonics {abs arg abs arg ...}}, the default are 10 harmonics
+ */
+int esweepThd(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_object *obj=NULL; 
+	Tcl_Obj *listPtr, *hPtr; 
+	const char *opts[] = {"-obj", "-frequency", "-harmonics", NULL};
+	int optMask[] = {1, 1, 0}; // necessary options
+	enum optIdx {objIdx, freqIdx, harmIdx};
+	int obji;
+	int index, i, harmonics=10; 
+	double f0; 
+	Real thd, thdn; 
+	Polar *out; 
+
+	CHECK_NUM_ARGS(objc == 5 || objc == 7, "-obj obj -frequency value ?-harmonics value?"); 
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR; 
+		}
+		switch (index) {
+			case objIdx: 
+				CHECK_ESWEEP_OBJECT(obji+1, obj); 
+				break;
+			case freqIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &f0)==TCL_ERROR) {
+					Tcl_SetResult(interp, "option -frequency invalid", TCL_STATIC); 
+					return TCL_ERROR;
+				}
+				break; 
+			case harmIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &harmonics)==TCL_ERROR || harmonics < 1) {
+					Tcl_SetResult(interp, "option -harmonics invalid", TCL_STATIC); 
+					return TCL_ERROR;
+				}
+				break; 
+		}
+		optMask[index]=0; 
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index); 
+
+	ESWEEP_MALLOC(out, harmonics, sizeof(Polar), TCL_ERROR); 
+	if (esweep_thd(obj, f0, harmonics, &thd, &thdn, out) != ERR_OK) {
+		free(out); 
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(errmsg, -1)); 
+		return TCL_ERROR; 
+	}
+	hPtr=Tcl_NewListObj(0, NULL); 
+	for (i=0; i < harmonics; i++) {
+		Tcl_ListObjAppendElement(NULL, hPtr, Tcl_NewDoubleObj(out[i].abs)); 
+		Tcl_ListObjAppendElement(NULL, hPtr, Tcl_NewDoubleObj(out[i].arg)); 
+	}
+	free(out); 
+	listPtr=Tcl_NewListObj(0, NULL); 
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("thd", -1)); 
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj(thd)); 
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("thdn", -1)); 
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj(thdn)); 
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("harmonics", -1)); 
+	Tcl_ListObjAppendElement(NULL, listPtr, hPtr); 
+	Tcl_SetObjResult(interp, listPtr); 
+	return TCL_OK; 
+}
+
+/*
+ * ::esweep::imd -obj obj -f1 value -f2 value ?-order n?
+ * Returns the IMD as ratio, relative to f2; the default order is 3
+ */
+int esweepImd(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_object *obj=NULL; 
+	const char *opts[] = {"-obj", "-f1", "-f2", "-order", NULL};
+	int optMask[] = {1, 1, 1, 0}; // necessary options
+	enum optIdx {objIdx, f1Idx, f2Idx, orderIdx};
+	int obji;
+	int index, order=3; 
+	double f1, f2; 
+	Real imd; 
+
+	CHECK_NUM_ARGS(objc == 7 || objc == 9, "-obj obj -f1 value -f2 value ?-order value?"); 
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR; 
+		}
+		switch (index) {
+			case objIdx: 
+				CHECK_ESWEEP_OBJECT(obji+1, obj); 
+				break;
+			case f1Idx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &f1)==TCL_ERROR) {
+					Tcl_SetResult(interp, "option -f1 invalid", TCL_STATIC); 
+					return TCL_ERROR;
+				}
+				break; 
+			case f2Idx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &f2)==TCL_ERROR) {
+					Tcl_SetResult(interp, "option -f2 invalid", TCL_STATIC); 
+					return TCL_ERROR;
+				}
+				break; 
+			case orderIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &order)==TCL_ERROR) {
+					Tcl_SetResult(interp, "option -order invalid", TCL_STATIC); 
+					return TCL_ERROR;
+				}
+				break; 
+		}
+		optMask[index]=0; 
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index); 
+
+	ESWEEP_TCL_ASSERT(esweep_imd(obj, f1, f2, order, &imd) == ERR_OK); 
+	Tcl_SetObjResult(interp, Tcl_NewDoubleObj(imd)); 
+	return TCL_OK; 
+}
+
 int esweepUnwrapPhase(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
 	esweep_object *obj=NULL; 
 	Tcl_Obj *tclObj=NULL; 
@@ -457,6 +796,53 @@ int esweepWindow(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *C
 	return TCL_OK; 
 }
 
+int esweepWindowInfo(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	Tcl_Obj *listPtr=NULL; 
+	const char *opts[] = {"-window", "-size", NULL};
+	int optMask[] = {1, 1}; // necessary options
+	enum optIdx {windowIdx, sizeIdx};
+	int obji;
+	int index; 
+	char *window=NULL; 
+	int size=0; 
+	Real cg, enbw; 
+
+	CHECK_NUM_ARGS(objc == 5, "-window name -size value"); 
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR; 
+		}
+		switch (index) {
+			case windowIdx:
+				if ((window=Tcl_GetString(objv[obji+1]))==NULL) {
+				/* almost impossible */
+					Tcl_SetResult(interp, "option -window invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case sizeIdx: 
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &size)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -size invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break; 
+		}
+		optMask[index]=0; 
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index); 
+
+	ESWEEP_TCL_ASSERT(esweep_windowInfo(window, size, &cg, &enbw) == ERR_OK); 
+
+	listPtr=Tcl_NewListObj(0, NULL); 
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("coherentGain", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj(cg));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("enbw", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj(enbw));
+	Tcl_SetObjResult(interp, listPtr); 
+	return TCL_OK; 
+}
+
 int esweepPeakDetect(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
 	esweep_object *obj=NULL; 
 	Tcl_Obj *listPtr=NULL; 
@@ -514,6 +900,96 @@ int esweepPeakDetect(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Ob
 	return TCL_OK; 
 }
 
+/*
+ * ::esweep::peakFind -obj obj -threshold value ?-distance samples? ?-prominence value? ?-interpolation none|parabolic|gaussian? ?-numPeaks value?
+ * Returns a list of peaks, each one the list {index value position value x value level value prominence value}
+ */
+int esweepPeakFind(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_object *obj=NULL;
+	esweep_peak *peaks;
+	Tcl_Obj *listPtr, *peakPtr;
+	const char *opts[] = {"-obj", "-threshold", "-distance", "-prominence", "-interpolation", "-numPeaks", NULL};
+	int optMask[] = {1, 1, 0, 0, 0, 0, 0}; // necessary options
+	enum optIdx {objIdx, thresIdx, distIdx, promIdx, interpIdx, numIdx};
+	int obji;
+	int index;
+	double threshold, distance=0.0, prominence=0.0;
+	const char *interpolation="parabolic";
+	int n=0, i;
+
+	CHECK_NUM_ARGS(objc >= 5 && objc <= 13 && (objc-1)%2 == 0, "-obj obj -threshold value ?-distance samples? ?-prominence value? ?-interpolation none|parabolic|gaussian? ?-numPeaks value?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case objIdx:
+				CHECK_ESWEEP_OBJECT(obji+1, obj);
+				break;
+			case thresIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &threshold)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -threshold invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case distIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &distance)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -distance invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case promIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &prominence)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -prominence invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case interpIdx:
+				interpolation=Tcl_GetString(objv[obji+1]);
+				break;
+			case numIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &n)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -numPeaks invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	if (n <= 0) {
+		ESWEEP_TCL_ASSERT(esweep_size(obj, &n) == ERR_OK);
+	}
+	ESWEEP_MALLOC(peaks, n, sizeof(esweep_peak), TCL_ERROR);
+	if (esweep_peakFind(obj, threshold, distance, prominence, interpolation, peaks, &n) != ERR_OK) {
+		free(peaks);
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(errmsg, -1));
+		return TCL_ERROR;
+	}
+
+	listPtr=Tcl_NewListObj(0, NULL);
+	for (i=0; i < n; i++) {
+		peakPtr=Tcl_NewListObj(0, NULL);
+		Tcl_ListObjAppendElement(NULL, peakPtr, Tcl_NewStringObj("index", -1));
+		Tcl_ListObjAppendElement(NULL, peakPtr, Tcl_NewIntObj(peaks[i].index));
+		Tcl_ListObjAppendElement(NULL, peakPtr, Tcl_NewStringObj("position", -1));
+		Tcl_ListObjAppendElement(NULL, peakPtr, Tcl_NewDoubleObj(peaks[i].position));
+		Tcl_ListObjAppendElement(NULL, peakPtr, Tcl_NewStringObj("x", -1));
+		Tcl_ListObjAppendElement(NULL, peakPtr, Tcl_NewDoubleObj(peaks[i].x));
+		Tcl_ListObjAppendElement(NULL, peakPtr, Tcl_NewStringObj("level", -1));
+		Tcl_ListObjAppendElement(NULL, peakPtr, Tcl_NewDoubleObj(peaks[i].level));
+		Tcl_ListObjAppendElement(NULL, peakPtr, Tcl_NewStringObj("prominence", -1));
+		Tcl_ListObjAppendElement(NULL, peakPtr, Tcl_NewDoubleObj(peaks[i].prominence));
+		Tcl_ListObjAppendElement(NULL, listPtr, peakPtr);
+	}
+	free(peaks);
+
+	Tcl_SetObjResult(interp, listPtr);
+	return TCL_OK;
+}
+
 int esweepIntegrate(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
 	esweep_object *obj=NULL; 
 	Tcl_Obj *tclObj=NULL; 
@@ -577,3 +1053,43 @@ int esweepDifferentiate(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl
 	Tcl_InvalidateStringRep(tclObj);  
 	return TCL_OK; 
 }
+
+/*
+ * ::esweep::envelope -obj objVarName ?-mode magnitude|etc|phase|frequency?
+ * The default mode is magnitude
+ */
+int esweepEnvelope(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_object *obj=NULL;
+	Tcl_Obj *tclObj=NULL;
+	const char *opts[] = {"-obj", "-mode", NULL};
+	int optMask[] = {1, 0, 0}; // necessary options
+	enum optIdx {objIdx, modeIdx};
+	int obji;
+	int index;
+	const char *mode="magnitude";
+
+	CHECK_NUM_ARGS(objc == 3 || objc == 5, "-obj objVarName ?-mode magnitude|etc|phase|frequency?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case objIdx:
+				CHECK_ESWEEP_OBJECT2(obji+1, tclObj, obj);
+				break;
+			case modeIdx:
+				mode=Tcl_GetString(objv[obji+1]);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	DUPLICATE_WHEN_SHARED(tclObj, obj);
+
+	ESWEEP_TCL_ASSERT(esweep_envelope(obj, mode) == ERR_OK);
+	Tcl_SetObjResult(interp, tclObj);
+	Tcl_InvalidateStringRep(tclObj);
+	return TCL_OK;
+}
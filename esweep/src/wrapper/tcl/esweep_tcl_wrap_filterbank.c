@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * esweep_tcl_wrap_filterbank.c
+ * Wraps the esweep_filterbank.c source file
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <tcl.h>
+#include "esweep_tcl_wrap.h"
+
+#define FILTERBANK_HANDLE "filterBank"
+
+static int freeFilterBank(void *bank) {
+	return esweep_filterBankFree((esweep_filterBank*) bank);
+}
+
+/*
+ * ::esweep::filterBankCreate -samplerate sr -channels M -hop D ?-taps T? ?-prototype obj?
+ * The default prototype has 4 taps per channel
+ */
+int esweepFilterBankCreate(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_filterBank *bank;
+	esweep_object *prototype=NULL;
+	Tcl_Obj *ret;
+	const char *opts[] = {"-samplerate", "-channels", "-hop", "-taps", "-prototype", NULL};
+	int optMask[] = {1, 1, 1, 0, 0, 0}; // necessary options
+	enum optIdx {srIdx, channelsIdx, hopIdx, tapsIdx, protoIdx};
+	int obji;
+	int index;
+	int samplerate=0, channels=0, hop=0, taps=4;
+
+	CHECK_NUM_ARGS(objc >= 7 && objc <= 11 && (objc-1)%2 == 0, "-samplerate value -channels value -hop value ?-taps value? ?-prototype obj?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case srIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &samplerate)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -samplerate invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case channelsIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &channels)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -channels invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case hopIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &hop)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -hop invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case tapsIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &taps)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -taps invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case protoIdx:
+				CHECK_ESWEEP_OBJECT(obji+1, prototype);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT((bank=esweep_filterBankCreate(samplerate, channels, hop, taps, prototype)) != NULL);
+	if ((ret=esweepNewHandleObj(FILTERBANK_HANDLE, bank, freeFilterBank)) == NULL) {
+		esweep_filterBankFree(bank);
+		return TCL_ERROR;
+	}
+	Tcl_SetObjResult(interp, ret);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::filterBankInfo -bank handle
+ * Returns the list {bins value hop value latency value}
+ */
+int esweepFilterBankInfo(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_filterBank *bank=NULL;
+	Tcl_Obj *listPtr;
+	const char *opts[] = {"-bank", NULL};
+	int optMask[] = {1, 0}; // necessary options
+	enum optIdx {bankIdx};
+	int obji;
+	int index;
+	int bins, hop, latency;
+
+	CHECK_NUM_ARGS(objc == 3, "-bank handle");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case bankIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, FILTERBANK_HANDLE, bank);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_filterBankInfo(bank, &bins, &hop, &latency) == ERR_OK);
+	listPtr=Tcl_NewListObj(0, NULL);
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("bins", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewIntObj(bins));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("hop", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewIntObj(hop));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("latency", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewIntObj(latency));
+	Tcl_SetObjResult(interp, listPtr);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::filterBankAnalyze -bank handle -signal obj
+ * Returns a new complex object with the frames of channel samples
+ */
+int esweepFilterBankAnalyze(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_filterBank *bank=NULL;
+	esweep_object *in=NULL, *out;
+	Tcl_Obj *ret;
+	const char *opts[] = {"-bank", "-signal", NULL};
+	int optMask[] = {1, 1, 0}; // necessary options
+	enum optIdx {bankIdx, sigIdx};
+	int obji;
+	int index;
+	int samplerate;
+
+	CHECK_NUM_ARGS(objc == 5, "-bank handle -signal obj");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case bankIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, FILTERBANK_HANDLE, bank);
+				break;
+			case sigIdx:
+				CHECK_ESWEEP_OBJECT(obji+1, in);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_samplerate(in, &samplerate)==ERR_OK);
+	ESWEEP_TCL_ASSERT((out=esweep_create("complex", samplerate, 0))!=NULL);
+	if (esweep_filterBankAnalyze(bank, out, in, NULL) != ERR_OK) {
+		esweep_free(out);
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(errmsg, -1));
+		return TCL_ERROR;
+	}
+	ret=Tcl_NewObj();
+	ret->internalRep.otherValuePtr=out;
+	ret->typePtr=(Tcl_ObjType*) &tclEsweepObjType;
+	Tcl_InvalidateStringRep(ret);
+	Tcl_SetObjResult(interp, ret);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::filterBankSynthesize -bank handle -subbands obj
+ * Returns a new wave object
+ */
+int esweepFilterBankSynthesize(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_filterBank *bank=NULL;
+	esweep_object *in=NULL, *out;
+	Tcl_Obj *ret;
+	const char *opts[] = {"-bank", "-subbands", NULL};
+	int optMask[] = {1, 1, 0}; // necessary options
+	enum optIdx {bankIdx, subIdx};
+	int obji;
+	int index;
+	int samplerate;
+
+	CHECK_NUM_ARGS(objc == 5, "-bank handle -subbands obj");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case bankIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, FILTERBANK_HANDLE, bank);
+				break;
+			case subIdx:
+				CHECK_ESWEEP_OBJECT(obji+1, in);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_samplerate(in, &samplerate)==ERR_OK);
+	ESWEEP_TCL_ASSERT((out=esweep_create("wave", samplerate, 0))!=NULL);
+	if (esweep_filterBankSynthesize(bank, out, in) != ERR_OK) {
+		esweep_free(out);
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(errmsg, -1));
+		return TCL_ERROR;
+	}
+	ret=Tcl_NewObj();
+	ret->internalRep.otherValuePtr=out;
+	ret->typePtr=(Tcl_ObjType*) &tclEsweepObjType;
+	Tcl_InvalidateStringRep(ret);
+	Tcl_SetObjResult(interp, ret);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::filterBankReset -bank handle
+ */
+int esweepFilterBankReset(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_filterBank *bank=NULL;
+	const char *opts[] = {"-bank", NULL};
+	int optMask[] = {1, 0}; // necessary options
+	enum optIdx {bankIdx};
+	int obji;
+	int index;
+
+	CHECK_NUM_ARGS(objc == 3, "-bank handle");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case bankIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, FILTERBANK_HANDLE, bank);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_filterBankReset(bank) == ERR_OK);
+	return TCL_OK;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * esweep_tcl_wrap_fp.c
+ * Wraps the esweep_fp.c source file
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <tcl.h>
+#include "esweep_tcl_wrap.h"
+
+/*
+ * ::esweep::denormals ?-mode off|ftz|dc|all?
+ * Without options the current policy is returned, otherwise it is set first
+ */
+int esweepDenormals(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	const char *opts[] = {"-mode", NULL};
+	enum optIdx {modeIdx};
+	int obji;
+	int index;
+	const char *mode=NULL;
+
+	CHECK_NUM_ARGS(objc == 1 || objc == 3, "?-mode off|ftz|dc|all?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case modeIdx:
+				ESWEEP_TCL_ASSERT(esweep_setDenormals(Tcl_GetString(objv[obji+1])) == ERR_OK);
+				break;
+		}
+	}
+
+	ESWEEP_TCL_ASSERT(esweep_getDenormals(&mode) == ERR_OK);
+
+	Tcl_SetObjResult(interp, Tcl_NewStringObj(mode, -1));
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::nonFinite ?-mode clamp|propagate|error? ?-reset 0|1?
+ * Returns the current policy and the counters as a list {mode m inf n nan n clamped n}
+ * With -reset 1 the counters are cleared after reading them
+ */
+int esweepNonFinite(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	const char *opts[] = {"-mode", "-reset", NULL};
+	enum optIdx {modeIdx, resetIdx};
+	int obji;
+	int index;
+	int reset=0;
+	long inf, nan, clamped;
+	const char *mode=NULL;
+	Tcl_Obj *listPtr;
+
+	CHECK_NUM_ARGS(objc == 1 || objc == 3 || objc == 5, "?-mode clamp|propagate|error? ?-reset 0|1?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case modeIdx:
+				ESWEEP_TCL_ASSERT(esweep_setNonFinite(Tcl_GetString(objv[obji+1])) == ERR_OK);
+				break;
+			case resetIdx:
+				if (Tcl_GetBooleanFromObj(NULL, objv[obji+1], &reset)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -reset invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+		}
+	}
+
+	ESWEEP_TCL_ASSERT(esweep_getNonFinite(&mode) == ERR_OK);
+	ESWEEP_TCL_ASSERT(esweep_getNonFiniteCount(&inf, &nan, &clamped, reset) == ERR_OK);
+
+	listPtr=Tcl_NewListObj(0, NULL);
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("mode", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj(mode, -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("inf", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewLongObj(inf));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("nan", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewLongObj(nan));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("clamped", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewLongObj(clamped));
+	Tcl_SetObjResult(interp, listPtr);
+	return TCL_OK;
+}
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * esweep_tcl_wrap_level.c
+ * Wraps the esweep_level.c source file
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <tcl.h>
+#include "esweep_tcl_wrap.h"
+
+#define LEVEL_HANDLE "levelLogger"
+
+static int freeLevelLogger(void *lv) {
+	return esweep_levelLoggerFree((esweep_levelLogger*) lv);
+}
+
+/* {time leq lmax lmin l10 l50 l90 lpeak} */
+static Tcl_Obj *levelRecordObj(const esweep_levelRecord *rec) {
+	Tcl_Obj *listPtr=Tcl_NewListObj(0, NULL);
+
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj(rec->time));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj(rec->leq));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj(rec->lmax));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj(rec->lmin));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj(rec->l10));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj(rec->l50));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj(rec->l90));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj(rec->lpeak));
+	return listPtr;
+}
+
+/*
+ * ::esweep::levelLoggerCreate -samplerate sr -interval seconds ?-weighting A|C|Z? ?-time fast|slow|impulse? ?-offset dB?
+ * The default is A weighting, fast time weighting and no offset
+ */
+int esweepLevelLoggerCreate(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_levelLogger *lv;
+	Tcl_Obj *ret;
+	const char *opts[] = {"-samplerate", "-interval", "-weighting", "-time", "-offset", NULL};
+	int optMask[] = {1, 1, 0, 0, 0, 0}; // necessary options
+	enum optIdx {srIdx, intervalIdx, weightingIdx, timeIdx, offsetIdx};
+	int obji;
+	int index;
+	int samplerate=0;
+	double interval=1.0, offset=0.0;
+	const char *weighting="A", *time="fast";
+
+	CHECK_NUM_ARGS(objc >= 5 && objc <= 11 && (objc-1)%2 == 0, "-samplerate value -interval seconds ?-weighting A|C|Z? ?-time fast|slow|impulse? ?-offset dB?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case srIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &samplerate)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -samplerate invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case intervalIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &interval)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -interval invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case weightingIdx:
+				weighting=Tcl_GetString(objv[obji+1]);
+				break;
+			case timeIdx:
+				time=Tcl_GetString(objv[obji+1]);
+				break;
+			case offsetIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &offset)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -offset invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT((lv=esweep_levelLoggerCreate(samplerate, weighting, time, interval, offset)) != NULL);
+	if ((ret=esweepNewHandleObj(LEVEL_HANDLE, lv, freeLevelLogger)) == NULL) {
+		esweep_levelLoggerFree(lv);
+		return TCL_ERROR;
+	}
+	Tcl_SetObjResult(interp, ret);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::levelLoggerProcess -logger handle -signal obj
+ * Returns a list with one record per interval completed by this block, possibly empty.
+ * Each record is the list {time leq lmax lmin l10 l50 l90 lpeak}
+ */
+int esweepLevelLoggerProcess(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_levelLogger *lv=NULL;
+	esweep_object *obj=NULL;
+	esweep_levelRecord *records=NULL;
+	Tcl_Obj *listPtr;
+	const char *opts[] = {"-logger", "-signal", NULL};
+	int optMask[] = {1, 1, 0}; // necessary options
+	enum optIdx {lvIdx, sigIdx};
+	int obji;
+	int index;
+	int i, n;
+
+	CHECK_NUM_ARGS(objc == 5, "-logger handle -signal obj");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case lvIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, LEVEL_HANDLE, lv);
+				break;
+			case sigIdx:
+				CHECK_ESWEEP_OBJECT(obji+1, obj);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	/* a block completes at most one interval per sample */
+	n=obj->size+1;
+	ESWEEP_MALLOC(records, n, sizeof(esweep_levelRecord), TCL_ERROR);
+	if (esweep_levelLoggerProcess(lv, obj, records, &n) != ERR_OK) {
+		free(records);
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(errmsg, -1));
+		return TCL_ERROR;
+	}
+	listPtr=Tcl_NewListObj(0, NULL);
+	for (i=0; i < n; i++) Tcl_ListObjAppendElement(NULL, listPtr, levelRecordObj(records+i));
+	free(records);
+	Tcl_SetObjResult(interp, listPtr);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::levelLoggerTotal -logger handle
+ * Returns the record {time leq lmax lmin l10 l50 l90 lpeak} over everything since the last reset
+ */
+int esweepLevelLoggerTotal(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_levelLogger *lv=NULL;
+	esweep_levelRecord total;
+	const char *opts[] = {"-logger", NULL};
+	int optMask[] = {1, 0}; // necessary options
+	enum optIdx {lvIdx};
+	int obji;
+	int index;
+
+	CHECK_NUM_ARGS(objc == 3, "-logger handle");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case lvIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, LEVEL_HANDLE, lv);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_levelLoggerTotal(lv, &total) == ERR_OK);
+	Tcl_SetObjResult(interp, levelRecordObj(&total));
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::levelLoggerReset -logger handle
+ */
+int esweepLevelLoggerReset(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_levelLogger *lv=NULL;
+	const char *opts[] = {"-logger", NULL};
+	int optMask[] = {1, 0}; // necessary options
+	enum optIdx {lvIdx};
+	int obji;
+	int index;
+
+	CHECK_NUM_ARGS(objc == 3, "-logger handle");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case lvIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, LEVEL_HANDLE, lv);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_levelLoggerReset(lv) == ERR_OK);
+	return TCL_OK;
+}
@@ -357,6 +357,68 @@ int esweepSqsum(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CO
 	return TCL_OK;
 }
 
+/*
+ * ::esweep::stats -obj esweepObj ?-threads n?
+ * Returns {n n sum x sqsum x mean x rms x min x max x argmin i argmax i crest x}
+ */
+int esweepStats(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_object *obj=NULL;
+	const char *opts[] = {"-obj", "-threads", NULL};
+	int optMask[] = {1, 0}; // necessary options
+	enum optIdx {objIdx, threadsIdx};
+	int obji;
+	int index;
+	int threads=0;
+	esweep_statistics stats;
+	Tcl_Obj *listPtr;
+
+	CHECK_NUM_ARGS(objc == 3 || objc == 5, "-obj esweepObj ?-threads n?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case objIdx:
+				CHECK_ESWEEP_OBJECT(obji+1, obj);
+				break;
+			case threadsIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &threads)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -threads invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_stats(obj, &stats, threads) == ERR_OK);
+	listPtr=Tcl_NewListObj(0, NULL);
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("n", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewIntObj(stats.n));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("sum", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj((double) stats.sum));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("sqsum", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj((double) stats.sqsum));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("mean", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj((double) stats.mean));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("rms", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj((double) stats.rms));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("min", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj((double) stats.min));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("max", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj((double) stats.max));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("argmin", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewIntObj(stats.argmin));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("argmax", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewIntObj(stats.argmax));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("crest", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewDoubleObj((double) stats.crest));
+	Tcl_SetObjResult(interp, listPtr);
+	return TCL_OK;
+}
+
 int esweepReal(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
 	esweep_object *obj=NULL;
 	Tcl_Obj *tclObj=NULL;
@@ -634,6 +696,150 @@ int esweepSchroeder(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj
 	return TCL_OK;
 }
 
+/*
+ * ::esweep::eval -obj varName -expr expression ?-vars {name value ...}?
+ * Evaluates the expression for every element in a single pass, see esweep_eval().
+ * Pass changing values with -vars instead of substituting them into the expression,
+ * so the compiled expression can be reused.
+ */
+int esweepEval(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_object *obj=NULL;
+	Tcl_Obj *tclObj=NULL, **varObjs=NULL;
+	const char *opts[] = {"-obj", "-expr", "-vars", NULL};
+	int optMask[] = {1, 1, 0}; // necessary options
+	enum optIdx {objIdx, exprIdx, varsIdx};
+	int obji;
+	int index, i, n=0;
+	const char *expr=NULL;
+	const char *names[16];
+	Real values[16];
+	double value;
+
+	CHECK_NUM_ARGS(objc == 5 || objc == 7, "-obj varName -expr expression ?-vars {name value ...}?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case objIdx:
+				CHECK_ESWEEP_OBJECT2(obji+1, tclObj, obj);
+				break;
+			case exprIdx:
+				expr=Tcl_GetString(objv[obji+1]);
+				break;
+			case varsIdx:
+				if (Tcl_ListObjGetElements(interp, objv[obji+1], &n, &varObjs) != TCL_OK) {
+					return TCL_ERROR;
+				}
+				if (n % 2 != 0 || n/2 > 16) {
+					Tcl_SetResult(interp, "option -vars must be a list of at most 16 names and values", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	for (i=0; i < n/2; i++) {
+		names[i]=Tcl_GetString(varObjs[2*i]);
+		if (Tcl_GetDoubleFromObj(NULL, varObjs[2*i+1], &value)==TCL_ERROR) {
+			Tcl_SetResult(interp, "option -vars: value invalid", TCL_STATIC);
+			return TCL_ERROR;
+		}
+		values[i]=(Real) value;
+	}
+
+	DUPLICATE_WHEN_SHARED(tclObj, obj);
+	ESWEEP_TCL_ASSERT(esweep_eval(obj, expr, n/2, names, values) == ERR_OK);
+	Tcl_SetObjResult(interp, tclObj);
+	Tcl_InvalidateStringRep(tclObj);
+	return TCL_OK;
+}
+
+
+/*
+ * ::esweep::roomAcoustics -obj ir ?-bands {0 63 125 ... 8000}? ?-threads n?
+ * Returns a list with one element per band, each a list of parameter names and values;
+ * the value of a parameter which is not available is empty
+ */
+int esweepRoomAcoustics(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_object *obj=NULL;
+	Tcl_Obj *listPtr, *bandPtr, **bandObjs=NULL;
+	const char *opts[] = {"-obj", "-bands", "-threads", NULL};
+	int optMask[] = {1, 0, 0}; // necessary options
+	enum optIdx {objIdx, bandsIdx, threadsIdx};
+	int obji;
+	int index, i, j;
+	int n_bands=9, threads=0;
+	double value;
+	Real *fc;
+	esweep_roomParams *params;
+	const Real octaves[] = {0, 63, 125, 250, 500, 1000, 2000, 4000, 8000};
+
+	CHECK_NUM_ARGS(objc == 3 || objc == 5 || objc == 7, "-obj ir ?-bands list? ?-threads n?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case objIdx:
+				CHECK_ESWEEP_OBJECT(obji+1, obj);
+				break;
+			case bandsIdx:
+				if (Tcl_ListObjGetElements(interp, objv[obji+1], &n_bands, &bandObjs) != TCL_OK || n_bands < 1) {
+					Tcl_SetResult(interp, "option -bands invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case threadsIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &threads)==TCL_ERROR) {
+					Tcl_SetResult(interp, "option -threads invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_MALLOC(fc, n_bands, sizeof(Real), TCL_ERROR);
+	for (i=0; i < n_bands; i++) {
+		if (bandObjs == NULL) fc[i]=octaves[i];
+		else if (Tcl_GetDoubleFromObj(NULL, bandObjs[i], &value)==TCL_ERROR) {
+			free(fc);
+			Tcl_SetResult(interp, "option -bands invalid", TCL_STATIC);
+			return TCL_ERROR;
+		} else fc[i]=value;
+	}
+	ESWEEP_MALLOC(params, n_bands, sizeof(esweep_roomParams), TCL_ERROR);
+	if (esweep_roomAcoustics(obj, fc, n_bands, threads, params) != ERR_OK) {
+		free(fc);
+		free(params);
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(errmsg, -1));
+		return TCL_ERROR;
+	}
+
+	listPtr=Tcl_NewListObj(0, NULL);
+	for (i=0; i < n_bands; i++) {
+		const char *names[] = {"fc", "onset", "edt", "t20", "t30", "c50", "c80", "d50", "ts", "noise", "crosspoint"};
+		const Real values[] = {params[i].fc, params[i].onset, params[i].edt, params[i].t20, params[i].t30,
+			params[i].c50, params[i].c80, params[i].d50, params[i].ts, params[i].noise, params[i].crosspoint};
+
+		bandPtr=Tcl_NewListObj(0, NULL);
+		for (j=0; j < (int) (sizeof(values)/sizeof(Real)); j++) {
+			Tcl_ListObjAppendElement(NULL, bandPtr, Tcl_NewStringObj(names[j], -1));
+			Tcl_ListObjAppendElement(NULL, bandPtr, isnan(values[j]) ? Tcl_NewObj() : Tcl_NewDoubleObj(values[j]));
+		}
+		Tcl_ListObjAppendElement(NULL, listPtr, bandPtr);
+	}
+	free(fc);
+	free(params);
+	Tcl_SetObjResult(interp, listPtr);
+	return TCL_OK;
+}
 
 int esweepClip(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
 	esweep_object *a=NULL, *b=NULL;
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * esweep_tcl_wrap_multires.c
+ * Wraps the esweep_multires.c source file
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <tcl.h>
+#include "esweep_tcl_wrap.h"
+
+/*
+ * ::esweep::multiResolution -signal ir -range {f1 f2} -points n ?-cycles value? ?-obj objVarName?
+ * Returns a polar object with the response at the logarithmically spaced frequencies. If -obj is given,
+ * the response is written into this object, which is only reallocated when its size does not match.
+ * The default gate is 8 cycles.
+ */
+int esweepMultiResolution(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_object *in=NULL, *out=NULL;
+	Tcl_Obj *tclObj=NULL;
+	Tcl_Obj **range;
+	const char *opts[] = {"-signal", "-range", "-points", "-cycles", "-obj", NULL};
+	int optMask[] = {1, 1, 1, 0, 0, 0}; // necessary options
+	enum optIdx {sigIdx, rangeIdx, pointsIdx, cyclesIdx, objIdx};
+	int obji;
+	int index;
+	int points=0, n;
+	double f1=0.0, f2=0.0, cycles=8.0;
+
+	CHECK_NUM_ARGS(objc >= 7 && objc <= 11 && (objc-1)%2 == 0, "-signal ir -range {f1 f2} -points n ?-cycles value? ?-obj objVarName?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case sigIdx:
+				CHECK_ESWEEP_OBJECT(obji+1, in);
+				break;
+			case rangeIdx:
+				if (Tcl_ListObjGetElements(NULL, objv[obji+1], &n, &range)!=TCL_OK || n != 2 ||
+				    Tcl_GetDoubleFromObj(NULL, range[0], &f1)!=TCL_OK ||
+				    Tcl_GetDoubleFromObj(NULL, range[1], &f2)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -range invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case pointsIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &points)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -points invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case cyclesIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &cycles)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -cycles invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case objIdx:
+				CHECK_ESWEEP_OBJECT2(obji+1, tclObj, out);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	if (tclObj != NULL) {
+		DUPLICATE_WHEN_SHARED(tclObj, out);
+		ESWEEP_TCL_ASSERT(esweep_multiResolution(out, in, cycles, f1, f2, points, NULL) == ERR_OK);
+	} else {
+		ESWEEP_TCL_ASSERT((out=esweep_create("polar", in->samplerate, 0))!=NULL);
+		if (esweep_multiResolution(out, in, cycles, f1, f2, points, NULL) != ERR_OK) {
+			esweep_free(out);
+			Tcl_SetObjResult(interp, Tcl_NewStringObj(errmsg, -1));
+			return TCL_ERROR;
+		}
+		tclObj=Tcl_NewObj();
+		tclObj->internalRep.otherValuePtr=out;
+		tclObj->typePtr=(Tcl_ObjType*) &tclEsweepObjType;
+	}
+	Tcl_InvalidateStringRep(tclObj);
+	Tcl_SetObjResult(interp, tclObj);
+	return TCL_OK;
+}
@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * esweep_tcl_wrap_spectrum.c
+ * Wraps the esweep_spectrum.c source file
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <tcl.h>
+#include "esweep_tcl_wrap.h"
+
+#define SPECTRUM_HANDLE "spectrum"
+
+static int freeSpectrum(void *spec) {
+	return esweep_spectrumFree((esweep_spectrum*) spec);
+}
+
+/*
+ * ::esweep::spectrumCreate -samplerate sr -size N ?-overlap percent? ?-window type? ?-average linear|exponential|peak? ?-tau seconds?
+ * The default is a Hann window with 50 % overlap and linear averaging
+ */
+int esweepSpectrumCreate(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_spectrum *spec;
+	Tcl_Obj *ret;
+	const char *opts[] = {"-samplerate", "-size", "-overlap", "-window", "-average", "-tau", NULL};
+	int optMask[] = {1, 1, 0, 0, 0, 0, 0}; // necessary options
+	enum optIdx {srIdx, sizeIdx, overlapIdx, winIdx, avgIdx, tauIdx};
+	int obji;
+	int index;
+	int samplerate=0, size=0;
+	double overlap=50.0, tau=1.0;
+	const char *win="hann", *average="linear";
+
+	CHECK_NUM_ARGS(objc >= 5 && objc <= 13 && (objc-1)%2 == 0, "-samplerate value -size value ?-overlap percent? ?-window type? ?-average linear|exponential|peak? ?-tau seconds?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case srIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &samplerate)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -samplerate invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case sizeIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &size)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -size invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case overlapIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &overlap)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -overlap invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case winIdx:
+				win=Tcl_GetString(objv[obji+1]);
+				break;
+			case avgIdx:
+				average=Tcl_GetString(objv[obji+1]);
+				break;
+			case tauIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &tau)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -tau invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT((spec=esweep_spectrumCreate(samplerate, size, overlap, win, average, tau)) != NULL);
+	if ((ret=esweepNewHandleObj(SPECTRUM_HANDLE, spec, freeSpectrum)) == NULL) {
+		esweep_spectrumFree(spec);
+		return TCL_ERROR;
+	}
+	Tcl_SetObjResult(interp, ret);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::spectrumProcess -spectrum handle -signal obj
+ * Returns the number of frames averaged so far
+ */
+int esweepSpectrumProcess(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_spectrum *spec=NULL;
+	esweep_object *in=NULL;
+	const char *opts[] = {"-spectrum", "-signal", NULL};
+	int optMask[] = {1, 1, 0}; // necessary options
+	enum optIdx {specIdx, sigIdx};
+	int obji;
+	int index;
+	int frames;
+
+	CHECK_NUM_ARGS(objc == 5, "-spectrum handle -signal obj");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case specIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, SPECTRUM_HANDLE, spec);
+				break;
+			case sigIdx:
+				CHECK_ESWEEP_OBJECT(obji+1, in);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_spectrumProcess(spec, in) == ERR_OK);
+	ESWEEP_TCL_ASSERT(esweep_spectrumInfo(spec, NULL, NULL, &frames) == ERR_OK);
+	Tcl_SetObjResult(interp, Tcl_NewIntObj(frames));
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::spectrumRead -spectrum handle ?-mode magnitude|power|psd? ?-obj objVarName?
+ * Returns a polar object with the averaged spectrum. If -obj is given, the spectrum is
+ * written into this object, which is only reallocated when its size does not match.
+ */
+int esweepSpectrumRead(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_spectrum *spec=NULL;
+	esweep_object *out=NULL;
+	Tcl_Obj *tclObj=NULL;
+	const char *opts[] = {"-spectrum", "-mode", "-obj", NULL};
+	int optMask[] = {1, 0, 0, 0}; // necessary options
+	enum optIdx {specIdx, modeIdx, objIdx};
+	int obji;
+	int index;
+	const char *mode="magnitude";
+
+	CHECK_NUM_ARGS(objc >= 3 && objc <= 7 && (objc-1)%2 == 0, "-spectrum handle ?-mode magnitude|power|psd? ?-obj objVarName?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case specIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, SPECTRUM_HANDLE, spec);
+				break;
+			case modeIdx:
+				mode=Tcl_GetString(objv[obji+1]);
+				break;
+			case objIdx:
+				CHECK_ESWEEP_OBJECT2(obji+1, tclObj, out);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	if (tclObj != NULL) {
+		DUPLICATE_WHEN_SHARED(tclObj, out);
+		ESWEEP_TCL_ASSERT(esweep_spectrumRead(spec, out, mode, NULL) == ERR_OK);
+	} else {
+		ESWEEP_TCL_ASSERT((out=esweep_create("polar", 1, 0))!=NULL);
+		if (esweep_spectrumRead(spec, out, mode, NULL) != ERR_OK) {
+			esweep_free(out);
+			Tcl_SetObjResult(interp, Tcl_NewStringObj(errmsg, -1));
+			return TCL_ERROR;
+		}
+		tclObj=Tcl_NewObj();
+		tclObj->internalRep.otherValuePtr=out;
+		tclObj->typePtr=(Tcl_ObjType*) &tclEsweepObjType;
+	}
+	Tcl_InvalidateStringRep(tclObj);
+	Tcl_SetObjResult(interp, tclObj);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::spectrumInfo -spectrum handle
+ * Returns the list {size value hop value frames value}
+ */
+int esweepSpectrumInfo(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_spectrum *spec=NULL;
+	Tcl_Obj *listPtr;
+	const char *opts[] = {"-spectrum", NULL};
+	int optMask[] = {1, 0}; // necessary options
+	enum optIdx {specIdx};
+	int obji;
+	int index;
+	int size, hop, frames;
+
+	CHECK_NUM_ARGS(objc == 3, "-spectrum handle");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case specIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, SPECTRUM_HANDLE, spec);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_spectrumInfo(spec, &size, &hop, &frames) == ERR_OK);
+	listPtr=Tcl_NewListObj(0, NULL);
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("size", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewIntObj(size));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("hop", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewIntObj(hop));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("frames", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewIntObj(frames));
+	Tcl_SetObjResult(interp, listPtr);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::spectrumReset -spectrum handle
+ */
+int esweepSpectrumReset(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_spectrum *spec=NULL;
+	const char *opts[] = {"-spectrum", NULL};
+	int optMask[] = {1, 0}; // necessary options
+	enum optIdx {specIdx};
+	int obji;
+	int index;
+
+	CHECK_NUM_ARGS(objc == 3, "-spectrum handle");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case specIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, SPECTRUM_HANDLE, spec);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_spectrumReset(spec) == ERR_OK);
+	return TCL_OK;
+}
@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * esweep_tcl_wrap_stft.c
+ * Wraps the esweep_stft.c source file
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <tcl.h>
+#include "esweep_tcl_wrap.h"
+
+#define STFT_HANDLE "stft"
+
+static int freeStft(void *stft) {
+	return esweep_stftFree((esweep_stftEngine*) stft);
+}
+
+/*
+ * ::esweep::stftCreate -samplerate sr -size N ?-hop samples? ?-window type? ?-axis linear|log? ?-range {f1 f2}? ?-bins n?
+ * The default is a Hann window, a hop of N/4 and a linear frequency axis
+ */
+int esweepStftCreate(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_stftEngine *stft;
+	Tcl_Obj *ret;
+	Tcl_Obj **range;
+	const char *opts[] = {"-samplerate", "-size", "-hop", "-window", "-axis", "-range", "-bins", NULL};
+	int optMask[] = {1, 1, 0, 0, 0, 0, 0, 0}; // necessary options
+	enum optIdx {srIdx, sizeIdx, hopIdx, winIdx, axisIdx, rangeIdx, binsIdx};
+	int obji;
+	int index;
+	int samplerate=0, size=0, hop=0, bins=100, n;
+	double f1=20.0, f2=20000.0;
+	const char *win="hann", *axis="linear";
+
+	CHECK_NUM_ARGS(objc >= 5 && objc <= 15 && (objc-1)%2 == 0, "-samplerate value -size value ?-hop samples? ?-window type? ?-axis linear|log? ?-range {f1 f2}? ?-bins n?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case srIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &samplerate)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -samplerate invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case sizeIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &size)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -size invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case hopIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &hop)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -hop invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case winIdx:
+				win=Tcl_GetString(objv[obji+1]);
+				break;
+			case axisIdx:
+				axis=Tcl_GetString(objv[obji+1]);
+				break;
+			case rangeIdx:
+				if (Tcl_ListObjGetElements(NULL, objv[obji+1], &n, &range)!=TCL_OK || n != 2 ||
+				    Tcl_GetDoubleFromObj(NULL, range[0], &f1)!=TCL_OK ||
+				    Tcl_GetDoubleFromObj(NULL, range[1], &f2)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -range invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case binsIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &bins)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -bins invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+	if (hop == 0) hop=size/4;
+
+	ESWEEP_TCL_ASSERT((stft=esweep_stftCreate(samplerate, size, hop, win, axis, f1, f2, bins)) != NULL);
+	if ((ret=esweepNewHandleObj(STFT_HANDLE, stft, freeStft)) == NULL) {
+		esweep_stftFree(stft);
+		return TCL_ERROR;
+	}
+	Tcl_SetObjResult(interp, ret);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::stftProcess -stft handle -signal obj -surface objVarName ?-threads n?
+ * Appends the spectrogram of the signal to the surface, returns the number of new rows.
+ * The surface must have as many columns as the engine has bins.
+ */
+int esweepStftProcess(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_stftEngine *stft=NULL;
+	esweep_object *in=NULL, *out=NULL;
+	Tcl_Obj *tclObj=NULL;
+	const char *opts[] = {"-stft", "-signal", "-surface", "-threads", NULL};
+	int optMask[] = {1, 1, 1, 0, 0}; // necessary options
+	enum optIdx {stftIdx, sigIdx, surfIdx, threadsIdx};
+	int obji;
+	int index;
+	int threads=1, frames;
+
+	CHECK_NUM_ARGS(objc == 7 || objc == 9, "-stft handle -signal obj -surface objVarName ?-threads n?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case stftIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, STFT_HANDLE, stft);
+				break;
+			case sigIdx:
+				CHECK_ESWEEP_OBJECT(obji+1, in);
+				break;
+			case surfIdx:
+				CHECK_ESWEEP_OBJECT2(obji+1, tclObj, out);
+				break;
+			case threadsIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &threads)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -threads invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	DUPLICATE_WHEN_SHARED(tclObj, out);
+	ESWEEP_TCL_ASSERT(esweep_stftProcess(stft, out, in, threads, &frames) == ERR_OK);
+	Tcl_InvalidateStringRep(tclObj);
+	Tcl_SetObjResult(interp, Tcl_NewIntObj(frames));
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::stftInfo -stft handle
+ * Returns the list {bins value frames value}
+ */
+int esweepStftInfo(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_stftEngine *stft=NULL;
+	Tcl_Obj *listPtr;
+	const char *opts[] = {"-stft", NULL};
+	int optMask[] = {1, 0}; // necessary options
+	enum optIdx {stftIdx};
+	int obji;
+	int index;
+	int bins;
+	long frames;
+
+	CHECK_NUM_ARGS(objc == 3, "-stft handle");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case stftIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, STFT_HANDLE, stft);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_stftInfo(stft, &bins, &frames) == ERR_OK);
+	listPtr=Tcl_NewListObj(0, NULL);
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("bins", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewIntObj(bins));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("frames", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewLongObj(frames));
+	Tcl_SetObjResult(interp, listPtr);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::stftReset -stft handle
+ */
+int esweepStftReset(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_stftEngine *stft=NULL;
+	const char *opts[] = {"-stft", NULL};
+	int optMask[] = {1, 0}; // necessary options
+	enum optIdx {stftIdx};
+	int obji;
+	int index;
+
+	CHECK_NUM_ARGS(objc == 3, "-stft handle");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case stftIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, STFT_HANDLE, stft);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_stftReset(stft) == ERR_OK);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::stft -signal obj -size N ?-hop samples? ?-window type? ?-threads n?
+ * Returns a new surface with the spectrogram of the signal
+ */
+int esweepStft(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_object *in=NULL, *out;
+	Tcl_Obj *tclObj;
+	const char *opts[] = {"-signal", "-size", "-hop", "-window", "-threads", NULL};
+	int optMask[] = {1, 1, 0, 0, 0, 0}; // necessary options
+	enum optIdx {sigIdx, sizeIdx, hopIdx, winIdx, threadsIdx};
+	int obji;
+	int index;
+	int size=0, hop=0, threads=1;
+	const char *win="hann";
+
+	CHECK_NUM_ARGS(objc >= 5 && objc <= 11 && (objc-1)%2 == 0, "-signal obj -size N ?-hop samples? ?-window type? ?-threads n?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case sigIdx:
+				CHECK_ESWEEP_OBJECT(obji+1, in);
+				break;
+			case sizeIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &size)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -size invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case hopIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &hop)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -hop invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case winIdx:
+				win=Tcl_GetString(objv[obji+1]);
+				break;
+			case threadsIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &threads)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -threads invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+	if (hop == 0) hop=size/4;
+
+	ESWEEP_TCL_ASSERT((out=esweep_create("surface", in->samplerate, 0))!=NULL);
+	if (esweep_stft(out, in, win, size, hop, threads) != ERR_OK) {
+		esweep_free(out);
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(errmsg, -1));
+		return TCL_ERROR;
+	}
+	tclObj=Tcl_NewObj();
+	tclObj->internalRep.otherValuePtr=out;
+	tclObj->typePtr=(Tcl_ObjType*) &tclEsweepObjType;
+	Tcl_InvalidateStringRep(tclObj);
+	Tcl_SetObjResult(interp, tclObj);
+	return TCL_OK;
+}
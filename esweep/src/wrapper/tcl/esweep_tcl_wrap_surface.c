@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * esweep_tcl_wrap_surface.c
+ * Wraps the esweep_surface.c source file
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <tcl.h>
+#include "esweep_tcl_wrap.h"
+
+/*
+ * ::esweep::csd -signal obj -step ms -steps n ?-rise ms? ?-smooth factor? ?-range {f1 f2}? ?-points n? ?-threads n?
+ * Returns a new surface with the cumulative spectral decay of the impulse response.
+ * Without -points the full FFT grid is used.
+ */
+int esweepCsd(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_object *in=NULL, *out;
+	Tcl_Obj *tclObj;
+	Tcl_Obj **range;
+	const char *opts[] = {"-signal", "-step", "-steps", "-rise", "-smooth", "-range", "-points", "-threads", NULL};
+	int optMask[] = {1, 1, 1, 0, 0, 0, 0, 0, 0}; // necessary options
+	enum optIdx {sigIdx, stepIdx, stepsIdx, riseIdx, smoothIdx, rangeIdx, pointsIdx, threadsIdx};
+	int obji;
+	int index;
+	int steps=0, points=0, threads=1, n;
+	double step=0.0, rise=0.0, smooth=0.0, f1=20.0, f2=20000.0;
+
+	CHECK_NUM_ARGS(objc >= 7 && objc <= 17 && (objc-1)%2 == 0, "-signal obj -step ms -steps n ?-rise ms? ?-smooth factor? ?-range {f1 f2}? ?-points n? ?-threads n?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case sigIdx:
+				CHECK_ESWEEP_OBJECT(obji+1, in);
+				break;
+			case stepIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &step)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -step invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case stepsIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &steps)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -steps invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case riseIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &rise)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -rise invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case smoothIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &smooth)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -smooth invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case rangeIdx:
+				if (Tcl_ListObjGetElements(NULL, objv[obji+1], &n, &range)!=TCL_OK || n != 2 ||
+				    Tcl_GetDoubleFromObj(NULL, range[0], &f1)!=TCL_OK ||
+				    Tcl_GetDoubleFromObj(NULL, range[1], &f2)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -range invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case pointsIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &points)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -points invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case threadsIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &threads)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -threads invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT((out=esweep_create("surface", in->samplerate, 0))!=NULL);
+	if (esweep_csdExt(out, in, step, steps, rise, smooth, f1, f2, points, threads) != ERR_OK) {
+		esweep_free(out);
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(errmsg, -1));
+		return TCL_ERROR;
+	}
+	tclObj=Tcl_NewObj();
+	tclObj->internalRep.otherValuePtr=out;
+	tclObj->typePtr=(Tcl_ObjType*) &tclEsweepObjType;
+	Tcl_InvalidateStringRep(tclObj);
+	Tcl_SetObjResult(interp, tclObj);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::cbsd -signal obj -range {f1 f2} ?-resolution periods? ?-periods n? ?-steps n? ?-shift 0|1? ?-threads n?
+ * Returns a new surface with the burst decay of the impulse response.
+ * The defaults are a resolution of 5 periods, 20 periods with 4 steps each and no time shift.
+ */
+int esweepCbsd(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_object *in=NULL, *out;
+	Tcl_Obj *tclObj;
+	Tcl_Obj **range;
+	const char *opts[] = {"-signal", "-range", "-resolution", "-periods", "-steps", "-shift", "-threads", NULL};
+	int optMask[] = {1, 1, 0, 0, 0, 0, 0, 0}; // necessary options
+	enum optIdx {sigIdx, rangeIdx, resIdx, periodsIdx, stepsIdx, shiftIdx, threadsIdx};
+	int obji;
+	int index;
+	int resolution=5, periods=20, steps=4, shift=0, threads=1, n;
+	double f1=0.0, f2=0.0;
+
+	CHECK_NUM_ARGS(objc >= 5 && objc <= 15 && (objc-1)%2 == 0, "-signal obj -range {f1 f2} ?-resolution periods? ?-periods n? ?-steps n? ?-shift 0|1? ?-threads n?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case sigIdx:
+				CHECK_ESWEEP_OBJECT(obji+1, in);
+				break;
+			case rangeIdx:
+				if (Tcl_ListObjGetElements(NULL, objv[obji+1], &n, &range)!=TCL_OK || n != 2 ||
+				    Tcl_GetDoubleFromObj(NULL, range[0], &f1)!=TCL_OK ||
+				    Tcl_GetDoubleFromObj(NULL, range[1], &f2)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -range invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case resIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &resolution)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -resolution invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case periodsIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &periods)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -periods invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case stepsIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &steps)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -steps invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case shiftIdx:
+				if (Tcl_GetBooleanFromObj(NULL, objv[obji+1], &shift)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -shift invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case threadsIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &threads)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -threads invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT((out=esweep_create("surface", in->samplerate, 0))!=NULL);
+	if (esweep_cbsdExt(out, in, f1, f2, resolution, periods, steps, shift ? 'y' : 'n', threads) != ERR_OK) {
+		esweep_free(out);
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(errmsg, -1));
+		return TCL_ERROR;
+	}
+	tclObj=Tcl_NewObj();
+	tclObj->internalRep.otherValuePtr=out;
+	tclObj->typePtr=(Tcl_ObjType*) &tclEsweepObjType;
+	Tcl_InvalidateStringRep(tclObj);
+	Tcl_SetObjResult(interp, tclObj);
+	return TCL_OK;
+}
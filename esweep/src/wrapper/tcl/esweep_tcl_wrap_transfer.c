@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2011 Jochen Fabricius <jfab@berlios.de>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * esweep_tcl_wrap_transfer.c
+ * Wraps the esweep_transfer.c source file
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <tcl.h>
+#include "esweep_tcl_wrap.h"
+
+#define TRANSFER_HANDLE "transfer"
+
+static int freeTransfer(void *tf) {
+	return esweep_transferFree((esweep_transfer*) tf);
+}
+
+/*
+ * ::esweep::transferCreate -samplerate sr -size N ?-channels n? ?-overlap percent? ?-window type? ?-average linear|exponential? ?-tau seconds?
+ * The default is one channel, a Hann window with 50 % overlap and linear averaging
+ */
+int esweepTransferCreate(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_transfer *tf;
+	Tcl_Obj *ret;
+	const char *opts[] = {"-samplerate", "-size", "-channels", "-overlap", "-window", "-average", "-tau", NULL};
+	int optMask[] = {1, 1, 0, 0, 0, 0, 0, 0}; // necessary options
+	enum optIdx {srIdx, sizeIdx, chIdx, overlapIdx, winIdx, avgIdx, tauIdx};
+	int obji;
+	int index;
+	int samplerate=0, size=0, channels=1;
+	double overlap=50.0, tau=1.0;
+	const char *win="hann", *average="linear";
+
+	CHECK_NUM_ARGS(objc >= 5 && objc <= 15 && (objc-1)%2 == 0, "-samplerate value -size value ?-channels n? ?-overlap percent? ?-window type? ?-average linear|exponential? ?-tau seconds?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case srIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &samplerate)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -samplerate invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case sizeIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &size)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -size invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case chIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &channels)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -channels invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case overlapIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &overlap)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -overlap invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case winIdx:
+				win=Tcl_GetString(objv[obji+1]);
+				break;
+			case avgIdx:
+				average=Tcl_GetString(objv[obji+1]);
+				break;
+			case tauIdx:
+				if (Tcl_GetDoubleFromObj(NULL, objv[obji+1], &tau)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -tau invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT((tf=esweep_transferCreate(samplerate, size, overlap, win, channels, average, tau)) != NULL);
+	if ((ret=esweepNewHandleObj(TRANSFER_HANDLE, tf, freeTransfer)) == NULL) {
+		esweep_transferFree(tf);
+		return TCL_ERROR;
+	}
+	Tcl_SetObjResult(interp, ret);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::transferProcess -transfer handle -reference obj -signals {obj ...}
+ * There must be one signal per channel, each with the size of the reference.
+ * Returns the number of frames averaged so far
+ */
+int esweepTransferProcess(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_transfer *tf=NULL;
+	esweep_object *ref=NULL;
+	const esweep_object **meas;
+	Tcl_Obj **sigs=NULL;
+	const char *opts[] = {"-transfer", "-reference", "-signals", NULL};
+	int optMask[] = {1, 1, 1, 0}; // necessary options
+	enum optIdx {tfIdx, refIdx, sigIdx};
+	int obji;
+	int index;
+	int i, n=0, channels, frames;
+
+	CHECK_NUM_ARGS(objc == 7, "-transfer handle -reference obj -signals {obj ...}");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case tfIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, TRANSFER_HANDLE, tf);
+				break;
+			case refIdx:
+				CHECK_ESWEEP_OBJECT(obji+1, ref);
+				break;
+			case sigIdx:
+				if (Tcl_ListObjGetElements(interp, objv[obji+1], &n, &sigs) != TCL_OK) {
+					return TCL_ERROR;
+				}
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_transferInfo(tf, NULL, NULL, &channels, NULL) == ERR_OK);
+	if (n != channels) {
+		Tcl_SetResult(interp, "option -signals needs one object per channel", TCL_STATIC);
+		return TCL_ERROR;
+	}
+	ESWEEP_MALLOC(meas, n, sizeof(esweep_object*), TCL_ERROR);
+	for (i=0; i < n; i++) {
+		if (sigs[i]->typePtr != &tclEsweepObjType) {
+			free(meas);
+			Tcl_SetObjResult(interp, Tcl_NewStringObj("List contains non-esweep objects", -1));
+			return TCL_ERROR;
+		}
+		meas[i]=(esweep_object*) sigs[i]->internalRep.otherValuePtr;
+	}
+	if (esweep_transferProcess(tf, ref, meas) != ERR_OK) {
+		free(meas);
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(errmsg, -1));
+		return TCL_ERROR;
+	}
+	free(meas);
+	ESWEEP_TCL_ASSERT(esweep_transferInfo(tf, NULL, NULL, NULL, &frames) == ERR_OK);
+	Tcl_SetObjResult(interp, Tcl_NewIntObj(frames));
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::transferRead -transfer handle ?-channel n? ?-mode h1|h2|coherence? ?-obj objVarName?
+ * Returns a complex object with the transfer function, or a polar object with the coherence. If -obj is given,
+ * the result is written into this object, which is only reallocated when its type or size does not match.
+ */
+int esweepTransferRead(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_transfer *tf=NULL;
+	esweep_object *out=NULL;
+	Tcl_Obj *tclObj=NULL;
+	const char *opts[] = {"-transfer", "-channel", "-mode", "-obj", NULL};
+	int optMask[] = {1, 0, 0, 0, 0}; // necessary options
+	enum optIdx {tfIdx, chIdx, modeIdx, objIdx};
+	int obji;
+	int index;
+	int channel=0;
+	const char *mode="h1";
+
+	CHECK_NUM_ARGS(objc >= 3 && objc <= 9 && (objc-1)%2 == 0, "-transfer handle ?-channel n? ?-mode h1|h2|coherence? ?-obj objVarName?");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case tfIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, TRANSFER_HANDLE, tf);
+				break;
+			case chIdx:
+				if (Tcl_GetIntFromObj(NULL, objv[obji+1], &channel)!=TCL_OK) {
+					Tcl_SetResult(interp, "option -channel invalid", TCL_STATIC);
+					return TCL_ERROR;
+				}
+				break;
+			case modeIdx:
+				mode=Tcl_GetString(objv[obji+1]);
+				break;
+			case objIdx:
+				CHECK_ESWEEP_OBJECT2(obji+1, tclObj, out);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	if (tclObj != NULL) {
+		DUPLICATE_WHEN_SHARED(tclObj, out);
+		ESWEEP_TCL_ASSERT(esweep_transferRead(tf, channel, out, mode, NULL) == ERR_OK);
+	} else {
+		ESWEEP_TCL_ASSERT((out=esweep_create("complex", 1, 0))!=NULL);
+		if (esweep_transferRead(tf, channel, out, mode, NULL) != ERR_OK) {
+			esweep_free(out);
+			Tcl_SetObjResult(interp, Tcl_NewStringObj(errmsg, -1));
+			return TCL_ERROR;
+		}
+		tclObj=Tcl_NewObj();
+		tclObj->internalRep.otherValuePtr=out;
+		tclObj->typePtr=(Tcl_ObjType*) &tclEsweepObjType;
+	}
+	Tcl_InvalidateStringRep(tclObj);
+	Tcl_SetObjResult(interp, tclObj);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::transferInfo -transfer handle
+ * Returns the list {size value hop value channels value frames value}
+ */
+int esweepTransferInfo(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_transfer *tf=NULL;
+	Tcl_Obj *listPtr;
+	const char *opts[] = {"-transfer", NULL};
+	int optMask[] = {1, 0}; // necessary options
+	enum optIdx {tfIdx};
+	int obji;
+	int index;
+	int size, hop, channels, frames;
+
+	CHECK_NUM_ARGS(objc == 3, "-transfer handle");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case tfIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, TRANSFER_HANDLE, tf);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_transferInfo(tf, &size, &hop, &channels, &frames) == ERR_OK);
+	listPtr=Tcl_NewListObj(0, NULL);
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("size", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewIntObj(size));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("hop", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewIntObj(hop));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("channels", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewIntObj(channels));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewStringObj("frames", -1));
+	Tcl_ListObjAppendElement(NULL, listPtr, Tcl_NewIntObj(frames));
+	Tcl_SetObjResult(interp, listPtr);
+	return TCL_OK;
+}
+
+/*
+ * ::esweep::transferReset -transfer handle
+ */
+int esweepTransferReset(ClientData clientdata, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]) {
+	esweep_transfer *tf=NULL;
+	const char *opts[] = {"-transfer", NULL};
+	int optMask[] = {1, 0}; // necessary options
+	enum optIdx {tfIdx};
+	int obji;
+	int index;
+
+	CHECK_NUM_ARGS(objc == 3, "-transfer handle");
+
+	for (obji=1; obji < objc; obji+=2) {
+		if (Tcl_GetIndexFromObj(interp, objv[obji], opts, "option", 0, &index) != TCL_OK) {
+			return TCL_ERROR;
+		}
+		switch (index) {
+			case tfIdx:
+				CHECK_ESWEEP_HANDLE(obji+1, TRANSFER_HANDLE, tf);
+				break;
+		}
+		optMask[index]=0;
+	}
+	CHECK_MISSING_OPTIONS(opts, optMask, index);
+
+	ESWEEP_TCL_ASSERT(esweep_transferReset(tf) == ERR_OK);
+	return TCL_OK;
+}